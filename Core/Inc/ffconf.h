@@ -0,0 +1,74 @@
+/*---------------------------------------------------------------------------/
+/  Configurations of FatFs R0.15 for the SD card of lvgl_port_fatfs
+/  Replaces Middlewares/Third_Party/FatFs/source/ffconf.h, which has to be
+/  deleted: ff.h includes the ffconf.h next to it first.
+/---------------------------------------------------------------------------*/
+
+#define FFCONF_DEF      80286   /* Revision ID */
+
+/*---------------------------------------------------------------------------/
+/ Function Configurations
+/---------------------------------------------------------------------------*/
+
+#define FF_FS_READONLY  0
+#define FF_FS_MINIMIZE  0
+#define FF_USE_FIND     0
+#define FF_USE_MKFS     0
+#define FF_USE_FASTSEEK 1       /* lvgl_port_video maps the clusters of the AVI file */
+#define FF_USE_EXPAND   0
+#define FF_USE_CHMOD    0
+#define FF_USE_LABEL    0
+#define FF_USE_FORWARD  0
+#define FF_USE_STRFUNC  0
+#define FF_PRINT_LLI    0
+#define FF_PRINT_FLOAT  0
+#define FF_STRF_ENCODE  3
+
+/*---------------------------------------------------------------------------/
+/ Locale and Namespace Configurations
+/---------------------------------------------------------------------------*/
+
+#define FF_CODE_PAGE    437
+
+/* Long file names with the working buffer on the stack (2), the static buffer (1)
+ * isn't safe with several tasks. Every task opening S: files needs about 600 bytes
+ * of stack for it. */
+#define FF_USE_LFN      2
+#define FF_MAX_LFN      255
+#define FF_LFN_UNICODE  0
+#define FF_LFN_BUF      255
+#define FF_SFN_BUF      12
+#define FF_FS_RPATH     0
+
+/*---------------------------------------------------------------------------/
+/ Drive/Volume Configurations
+/---------------------------------------------------------------------------*/
+
+#define FF_VOLUMES      1       /* the SD card */
+#define FF_STR_VOLUME_ID 0
+#define FF_VOLUME_STRS  "SD"
+#define FF_MULTI_PARTITION 0
+#define FF_MIN_SS       512
+#define FF_MAX_SS       512
+#define FF_LBA64        0
+#define FF_MIN_GPT      0x10000000
+#define FF_USE_TRIM     0
+
+/*---------------------------------------------------------------------------/
+/ System Configurations
+/---------------------------------------------------------------------------*/
+
+#define FF_FS_TINY      0
+#define FF_FS_EXFAT     1       /* SDXC cards are exFAT formatted */
+#define FF_FS_NORTC     0       /* get_fattime() reads the RTC */
+#define FF_NORTC_MON    1
+#define FF_NORTC_MDAY   1
+#define FF_NORTC_YEAR   2025
+#define FF_FS_NOFSINFO  0
+#define FF_FS_LOCK      0
+
+/* The LVGL task, the video task and lv_fs users in other tasks share the card. The
+ * volume is locked by ff_mutex_take() in lvgl_port_fatfs.c, which also covers the
+ * bounce buffer of the disk functions. ffsystem.c isn't built. */
+#define FF_FS_REENTRANT 1
+#define FF_FS_TIMEOUT   1000
@@ -36,6 +36,8 @@ extern HASH_HandleTypeDef hhash;
 
 /* USER CODE BEGIN Private defines */
 
+extern DMA_HandleTypeDef handle_GPDMA1_Channel7;
+
 /* USER CODE END Private defines */
 
 void MX_HASH_Init(void);
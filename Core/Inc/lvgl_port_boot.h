@@ -0,0 +1,81 @@
+#ifndef __LVGL_PORT_BOOT_H
+#define __LVGL_PORT_BOOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define BOOT_STAGE_MAX           16
+
+/* lv_image_dsc_t of the splash, an RGB565 image in the internal flash, e.g.
+ * `LVGLImage.py --ofmt C --cf RGB565 -o Core/Src boot_splash.png`. One of the panel
+ * size is scanned out as it is, a smaller one (the logo in Core/Src/boot_splash.c)
+ * is copied to the middle of the cleared framebuffer. */
+#define BOOT_SPLASH_IMAGE        boot_splash
+
+/* RGB565 color the framebuffer is cleared to around a smaller splash image */
+#define BOOT_SPLASH_COLOR        0x0000
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  const char *name;
+  uint32_t    us;             /* since lvgl_boot_init() */
+} lvgl_boot_stage_t;
+
+typedef struct
+{
+  lvgl_boot_stage_t stages[BOOT_STAGE_MAX];
+  uint32_t          stage_cnt;
+  uint32_t          first_frame_us;   /* 0 until LVGL has rendered its first frame */
+} lvgl_boot_report_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Start the DWT cycle counter, the time of the stages is counted from here.
+ * Called right after the system clock is configured. */
+void
+lvgl_boot_init (void);
+
+/* Timestamp the end of the boot stage `name`, from any task or before the kernel runs */
+void
+lvgl_boot_mark (const char *name);
+
+/* Let the LTDC scan out the splash image from the flash, or clear the framebuffer
+ * with the DMA2D and copy a smaller splash into it, so the backlight can be turned on
+ * before LVGL has rendered anything. It costs no RAM and needs no OSPI. */
+void
+lvgl_boot_splash (void);
+
+/* Record the "first frame" stage when `disp` has rendered for the first time,
+ * and switch from the splash to the LVGL framebuffer in the same vblank */
+void
+lvgl_boot_watch (lv_display_t *disp);
+
+void
+lvgl_boot_get_report (lvgl_boot_report_t *report);
+
+/* Print the stages with LV_LOG_USER */
+void
+lvgl_boot_log (void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_BOOT_H */
@@ -0,0 +1,105 @@
+#ifndef __LVGL_PORT_BUNDLE_H
+#define __LVGL_PORT_BUNDLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* The bundle is flashed to the start of the octal NOR, which OCTOSPI1 maps here */
+#define BUNDLE_ADDR              0x90000000
+#define BUNDLE_MAX_SIZE          (16 * 1024 * 1024)
+
+/* drive letter of the assets, e.g. "B:icons/home" */
+#define BUNDLE_LETTER            'B'
+
+#define BUNDLE_MAGIC             0x4B50564C   /* "LVPK" */
+#define BUNDLE_VERSION           1
+
+/* payloads are aligned at least to the GPU's texture and the cache line alignment */
+#define BUNDLE_MIN_ALIGN         32
+
+#define BUNDLE_TYPE_BLOB         0
+#define BUNDLE_TYPE_IMAGE        1   /* LVGL image, header fields in the entry */
+#define BUNDLE_TYPE_FONT         2   /* LVGL binary font, lv_binfont_create("B:...") copies it to RAM */
+#define BUNDLE_TYPE_STRING       3   /* UTF-8, NUL terminated */
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/* The layout of the bundle (Tools/lvgl_bundle.py), little endian:
+ * header, `count` hash seeds, `count` entries, names, aligned payloads */
+typedef struct
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t align;
+  uint32_t count;
+  uint32_t seeds_off;
+  uint32_t entries_off;
+  uint32_t names_off;
+  uint32_t size;
+  uint32_t reserved;
+} lvgl_bundle_header_t;
+
+typedef struct
+{
+  uint32_t name_off;     /* from `names_off` */
+  uint32_t data_off;     /* from the start of the bundle */
+  uint32_t data_size;
+  uint8_t  type;         /* BUNDLE_TYPE_... */
+  uint8_t  cf;           /* images: lv_color_format_t */
+  uint16_t flags;        /* images: lv_image_flags_t */
+  uint16_t w;
+  uint16_t h;
+  uint16_t stride;
+  uint16_t reserved;
+} lvgl_bundle_entry_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Use the bundle at `base`, e.g. BUNDLE_ADDR. Its names are opened through the
+ * BUNDLE_LETTER drive and image names are drawn straight from `base` by an image decoder.
+ * Can be called again to switch to another bundle when nothing of the old one is in use. */
+lv_result_t
+lvgl_bundle_init (const void *base);
+
+/* Check the header and the entries of the bundle at `base` without using it, e.g.
+ * an update written to the other slot */
+bool
+lvgl_bundle_is_valid (const void *base);
+
+/* Find an asset with a single hash lookup, NULL if it's not in the bundle */
+const lvgl_bundle_entry_t *
+lvgl_bundle_find (const char *name);
+
+/* Payload of an entry in the memory-mapped flash */
+const void *
+lvgl_bundle_get_data (const lvgl_bundle_entry_t *entry);
+
+/* Describe the image `name` in `dsc` to use it as a variable source, compressed
+ * and TSC images are handled by their decoders this way too */
+lv_result_t
+lvgl_bundle_get_image (const char *name, lv_image_dsc_t *dsc);
+
+/* The string `name` or NULL */
+const char *
+lvgl_bundle_get_string (const char *name);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_BUNDLE_H */
@@ -0,0 +1,110 @@
+#ifndef __LVGL_PORT_CAN_H
+#define __LVGL_PORT_CAN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* added to lvgl_can_signal_t.id for a 29 bit identifier */
+#define CAN_ID_EXT               0x80000000U
+
+/* lvgl_can_signal_t.flags */
+#define CAN_SIGNAL_SIGNED        0x01
+#define CAN_SIGNAL_BIG_ENDIAN    0x02         /* Motorola, `start` is the MSB as in a DBC */
+
+/* signals of the database, and the messages they are in */
+#define CAN_SIGNAL_MAX           64
+#define CAN_MESSAGE_MAX          64
+
+/* The filter elements of the message RAM, MX_FDCAN1_Init() enables all of them. A
+ * standard element takes two identifiers or a range of them. If the database has
+ * more, the closest identifiers are merged into ranges and the frames that don't
+ * belong to the database are dropped by the interrupt. */
+#define CAN_STD_FILTER_MAX       28
+#define CAN_EXT_FILTER_MAX       8
+
+/* Standard frames are received into FIFO 0, extended ones into FIFO 1. The FIFOs
+ * hold 3 frames, a full one is overwritten: the latest value of a signal counts. */
+#define CAN_IRQ_PRIORITY         5
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/* A signal of the database, its value is raw * scale + offset */
+typedef struct
+{
+  uint32_t id;                  /* of its message, CAN_ID_EXT added for an extended one */
+  uint16_t start;               /* bit, the LSB with Intel byte order */
+  uint8_t  length;              /* bits, 1 to 32 */
+  uint8_t  flags;
+  float    scale;
+  float    offset;
+} lvgl_can_signal_t;
+
+typedef struct
+{
+  uint32_t frames;              /* received and in the database */
+  uint32_t unmatched;           /* passed a merged range filter but not in the database */
+  uint32_t lost;                /* overwritten in a FIFO */
+  uint32_t truncated;           /* too short for one of their signals */
+  uint32_t latches;             /* refreshes which took changed signals */
+  uint32_t latch_age_max_ms;    /* from a frame to the refresh which showed it */
+  uint32_t isr_us_max;
+  uint32_t std_filters;         /* elements programmed */
+  uint32_t ext_filters;
+  uint32_t ids_extra;           /* accepted by the ranges, not in the database */
+} lvgl_can_stats_t;
+
+/* called by the LVGL task when a refresh starts and signals changed */
+typedef void (*lvgl_can_update_cb_t) (void);
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Program the filters of FDCAN1 for the messages of `signals` and start receiving.
+ * Called once after MX_FDCAN1_Init(). `signals` stays valid, its index identifies a
+ * signal. */
+lv_result_t
+lvgl_can_start (const lvgl_can_signal_t *signals, uint32_t cnt);
+
+/* The values are taken at the start of each refresh of `disp`, then `update_cb`
+ * updates the widgets. Called by the LVGL task. */
+void
+lvgl_can_attach (lv_display_t *disp, lvgl_can_update_cb_t update_cb);
+
+/* The value of signal `idx` as of the start of the refresh, 0 until received */
+float
+lvgl_can_get (uint32_t idx);
+
+/* if signal `idx` was received since the previous refresh */
+bool
+lvgl_can_is_changed (uint32_t idx);
+
+/* Milliseconds from its last frame to the start of the refresh, UINT32_MAX if it
+ * wasn't received yet, e.g. to grey out a stale value */
+uint32_t
+lvgl_can_get_age (uint32_t idx);
+
+void
+lvgl_can_get_stats (lvgl_can_stats_t *stats);
+
+void
+lvgl_can_reset_stats (void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_CAN_H */
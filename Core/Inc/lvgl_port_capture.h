@@ -0,0 +1,88 @@
+#ifndef __LVGL_PORT_CAPTURE_H
+#define __LVGL_PORT_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Build the screen capture, started after the deferred peripherals */
+#define CAPTURE_ENABLE           1
+
+/* The service port. USART1 is taken by the bundle update, huart6 and USART6_IRQn
+ * are the RS485 port, its DE pin is driven by the USART. */
+#define CAPTURE_UART               huart3
+#define CAPTURE_UART_IRQn          USART3_IRQn
+#define CAPTURE_UART_MAGIC         0x4353564C   /* "LVSC" */
+
+/* A request is received at the rate of CubeMX. The capture is sent at the rate the
+ * host asks for, up to this one. The USART takes 10 Mbit/s from its 160 MHz clock,
+ * the transceiver and the cable limit it further. */
+#define CAPTURE_UART_MAX_BAUDRATE  4000000
+
+/* after the answer to a request, before the capture is sent at the new rate */
+#define CAPTURE_UART_SWITCH_MS     20
+
+/* the host doesn't read, or a request isn't complete */
+#define CAPTURE_UART_TIMEOUT       2000
+
+#define CAPTURE_UART_IRQ_PRIORITY  5
+
+/* The framebuffer is compared with the last capture in tiles of this size, only
+ * changed tiles are sent if the host has that capture */
+#define CAPTURE_TILE_SIZE          32
+
+/* the tiles are encoded into one while the DMA sends the other */
+#define CAPTURE_BUF_SIZE           (8 * 1024)
+
+/* Below the LVGL task, the framebuffer is read a tile at a time */
+#define CAPTURE_TASK_PRIORITY      osPriorityLow
+#define CAPTURE_TASK_STACK_SIZE    (1 * 1024)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint32_t captures;
+  uint32_t deltas;              /* against the host's last capture */
+  uint32_t failures;            /* the host didn't read, or a bad request */
+  uint32_t tiles;               /* sent by the last capture */
+  uint32_t tiles_skipped;       /* unchanged since the previous one */
+  uint32_t bytes;               /* sent by the last capture */
+  uint32_t raw_bytes;           /* of the framebuffer */
+  uint32_t ms;                  /* of the last capture */
+  uint32_t baudrate;            /* of the last capture */
+  uint32_t kbyte_per_s;         /* computed by get_stats */
+} lvgl_capture_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Send screenshots of the LVGL layer on CAPTURE_UART from a task, Tools/lvgl_capture.py
+ * requests them. Called after the UART is initialized. */
+void
+lvgl_capture_uart_start (void);
+
+void
+lvgl_capture_get_stats (lvgl_capture_stats_t *stats);
+
+void
+lvgl_capture_reset_stats (void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_CAPTURE_H */
@@ -18,6 +18,10 @@ extern "C" {
 #define MY_DISP_HOR_RES    800
 #define MY_DISP_VER_RES    480
 
+/* Counter-clockwise rotation of the UI in degrees (0, 90, 180 or 270), 90 or 270
+ * for portrait enclosures. MY_DISP_HOR_RES/VER_RES stay the native panel resolution. */
+#define MY_DISP_ROTATION   0
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
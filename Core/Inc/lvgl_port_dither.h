@@ -0,0 +1,75 @@
+#ifndef __LVGL_PORT_DITHER_H
+#define __LVGL_PORT_DITHER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Build the gradient dithering and attach it in lvgl_display_init(). Off by default,
+ * as its cache takes DITHER_CACHE_SIZE of RAM for good, and
+ * lvgl_dither_add() only exists with it. */
+#define DITHER_ENABLE            0
+
+/* Memory for the dithered gradient textures, least recently drawn ones are evicted first */
+#define DITHER_CACHE_SIZE        (96 * 1024)
+
+/* Max. number of cached gradients */
+#define DITHER_CACHE_CNT         8
+
+/* Thickness of a texture across the gradient, it's blitted side by side over the
+ * filled area. Multiple of the 4x4 dither matrix. */
+#define DITHER_TILE              32
+
+/* Max. number of fills per refresh which aren't a multiple of DITHER_TILE thick,
+ * further ones are left to the GPU */
+#define DITHER_REST_CNT          16
+
+/* Shorter gradients have too few steps per RGB565 level to band visibly */
+#define DITHER_MIN_LEN           64
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint32_t hit_cnt;       /* gradient fills served from a cached texture */
+  uint32_t miss_cnt;      /* ... for which a texture had to be generated */
+  uint32_t skip_cnt;      /* ... left to the GPU (no memory or not supported) */
+  uint32_t gen_time;      /* ms spent generating textures */
+} lvgl_dither_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+void
+lvgl_dither_init (lv_display_t *disp);
+
+/* Draw the opaque horizontal and vertical gradient fills of `obj` (e.g. its
+ * background) from an ordered-dithered RGB565 texture instead of the GPU's
+ * truncating gradient fill. Fills with radius or transparency are left unchanged. */
+void
+lvgl_dither_add (lv_obj_t *obj);
+
+void
+lvgl_dither_remove (lv_obj_t *obj);
+
+void
+lvgl_dither_get_stats (lvgl_dither_stats_t *stats);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_DITHER_H */
@@ -0,0 +1,45 @@
+#ifndef __LVGL_PORT_DMA2D_H
+#define __LVGL_PORT_DMA2D_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "main.h"
+#include "lvgl/lvgl.h"
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+void
+lvgl_dma2d_init (void);
+
+/* The DMA2D is shared by the LVGL task (the flush, JPEG decoding, transitions) and
+ * the video task. Hold the lock while programming and running a transfer, the
+ * registers are not restored, so every user sets up everything it needs. It's a
+ * semaphore, so the interrupt ending a flush's transfer can release it. */
+void
+lvgl_dma2d_lock (void);
+
+void
+lvgl_dma2d_unlock (void);
+
+/* Take the lock for the flushes of `disp` in partial mode, whose DMA2D transfers
+ * are started by the LTDC driver and end in the DMA2D interrupt */
+void
+lvgl_dma2d_attach (lv_display_t *disp);
+
+/* Called by the DMA2D interrupt after the HAL handler */
+void
+lvgl_dma2d_irq_handler (void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_DMA2D_H */
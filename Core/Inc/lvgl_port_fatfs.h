@@ -0,0 +1,56 @@
+#ifndef __LVGL_PORT_FATFS_H
+#define __LVGL_PORT_FATFS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Random reads of the benchmark, each FATFS_BENCH_RANDOM_SIZE bytes at a random sector */
+#define FATFS_BENCH_RANDOM_READS 64
+#define FATFS_BENCH_RANDOM_SIZE  512
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint32_t file_size;
+  uint32_t seq_kbyte_per_s;     /* the whole file in reads of the buffer size */
+  uint32_t seq_time_ms;
+  uint32_t random_reads_per_s;
+  uint32_t random_avg_us;
+  uint32_t random_max_us;
+} lvgl_fatfs_bench_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Mount the SD card as the LV_FS_FATFS_LETTER drive. The card is initialized on
+ * the first access, sectors are transferred by the SDMMC's DMA, runs of sectors
+ * with a single multi-block command. Any task may use the drive, FatFs locks the
+ * volume for each call (FF_FS_REENTRANT in Core/Inc/ffconf.h). */
+void
+lvgl_fatfs_init (void);
+
+/* Measure reading `path` (e.g. "S:video.avi") through lv_fs, sequentially in
+ * reads of `buf_size` and at random sectors. Runs in the calling task and blocks it. */
+lv_result_t
+lvgl_fatfs_benchmark (const char *path, void *buf, uint32_t buf_size, lvgl_fatfs_bench_t *bench);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_FATFS_H */
@@ -0,0 +1,71 @@
+#ifndef __LVGL_PORT_FS_CACHE_H
+#define __LVGL_PORT_FS_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* The blocks are shared by all attached drives, the least recently used one is
+ * replaced. A block is a whole number of SD sectors and LittleFS read units. */
+#define FS_CACHE_BLOCK_SIZE      1024
+#define FS_CACHE_BLOCK_CNT       16
+
+/* Blocks loaded after a miss which continues the previous block of the file */
+#define FS_CACHE_READ_AHEAD      3
+
+/* Drives which can be attached */
+#define FS_CACHE_DRV_MAX         4
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint32_t hits;              /* blocks found in the cache */
+  uint32_t misses;
+  uint32_t hit_pct;           /* hits of all block lookups, computed by get_stats */
+  uint32_t read_ahead;        /* blocks loaded ahead of a sequential reader */
+  uint32_t read_ahead_hits;   /* of them used later */
+  uint32_t backend_reads;     /* read calls to the driver */
+  uint32_t backend_bytes;
+  uint32_t direct_bytes;      /* whole uncached blocks read straight into the caller's buffer */
+} lvgl_fs_cache_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Cache the reads of the registered drive `letter`. Its callbacks are wrapped,
+ * files opened for writing pass through and invalidate the file's blocks. The
+ * lv_fs cache of the drive is disabled. Only depends on lv_fs, e.g. a counting
+ * fake driver can be attached on the host. */
+lv_result_t
+lvgl_fs_cache_attach (char letter);
+
+/* Drop the cached blocks of `letter`, or of all drives with 0, e.g. after a card change */
+void
+lvgl_fs_cache_invalidate (char letter);
+
+/* Counters of `letter`, or of all drives with 0 */
+void
+lvgl_fs_cache_get_stats (char letter, lvgl_fs_cache_stats_t *stats);
+
+void
+lvgl_fs_cache_reset_stats (void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_FS_CACHE_H */
@@ -0,0 +1,56 @@
+#ifndef __LVGL_PORT_IMAGE_CACHE_H
+#define __LVGL_PORT_IMAGE_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Allocate the decoded images from a static arena of IMAGE_CACHE_POOL_SIZE, in
+ * lvgl_display_init(). Without it they come from the LVGL heap. */
+#define IMAGE_CACHE_ENABLE       1
+
+/* The image cache evicts at LV_CACHE_DEF_SIZE (lv_conf.h), the arena adds some
+ * headroom for the alignment and fragmentation of the decoded buffers */
+#define IMAGE_CACHE_POOL_SIZE    (LV_CACHE_DEF_SIZE + 8 * 1024)
+
+/* Start address alignment of the decoded images (D-cache line, GPU2D fetch) */
+#define IMAGE_CACHE_ALIGN        32
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint32_t used_bytes;      /* decoded images currently in the arena */
+  uint32_t peak_bytes;
+  uint32_t fallback_cnt;    /* buffers which didn't fit and went to the LVGL heap */
+} lvgl_image_cache_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Serve the buffers of decoded images from a dedicated arena instead of the
+ * small LVGL heap, e.g. the output of the compressed image decoders */
+void
+lvgl_image_cache_init (void);
+
+void
+lvgl_image_cache_get_stats (lvgl_image_cache_stats_t *stats);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_IMAGE_CACHE_H */
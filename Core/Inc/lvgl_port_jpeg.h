@@ -0,0 +1,75 @@
+#ifndef __LVGL_PORT_JPEG_H
+#define __LVGL_PORT_JPEG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* TJpgDec work area, 3100 bytes are enough with JD_FASTDECODE 0/1 */
+#define JPEG_WORK_SIZE           4096
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/* Reads `len` bytes of the JPEG data to `buf`, or skips them if `buf` is NULL.
+ * Returns the number of bytes read, less at the end of the data. */
+typedef size_t (*lvgl_jpeg_in_cb_t)(void *user_data, uint8_t *buf, size_t len);
+
+typedef struct
+{
+  lvgl_jpeg_in_cb_t in_cb;
+  void             *user_data;
+  void             *work;         /* TJpgDec work area, JPEG_WORK_SIZE bytes, one per task */
+  uint32_t          work_size;
+  uint8_t          *dst;          /* RGB565 output */
+  uint32_t          dst_stride;   /* bytes per line of `dst`, 0: packed to the image width */
+  uint32_t          max_w;        /* larger images are rejected */
+  uint32_t          max_h;
+  uint32_t          w;            /* set to the size of the decoded image */
+  uint32_t          h;
+  uint32_t          work_used;    /* ... and the part of the work area TJpgDec used */
+} lvgl_jpeg_job_t;
+
+typedef struct
+{
+  uint32_t w;
+  uint32_t h;
+  uint32_t time_us;        /* jd_prepare() + jd_decomp() */
+  uint32_t work_bytes;     /* part of the work area TJpgDec used */
+  uint32_t peak_bytes;     /* work area + decoded RGB565 image */
+} lvgl_jpeg_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Register a baseline JPEG decoder for `lv_image_dsc_t`s with LV_COLOR_FORMAT_RAW data
+ * and for "*.jpg" files. TJpgDec decodes the MCUs and converts them from YCbCr on the
+ * CPU, they're copied to the decoded image which is kept in the image cache. */
+void
+lvgl_jpeg_init (void);
+
+/* Decode a baseline JPEG to RGB565, from any task */
+lv_result_t
+lvgl_jpeg_decode (lvgl_jpeg_job_t *job);
+
+/* Figures of the last image decoded for LVGL */
+void
+lvgl_jpeg_get_stats (lvgl_jpeg_stats_t *stats);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_JPEG_H */
@@ -0,0 +1,71 @@
+#ifndef __LVGL_PORT_LAYER_POOL_H
+#define __LVGL_PORT_LAYER_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Serve LVGL's layer buffers from a static arena of LAYER_POOL_SIZE, in
+ * lvgl_display_init(). Without it they come from the LVGL heap. */
+#define LAYER_POOL_ENABLE        1
+
+/* The layer budget is configured once with LV_DRAW_LAYER_MAX_MEMORY in lv_conf.h.
+ * LVGL defers new layers while the budget is used up, the arena adds one simple
+ * layer chunk of headroom for alignment and for buffers of mixed sizes. */
+#if LV_DRAW_LAYER_MAX_MEMORY > 0
+  #define LAYER_POOL_SIZE        (LV_DRAW_LAYER_MAX_MEMORY + LV_DRAW_LAYER_SIMPLE_BUF_SIZE)
+#else
+  #define LAYER_POOL_SIZE        (128 * 1024)
+#endif
+
+/* Max. number of buffers tracked by the pool (live and recyclable) */
+#define LAYER_POOL_SLOT_CNT      16
+
+/* Start address alignment of the pooled buffers (D-cache line) */
+#define LAYER_POOL_ALIGN         32
+
+/* Max. bytes a recycled buffer may be larger than requested, a larger free buffer
+ * is split and its tail stays free */
+#define LAYER_POOL_SLACK_MAX     (4 * 1024)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint32_t alloc_cnt;      /* buffers handed out in the frame */
+  uint32_t reuse_cnt;      /* ... of which were recycled from an earlier buffer */
+  uint32_t fallback_cnt;   /* ... of which didn't fit and went to the LVGL heap */
+  uint32_t peak_bytes;     /* peak of the pooled bytes in use during the frame */
+  uint32_t arena_bytes;    /* bytes of the arena carved into slots after the frame */
+} lvgl_layer_pool_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Serve the layers of the refreshes of `disp` from the arena. Only the draw buffers
+ * allocated between LV_EVENT_REFR_START and LV_EVENT_REFR_READY are pooled, those
+ * allocated at other times, e.g. canvases and snapshots, go to the LVGL heap. */
+void
+lvgl_layer_pool_init (lv_display_t *disp);
+
+void
+lvgl_layer_pool_get_stats (lvgl_layer_pool_stats_t *stats);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_LAYER_POOL_H */
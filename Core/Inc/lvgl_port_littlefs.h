@@ -0,0 +1,64 @@
+#ifndef __LVGL_PORT_LITTLEFS_H
+#define __LVGL_PORT_LITTLEFS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Part of the octal NOR used by the file system, the asset bundle is below it */
+#define LITTLEFS_FLASH_OFFSET    (32 * 1024 * 1024)
+#define LITTLEFS_FLASH_SIZE      (16 * 1024 * 1024)
+
+/* LittleFS geometry, blocks are the 4K erase sectors */
+#define LITTLEFS_READ_SIZE       16
+#define LITTLEFS_PROG_SIZE       16
+#define LITTLEFS_BLOCK_CYCLES    500
+#define LITTLEFS_LOOKAHEAD_SIZE  64
+
+/* LittleFS read and program cache per file and for the metadata, a divisor of the
+ * sector size and at most a page, so every program stays within one page */
+#define LITTLEFS_CACHE_SIZE      256
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint32_t block_size;
+  uint32_t block_count;
+  uint32_t blocks_used;
+  uint32_t reads;       /* block device operations since the mount */
+  uint32_t programs;
+  uint32_t erases;
+} lvgl_littlefs_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Mount the file system of the NOR region and use it as the LV_FS_LITTLEFS_LETTER drive,
+ * it's formatted if it has no valid superblock (the first boot). Reads are copied from
+ * the memory-mapped flash in an lvgl_ospi_read_begin() bracket, programs and erases
+ * briefly leave the memory-mapped mode. */
+lv_result_t
+lvgl_littlefs_init (void);
+
+void
+lvgl_littlefs_get_stats (lvgl_littlefs_stats_t *stats);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_LITTLEFS_H */
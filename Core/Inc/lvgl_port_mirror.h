@@ -0,0 +1,98 @@
+#ifndef __LVGL_PORT_MIRROR_H
+#define __LVGL_PORT_MIRROR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Mirror the display over USB in lvgl_display_init() and start the USB device.
+ * The changed tiles come from lvgl_port_tile_filter, so it needs TILE_FILTER_ENABLE
+ * too. Off by default, lvgl_mirror_rle_line() is built without it. */
+#define MIRROR_ENABLE            0
+
+/* Starts every message, both ways */
+#define MIRROR_MAGIC             0x4D4C       /* "LM" */
+
+/* The changed rectangles of a frame are encoded into one of these and sent by the
+ * mirror task while the next one is filled. A rectangle which doesn't fit is split
+ * into bands of lines. The flush doesn't wait for a buffer: when none is free, the
+ * rest of the frame is dropped and the whole screen is sent again once the host
+ * caught up. They're taken from the LVGL heap while a host is connected, and hold
+ * a run of tiles across the screen at a 3:1 RLE ratio. */
+#define MIRROR_BUF_SIZE          (16 * 1024)
+#define MIRROR_BUF_CNT           2
+
+/* RLE of RGB565: a control byte below 128 is followed by that many +1 literal
+ * pixels, from 128 it's followed by one pixel repeated that many -126 times */
+#define MIRROR_RLE_LITERAL_MAX   128
+#define MIRROR_RLE_REPEAT_MAX    129
+
+/* the longest encoding of a line of `w` pixels */
+#define MIRROR_RLE_LINE_MAX(w)   ((w) * 2 + ((w) + MIRROR_RLE_LITERAL_MAX - 1) / MIRROR_RLE_LITERAL_MAX)
+
+/* a buffer the host doesn't read within this time is dropped */
+#define MIRROR_WRITE_TIMEOUT     500
+
+/* pointer events received from the host and not read by the indev yet */
+#define MIRROR_EVENT_CNT         16
+
+/* Above the LVGL task, so a buffer is sent as soon as it's full. It waits for the
+ * USB interrupts most of the time. */
+#define MIRROR_TASK_PRIORITY     osPriorityAboveNormal
+#define MIRROR_TASK_STACK_SIZE   (1 * 1024)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint32_t frames;              /* sent */
+  uint32_t rects;
+  uint32_t raw_bytes;           /* of the changed rectangles */
+  uint32_t encoded_bytes;       /* sent for them */
+  uint32_t ratio_pct;           /* encoded of raw, computed by get_stats */
+  uint32_t encode_us;
+  uint32_t encode_kbyte_per_s;  /* of raw pixels, computed by get_stats */
+  uint32_t send_us;             /* the mirror task waited for the host */
+  uint32_t dropped;             /* frames, no buffer was free */
+  uint32_t events;              /* pointer events from the host */
+  uint32_t events_dropped;      /* the queue was full */
+} lvgl_mirror_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Send the changed tiles of `disp` to a host viewer (Tools/lvgl_mirror.py) and read
+ * its pointer events with a second pointer indev. RGB565 is RLE encoded, other color
+ * formats are sent as they are. Nothing is encoded while no host is connected. */
+lv_result_t
+lvgl_mirror_init (lv_display_t *disp);
+
+/* Encode a line of `w` RGB565 pixels into `out`, which has room for MIRROR_RLE_LINE_MAX(w).
+ * Returns the bytes written. */
+uint32_t
+lvgl_mirror_rle_line (const uint16_t *px, uint32_t w, uint8_t *out);
+
+void
+lvgl_mirror_get_stats (lvgl_mirror_stats_t *stats);
+
+void
+lvgl_mirror_reset_stats (void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_MIRROR_H */
@@ -0,0 +1,111 @@
+#ifndef __LVGL_PORT_OSPI_H
+#define __LVGL_PORT_OSPI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* OCTOSPI1 maps the MX25LM51245G here */
+#define OSPI_MAP_ADDR            0x90000000
+#define OSPI_FLASH_SIZE          (64 * 1024 * 1024)
+#define OSPI_SECTOR_SIZE         4096
+#define OSPI_PAGE_SIZE           256
+
+/* Longest time the writer keeps the flash out of the memory-mapped mode while a
+ * reader waits, an erase is suspended after it. Program and erase resume for at
+ * least this long, so they make progress between the frames. */
+#define OSPI_SLICE_US            1000
+
+/* Program and erase jobs which can be queued */
+#define OSPI_QUEUE_LEN           8
+
+/* below LVGL, the writer runs between the frames */
+#define OSPI_TASK_PRIORITY       osPriorityBelowNormal
+#define OSPI_TASK_STACK_SIZE     (1 * 1024)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/* Called from the OSPI task when a queued job is done */
+typedef void (*lvgl_ospi_done_cb_t)(lv_result_t res, void *user_data);
+
+typedef struct
+{
+  uint32_t jobs;                /* queued jobs done */
+  uint32_t errors;
+  uint32_t program_bytes;
+  uint32_t program_ms;          /* of the queued programs, time the reads were served included */
+  uint32_t program_kbyte_per_s; /* computed by get_stats */
+  uint32_t erase_bytes;
+  uint32_t erase_ms;
+  uint32_t erase_kbyte_per_s;
+  uint32_t suspends;            /* erases and programs suspended for a reader */
+  uint32_t stall_us_max;        /* longest wait of a reader for the memory-mapped mode */
+} lvgl_ospi_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+void
+lvgl_ospi_init (void);
+
+/* Address of `offset` in the memory-mapped flash */
+const void *
+lvgl_ospi_get_ptr (uint32_t offset);
+
+/* Program and erase leave the memory-mapped mode for their duration and block the
+ * readers (lvgl_ospi_read_begin()), a suspended queued job is completed first.
+ * The DCACHE lines of the changed range are invalidated afterwards. */
+lv_result_t
+lvgl_ospi_program (uint32_t offset, const void *buf, uint32_t size);
+
+/* Erase the OSPI_SECTOR_SIZE aligned range */
+lv_result_t
+lvgl_ospi_erase (uint32_t offset, uint32_t size);
+
+/* Queue a program or erase for the OSPI task, which runs it in slices between the
+ * readers. `buf` has to stay valid until `cb` (may be NULL) is called. Fails if the
+ * queue is full. Readers must not touch the range until it's done. */
+lv_result_t
+lvgl_ospi_program_async (uint32_t offset, const void *buf, uint32_t size,
+                         lvgl_ospi_done_cb_t cb, void *user_data);
+
+lv_result_t
+lvgl_ospi_erase_async (uint32_t offset, uint32_t size, lvgl_ospi_done_cb_t cb, void *user_data);
+
+/* Bracket the accesses to the mapped flash (LVGL rendering, lv_fs reads, ...) by
+ * tasks other than the OSPI task. A running queued job is suspended within
+ * OSPI_SLICE_US. Can be nested. */
+void
+lvgl_ospi_read_begin (void);
+
+void
+lvgl_ospi_read_end (void);
+
+/* True while queued jobs are pending */
+bool
+lvgl_ospi_is_busy (void);
+
+void
+lvgl_ospi_get_stats (lvgl_ospi_stats_t *stats);
+
+void
+lvgl_ospi_reset_stats (void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_OSPI_H */
@@ -0,0 +1,90 @@
+#ifndef __LVGL_PORT_PLANE_H
+#define __LVGL_PORT_PLANE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "main.h"
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* The LTDC blends its 2nd layer over the 1st one at scan-out.
+ * PLANE_MODE_OVERLAY:    LVGL on layer 1, the plane on top of it (status bars, popups, video)
+ * PLANE_MODE_BACKGROUND: the plane on layer 1, LVGL on top of it, LVGL pixels of
+ *                        PLANE_COLOR_KEY are transparent (static wallpapers) */
+#define PLANE_MODE_OVERLAY       0
+#define PLANE_MODE_BACKGROUND    1
+
+#define PLANE_MODE               PLANE_MODE_OVERLAY
+
+/* RGB888 value of the LVGL color which shows the background plane,
+ * e.g. `lv_color_hex(0xFF00FF)` is 0xF81F in RGB565 which the LTDC expands to 0xFF00FF */
+#define PLANE_COLOR_KEY          0xFF00FF
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  const void *buf;           /* pixels of the plane, e.g. in flash, OSPI or SRAM */
+  uint32_t    pixel_format;  /* LTDC_PIXEL_FORMAT_... */
+  uint16_t    w;             /* width of `buf` in pixels */
+  uint16_t    h;             /* height of `buf` in pixels */
+  int32_t     x;             /* position on the screen, may be partly off-screen */
+  int32_t     y;
+  uint8_t     alpha;         /* constant alpha, multiplied with the per-pixel alpha */
+} lvgl_plane_cfg_t;
+
+/* Called from the LTDC interrupt in the vertical blanking after a change was latched */
+typedef void (*lvgl_plane_vblank_cb_t)(void);
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Configure both LTDC layers, has to be called before the LVGL display is created */
+void
+lvgl_plane_init (void);
+
+/* LTDC layer index LVGL has to render to */
+uint32_t
+lvgl_plane_get_lvgl_layer (void);
+
+/* The functions below only update a shadow copy, it's written to the LTDC
+ * in the next vertical blanking, so they are cheap and tear-free */
+void
+lvgl_plane_show (const lvgl_plane_cfg_t *cfg);
+
+void
+lvgl_plane_hide (void);
+
+void
+lvgl_plane_set_pos (int32_t x, int32_t y);
+
+void
+lvgl_plane_set_alpha (uint8_t alpha);
+
+void
+lvgl_plane_set_buf (const void *buf);
+
+/* True while a change is waiting for the vertical blanking */
+bool
+lvgl_plane_is_pending (void);
+
+void
+lvgl_plane_set_vblank_cb (lvgl_plane_vblank_cb_t cb);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_PLANE_H */
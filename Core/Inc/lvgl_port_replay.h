@@ -0,0 +1,154 @@
+#ifndef __LVGL_PORT_REPLAY_H
+#define __LVGL_PORT_REPLAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Starts every event of the command stream */
+#define REPLAY_MAGIC             0x524C       /* "LR" */
+
+/* lvgl_replay_event_t.type, device and host */
+#define REPLAY_EV_POINTER        0x01
+#define REPLAY_EV_KEY            0x02
+#define REPLAY_EV_END            0x03         /* time_ms is the length of the recording */
+
+/* an event with this added is appended to the script instead of applied now */
+#define REPLAY_EV_SCRIPT         0x80
+
+/* commands of the host */
+#define REPLAY_CMD_CLEAR         0x10         /* empty the script */
+#define REPLAY_CMD_PLAY          0x11         /* replay the script, then send the result */
+#define REPLAY_CMD_RECORD        0x12         /* record the input devices into the script */
+#define REPLAY_CMD_STOP          0x13         /* stop the recording and send it, or the replay */
+
+/* sent to the host, followed by `key` bytes of lvgl_replay_result_t */
+#define REPLAY_MSG_RESULT        0x20
+
+/* Events from the command stream not read by an indev yet. The stream has a single
+ * producer, e.g. the USB interrupt. */
+#define REPLAY_QUEUE_CNT         64
+
+/* events the stream can load or record, 16 bytes each */
+#define REPLAY_SCRIPT_MAX        1024
+
+/* input devices recorded at the same time */
+#define REPLAY_RECORD_INDEV_MAX  4
+
+/* The refresh times are counted in buckets of this width for the percentiles, the
+ * last bucket takes the longer ones */
+#define REPLAY_HIST_STEP_US      250
+#define REPLAY_HIST_CNT          128
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/* One event of a recording, a script file or the command stream, little endian */
+typedef struct __attribute__((packed))
+{
+  uint16_t magic;
+  uint8_t  type;
+  uint8_t  pressed;
+  uint32_t time_ms;             /* from the start of the recording */
+  int16_t  x;
+  int16_t  y;
+  uint32_t key;                 /* LV_KEY_... or a character */
+} lvgl_replay_event_t;
+
+typedef struct
+{
+  uint32_t events;              /* applied during the replay */
+  uint32_t frames;              /* refreshed */
+  uint32_t time_ms;
+  uint32_t avg_us;              /* of a refresh, from its start to its end */
+  uint32_t p50_us;
+  uint32_t p95_us;
+  uint32_t max_us;
+} lvgl_replay_result_t;
+
+typedef struct
+{
+  uint32_t events;              /* received on the command stream */
+  uint32_t dropped;             /* the queue was full */
+  uint32_t latency_us;          /* average from the stream to an indev read */
+  uint32_t latency_max_us;
+  uint32_t recorded;
+  uint32_t replays;
+} lvgl_replay_stats_t;
+
+/* a free running counter, e.g. of CPU cycles, lv_tick_get() is used without one */
+typedef uint32_t (*lvgl_replay_clock_cb_t) (void);
+
+/* called by the LVGL task with the bytes for the host */
+typedef void (*lvgl_replay_output_cb_t) (const void *data, uint32_t len);
+
+typedef void (*lvgl_replay_done_cb_t) (const lvgl_replay_result_t *result);
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Create a virtual pointer and keypad on `disp`. They apply the events of the command
+ * stream and of a replay. The module only uses LVGL, so it runs in a host build too,
+ * see Tools/lvgl_replay_host.c. */
+lv_result_t
+lvgl_replay_init (lv_display_t *disp);
+
+/* The refresh times and the latency are taken with `clock_cb`, which counts
+ * `ticks_per_us` in a microsecond */
+void
+lvgl_replay_set_clock (lvgl_replay_clock_cb_t clock_cb, uint32_t ticks_per_us);
+
+void
+lvgl_replay_set_output (lvgl_replay_output_cb_t output_cb);
+
+/* The keypad of the replay, e.g. to set its group */
+lv_indev_t *
+lvgl_replay_get_keypad (void);
+
+/* Take an event of the command stream, from any one task or interrupt. Commands
+ * are carried out by the LVGL task. */
+void
+lvgl_replay_feed (const lvgl_replay_event_t *ev);
+
+/* Replay `cnt` events, which stay valid until `done_cb` is called with the refresh
+ * times. The pointer starts released. */
+lv_result_t
+lvgl_replay_play (const lvgl_replay_event_t *events, uint32_t cnt, lvgl_replay_done_cb_t done_cb);
+
+/* Record what the pointers and keypads read into `buf`, up to `cnt` events */
+lv_result_t
+lvgl_replay_record_start (lvgl_replay_event_t *buf, uint32_t cnt);
+
+/* Returns the events recorded, with a REPLAY_EV_END last */
+uint32_t
+lvgl_replay_record_stop (void);
+
+/* Returns LV_RESULT_INVALID if the refreshes of `run` were more than `tolerance_pct`
+ * slower than those of `baseline` */
+lv_result_t
+lvgl_replay_compare (const lvgl_replay_result_t *run, const lvgl_replay_result_t *baseline,
+                     uint32_t tolerance_pct);
+
+void
+lvgl_replay_get_stats (lvgl_replay_stats_t *stats);
+
+void
+lvgl_replay_reset_stats (void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_REPLAY_H */
@@ -0,0 +1,56 @@
+#ifndef __LVGL_PORT_RETAINED_H
+#define __LVGL_PORT_RETAINED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Build the retained rendering and attach it in lvgl_display_init(). Off by default,
+ * as its cache takes RETAINED_CACHE_SIZE of RAM for good, and
+ * lvgl_retained_add() only exists with it. */
+#define RETAINED_ENABLE          0
+
+/* Memory for the cached subtree textures, least recently drawn ones are evicted first */
+#define RETAINED_CACHE_SIZE      (256 * 1024)
+
+/* Max. number of objects rendered in retained mode */
+#define RETAINED_MAX_CNT         8
+
+/* Refresh periods an object has to stay unchanged before it's cached again */
+#define RETAINED_SETTLE_PERIODS  2
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+void
+lvgl_retained_init (lv_display_t *disp);
+
+/* Render `obj` and its children once into a `cf` (RGB565 or ARGB8888) texture and
+ * blit that texture until something inside the object is invalidated.
+ * The object's local `opa` style is used internally, don't set it on `obj`. */
+lv_result_t
+lvgl_retained_add (lv_obj_t *obj, lv_color_format_t cf);
+
+void
+lvgl_retained_remove (lv_obj_t *obj);
+
+/* Force a re-render of the cached texture, e.g. after a change that doesn't invalidate */
+void
+lvgl_retained_invalidate (lv_obj_t *obj);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_RETAINED_H */
@@ -0,0 +1,39 @@
+#ifndef __LVGL_PORT_ROTATION_H
+#define __LVGL_PORT_ROTATION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Lines of the native short side (MY_DISP_VER_RES wide) in each of the two
+ * render buffers, a rotated frame is flushed in bands of this height */
+#define ROTATION_BUF_LINES       160
+
+/* Size of the GPU command list used for the rotating blits */
+#define ROTATION_CL_SIZE         1024
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Create a display which LVGL renders in the `rotation` orientation in partial mode.
+ * Every flushed band is rotated by GPU2D into the framebuffer of the LTDC layer
+ * `layer_idx`, so the CPU doesn't touch the pixels. RGB565 only. */
+lv_display_t *
+lvgl_rotation_create (lv_display_rotation_t rotation, uint32_t layer_idx);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_ROTATION_H */
@@ -0,0 +1,69 @@
+#ifndef __LVGL_PORT_SD_H
+#define __LVGL_PORT_SD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define SD_BLOCK_SIZE            512
+
+/* NVIC priority of SDMMC1, the completion is signalled to tasks so it can't be
+ * above configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY */
+#define SD_IRQ_PRIORITY          5
+
+/* a transfer which takes longer (ms) is aborted */
+#define SD_TIMEOUT               1000
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Initialize SDMMC1 like MX_SDMMC1_SD_Init() does, but without stopping in
+ * Error_Handler() if no card is inserted. Can be called again, e.g. after a card was inserted. */
+lv_result_t
+lvgl_sd_init (void);
+
+bool
+lvgl_sd_is_ready (void);
+
+/* Capacity in SD_BLOCK_SIZE blocks */
+uint32_t
+lvgl_sd_get_block_count (void);
+
+/* Start reading `cnt` blocks from `lba` with the SDMMC's IDMA to `buf` which has to be
+ * 4 bytes aligned, its result is returned by lvgl_sd_read_wait(). The card isn't locked
+ * in between, another task can use it as soon as the transfer is complete.
+ * One task at a time can have a read started, it fails in the others. */
+lv_result_t
+lvgl_sd_read_start (uint32_t lba, void *buf, uint32_t cnt);
+
+/* True if the transfer started last is complete, lvgl_sd_read_wait() won't block */
+bool
+lvgl_sd_read_is_done (void);
+
+lv_result_t
+lvgl_sd_read_wait (void);
+
+/* lvgl_sd_read_start() + lvgl_sd_read_wait() */
+lv_result_t
+lvgl_sd_read (uint32_t lba, void *buf, uint32_t cnt);
+
+/* Write `cnt` blocks to `lba` with the IDMA, `buf` has to be 4 bytes aligned */
+lv_result_t
+lvgl_sd_write (uint32_t lba, const void *buf, uint32_t cnt);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_SD_H */
@@ -0,0 +1,97 @@
+#ifndef __LVGL_PORT_STREAM_H
+#define __LVGL_PORT_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Max. number of stream charts */
+#define STREAM_MAX_CNT           4
+
+/* Columns of a chart, its content width can't be wider */
+#define STREAM_WIDTH_MAX         800
+
+/* A min/max pair of the first level covers this many samples, a pair of the next
+ * level this many pairs of the level below. A power of 2. */
+#define STREAM_LEVEL_FACTOR      8
+#define STREAM_LEVEL_MAX         10
+
+/* Sweep mode: the columns cleared ahead of the newest one */
+#define STREAM_SWEEP_GAP         8
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum
+{
+  STREAM_MODE_SWEEP,            /* the newest column wraps around, like a patient monitor */
+  STREAM_MODE_SCROLL,           /* the newest column is at the right edge */
+} lvgl_stream_mode_t;
+
+typedef struct
+{
+  uint32_t capacity;            /* samples of history the buffer holds */
+  uint32_t levels;              /* of min/max pairs above the samples */
+  uint32_t samples;             /* taken from the producer */
+  uint32_t overruns;            /* samples the producer overwrote before they were taken */
+  uint32_t columns;             /* computed from the pyramid */
+  uint32_t rebuilds;            /* of all columns, after a zoom, a pan or a resize */
+  uint32_t drawn;               /* columns drawn */
+  uint32_t invalidated_px;      /* area invalidated for new samples */
+} lvgl_stream_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Create a chart of the samples written to it, drawn with the line color of its
+ * main part. `buf` of `size` bytes holds the history and its min/max pyramid, the
+ * history is the largest power of 2 of samples that fits, about 2.6 bytes each. Each
+ * column is drawn as the min/max of its samples, taken from the largest finished
+ * pairs of the pyramid, at most 2 * (STREAM_LEVEL_FACTOR - 1) per level. */
+lv_obj_t *
+lvgl_stream_create (lv_obj_t *parent, void *buf, uint32_t size, lvgl_stream_mode_t mode);
+
+/* The values at the bottom and at the top of the content area */
+void
+lvgl_stream_set_range (lv_obj_t *obj, int32_t min, int32_t max);
+
+/* Show `samples_per_px` samples in each column, ending `columns_back` columns before
+ * the newest one. 0 follows the new samples. */
+void
+lvgl_stream_set_view (lv_obj_t *obj, uint32_t samples_per_px, uint32_t columns_back);
+
+/* The id of the chart for lvgl_stream_write(), -1 if `obj` isn't one. Called by the
+ * LVGL task, which hands it to the producer. */
+int32_t
+lvgl_stream_get_id (lv_obj_t *obj);
+
+/* Append samples to the chart `id`, from one task or interrupt per chart, without
+ * a lock. The LVGL task takes them once per refresh period and invalidates only the
+ * columns they changed in sweep mode. The producer stops before the chart is deleted. */
+void
+lvgl_stream_write (int32_t id, const int16_t *samples, uint32_t cnt);
+
+/* Take the written samples now, e.g. before a chart is read, called by the LVGL task */
+void
+lvgl_stream_update (lv_obj_t *obj);
+
+void
+lvgl_stream_get_stats (lv_obj_t *obj, lvgl_stream_stats_t *stats);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_STREAM_H */
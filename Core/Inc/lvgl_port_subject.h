@@ -0,0 +1,65 @@
+#ifndef __LVGL_PORT_SUBJECT_H
+#define __LVGL_PORT_SUBJECT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* subjects published through the module */
+#define SUBJECT_MAX              64
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint32_t published;           /* by the producers */
+  uint32_t applied;             /* to the subjects, once per refresh at most */
+  uint32_t dropped;             /* replaced by a newer value before a refresh applied them */
+  uint32_t unchanged;           /* applied values the subject already had, not notified */
+  uint32_t refreshes;           /* which applied values */
+  uint32_t latency_us;          /* average from the first publish to the refresh applying it */
+  uint32_t latency_max_us;
+} lvgl_subject_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Apply the published values at the start of each refresh of `disp` */
+void
+lvgl_subject_init (lv_display_t *disp);
+
+/* Publish to `subject`, an integer subject initialized by the LVGL task. Returns the
+ * index to publish with, -1 if SUBJECT_MAX are bound. Called by the LVGL task. */
+int32_t
+lvgl_subject_bind (lv_subject_t *subject);
+
+/* From any task or interrupt, without a lock. Only the latest value before a refresh
+ * is set to the subject, so its observers run once per refresh at most. A fraction
+ * is published scaled, LV_USE_FLOAT is off. */
+void
+lvgl_subject_publish (int32_t idx, int32_t value);
+
+void
+lvgl_subject_get_stats (lvgl_subject_stats_t *stats);
+
+void
+lvgl_subject_reset_stats (void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_SUBJECT_H */
@@ -0,0 +1,81 @@
+#ifndef __LVGL_PORT_TILE_FILTER_H
+#define __LVGL_PORT_TILE_FILTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Attach the filter to the display in lvgl_display_init(), lvgl_port_mirror needs it */
+#define TILE_FILTER_ENABLE       1
+
+/* The screen is divided into tiles of this size, aligned to the top left corner */
+#define TILE_FILTER_TILE_SIZE    32
+
+/* Callbacks which can be added, e.g. a remote display */
+#define TILE_FILTER_CB_MAX       2
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/* A run of changed tiles of a flushed area, in the display's (rotated) coordinates.
+ * `px` is the first pixel of `area`, `stride` the bytes of a line. */
+typedef void (*lvgl_tile_filter_cb_t)(const lv_area_t *area, const uint8_t *px, uint32_t stride,
+                                      void *user_data);
+
+typedef struct
+{
+  uint32_t flushes;
+  uint32_t tiles;               /* parts of tiles flushed */
+  uint32_t tiles_skipped;       /* with the same pixels as the last time */
+  uint32_t bytes_flushed;       /* copied to the framebuffer or passed on */
+  uint32_t bytes_saved;         /* skipped, not copied and not passed on, 0 in the direct mode */
+  uint32_t crc_us;              /* computing the signatures */
+} lvgl_tile_filter_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* CRC each flushed tile with the CRC unit and compare it with the signature of the
+ * last flush of that tile. In the partial render mode unchanged tiles aren't copied
+ * to the framebuffer: on `layer_idx` of the LTDC the filter copies the changed runs
+ * with the DMA2D, with other flushes (e.g. lvgl_rotation_create()) the changed lines
+ * are passed on. The direct mode is flushed as it is, LVGL has rendered to the
+ * framebuffer already, so only the callbacks are filtered and without one the
+ * tiles aren't even checked. */
+lv_result_t
+lvgl_tile_filter_attach (lv_display_t *disp, uint32_t layer_idx);
+
+/* Called with the changed runs of every flush */
+lv_result_t
+lvgl_tile_filter_add_cb (lvgl_tile_filter_cb_t cb, void *user_data);
+
+void
+lvgl_tile_filter_remove_cb (lvgl_tile_filter_cb_t cb, void *user_data);
+
+/* Forget the signatures, when the framebuffer was written by something else than the flush */
+void
+lvgl_tile_filter_invalidate (void);
+
+void
+lvgl_tile_filter_get_stats (lvgl_tile_filter_stats_t *stats);
+
+void
+lvgl_tile_filter_reset_stats (void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_TILE_FILTER_H */
@@ -0,0 +1,38 @@
+#ifndef __LVGL_PORT_TRACE_H
+#define __LVGL_PORT_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* ITM stimulus port of the messages, the SWO console of the debugger shows port 0 */
+#define TRACE_ITM_PORT           0
+
+/* longer messages are cut */
+#define TRACE_LINE_MAX           96
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Print a line to the SWO through the ITM, from any task. LVGL's log may only be used
+ * by the LVGL task (LV_OS_NONE), the port's own tasks report through this. Nothing is
+ * sent while no debugger has enabled the ITM. Not from interrupts. */
+void
+lvgl_trace (const char *format, ...) LV_FORMAT_ATTRIBUTE(1, 2);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_TRACE_H */
@@ -0,0 +1,42 @@
+#ifndef __LVGL_PORT_TRANSITION_H
+#define __LVGL_PORT_TRANSITION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Period of the LVGL timer which finishes a transition once the plane reached its end position */
+#define TRANSITION_POLL_PERIOD   5
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Drop-in for lv_screen_load_anim(). `scr` is rendered once into LVGL's back buffer
+ * which is then slid or faded in on the 2nd LTDC layer, so the intermediate frames
+ * cost no rendering at all. LVGL doesn't refresh while the transition runs.
+ * OVER_LEFT/RIGHT/TOP/BOTTOM and FADE_IN are done on the LTDC, the other
+ * animations (and all of them without direct mode) fall back to lv_screen_load_anim().
+ * Returns LV_RESULT_INVALID if a transition is already running. */
+lv_result_t
+lvgl_transition_load (lv_obj_t *scr, lv_screen_load_anim_t anim_type, uint32_t time,
+                      uint32_t delay, bool auto_del);
+
+bool
+lvgl_transition_is_running (void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_TRANSITION_H */
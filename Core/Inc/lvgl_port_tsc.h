@@ -0,0 +1,43 @@
+#ifndef __LVGL_PORT_TSC_H
+#define __LVGL_PORT_TSC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* GPU2D samples TSC textures in 4x4 pixel blocks from 8 byte aligned addresses */
+#define TSC_BLOCK_SIZE           4
+#define TSC_ALIGN                8
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Register an image decoder for `lv_image_dsc_t`s with a LV_COLOR_FORMAT_NEMA_TSC...
+ * color format (see Tools/tsc_to_lvgl.py). The compressed data isn't decoded, the
+ * descriptor's data is handed to the NemaGFX draw unit as is, e.g. straight from flash. */
+void
+lvgl_tsc_init (void);
+
+bool
+lvgl_tsc_is_tsc (lv_color_format_t cf);
+
+/* Size of the compressed data of a `w` x `h` image in `cf`, 0 if `cf` isn't TSC */
+uint32_t
+lvgl_tsc_get_size (lv_color_format_t cf, uint32_t w, uint32_t h);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_TSC_H */
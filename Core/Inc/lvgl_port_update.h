@@ -0,0 +1,119 @@
+#ifndef __LVGL_PORT_UPDATE_H
+#define __LVGL_PORT_UPDATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+#include "lvgl_port_ospi.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* The bundle has an A and a B slot at the start of the OSPI flash. An update is
+ * written to the slot not in use while the assets of the other one are shown, the
+ * record in the last sector of the slot makes it the active one once it's verified. */
+#define UPDATE_SLOT_SIZE         (16 * 1024 * 1024)
+#define UPDATE_SLOT_CNT          2
+#define UPDATE_RECORD_OFFSET     (UPDATE_SLOT_SIZE - OSPI_SECTOR_SIZE)
+#define UPDATE_MAX_SIZE          UPDATE_RECORD_OFFSET
+
+/* SHA-256 */
+#define UPDATE_DIGEST_SIZE       32
+
+/* The image is received into these, a full chunk is hashed by the HASH's DMA and
+ * queued for the OSPI task while the next one is received */
+#define UPDATE_CHUNK_SIZE        4096
+#define UPDATE_CHUNK_CNT         4
+
+/* The UART transport, lvgl_update_uart_start() */
+#define UPDATE_UART              huart1
+#define UPDATE_UART_IRQn         USART1_IRQn
+#define UPDATE_UART_BAUDRATE     921600
+#define UPDATE_UART_MAGIC        0x5055564C   /* "LVUP" */
+
+/* the update is aborted if the host doesn't send for that long */
+#define UPDATE_UART_TIMEOUT      2000
+
+/* NVIC priority of the UART, the reception is signalled to the task so it can't be
+ * above configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY */
+#define UPDATE_UART_IRQ_PRIORITY 5
+
+#define UPDATE_TASK_PRIORITY     osPriorityBelowNormal
+#define UPDATE_TASK_STACK_SIZE   (1 * 1024)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint32_t updates;             /* switched to */
+  uint32_t failures;            /* aborted, or the digest didn't match */
+  uint32_t bytes;               /* of the last update */
+  uint32_t ms;                  /* of the last update, from begin to the switch */
+  uint32_t kbyte_per_s;         /* computed by get_stats */
+  uint32_t wait_ms;             /* writes waited for a chunk, the flash was slower than the transport */
+  uint32_t hash_wait_us;        /* waited for the HASH, ~0 as it's much faster than the flash */
+} lvgl_update_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Find the active slot, the one with the newest complete record, or the 1st slot
+ * if none has one (a bundle flashed with the programmer). Its bundle is the one in use
+ * until the next boot. */
+void
+lvgl_update_init (void);
+
+/* The bundle of the active slot, for lvgl_bundle_init() at boot */
+const void *
+lvgl_update_get_bundle (void);
+
+uint32_t
+lvgl_update_get_active_slot (void);
+
+/* Start an update of `size` bytes with the SHA-256 `digest` into the inactive slot.
+ * It's erased by the OSPI task in the background, so the transport can start right away.
+ * Refused after an update until the reboot, the inactive slot then holds the bundle in use. */
+lv_result_t
+lvgl_update_begin (uint32_t size, const uint8_t digest[UPDATE_DIGEST_SIZE]);
+
+/* The next `size` bytes of the image, in pieces of any size. Blocks while all the
+ * chunks wait for the flash. */
+lv_result_t
+lvgl_update_write (const void *data, uint32_t size);
+
+/* Wait for the flash, check the digest and the bundle, then switch the active slot
+ * by programming its record. The new bundle is used from the next boot: images and
+ * strings of the old one are used in place, so it isn't switched while running. */
+lv_result_t
+lvgl_update_finish (void);
+
+/* Stop an update, the active slot is kept */
+void
+lvgl_update_abort (void);
+
+/* Receive updates on UPDATE_UART in a task, Tools/lvgl_update.py sends them.
+ * Called after MX_USART1_UART_Init() and MX_HASH_Init(). */
+void
+lvgl_update_uart_start (void);
+
+void
+lvgl_update_get_stats (lvgl_update_stats_t *stats);
+
+void
+lvgl_update_reset_stats (void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_UPDATE_H */
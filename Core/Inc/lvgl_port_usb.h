@@ -0,0 +1,65 @@
+#ifndef __LVGL_PORT_USB_H
+#define __LVGL_PORT_USB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* pid.codes test VID/PID, replace them with an own pair for products */
+#define USB_VID                  0x1209
+#define USB_PID                  0x0001
+
+#define USB_MANUFACTURER_STRING  "Riverdi"
+#define USB_PRODUCT_STRING       "LVGL STM32 Embedded Display"
+
+/* A vendor specific interface with a bulk OUT and a bulk IN endpoint */
+#define USB_EP_OUT               0x01
+#define USB_EP_IN                0x81
+
+/* received into a buffer of this size, a host transfer may take several */
+#define USB_RX_SIZE              512
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/* Called in the interrupt with each packet received on USB_EP_OUT */
+typedef void (*lvgl_usb_rx_cb_t)(const uint8_t *data, uint32_t size);
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Start the device on hpcd_USB_OTG_HS, called after MX_USB_OTG_HS_USB_Init().
+ * The host can talk to it with libusb, without a driver on Linux and macOS. */
+void
+lvgl_usb_start (void);
+
+/* The host configured the device, the bulk endpoints are open */
+bool
+lvgl_usb_is_configured (void);
+
+void
+lvgl_usb_set_rx_cb (lvgl_usb_rx_cb_t cb);
+
+/* Send `size` bytes on USB_EP_IN as one transfer, ended with a zero length packet
+ * if needed. Blocks until the host has read them or `timeout` ms passed, only one
+ * task may write. `data` is read by the interrupt while it blocks. */
+lv_result_t
+lvgl_usb_write (const void *data, uint32_t size, uint32_t timeout);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_USB_H */
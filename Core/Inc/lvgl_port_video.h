@@ -0,0 +1,97 @@
+#ifndef __LVGL_PORT_VIDEO_H
+#define __LVGL_PORT_VIDEO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Blocks of one SD read, two of these buffers are in flight: one is parsed and
+ * decoded while the SDMMC's DMA fills the other */
+#define VIDEO_READ_BLOCKS        16
+
+/* Fragments the AVI file may have on the card, copy a more fragmented file again */
+#define VIDEO_FRAGMENTS_MAX      32
+
+#define VIDEO_TASK_PRIORITY      osPriorityNormal
+#define VIDEO_TASK_STACK_SIZE    (4 * 1024)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/* Returns the media position in ms, e.g. the audio clock. Frames are shown when
+ * it reaches their time stamp, so the video follows it. */
+typedef uint32_t (*lvgl_video_clock_cb_t)(void);
+
+typedef struct
+{
+  const char           *path;           /* AVI file on the SD card, e.g. "S:clip.avi" */
+  void                 *frame_buf[2];   /* RGB565, width * height * 2 bytes each, 4 bytes aligned */
+  uint32_t              frame_buf_size;
+  int32_t               x;              /* position of the video on the screen */
+  int32_t               y;
+  bool                  loop;
+  lvgl_video_clock_cb_t clock_cb;       /* NULL: the system tick from the first frame on */
+} lvgl_video_cfg_t;
+
+typedef struct
+{
+  uint32_t w;
+  uint32_t h;
+  uint32_t frame_period_us;   /* from the AVI header */
+  uint32_t decoded;
+  uint32_t shown;
+  uint32_t dropped;           /* skipped because they were late by a frame period or more */
+  uint32_t underruns;         /* the decoder had to wait for the SD card */
+  uint32_t errors;            /* undecodable frames and failed reads */
+  uint32_t decode_us;         /* last frame, JPEG decoding with the reads it waited for */
+  uint32_t decode_us_max;
+  int32_t  av_offset_ms;      /* last frame shown, after (+) or before (-) its time stamp */
+  int32_t  av_offset_max_ms;
+} lvgl_video_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Play an MJPEG AVI on the LTDC plane of lvgl_port_plane from a task of its own.
+ * Frames are baseline JPEGs with Huffman tables (e.g. `ffmpeg -c:v mjpeg -pix_fmt yuvj420p`),
+ * other streams (audio) are skipped. The file's clusters are looked up through FatFs here,
+ * then read with the SDMMC's DMA directly, so it mustn't be written while it plays.
+ * `cfg` is copied, the frame buffers are in use until lvgl_video_is_playing() returns false.
+ * Returns LV_RESULT_INVALID if a video is already playing or the file can't be opened. */
+lv_result_t
+lvgl_video_play (const lvgl_video_cfg_t *cfg);
+
+/* Stop after the current frame and hide the plane */
+void
+lvgl_video_stop (void);
+
+bool
+lvgl_video_is_playing (void);
+
+/* Time stamp of the last frame shown in ms */
+uint32_t
+lvgl_video_get_pos (void);
+
+void
+lvgl_video_get_stats (lvgl_video_stats_t *stats);
+
+void
+lvgl_video_reset_stats (void);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_VIDEO_H */
@@ -0,0 +1,47 @@
+#ifndef __LVGL_PORT_ZIMG_H
+#define __LVGL_PORT_ZIMG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl/lvgl.h"
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint32_t compressed_size;     /* bytes read from flash */
+  uint32_t decompressed_size;   /* bytes written to the decoded buffer */
+  uint32_t cycles;              /* CPU cycles of the decode, DWT->CYCCNT */
+  uint32_t time_us;
+  uint32_t kbyte_per_s;         /* output throughput */
+} lvgl_zimg_bench_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/* Register the decoder of RLE and LZ4 compressed `lv_image_dsc_t`s (LVGLImage.py
+ * `--compress RLE/LZ4`). The data is read in place from internal or memory-mapped
+ * OSPI flash and decompressed straight into the buffer stored in the image cache,
+ * in the stride the GPU samples, without an intermediate copy. */
+void
+lvgl_zimg_init (void);
+
+/* Decode `src` once bypassing the cache and measure it, to choose per asset
+ * between the compression ratio and the first draw latency */
+lv_result_t
+lvgl_zimg_benchmark (const lv_image_dsc_t *src, lvgl_zimg_bench_t *bench);
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /* __LVGL_PORT_ZIMG_H */
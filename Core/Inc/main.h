@@ -53,6 +53,7 @@ extern "C" {
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
+void Deferred_Init(void);
 
 /* USER CODE END EFP */
 
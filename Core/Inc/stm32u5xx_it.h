@@ -59,6 +59,7 @@ void GPU2D_IRQHandler(void);
 void GPU2D_ER_IRQHandler(void);
 void LTDC_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void SDMMC1_IRQHandler(void);
 
 /* USER CODE END EFP */
 
@@ -42,6 +42,9 @@ extern UART_HandleTypeDef huart6;
 
 /* USER CODE BEGIN Private defines */
 
+extern DMA_HandleTypeDef handle_GPDMA1_Channel6;
+extern DMA_HandleTypeDef handle_GPDMA1_Channel5;
+
 /* USER CODE END Private defines */
 
 void MX_USART1_UART_Init(void);
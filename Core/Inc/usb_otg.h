@@ -34,6 +34,8 @@ extern "C" {
 
 /* USER CODE BEGIN Private defines */
 
+extern PCD_HandleTypeDef hpcd_USB_OTG_HS;
+
 /* USER CODE END Private defines */
 
 void MX_USB_OTG_HS_USB_Init(void);
@@ -25,6 +25,13 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "lvgl/lvgl.h"
+#include "lvgl/demos/lv_demos.h"
+#include "lvgl_port_boot.h"
+#include "lvgl_port_ospi.h"
+#include "lvgl_port_update.h"
+#include "lvgl_port_usb.h"
+#include "lvgl_port_mirror.h"
+#include "lvgl_port_capture.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -50,6 +57,12 @@ const osThreadAttr_t lvglTimer_attributes = {
   .priority = (osPriority_t) osPriorityNormal,
   .stack_size = 16* 1024
 };
+osThreadId_t deferredInitHandle;
+const osThreadAttr_t deferredInit_attributes = {
+  .name = "deferredInit",
+  .priority = (osPriority_t) osPriorityLow,
+  .stack_size = 2 * 1024
+};
 /* USER CODE END Variables */
 /* Definitions for defaultTask */
 osThreadId_t defaultTaskHandle;
@@ -62,6 +75,7 @@ const osThreadAttr_t defaultTask_attributes = {
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN FunctionPrototypes */
 void LVGLTimer(void *argument);
+void DeferredInit(void *argument);
 /* USER CODE END FunctionPrototypes */
 
 void StartDefaultTask(void *argument);
@@ -144,6 +158,7 @@ void MX_FREERTOS_Init(void) {
   /* USER CODE BEGIN RTOS_THREADS */
   /* add threads, ... */
   lvglTimerHandle = osThreadNew(LVGLTimer, NULL, &lvglTimer_attributes);
+  deferredInitHandle = osThreadNew(DeferredInit, NULL, &deferredInit_attributes);
   /* USER CODE END RTOS_THREADS */
 
   /* USER CODE BEGIN RTOS_EVENTS */
@@ -174,11 +189,50 @@ void StartDefaultTask(void *argument)
 /* LVGL timer for tasks */
 void LVGLTimer(void *argument)
 {
+  lvgl_boot_mark("kernel");
+
+  /* LVGL reads fonts and images from the OSPI flash, flash writes are
+   * suspended meanwhile and run while this task sleeps */
+  lvgl_ospi_read_begin();
+
+  /* lvgl demo */
+  //  lv_demo_widgets();
+  //lv_demo_music();
+  lv_demo_benchmark();
+  lvgl_boot_mark("ui");
+
+  lvgl_ospi_read_end();
+
   for(;;)
   {
+    lvgl_ospi_read_begin();
     lv_timer_handler();
+    lvgl_ospi_read_end();
     osDelay(1);
   }
 }
+
+/* Peripherals which aren't needed for the first frame, they are initialized
+ * while the LVGL task waits */
+void DeferredInit(void *argument)
+{
+  Deferred_Init();
+  lvgl_boot_mark("deferred");
+
+  /* bundle updates are received once the UART and the HASH are up */
+  lvgl_update_uart_start();
+
+#if MIRROR_ENABLE
+  /* the mirror's host can connect once the USB device is up */
+  lvgl_usb_start();
+#endif
+
+#if CAPTURE_ENABLE
+  /* screenshots on the service port, by its TX DMA */
+  lvgl_capture_uart_start();
+#endif
+
+  osThreadExit();
+}
 /* USER CODE END Application */
 
@@ -22,6 +22,9 @@
 
 /* USER CODE BEGIN 0 */
 
+/* feeds the update images to the HASH, lvgl_port_update.c */
+DMA_HandleTypeDef handle_GPDMA1_Channel7;
+
 /* USER CODE END 0 */
 
 HASH_HandleTypeDef hhash;
@@ -37,7 +40,7 @@ void MX_HASH_Init(void)
   /* USER CODE BEGIN HASH_Init 1 */
 
   /* USER CODE END HASH_Init 1 */
-  hhash.Init.DataType = HASH_DATATYPE_32B;
+  hhash.Init.DataType = HASH_DATATYPE_8B;
   if (HAL_HASH_Init(&hhash) != HAL_OK)
   {
     Error_Handler();
@@ -57,7 +60,32 @@ void HAL_HASH_MspInit(HASH_HandleTypeDef* hashHandle)
     /* HASH clock enable */
     __HAL_RCC_HASH_CLK_ENABLE();
   /* USER CODE BEGIN HASH_MspInit 1 */
-
+    __HAL_RCC_GPDMA1_CLK_ENABLE();
+
+    /* HASH_IN: words from the RAM to DIN, the HASH swaps the bytes (8-bit data type) */
+    handle_GPDMA1_Channel7.Instance = GPDMA1_Channel7;
+    handle_GPDMA1_Channel7.Init.Request = GPDMA1_REQUEST_HASH_IN;
+    handle_GPDMA1_Channel7.Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
+    handle_GPDMA1_Channel7.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    handle_GPDMA1_Channel7.Init.SrcInc = DMA_SINC_INCREMENTED;
+    handle_GPDMA1_Channel7.Init.DestInc = DMA_DINC_FIXED;
+    handle_GPDMA1_Channel7.Init.SrcDataWidth = DMA_SRC_DATAWIDTH_WORD;
+    handle_GPDMA1_Channel7.Init.DestDataWidth = DMA_DEST_DATAWIDTH_WORD;
+    handle_GPDMA1_Channel7.Init.Priority = DMA_LOW_PRIORITY_HIGH_WEIGHT;
+    handle_GPDMA1_Channel7.Init.SrcBurstLength = 1;
+    handle_GPDMA1_Channel7.Init.DestBurstLength = 1;
+    handle_GPDMA1_Channel7.Init.TransferAllocatedPort = DMA_SRC_ALLOCATED_PORT0|DMA_DEST_ALLOCATED_PORT0;
+    handle_GPDMA1_Channel7.Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
+    handle_GPDMA1_Channel7.Init.Mode = DMA_NORMAL;
+    if (HAL_DMA_Init(&handle_GPDMA1_Channel7) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(hashHandle, hdmain, handle_GPDMA1_Channel7);
+
+    HAL_NVIC_SetPriority(GPDMA1_Channel7_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(GPDMA1_Channel7_IRQn);
   /* USER CODE END HASH_MspInit 1 */
 }
 
@@ -70,7 +98,8 @@ void HAL_HASH_MspDeInit(HASH_HandleTypeDef* hashHandle)
     /* Peripheral clock disable */
     __HAL_RCC_HASH_CLK_DISABLE();
   /* USER CODE BEGIN HASH_MspDeInit 1 */
-
+    HAL_DMA_DeInit(hashHandle->hdmain);
+    HAL_NVIC_DisableIRQ(GPDMA1_Channel7_IRQn);
   /* USER CODE END HASH_MspDeInit 1 */
 }
 
@@ -0,0 +1,209 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_boot.h"
+#include "lvgl_port_plane.h"
+#include "main.h"
+#include "ltdc.h"
+#include "dma2d.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define BOOT_CYCLES_TO_US(c)  ((uint32_t)((uint64_t)(c) * 1000000 / SystemCoreClock))
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void
+boot_set_fb (uint32_t layer_idx, uint32_t addr, bool immediate);
+
+static void
+boot_refr_ready_cb (lv_event_t *e);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/* Core/Src/boot_splash.c by default, without an image the framebuffer is only cleared */
+extern const lv_image_dsc_t BOOT_SPLASH_IMAGE __attribute__((weak));
+
+static lvgl_boot_report_t report;
+static uint32_t start_cycles;
+
+/* the splash pixels while the LTDC scans them out, 0 once LVGL is shown */
+static uint32_t splash_addr;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_boot_init (void)
+{
+  DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  start_cycles = DWT->CYCCNT;
+}
+
+void
+lvgl_boot_mark (const char *name)
+{
+  uint32_t us = BOOT_CYCLES_TO_US(DWT->CYCCNT - start_cycles);
+  uint32_t primask = __get_PRIMASK();
+
+  /* the init task and the LVGL task may mark at the same time */
+  __disable_irq();
+  if (report.stage_cnt < BOOT_STAGE_MAX)
+    {
+      report.stages[report.stage_cnt].name = name;
+      report.stages[report.stage_cnt].us = us;
+      report.stage_cnt++;
+    }
+  __set_PRIMASK(primask);
+}
+
+void
+lvgl_boot_splash (void)
+{
+  LTDC_LayerCfgTypeDef *layer = &hltdc.LayerCfg[0];
+  const lv_image_dsc_t *img = &BOOT_SPLASH_IMAGE;
+
+  if (img != NULL && img->header.cf == LV_COLOR_FORMAT_RGB565 &&
+      layer->PixelFormat == LTDC_PIXEL_FORMAT_RGB565 &&
+      img->header.w == layer->ImageWidth && img->header.h == layer->ImageHeight &&
+      img->header.stride == layer->ImageWidth * 2)
+    {
+      /* scanned out from the flash as it is, LayerCfg keeps the framebuffer
+       * LVGL renders to */
+      splash_addr = (uint32_t)img->data;
+      boot_set_fb(0, splash_addr, true);
+      return;
+    }
+
+  /* before the kernel runs the DMA2D isn't shared yet */
+  hdma2d.Init.Mode = DMA2D_R2M;
+  hdma2d.Init.ColorMode = DMA2D_OUTPUT_RGB565;
+  hdma2d.Init.OutputOffset = 0;
+  if (HAL_DMA2D_Init(&hdma2d) == HAL_OK &&
+      HAL_DMA2D_Start(&hdma2d, BOOT_SPLASH_COLOR, layer->FBStartAdress,
+                      layer->ImageWidth, layer->ImageHeight) == HAL_OK)
+    {
+      HAL_DMA2D_PollForTransfer(&hdma2d, 100);
+    }
+
+  /* a smaller image, e.g. a logo, is copied to the middle of the cleared framebuffer */
+  if (img != NULL && img->header.cf == LV_COLOR_FORMAT_RGB565 &&
+      layer->PixelFormat == LTDC_PIXEL_FORMAT_RGB565 &&
+      img->header.w <= layer->ImageWidth && img->header.h <= layer->ImageHeight)
+    {
+      uint32_t x = (layer->ImageWidth - img->header.w) / 2;
+      uint32_t y = (layer->ImageHeight - img->header.h) / 2;
+
+      hdma2d.Init.Mode = DMA2D_M2M;
+      hdma2d.Init.OutputOffset = layer->ImageWidth - img->header.w;
+      hdma2d.LayerCfg[1].InputColorMode = DMA2D_INPUT_RGB565;
+      hdma2d.LayerCfg[1].InputOffset = img->header.stride / 2 - img->header.w;
+      hdma2d.LayerCfg[1].AlphaMode = DMA2D_NO_MODIF_ALPHA;
+      hdma2d.LayerCfg[1].InputAlpha = 0xFF;
+      if (HAL_DMA2D_Init(&hdma2d) == HAL_OK && HAL_DMA2D_ConfigLayer(&hdma2d, 1) == HAL_OK &&
+          HAL_DMA2D_Start(&hdma2d, (uint32_t)img->data,
+                          layer->FBStartAdress + (y * layer->ImageWidth + x) * 2,
+                          img->header.w, img->header.h) == HAL_OK)
+        {
+          HAL_DMA2D_PollForTransfer(&hdma2d, 100);
+        }
+    }
+
+  /* LVGL expects the memory to memory mode of MX_DMA2D_Init() */
+  MX_DMA2D_Init();
+}
+
+void
+lvgl_boot_watch (lv_display_t *disp)
+{
+  /* lvgl_plane_init() may have moved LVGL to the other layer */
+  if (splash_addr != 0)
+    {
+      boot_set_fb(lvgl_plane_get_lvgl_layer(), splash_addr, true);
+    }
+
+  lv_display_add_event_cb(disp, boot_refr_ready_cb, LV_EVENT_REFR_READY, NULL);
+}
+
+void
+lvgl_boot_get_report (lvgl_boot_report_t *report_out)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  *report_out = report;
+  __set_PRIMASK(primask);
+}
+
+void
+lvgl_boot_log (void)
+{
+  lvgl_boot_report_t r;
+  uint32_t prev = 0;
+  uint32_t i;
+
+  lvgl_boot_get_report(&r);
+
+  for (i = 0; i < r.stage_cnt; i++)
+    {
+      LV_LOG_USER("boot: %-12s %7u us (+%u us)", r.stages[i].name,
+                  (unsigned)r.stages[i].us, (unsigned)(r.stages[i].us - prev));
+      prev = r.stages[i].us;
+    }
+  LV_LOG_USER("boot: time to first frame %u us", (unsigned)r.first_frame_us);
+
+  LV_UNUSED(prev);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void
+boot_set_fb (uint32_t layer_idx,
+             uint32_t addr,
+             bool     immediate)
+{
+  LTDC_LAYER(&hltdc, layer_idx)->CFBAR = addr;
+
+  if (immediate)
+    {
+      __HAL_LTDC_RELOAD_IMMEDIATE_CONFIG(&hltdc);
+    }
+  else
+    {
+      __HAL_LTDC_RELOAD_CONFIG(&hltdc);
+    }
+}
+
+static void
+boot_refr_ready_cb (lv_event_t *e)
+{
+  uint32_t layer_idx = lvgl_plane_get_lvgl_layer();
+
+  /* rendered, the direct mode flush shows it at the next vblank */
+  report.first_frame_us = BOOT_CYCLES_TO_US(DWT->CYCCNT - start_cycles);
+  lvgl_boot_mark("first frame");
+
+  /* the direct mode flush has switched from the splash already, the partial and
+   * rotated flushes write to the framebuffer CubeMX configured, which is complete now */
+  if (splash_addr != 0 && LTDC_LAYER(&hltdc, layer_idx)->CFBAR == splash_addr)
+    {
+      boot_set_fb(layer_idx, hltdc.LayerCfg[layer_idx].FBStartAdress, false);
+    }
+  splash_addr = 0;
+
+  lv_display_remove_event_cb_with_user_data(lv_event_get_target(e), boot_refr_ready_cb, NULL);
+
+  lvgl_boot_log();
+}
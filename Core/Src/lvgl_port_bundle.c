@@ -0,0 +1,444 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_bundle.h"
+#include "lvgl/src/draw/lv_image_decoder_private.h"
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define BUNDLE_FNV_PRIME    0x01000193
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  const lvgl_bundle_entry_t *entry;
+  uint32_t                   pos;
+} bundle_file_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static uint32_t
+bundle_hash (const char *name, uint32_t seed);
+
+static const char *
+bundle_strip (const char *path);
+
+static bool
+bundle_check (const uint8_t *base);
+
+static void *
+bundle_open_cb (lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode);
+
+static lv_fs_res_t
+bundle_close_cb (lv_fs_drv_t *drv, void *file_p);
+
+static lv_fs_res_t
+bundle_read_cb (lv_fs_drv_t *drv, void *file_p, void *buf, uint32_t btr, uint32_t *br);
+
+static lv_fs_res_t
+bundle_seek_cb (lv_fs_drv_t *drv, void *file_p, uint32_t pos, lv_fs_whence_t whence);
+
+static lv_fs_res_t
+bundle_tell_cb (lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p);
+
+static lv_result_t
+bundle_info_cb (lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc, lv_image_header_t *header);
+
+static lv_result_t
+bundle_open_image_cb (lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc);
+
+static void
+bundle_close_image_cb (lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static const uint8_t *bundle;
+static const lvgl_bundle_header_t *header;
+
+static lv_fs_drv_t fs_drv;
+static bool registered;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_result_t
+lvgl_bundle_init (const void *base)
+{
+  lv_image_decoder_t *decoder;
+
+  if (!registered)
+    {
+      lv_fs_drv_init(&fs_drv);
+      fs_drv.letter = BUNDLE_LETTER;
+      fs_drv.open_cb = bundle_open_cb;
+      fs_drv.close_cb = bundle_close_cb;
+      fs_drv.read_cb = bundle_read_cb;
+      fs_drv.seek_cb = bundle_seek_cb;
+      fs_drv.tell_cb = bundle_tell_cb;
+      lv_fs_drv_register(&fs_drv);
+
+      decoder = lv_image_decoder_create();
+      lv_image_decoder_set_info_cb(decoder, bundle_info_cb);
+      lv_image_decoder_set_open_cb(decoder, bundle_open_image_cb);
+      lv_image_decoder_set_close_cb(decoder, bundle_close_image_cb);
+
+      registered = true;
+    }
+
+  bundle = NULL;
+  header = NULL;
+
+  if (!bundle_check(base))
+    {
+      LV_LOG_WARN("no asset bundle at %p", base);
+      return LV_RESULT_INVALID;
+    }
+
+  bundle = base;
+  header = base;
+
+  return LV_RESULT_OK;
+}
+
+bool
+lvgl_bundle_is_valid (const void *base)
+{
+  return bundle_check(base);
+}
+
+const lvgl_bundle_entry_t *
+lvgl_bundle_find (const char *name)
+{
+  const uint32_t *seeds;
+  const lvgl_bundle_entry_t *entry;
+  uint32_t seed;
+
+  if (header == NULL)
+    {
+      return NULL;
+    }
+
+  /* hash and displace: the 1st hash selects a seed which places the bucket's
+   * names without collision, so the 2nd hash is the index of the entry */
+  seeds = (const uint32_t *)(bundle + header->seeds_off);
+  seed = seeds[bundle_hash(name, 0) % header->count];
+  entry = (const lvgl_bundle_entry_t *)(bundle + header->entries_off) +
+          bundle_hash(name, seed) % header->count;
+
+  /* any name lands on an entry, it's the asset only if the name matches */
+  if (lv_strcmp((const char *)bundle + header->names_off + entry->name_off, name) != 0)
+    {
+      return NULL;
+    }
+
+  return entry;
+}
+
+const void *
+lvgl_bundle_get_data (const lvgl_bundle_entry_t *entry)
+{
+  return bundle + entry->data_off;
+}
+
+lv_result_t
+lvgl_bundle_get_image (const char     *name,
+                       lv_image_dsc_t *dsc)
+{
+  const lvgl_bundle_entry_t *entry = lvgl_bundle_find(name);
+
+  if (entry == NULL || entry->type != BUNDLE_TYPE_IMAGE)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  lv_memzero(dsc, sizeof(*dsc));
+  dsc->header.magic = LV_IMAGE_HEADER_MAGIC;
+  dsc->header.cf = entry->cf;
+  dsc->header.flags = entry->flags;
+  dsc->header.w = entry->w;
+  dsc->header.h = entry->h;
+  dsc->header.stride = entry->stride;
+  dsc->data_size = entry->data_size;
+  dsc->data = lvgl_bundle_get_data(entry);
+
+  return LV_RESULT_OK;
+}
+
+const char *
+lvgl_bundle_get_string (const char *name)
+{
+  const lvgl_bundle_entry_t *entry = lvgl_bundle_find(name);
+
+  if (entry == NULL || entry->type != BUNDLE_TYPE_STRING)
+    {
+      return NULL;
+    }
+
+  return lvgl_bundle_get_data(entry);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static uint32_t
+bundle_hash (const char *name,
+             uint32_t    seed)
+{
+  /* FNV-1a with the seed mixed into the offset basis, Tools/lvgl_bundle.py has the same */
+  uint32_t h = 0x811C9DC5 ^ seed;
+
+  while (*name != '\0')
+    {
+      h ^= (uint8_t)*name++;
+      h *= BUNDLE_FNV_PRIME;
+    }
+
+  return h;
+}
+
+static const char *
+bundle_strip (const char *path)
+{
+  while (*path == '/')
+    {
+      path++;
+    }
+
+  return path;
+}
+
+static bool
+bundle_check (const uint8_t *base)
+{
+  const lvgl_bundle_header_t *hdr = (const lvgl_bundle_header_t *)base;
+  const lvgl_bundle_entry_t *entries;
+  const uint8_t *names;
+  uint32_t names_size;
+  uint32_t i;
+
+  if (hdr->magic != BUNDLE_MAGIC || hdr->version != BUNDLE_VERSION ||
+      hdr->size > BUNDLE_MAX_SIZE || hdr->count == 0 ||
+      hdr->align < BUNDLE_MIN_ALIGN || (hdr->align & (hdr->align - 1)) != 0 ||
+      (uintptr_t)base % hdr->align != 0)
+    {
+      return false;
+    }
+
+  /* the seeds, the entries and the names follow each other, the count is compared
+   * with the room between two of them, so no offset plus count can overflow */
+  if (hdr->seeds_off < sizeof(lvgl_bundle_header_t) || hdr->seeds_off % sizeof(uint32_t) != 0 ||
+      hdr->entries_off < hdr->seeds_off || hdr->entries_off % sizeof(uint32_t) != 0 ||
+      hdr->names_off < hdr->entries_off || hdr->names_off >= hdr->size ||
+      hdr->count > (hdr->entries_off - hdr->seeds_off) / sizeof(uint32_t) ||
+      hdr->count > (hdr->names_off - hdr->entries_off) / sizeof(lvgl_bundle_entry_t))
+    {
+      return false;
+    }
+
+  /* the entries are checked once, so lookups can trust them */
+  entries = (const lvgl_bundle_entry_t *)(base + hdr->entries_off);
+  names = base + hdr->names_off;
+  names_size = hdr->size - hdr->names_off;
+
+  for (i = 0; i < hdr->count; i++)
+    {
+      if (entries[i].name_off >= names_size ||
+          memchr(names + entries[i].name_off, '\0', names_size - entries[i].name_off) == NULL ||
+          entries[i].data_off > hdr->size || entries[i].data_size > hdr->size - entries[i].data_off ||
+          entries[i].data_off % hdr->align != 0)
+        {
+          return false;
+        }
+
+      /* strings are handed out as C strings */
+      if (entries[i].type == BUNDLE_TYPE_STRING &&
+          (entries[i].data_size == 0 || base[entries[i].data_off + entries[i].data_size - 1] != '\0'))
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+static void *
+bundle_open_cb (lv_fs_drv_t *drv,
+                const char  *path,
+                lv_fs_mode_t mode)
+{
+  const lvgl_bundle_entry_t *entry;
+  bundle_file_t *file;
+
+  LV_UNUSED(drv);
+
+  if (mode != LV_FS_MODE_RD)
+    {
+      return NULL;
+    }
+
+  entry = lvgl_bundle_find(bundle_strip(path));
+  if (entry == NULL)
+    {
+      return NULL;
+    }
+
+  file = lv_malloc(sizeof(bundle_file_t));
+  if (file == NULL)
+    {
+      return NULL;
+    }
+
+  file->entry = entry;
+  file->pos = 0;
+
+  return file;
+}
+
+static lv_fs_res_t
+bundle_close_cb (lv_fs_drv_t *drv,
+                 void        *file_p)
+{
+  LV_UNUSED(drv);
+
+  lv_free(file_p);
+
+  return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t
+bundle_read_cb (lv_fs_drv_t *drv,
+                void        *file_p,
+                void        *buf,
+                uint32_t     btr,
+                uint32_t    *br)
+{
+  bundle_file_t *file = file_p;
+
+  LV_UNUSED(drv);
+
+  *br = LV_MIN(btr, file->entry->data_size - file->pos);
+  lv_memcpy(buf, bundle + file->entry->data_off + file->pos, *br);
+  file->pos += *br;
+
+  return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t
+bundle_seek_cb (lv_fs_drv_t   *drv,
+                void          *file_p,
+                uint32_t       pos,
+                lv_fs_whence_t whence)
+{
+  bundle_file_t *file = file_p;
+
+  LV_UNUSED(drv);
+
+  switch (whence)
+    {
+      case LV_FS_SEEK_CUR:
+        pos += file->pos;
+        break;
+      case LV_FS_SEEK_END:
+        pos += file->entry->data_size;
+        break;
+      default:
+        break;
+    }
+
+  if (pos > file->entry->data_size)
+    {
+      return LV_FS_RES_INV_PARAM;
+    }
+  file->pos = pos;
+
+  return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t
+bundle_tell_cb (lv_fs_drv_t *drv,
+                void        *file_p,
+                uint32_t    *pos_p)
+{
+  bundle_file_t *file = file_p;
+
+  LV_UNUSED(drv);
+
+  *pos_p = file->pos;
+
+  return LV_FS_RES_OK;
+}
+
+static lv_result_t
+bundle_info_cb (lv_image_decoder_t     *decoder,
+                lv_image_decoder_dsc_t *dsc,
+                lv_image_header_t      *header_out)
+{
+  const char *path = dsc->src;
+  lv_image_dsc_t img;
+
+  LV_UNUSED(decoder);
+
+  /* compressed images would need a buffer, they are left to the decoders of
+   * variable sources through lvgl_bundle_get_image() */
+  if (dsc->src_type != LV_IMAGE_SRC_FILE || path[0] != BUNDLE_LETTER || path[1] != ':' ||
+      lvgl_bundle_get_image(bundle_strip(path + 2), &img) != LV_RESULT_OK ||
+      (img.header.flags & LV_IMAGE_FLAGS_COMPRESSED) != 0)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  *header_out = img.header;
+
+  return LV_RESULT_OK;
+}
+
+static lv_result_t
+bundle_open_image_cb (lv_image_decoder_t     *decoder,
+                      lv_image_decoder_dsc_t *dsc)
+{
+  const char *path = dsc->src;
+  lv_image_dsc_t img;
+  lv_draw_buf_t *decoded;
+
+  LV_UNUSED(decoder);
+
+  if (lvgl_bundle_get_image(bundle_strip(path + 2), &img) != LV_RESULT_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  /* only the descriptor is allocated, it points to the pixels in the flash */
+  decoded = lv_malloc_zeroed(sizeof(lv_draw_buf_t));
+  if (decoded == NULL)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  lv_draw_buf_from_image(decoded, &img);
+  dsc->decoded = decoded;
+
+  return LV_RESULT_OK;
+}
+
+static void
+bundle_close_image_cb (lv_image_decoder_t     *decoder,
+                       lv_image_decoder_dsc_t *dsc)
+{
+  LV_UNUSED(decoder);
+
+  lv_free((void *)dsc->decoded);
+  dsc->decoded = NULL;
+}
@@ -0,0 +1,648 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_can.h"
+#include "main.h"
+#include "fdcan.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define CAN_CYCLES_TO_US(c)  ((uint32_t)((uint64_t)(c) * 1000000 / SystemCoreClock))
+
+#define CAN_WORDS            ((CAN_SIGNAL_MAX + 31) / 32)
+
+/* an element of the Rx FIFOs in the message RAM, as in stm32u5xx_hal_fdcan.c */
+#define CAN_RX_ELEMENT_SIZE  (18U * 4U)
+#define CAN_RX_ELEMENT_CNT   3U
+
+#define CAN_ELEMENT_XTD      0x40000000U
+#define CAN_ELEMENT_EXTID    0x1FFFFFFFU
+#define CAN_ELEMENT_STDID_POS 18U
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint32_t id;                  /* with CAN_ID_EXT */
+  uint16_t first;               /* in `order` */
+  uint16_t cnt;
+} can_msg_t;
+
+typedef struct
+{
+  uint32_t lo;
+  uint32_t hi;
+} can_range_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static uint32_t
+can_plan (uint32_t ext, can_range_t *ranges, uint32_t max);
+
+static lv_result_t
+can_program (uint32_t ext, const can_range_t *ranges, uint32_t cnt);
+
+static void
+can_rx_fifo (uint32_t fifo);
+
+static void
+can_decode (uint32_t w0, uint32_t w1, const uint8_t *data);
+
+static bool
+can_extract (const lvgl_can_signal_t *sig, const uint8_t *data, uint32_t len, float *value);
+
+static const can_msg_t *
+can_find (uint32_t id);
+
+static void
+can_refr_start_cb (lv_event_t *e);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static const uint8_t dlc_bytes[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64 };
+
+static const lvgl_can_signal_t *db;
+static uint32_t db_cnt;
+static volatile bool running;
+
+/* the messages sorted by identifier, their signals grouped in `order` */
+static can_msg_t msgs[CAN_MESSAGE_MAX];
+static uint32_t msg_cnt;
+static uint16_t order[CAN_SIGNAL_MAX];
+
+/* Written by the interrupt. The refresh copies the signals marked in `dirty` into
+ * the table the UI reads, with the interrupt masked. */
+static float live[CAN_SIGNAL_MAX];
+static uint32_t live_tick[CAN_SIGNAL_MAX];
+static uint32_t dirty[CAN_WORDS];
+
+static float front[CAN_SIGNAL_MAX];
+static uint32_t front_tick[CAN_SIGNAL_MAX];
+static uint32_t changed[CAN_WORDS];
+static uint32_t latch_tick;
+
+static lvgl_can_update_cb_t update_cb;
+
+static lvgl_can_stats_t stats;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_result_t
+lvgl_can_start (const lvgl_can_signal_t *signals,
+                uint32_t                 cnt)
+{
+  static can_range_t ranges[CAN_MESSAGE_MAX];
+  uint32_t range_cnt;
+  uint32_t i;
+  uint32_t j;
+  uint16_t s;
+
+  if (running || cnt == 0 || cnt > CAN_SIGNAL_MAX)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  /* the signals ordered by their message, a stable insertion sort of a few */
+  for (i = 0; i < cnt; i++)
+    {
+      if (signals[i].length == 0 || signals[i].length > 32)
+        {
+          return LV_RESULT_INVALID;
+        }
+      for (j = i; j > 0 && signals[order[j - 1]].id > signals[i].id; j--)
+        {
+          order[j] = order[j - 1];
+        }
+      order[j] = i;
+    }
+
+  msg_cnt = 0;
+  for (i = 0; i < cnt; i++)
+    {
+      s = order[i];
+      if (msg_cnt > 0 && msgs[msg_cnt - 1].id == signals[s].id)
+        {
+          msgs[msg_cnt - 1].cnt++;
+          continue;
+        }
+      if (msg_cnt == CAN_MESSAGE_MAX)
+        {
+          return LV_RESULT_INVALID;
+        }
+      msgs[msg_cnt].id = signals[s].id;
+      msgs[msg_cnt].first = i;
+      msgs[msg_cnt].cnt = 1;
+      msg_cnt++;
+    }
+
+  for (i = 0; i < cnt; i++)
+    {
+      live_tick[i] = UINT32_MAX;
+      front_tick[i] = UINT32_MAX;
+    }
+  db = signals;
+  db_cnt = cnt;
+
+  /* everything else is rejected by the hardware */
+  range_cnt = can_plan(0, ranges, CAN_STD_FILTER_MAX);
+  if (can_program(0, ranges, range_cnt) != LV_RESULT_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+  range_cnt = can_plan(CAN_ID_EXT, ranges, CAN_EXT_FILTER_MAX);
+  if (can_program(CAN_ID_EXT, ranges, range_cnt) != LV_RESULT_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  if (HAL_FDCAN_ConfigGlobalFilter(&hfdcan1, FDCAN_REJECT, FDCAN_REJECT,
+                                   FDCAN_REJECT_REMOTE, FDCAN_REJECT_REMOTE) != HAL_OK ||
+      HAL_FDCAN_ConfigRxFifoOverwrite(&hfdcan1, FDCAN_RX_FIFO0, FDCAN_RX_FIFO_OVERWRITE) != HAL_OK ||
+      HAL_FDCAN_ConfigRxFifoOverwrite(&hfdcan1, FDCAN_RX_FIFO1, FDCAN_RX_FIFO_OVERWRITE) != HAL_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  if (HAL_FDCAN_ActivateNotification(&hfdcan1, FDCAN_IT_RX_FIFO0_NEW_MESSAGE | FDCAN_IT_RX_FIFO0_MESSAGE_LOST |
+                                               FDCAN_IT_RX_FIFO1_NEW_MESSAGE | FDCAN_IT_RX_FIFO1_MESSAGE_LOST,
+                                     0) != HAL_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  HAL_NVIC_SetPriority(FDCAN1_IT0_IRQn, CAN_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(FDCAN1_IT0_IRQn);
+
+  if (HAL_FDCAN_Start(&hfdcan1) != HAL_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+  running = true;
+
+  return LV_RESULT_OK;
+}
+
+void
+lvgl_can_attach (lv_display_t         *disp,
+                 lvgl_can_update_cb_t  cb)
+{
+  update_cb = cb;
+  lv_display_add_event_cb(disp, can_refr_start_cb, LV_EVENT_REFR_START, NULL);
+}
+
+float
+lvgl_can_get (uint32_t idx)
+{
+  return idx < db_cnt ? front[idx] : 0.0f;
+}
+
+bool
+lvgl_can_is_changed (uint32_t idx)
+{
+  return idx < db_cnt && (changed[idx / 32] & (1UL << (idx % 32))) != 0;
+}
+
+uint32_t
+lvgl_can_get_age (uint32_t idx)
+{
+  if (idx >= db_cnt || front_tick[idx] == UINT32_MAX)
+    {
+      return UINT32_MAX;
+    }
+
+  return latch_tick - front_tick[idx];
+}
+
+void
+lvgl_can_get_stats (lvgl_can_stats_t *stats_out)
+{
+  *stats_out = stats;
+}
+
+void
+lvgl_can_reset_stats (void)
+{
+  uint32_t std_filters = stats.std_filters;
+  uint32_t ext_filters = stats.ext_filters;
+  uint32_t ids_extra = stats.ids_extra;
+
+  /* the filters stay as they are */
+  lv_memzero(&stats, sizeof(stats));
+  stats.std_filters = std_filters;
+  stats.ext_filters = ext_filters;
+  stats.ids_extra = ids_extra;
+}
+
+/* in the FDCAN1 interrupt, by HAL_FDCAN_IRQHandler() */
+void
+HAL_FDCAN_RxFifo0Callback (FDCAN_HandleTypeDef *hfdcan,
+                           uint32_t             RxFifo0ITs)
+{
+  if (hfdcan != &hfdcan1)
+    {
+      return;
+    }
+  if (RxFifo0ITs & FDCAN_IT_RX_FIFO0_MESSAGE_LOST)
+    {
+      stats.lost++;
+    }
+  can_rx_fifo(FDCAN_RX_FIFO0);
+}
+
+void
+HAL_FDCAN_RxFifo1Callback (FDCAN_HandleTypeDef *hfdcan,
+                           uint32_t             RxFifo1ITs)
+{
+  if (hfdcan != &hfdcan1)
+    {
+      return;
+    }
+  if (RxFifo1ITs & FDCAN_IT_RX_FIFO1_MESSAGE_LOST)
+    {
+      stats.lost++;
+    }
+  can_rx_fifo(FDCAN_RX_FIFO1);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/* The ranges of identifiers that cover the messages of one type in `max` filter
+ * elements. Returns their count. */
+static uint32_t
+can_plan (uint32_t     ext,
+          can_range_t *ranges,
+          uint32_t     max)
+{
+  uint32_t cnt = 0;
+  uint32_t singles;
+  uint32_t elements;
+  uint32_t gap;
+  uint32_t best;
+  uint32_t i;
+
+  /* the messages are sorted, the extended ones after the standard ones */
+  for (i = 0; i < msg_cnt; i++)
+    {
+      if ((msgs[i].id & CAN_ID_EXT) != ext)
+        {
+          continue;
+        }
+      if (cnt > 0 && ranges[cnt - 1].hi + 1 == (msgs[i].id & ~CAN_ID_EXT))
+        {
+          ranges[cnt - 1].hi++;
+          continue;
+        }
+      ranges[cnt].lo = msgs[i].id & ~CAN_ID_EXT;
+      ranges[cnt].hi = ranges[cnt].lo;
+      cnt++;
+    }
+
+  for (;;)
+    {
+      /* a range takes an element, two single identifiers share one */
+      singles = 0;
+      elements = 0;
+      for (i = 0; i < cnt; i++)
+        {
+          if (ranges[i].lo == ranges[i].hi)
+            {
+              singles++;
+            }
+          else
+            {
+              elements++;
+            }
+        }
+      elements += (singles + 1) / 2;
+      if (elements <= max || cnt < 2)
+        {
+          break;
+        }
+
+      /* the two neighbours with the fewest identifiers between them */
+      best = 0;
+      gap = UINT32_MAX;
+      for (i = 0; i + 1 < cnt; i++)
+        {
+          if (ranges[i + 1].lo - ranges[i].hi < gap)
+            {
+              gap = ranges[i + 1].lo - ranges[i].hi;
+              best = i;
+            }
+        }
+      stats.ids_extra += gap - 1;
+      ranges[best].hi = ranges[best + 1].hi;
+      lv_memmove(&ranges[best + 1], &ranges[best + 2], (cnt - best - 2) * sizeof(can_range_t));
+      cnt--;
+    }
+
+  return cnt;
+}
+
+static lv_result_t
+can_program (uint32_t           ext,
+             const can_range_t *ranges,
+             uint32_t           cnt)
+{
+  FDCAN_FilterTypeDef filter;
+  int32_t single = -1;
+  uint32_t i;
+
+  filter.IdType = ext ? FDCAN_EXTENDED_ID : FDCAN_STANDARD_ID;
+  filter.FilterIndex = 0;
+  filter.FilterConfig = ext ? FDCAN_FILTER_TO_RXFIFO1 : FDCAN_FILTER_TO_RXFIFO0;
+
+  for (i = 0; i < cnt; i++)
+    {
+      if (ranges[i].lo != ranges[i].hi)
+        {
+          filter.FilterType = FDCAN_FILTER_RANGE;
+          filter.FilterID1 = ranges[i].lo;
+          filter.FilterID2 = ranges[i].hi;
+        }
+      else if (single < 0)
+        {
+          /* waits for another single identifier */
+          single = i;
+          continue;
+        }
+      else
+        {
+          filter.FilterType = FDCAN_FILTER_DUAL;
+          filter.FilterID1 = ranges[single].lo;
+          filter.FilterID2 = ranges[i].lo;
+          single = -1;
+        }
+
+      if (HAL_FDCAN_ConfigFilter(&hfdcan1, &filter) != HAL_OK)
+        {
+          return LV_RESULT_INVALID;
+        }
+      filter.FilterIndex++;
+    }
+
+  if (single >= 0)
+    {
+      filter.FilterType = FDCAN_FILTER_DUAL;
+      filter.FilterID1 = ranges[single].lo;
+      filter.FilterID2 = ranges[single].lo;
+      if (HAL_FDCAN_ConfigFilter(&hfdcan1, &filter) != HAL_OK)
+        {
+          return LV_RESULT_INVALID;
+        }
+      filter.FilterIndex++;
+    }
+
+  if (ext)
+    {
+      stats.ext_filters = filter.FilterIndex;
+    }
+  else
+    {
+      stats.std_filters = filter.FilterIndex;
+    }
+
+  return LV_RESULT_OK;
+}
+
+/* The frames are decoded where they are in the message RAM, then acknowledged */
+static void
+can_rx_fifo (uint32_t fifo)
+{
+  FDCAN_GlobalTypeDef *can = hfdcan1.Instance;
+  uint32_t start = DWT->CYCCNT;
+  const uint32_t *elem;
+  uint32_t status;
+  uint32_t gi;
+
+  for (;;)
+    {
+      status = fifo == FDCAN_RX_FIFO0 ? can->RXF0S : can->RXF1S;
+      if ((status & FDCAN_RXF0S_F0FL) == 0)
+        {
+          break;
+        }
+
+      gi = (status & FDCAN_RXF0S_F0GI) >> FDCAN_RXF0S_F0GI_Pos;
+      /* a full FIFO in overwrite mode is writing its oldest element, as in
+       * HAL_FDCAN_GetRxMessage() the next one is read */
+      if (status & FDCAN_RXF0S_F0F)
+        {
+          gi = (gi + 1) % CAN_RX_ELEMENT_CNT;
+        }
+
+      elem = (const uint32_t *)((fifo == FDCAN_RX_FIFO0 ? hfdcan1.msgRam.RxFIFO0SA : hfdcan1.msgRam.RxFIFO1SA) +
+                                gi * CAN_RX_ELEMENT_SIZE);
+      can_decode(elem[0], elem[1], (const uint8_t *)&elem[2]);
+
+      if (fifo == FDCAN_RX_FIFO0)
+        {
+          can->RXF0A = gi;
+        }
+      else
+        {
+          can->RXF1A = gi;
+        }
+    }
+
+  stats.isr_us_max = LV_MAX(stats.isr_us_max, CAN_CYCLES_TO_US(DWT->CYCCNT - start));
+}
+
+static void
+can_decode (uint32_t       w0,
+            uint32_t       w1,
+            const uint8_t *data)
+{
+  uint32_t id = (w0 & CAN_ELEMENT_XTD) ? (w0 & CAN_ELEMENT_EXTID) | CAN_ID_EXT :
+                                         (w0 >> CAN_ELEMENT_STDID_POS) & 0x7FF;
+  uint32_t len = dlc_bytes[(w1 >> 16) & 0xF];
+  uint32_t tick = HAL_GetTick();
+  const can_msg_t *msg = can_find(id);
+  float value;
+  uint16_t s;
+  uint32_t i;
+
+  if (msg == NULL)
+    {
+      stats.unmatched++;
+      return;
+    }
+
+  for (i = 0; i < msg->cnt; i++)
+    {
+      s = order[msg->first + i];
+      if (!can_extract(&db[s], data, len, &value))
+        {
+          stats.truncated++;
+          continue;
+        }
+      live[s] = value;
+      live_tick[s] = tick;
+      dirty[s / 32] |= 1UL << (s % 32);
+    }
+
+  stats.frames++;
+}
+
+/* As in a DBC: an Intel signal starts at its LSB and goes up. A Motorola signal
+ * starts at its MSB and goes down, from bit 0 of a byte to bit 7 of the next one. */
+static bool
+can_extract (const lvgl_can_signal_t *sig,
+             const uint8_t           *data,
+             uint32_t                 len,
+             float                   *value)
+{
+  uint32_t byte = sig->start / 8;
+  uint32_t bit = sig->start % 8;
+  uint32_t mask = (uint32_t)((1ULL << sig->length) - 1);
+  uint32_t last;
+  uint64_t window = 0;
+  uint32_t raw;
+  uint32_t i;
+
+  if (sig->flags & CAN_SIGNAL_BIG_ENDIAN)
+    {
+      last = byte + (sig->length > bit + 1 ? (sig->length - bit - 1 + 7) / 8 : 0);
+    }
+  else
+    {
+      last = (sig->start + sig->length - 1) / 8;
+    }
+  if (last >= len)
+    {
+      return false;
+    }
+
+  /* the 5 bytes from the first one hold any signal up to 32 bits */
+  for (i = 0; i < 5 && byte + i < len; i++)
+    {
+      if (sig->flags & CAN_SIGNAL_BIG_ENDIAN)
+        {
+          window |= (uint64_t)data[byte + i] << (32 - 8 * i);
+        }
+      else
+        {
+          window |= (uint64_t)data[byte + i] << (8 * i);
+        }
+    }
+
+  if (sig->flags & CAN_SIGNAL_BIG_ENDIAN)
+    {
+      raw = (uint32_t)(window >> (32 + bit + 1 - sig->length)) & mask;
+    }
+  else
+    {
+      raw = (uint32_t)(window >> bit) & mask;
+    }
+
+  if ((sig->flags & CAN_SIGNAL_SIGNED) && (raw & (1UL << (sig->length - 1))))
+    {
+      *value = (float)(int32_t)(raw | ~mask) * sig->scale + sig->offset;
+    }
+  else
+    {
+      *value = (float)raw * sig->scale + sig->offset;
+    }
+
+  return true;
+}
+
+static const can_msg_t *
+can_find (uint32_t id)
+{
+  uint32_t lo = 0;
+  uint32_t hi = msg_cnt;
+  uint32_t mid;
+
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      if (msgs[mid].id == id)
+        {
+          return &msgs[mid];
+        }
+      if (msgs[mid].id < id)
+        {
+          lo = mid + 1;
+        }
+      else
+        {
+          hi = mid;
+        }
+    }
+
+  return NULL;
+}
+
+/* Once per refresh, before the widgets are laid out and rendered */
+static void
+can_refr_start_cb (lv_event_t *e)
+{
+  uint32_t any = 0;
+  uint32_t bits;
+  uint32_t age;
+  uint32_t w;
+  uint32_t s;
+
+  LV_UNUSED(e);
+
+  if (!running)
+    {
+      return;
+    }
+
+  latch_tick = HAL_GetTick();
+
+  /* only the FDCAN interrupt is held off, for the copy of the changed signals */
+  HAL_NVIC_DisableIRQ(FDCAN1_IT0_IRQn);
+  for (w = 0; w < CAN_WORDS; w++)
+    {
+      changed[w] = dirty[w];
+      dirty[w] = 0;
+      for (bits = changed[w]; bits != 0; bits &= bits - 1)
+        {
+          s = w * 32 + __builtin_ctz(bits);
+          front[s] = live[s];
+          front_tick[s] = live_tick[s];
+        }
+      any |= changed[w];
+    }
+  HAL_NVIC_EnableIRQ(FDCAN1_IT0_IRQn);
+
+  if (any == 0)
+    {
+      return;
+    }
+
+  for (w = 0; w < CAN_WORDS; w++)
+    {
+      for (bits = changed[w]; bits != 0; bits &= bits - 1)
+        {
+          s = w * 32 + __builtin_ctz(bits);
+          age = latch_tick - front_tick[s];
+          stats.latch_age_max_ms = LV_MAX(stats.latch_age_max_ms, age);
+        }
+    }
+  stats.latches++;
+
+  if (update_cb != NULL)
+    {
+      update_cb();
+    }
+}
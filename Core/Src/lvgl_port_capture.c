@@ -0,0 +1,598 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_capture.h"
+#include "lvgl_port_display.h"
+#include "lvgl_port_mirror.h"
+#include "lvgl_port_plane.h"
+#include "lvgl_port_trace.h"
+#include "main.h"
+#include "ltdc.h"
+#include "usart.h"
+#include "cmsis_os2.h"
+
+#if CAPTURE_ENABLE
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define CAPTURE_TILES_MAX  (((MY_DISP_HOR_RES + CAPTURE_TILE_SIZE - 1) / CAPTURE_TILE_SIZE) * \
+                            ((MY_DISP_VER_RES + CAPTURE_TILE_SIZE - 1) / CAPTURE_TILE_SIZE))
+
+/* the longest encoding of a tile after its record, RLE of RGB565 is shorter than 32 bit pixels */
+#define CAPTURE_TILE_MAX   (CAPTURE_TILE_SIZE * CAPTURE_TILE_SIZE * 4)
+
+#define CAPTURE_FLAG_RLE   0x01
+
+/* the index of the record after the last tile */
+#define CAPTURE_TILE_END   0xFFFF
+
+#define CAPTURE_UART_ACK   'K'
+#define CAPTURE_UART_NAK   'E'
+
+#if CAPTURE_BUF_SIZE < CAPTURE_TILE_MAX + 64
+  #error "a tile has to fit into a buffer"
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/* Sent by the host at the rate of CubeMX. The device answers CAPTURE_UART_ACK and
+ * the rate it switches to, then sends the capture at that rate and switches back. */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t baudrate;            /* 0 keeps the rate */
+  uint32_t base_id;             /* of the capture the host has, 0 for none */
+  uint32_t reserved;
+} capture_request_t;
+
+/* Followed by a record of each tile sent, in rows from the top left one. The tiles
+ * not sent are the same as in the capture `base_id`. The end record is followed by
+ * the Adler-32 of all the records. */
+typedef struct __attribute__((packed))
+{
+  uint32_t magic;
+  uint32_t id;
+  uint32_t base_id;             /* 0 if all the tiles are sent */
+  uint16_t w;
+  uint16_t h;
+  uint8_t  cf;                  /* lv_color_format_t */
+  uint8_t  tile_size;
+  uint8_t  flags;               /* CAPTURE_FLAG_RLE, RGB565 tiles are encoded like the mirror's */
+  uint8_t  reserved;
+} capture_header_t;
+
+typedef struct __attribute__((packed))
+{
+  uint16_t idx;
+  uint16_t len;
+} capture_tile_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void
+capture_task (void *argument);
+
+static lv_result_t
+capture_send (uint32_t base_id);
+
+static lv_result_t
+capture_put (const void *data, uint32_t size);
+
+static lv_result_t
+capture_flush (void);
+
+static lv_result_t
+capture_tx_wait (void);
+
+static uint32_t
+capture_read_tile (uint32_t fb, uint32_t stride, uint32_t bpp, const lv_area_t *tile);
+
+static void
+capture_set_baudrate (uint32_t baudrate);
+
+static lv_result_t
+capture_receive (void *buf, uint32_t size, uint32_t timeout);
+
+static void
+capture_reply (const void *data, uint32_t size);
+
+static uint32_t
+capture_adler32 (uint32_t adler, const uint8_t *data, uint32_t size);
+
+static lv_color_format_t
+capture_layer_cf (uint32_t layer_idx);
+
+static void
+capture_tx_cplt_cb (UART_HandleTypeDef *huart);
+
+static void
+capture_rx_cplt_cb (UART_HandleTypeDef *huart);
+
+static void
+capture_error_cb (UART_HandleTypeDef *huart);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static const osThreadAttr_t capture_task_attr =
+{
+  .name = "capture",
+  .priority = (osPriority_t) CAPTURE_TASK_PRIORITY,
+  .stack_size = CAPTURE_TASK_STACK_SIZE,
+};
+
+static uint8_t bufs[2][CAPTURE_BUF_SIZE] __attribute__((aligned(4)));
+static uint32_t cur;
+static uint32_t cur_len;
+static bool tx_busy;
+
+/* a copy of the tile being encoded, the framebuffer may be swapped meanwhile */
+static uint8_t tile_buf[CAPTURE_TILE_SIZE * CAPTURE_TILE_SIZE * 4] __attribute__((aligned(4)));
+
+/* the CRC of each tile of the last capture */
+static uint32_t sigs[CAPTURE_TILES_MAX];
+static uint32_t last_id;
+static uint32_t next_id;
+
+static uint32_t adler;
+static uint32_t sent;
+
+static osSemaphoreId_t tx_sem;
+static osSemaphoreId_t rx_sem;
+static volatile bool uart_error;
+
+/* the rate of CubeMX */
+static uint32_t base_baudrate;
+
+static lvgl_capture_stats_t stats;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_capture_uart_start (void)
+{
+  if (tx_sem != NULL || CAPTURE_UART.hdmatx == NULL)
+    {
+      return;
+    }
+
+  tx_sem = osSemaphoreNew(1, 0, NULL);
+  rx_sem = osSemaphoreNew(1, 0, NULL);
+  base_baudrate = CAPTURE_UART.Init.BaudRate;
+
+  HAL_UART_RegisterCallback(&CAPTURE_UART, HAL_UART_TX_COMPLETE_CB_ID, capture_tx_cplt_cb);
+  HAL_UART_RegisterCallback(&CAPTURE_UART, HAL_UART_RX_COMPLETE_CB_ID, capture_rx_cplt_cb);
+  HAL_UART_RegisterCallback(&CAPTURE_UART, HAL_UART_ERROR_CB_ID, capture_error_cb);
+
+  HAL_NVIC_SetPriority(CAPTURE_UART_IRQn, CAPTURE_UART_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(CAPTURE_UART_IRQn);
+
+  osThreadNew(capture_task, NULL, &capture_task_attr);
+}
+
+void
+lvgl_capture_get_stats (lvgl_capture_stats_t *stats_out)
+{
+  *stats_out = stats;
+  stats_out->kbyte_per_s = stats.ms > 0 ? (uint32_t)((uint64_t)stats.bytes * 1000 / 1024 / stats.ms) : 0;
+}
+
+void
+lvgl_capture_reset_stats (void)
+{
+  lv_memzero(&stats, sizeof(stats));
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void
+capture_task (void *argument)
+{
+  capture_request_t req;
+  uint8_t reply[5];
+  uint32_t baudrate;
+  lv_result_t res;
+
+  LV_UNUSED(argument);
+
+  for (;;)
+    {
+      if (capture_receive(&req, sizeof(req), osWaitForever) != LV_RESULT_OK)
+        {
+          continue;
+        }
+      if (req.magic != CAPTURE_UART_MAGIC)
+        {
+          /* out of step, the rest of the garbage times out */
+          stats.failures++;
+          reply[0] = CAPTURE_UART_NAK;
+          capture_reply(reply, 1);
+          while (capture_receive(&req, sizeof(req), 100) == LV_RESULT_OK)
+            {
+            }
+          continue;
+        }
+
+      baudrate = req.baudrate == 0 ? base_baudrate :
+                 LV_CLAMP(base_baudrate, req.baudrate, CAPTURE_UART_MAX_BAUDRATE);
+
+      /* the answer at the old rate, it's sent out completely before the switch */
+      reply[0] = CAPTURE_UART_ACK;
+      lv_memcpy(&reply[1], &baudrate, sizeof(baudrate));
+      capture_reply(reply, sizeof(reply));
+
+      capture_set_baudrate(baudrate);
+      osDelay(CAPTURE_UART_SWITCH_MS);
+
+      res = capture_send(req.base_id);
+
+      capture_set_baudrate(base_baudrate);
+
+      if (res != LV_RESULT_OK)
+        {
+          /* the host gets all the tiles the next time */
+          last_id = 0;
+          stats.failures++;
+        }
+      /* LVGL's log belongs to the LVGL task */
+      lvgl_trace("capture %u: %s, %u bytes", (unsigned)next_id,
+                 res == LV_RESULT_OK ? "sent" : "failed", (unsigned)stats.bytes);
+    }
+}
+
+static lv_result_t
+capture_send (uint32_t base_id)
+{
+  uint32_t layer = lvgl_plane_get_lvgl_layer();
+  LTDC_LayerCfgTypeDef *cfg = &hltdc.LayerCfg[layer];
+  lv_color_format_t cf = capture_layer_cf(layer);
+  uint32_t bpp = lv_color_format_get_size(cf);
+  uint32_t w = cfg->ImageWidth;
+  uint32_t h = cfg->ImageHeight;
+  uint32_t cols = (w + CAPTURE_TILE_SIZE - 1) / CAPTURE_TILE_SIZE;
+  uint32_t rows = (h + CAPTURE_TILE_SIZE - 1) / CAPTURE_TILE_SIZE;
+  bool rle = bpp == 2;
+  bool delta = base_id != 0 && base_id == last_id;
+  uint32_t start = HAL_GetTick();
+  capture_header_t header;
+  capture_tile_t rec;
+  lv_area_t tile;
+  uint32_t sig;
+  uint32_t pos;
+  uint32_t tw;
+  int32_t y;
+  uint32_t i;
+
+  if (bpp == 0 || cols * rows > CAPTURE_TILES_MAX)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  /* never 0, that's no capture */
+  if (++next_id == 0)
+    {
+      next_id = 1;
+    }
+
+  cur = 0;
+  cur_len = 0;
+  sent = 0;
+  stats.tiles = 0;
+  stats.tiles_skipped = 0;
+
+  header.magic = CAPTURE_UART_MAGIC;
+  header.id = next_id;
+  header.base_id = delta ? base_id : 0;
+  header.w = w;
+  header.h = h;
+  header.cf = cf;
+  header.tile_size = CAPTURE_TILE_SIZE;
+  header.flags = rle ? CAPTURE_FLAG_RLE : 0;
+  header.reserved = 0;
+  if (capture_put(&header, sizeof(header)) != LV_RESULT_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  /* of the records, after the header */
+  adler = 1;
+
+  for (i = 0; i < cols * rows; i++)
+    {
+      tile.x1 = (i % cols) * CAPTURE_TILE_SIZE;
+      tile.y1 = (i / cols) * CAPTURE_TILE_SIZE;
+      tile.x2 = LV_MIN(tile.x1 + CAPTURE_TILE_SIZE, (int32_t)w) - 1;
+      tile.y2 = LV_MIN(tile.y1 + CAPTURE_TILE_SIZE, (int32_t)h) - 1;
+      tw = lv_area_get_width(&tile);
+
+      /* the framebuffer scanned out now, LVGL may have swapped them since the last tile */
+      sig = capture_read_tile(LTDC_LAYER(&hltdc, layer)->CFBAR, w * bpp, bpp, &tile);
+      if (delta && sigs[i] == sig)
+        {
+          stats.tiles_skipped++;
+          continue;
+        }
+      sigs[i] = sig;
+
+      if (CAPTURE_BUF_SIZE - cur_len < sizeof(rec) + CAPTURE_TILE_MAX && capture_flush() != LV_RESULT_OK)
+        {
+          return LV_RESULT_INVALID;
+        }
+
+      /* the record first, its length once the tile is encoded */
+      pos = cur_len;
+      cur_len += sizeof(rec);
+      for (y = 0; y < lv_area_get_height(&tile); y++)
+        {
+          if (rle)
+            {
+              cur_len += lvgl_mirror_rle_line((const uint16_t *)&tile_buf[y * tw * 2], tw, &bufs[cur][cur_len]);
+            }
+          else
+            {
+              lv_memcpy(&bufs[cur][cur_len], &tile_buf[y * tw * bpp], tw * bpp);
+              cur_len += tw * bpp;
+            }
+        }
+      rec.idx = i;
+      rec.len = cur_len - pos - sizeof(rec);
+      lv_memcpy(&bufs[cur][pos], &rec, sizeof(rec));
+      adler = capture_adler32(adler, &bufs[cur][pos], cur_len - pos);
+
+      stats.tiles++;
+    }
+
+  rec.idx = CAPTURE_TILE_END;
+  rec.len = 0;
+  adler = capture_adler32(adler, (const uint8_t *)&rec, sizeof(rec));
+  if (capture_put(&rec, sizeof(rec)) != LV_RESULT_OK ||
+      capture_put(&adler, sizeof(adler)) != LV_RESULT_OK ||
+      capture_flush() != LV_RESULT_OK || capture_tx_wait() != LV_RESULT_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  last_id = next_id;
+
+  stats.captures++;
+  stats.deltas += delta ? 1 : 0;
+  stats.bytes = sent;
+  stats.raw_bytes = w * h * bpp;
+  stats.ms = HAL_GetTick() - start;
+  stats.baudrate = CAPTURE_UART.Init.BaudRate;
+
+  return LV_RESULT_OK;
+}
+
+static lv_result_t
+capture_put (const void *data,
+             uint32_t    size)
+{
+  if (CAPTURE_BUF_SIZE - cur_len < size && capture_flush() != LV_RESULT_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  lv_memcpy(&bufs[cur][cur_len], data, size);
+  cur_len += size;
+
+  return LV_RESULT_OK;
+}
+
+static lv_result_t
+capture_flush (void)
+{
+  if (capture_tx_wait() != LV_RESULT_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+  if (cur_len == 0)
+    {
+      return LV_RESULT_OK;
+    }
+
+  /* a token left by an error callback */
+  osSemaphoreAcquire(tx_sem, 0);
+
+  if (HAL_UART_Transmit_DMA(&CAPTURE_UART, bufs[cur], cur_len) != HAL_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+  tx_busy = true;
+  sent += cur_len;
+
+  /* the other one is filled meanwhile */
+  cur ^= 1;
+  cur_len = 0;
+
+  return LV_RESULT_OK;
+}
+
+static lv_result_t
+capture_tx_wait (void)
+{
+  if (!tx_busy)
+    {
+      return LV_RESULT_OK;
+    }
+
+  tx_busy = false;
+  if (osSemaphoreAcquire(tx_sem, CAPTURE_UART_TIMEOUT) != osOK || uart_error)
+    {
+      HAL_UART_AbortTransmit(&CAPTURE_UART);
+      uart_error = false;
+      return LV_RESULT_INVALID;
+    }
+
+  return LV_RESULT_OK;
+}
+
+static uint32_t
+capture_read_tile (uint32_t         fb,
+                   uint32_t         stride,
+                   uint32_t         bpp,
+                   const lv_area_t *tile)
+{
+  const uint8_t *src = (const uint8_t *)fb + tile->y1 * stride + tile->x1 * bpp;
+  uint32_t line = lv_area_get_width(tile) * bpp;
+  uint32_t size = line * lv_area_get_height(tile);
+  const uint32_t *p;
+  uint32_t crc;
+  uint32_t n;
+  int32_t y;
+
+  /* The copy and its CRC can't be interrupted by another task: the tile filter of the
+   * LVGL task uses the CRC unit too, and LVGL mustn't render into the tile meanwhile.
+   * It takes a few us. */
+  osKernelLock();
+
+  for (y = 0; y <= tile->y2 - tile->y1; y++)
+    {
+      lv_memcpy(&tile_buf[y * line], src + y * stride, line);
+    }
+
+  /* words, then the bytes of a tile which isn't a multiple of 4 bytes */
+  CRC->CR |= CRC_CR_RESET;
+  p = (const uint32_t *)tile_buf;
+  for (n = size / 4; n > 0; n--)
+    {
+      CRC->DR = *p++;
+    }
+  for (n = size & ~3U; n < size; n++)
+    {
+      *(__IO uint8_t *)&CRC->DR = tile_buf[n];
+    }
+  crc = CRC->DR;
+
+  osKernelUnlock();
+
+  return crc;
+}
+
+static void
+capture_set_baudrate (uint32_t baudrate)
+{
+  if (CAPTURE_UART.Init.BaudRate == baudrate)
+    {
+      return;
+    }
+
+  /* only BRR changes, HAL_UART_Init() would lose the RS485 setup of USART6 */
+  __HAL_UART_DISABLE(&CAPTURE_UART);
+  CAPTURE_UART.Init.BaudRate = baudrate;
+  UART_SetConfig(&CAPTURE_UART);
+  __HAL_UART_ENABLE(&CAPTURE_UART);
+}
+
+static lv_result_t
+capture_receive (void    *buf,
+                 uint32_t size,
+                 uint32_t timeout)
+{
+  uart_error = false;
+  osSemaphoreAcquire(rx_sem, 0);
+
+  if (HAL_UART_Receive_IT(&CAPTURE_UART, buf, size) != HAL_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  if (osSemaphoreAcquire(rx_sem, timeout) != osOK)
+    {
+      HAL_UART_AbortReceive(&CAPTURE_UART);
+      return LV_RESULT_INVALID;
+    }
+
+  return uart_error ? LV_RESULT_INVALID : LV_RESULT_OK;
+}
+
+static void
+capture_reply (const void *data,
+               uint32_t    size)
+{
+  /* blocking, it returns once the last stop bit is out */
+  HAL_UART_Transmit(&CAPTURE_UART, data, size, CAPTURE_UART_TIMEOUT);
+}
+
+static uint32_t
+capture_adler32 (uint32_t       adler_in,
+                 const uint8_t *data,
+                 uint32_t       size)
+{
+  uint32_t a = adler_in & 0xFFFF;
+  uint32_t b = adler_in >> 16;
+  uint32_t n;
+
+  /* the sums are reduced every 5552 bytes, before b can overflow */
+  while (size > 0)
+    {
+      n = LV_MIN(size, 5552);
+      size -= n;
+      while (n-- > 0)
+        {
+          a += *data++;
+          b += a;
+        }
+      a %= 65521;
+      b %= 65521;
+    }
+
+  return b << 16 | a;
+}
+
+static lv_color_format_t
+capture_layer_cf (uint32_t layer_idx)
+{
+  switch (hltdc.LayerCfg[layer_idx].PixelFormat)
+    {
+      case LTDC_PIXEL_FORMAT_ARGB8888:
+        return LV_COLOR_FORMAT_ARGB8888;
+      case LTDC_PIXEL_FORMAT_RGB888:
+        return LV_COLOR_FORMAT_RGB888;
+      case LTDC_PIXEL_FORMAT_RGB565:
+        return LV_COLOR_FORMAT_RGB565;
+      default:
+        return LV_COLOR_FORMAT_UNKNOWN;
+    }
+}
+
+/* USE_HAL_UART_REGISTER_CALLBACKS is 1, these are CAPTURE_UART's */
+static void
+capture_tx_cplt_cb (UART_HandleTypeDef *huart)
+{
+  LV_UNUSED(huart);
+
+  osSemaphoreRelease(tx_sem);
+}
+
+static void
+capture_rx_cplt_cb (UART_HandleTypeDef *huart)
+{
+  LV_UNUSED(huart);
+
+  osSemaphoreRelease(rx_sem);
+}
+
+static void
+capture_error_cb (UART_HandleTypeDef *huart)
+{
+  LV_UNUSED(huart);
+
+  uart_error = true;
+  osSemaphoreRelease(rx_sem);
+  osSemaphoreRelease(tx_sem);
+}
+
+#endif /* CAPTURE_ENABLE */
@@ -6,6 +6,25 @@
 #include "main.h"
 #include "ltdc.h"
 #include "dma2d.h"
+#include "lvgl_port_bundle.h"
+#include "lvgl_port_dither.h"
+#include "lvgl_port_dma2d.h"
+#include "lvgl_port_fatfs.h"
+#include "lvgl_port_fs_cache.h"
+#include "lvgl_port_image_cache.h"
+#include "lvgl_port_jpeg.h"
+#include "lvgl_port_layer_pool.h"
+#include "lvgl_port_littlefs.h"
+#include "lvgl_port_mirror.h"
+#include "lvgl_port_ospi.h"
+#include "lvgl_port_plane.h"
+#include "lvgl_port_retained.h"
+#include "lvgl_port_rotation.h"
+#include "lvgl_port_subject.h"
+#include "lvgl_port_tile_filter.h"
+#include "lvgl_port_tsc.h"
+#include "lvgl_port_update.h"
+#include "lvgl_port_zimg.h"
 
 /**********************
  *  STATIC PROTOTYPES
@@ -22,17 +41,85 @@
 void lvgl_display_init (void)
 {
 	/* display initialization */
+  lv_display_t * disp;
 
-#if LV_COLOR_DEPTH == 16
+  /* the 2nd LTDC layer is left to lvgl_port_plane, LVGL renders to the other one */
+  lvgl_plane_init();
+
+#if MY_DISP_ROTATION != 0
+  /* rendered rotated in bands, GPU2D turns them into the native framebuffer */
+  disp = lvgl_rotation_create((lv_display_rotation_t)(MY_DISP_ROTATION / 90), lvgl_plane_get_lvgl_layer());
+#elif LV_COLOR_DEPTH == 16
   static __attribute__((aligned(32))) uint8_t buf_2[MY_DISP_HOR_RES * MY_DISP_VER_RES * 2];
-  lv_st_ltdc_create_direct((void *)0x20000000, buf_2, 0);
+  disp = lv_st_ltdc_create_direct((void *)0x20000000, buf_2, lvgl_plane_get_lvgl_layer());
 #elif LV_COLOR_DEPTH == 24 || LV_COLOR_DEPTH == 32
   static __attribute__((aligned(32))) uint8_t buf_1[MY_DISP_HOR_RES * MY_DISP_VER_RES];
   static __attribute__((aligned(32))) uint8_t buf_2[MY_DISP_HOR_RES * MY_DISP_VER_RES];
-  lv_st_ltdc_create_partial(buf_1, buf_2, sizeof(buf_1), 0);
+  disp = lv_st_ltdc_create_partial(buf_1, buf_2, sizeof(buf_1), lvgl_plane_get_lvgl_layer());
 #else
   #error LV_COLOR_DEPTH not supported
 #endif
+
+  /* the flushes in partial mode hold the DMA2D lock while their transfer runs */
+  lvgl_dma2d_init();
+  lvgl_dma2d_attach(disp);
+
+#if TILE_FILTER_ENABLE
+  /* partial flushes skip the tiles which were redrawn with the same pixels */
+  lvgl_tile_filter_attach(disp, lvgl_plane_get_lvgl_layer());
+#if MIRROR_ENABLE
+  /* the changed tiles are sent to a host viewer over USB, its pointer is read back */
+  lvgl_mirror_init(disp);
+#endif
+#endif
+
+  /* values published to subjects by other tasks are applied once per refresh */
+  lvgl_subject_init(disp);
+
+#if LAYER_POOL_ENABLE
+  /* opacity and transform layers are served from a recycled arena */
+  lvgl_layer_pool_init(disp);
+#endif
+
+#if RETAINED_ENABLE
+  /* objects added with lvgl_retained_add() are blitted from a cached texture */
+  lvgl_retained_init(disp);
+#endif
+
+#if DITHER_ENABLE
+  /* gradients of objects added with lvgl_dither_add() are dithered to RGB565 */
+  lvgl_dither_init(disp);
+#endif
+
+  /* TSC compressed images are sampled by GPU2D straight from their descriptor */
+  lvgl_tsc_init();
+
+  /* decoded images are cached in their own arena, RLE/LZ4 images are decompressed into it */
+#if IMAGE_CACHE_ENABLE
+  lvgl_image_cache_init();
+#endif
+  lvgl_zimg_init();
+
+  /* JPEGs are decoded by TJpgDec on the CPU, the video task uses it too */
+  lvgl_jpeg_init();
+
+  /* the writes to the OSPI flash are queued, its readers are bracketed */
+  lvgl_ospi_init();
+
+  /* the assets of the bundle in the memory-mapped OSPI flash are used in place by name,
+   * from the A/B slot the last verified update was written to */
+  lvgl_update_init();
+  lvgl_bundle_init(lvgl_update_get_bundle());
+
+  /* logs and user files are kept in LittleFS further up in the same flash */
+  lvgl_littlefs_init();
+
+  /* media on the SD card is read through the FatFs drive */
+  lvgl_fatfs_init();
+
+  /* the many small reads of the image and font decoders are served from shared blocks */
+  lvgl_fs_cache_attach(LV_FS_FATFS_LETTER);
+  lvgl_fs_cache_attach(LV_FS_LITTLEFS_LETTER);
 }
 
 /**********************
@@ -0,0 +1,469 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_dither.h"
+#include "lvgl/src/stdlib/builtin/lv_tlsf.h"
+
+#if DITHER_ENABLE
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define DITHER_BUF_ALIGN  32
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  bool               used;
+  lv_grad_dir_t      dir;
+  int32_t            len;
+  uint8_t            stops_count;
+  lv_gradient_stop_t stops[LV_GRADIENT_MAX_STOPS];
+  uint32_t           last_frame;
+  void              *data;
+  lv_draw_buf_t      draw_buf;
+} dither_entry_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static bool
+dither_is_supported (const lv_draw_fill_dsc_t *fill);
+
+static dither_entry_t *
+dither_get (const lv_grad_dsc_t *grad, int32_t len);
+
+static dither_entry_t *
+dither_lru (void);
+
+static void
+dither_free (dither_entry_t *entry);
+
+static void
+dither_generate (dither_entry_t *entry);
+
+static uint16_t
+dither_pixel (const int32_t *rgb, uint32_t threshold);
+
+static void
+dither_draw_task_cb (lv_event_t *e);
+
+static void
+dither_set_part (lv_area_t *part, const lv_area_t *area, bool ver, int32_t pos, int32_t size);
+
+static void
+dither_refr_start_cb (lv_event_t *e);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static __attribute__((aligned(DITHER_BUF_ALIGN))) uint8_t cache_mem[DITHER_CACHE_SIZE];
+static lv_tlsf_t cache_tlsf;
+
+static dither_entry_t entries[DITHER_CACHE_CNT];
+
+/* narrower views of the textures for the last blit of a fill, used in this refresh */
+static lv_draw_buf_t rest_bufs[DITHER_REST_CNT];
+static uint32_t rest_cnt;
+
+/* textures used in the current refresh are still referenced by queued draw tasks */
+static uint32_t cur_frame;
+
+static bool enabled;
+static lvgl_dither_stats_t stats;
+
+/* 4x4 Bayer matrix, thresholds in 1/16 of an RGB565 step */
+static const uint8_t bayer4[4][4] =
+{
+  {  0,  8,  2, 10 },
+  { 12,  4, 14,  6 },
+  {  3, 11,  1,  9 },
+  { 15,  7, 13,  5 },
+};
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_dither_init (lv_display_t *disp)
+{
+  /* with a 24 or 32 bit framebuffer the GPU's gradients don't band */
+  enabled = lv_display_get_color_format(disp) == LV_COLOR_FORMAT_RGB565;
+  if (!enabled)
+    {
+      return;
+    }
+
+  cache_tlsf = lv_tlsf_create_with_pool(cache_mem, sizeof(cache_mem));
+
+  lv_display_add_event_cb(disp, dither_refr_start_cb, LV_EVENT_REFR_START, NULL);
+}
+
+void
+lvgl_dither_add (lv_obj_t *obj)
+{
+  if (!enabled)
+    {
+      return;
+    }
+
+  lv_obj_add_flag(obj, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS);
+  lv_obj_add_event_cb(obj, dither_draw_task_cb, LV_EVENT_DRAW_TASK_ADDED, NULL);
+  lv_obj_invalidate(obj);
+}
+
+void
+lvgl_dither_remove (lv_obj_t *obj)
+{
+  if (lv_obj_remove_event_cb(obj, dither_draw_task_cb))
+    {
+      lv_obj_remove_flag(obj, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS);
+      lv_obj_invalidate(obj);
+    }
+}
+
+void
+lvgl_dither_get_stats (lvgl_dither_stats_t *stats_out)
+{
+  *stats_out = stats;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static bool
+dither_is_supported (const lv_draw_fill_dsc_t *fill)
+{
+  uint32_t i;
+
+  if (fill->radius != 0 || fill->opa < LV_OPA_MAX || fill->grad.stops_count < 2 ||
+      (fill->grad.dir != LV_GRAD_DIR_VER && fill->grad.dir != LV_GRAD_DIR_HOR))
+    {
+      return false;
+    }
+
+  /* the texture is opaque RGB565 */
+  for (i = 0; i < fill->grad.stops_count; i++)
+    {
+      if (fill->grad.stops[i].opa < LV_OPA_MAX)
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+static dither_entry_t *
+dither_get (const lv_grad_dsc_t *grad,
+            int32_t              len)
+{
+  dither_entry_t *entry = NULL;
+  uint32_t w;
+  uint32_t h;
+  uint32_t stride;
+  uint32_t start;
+  uint32_t i;
+
+  for (i = 0; i < DITHER_CACHE_CNT; i++)
+    {
+      if (entries[i].used && entries[i].dir == grad->dir && entries[i].len == len &&
+          entries[i].stops_count == grad->stops_count &&
+          lv_memcmp(entries[i].stops, grad->stops, grad->stops_count * sizeof(grad->stops[0])) == 0)
+        {
+          entries[i].last_frame = cur_frame;
+          stats.hit_cnt++;
+          return &entries[i];
+        }
+      if (!entries[i].used && entry == NULL)
+        {
+          entry = &entries[i];
+        }
+    }
+
+  if (entry == NULL)
+    {
+      entry = dither_lru();
+      if (entry == NULL)
+        {
+          return NULL;
+        }
+      dither_free(entry);
+    }
+
+  entry->dir = grad->dir;
+  entry->len = len;
+  entry->stops_count = grad->stops_count;
+  lv_memcpy(entry->stops, grad->stops, grad->stops_count * sizeof(grad->stops[0]));
+
+  w = entry->dir == LV_GRAD_DIR_VER ? DITHER_TILE : len;
+  h = entry->dir == LV_GRAD_DIR_VER ? len : DITHER_TILE;
+  stride = lv_draw_buf_width_to_stride(w, LV_COLOR_FORMAT_RGB565);
+
+  entry->data = lv_tlsf_memalign(cache_tlsf, DITHER_BUF_ALIGN, stride * h);
+  while (entry->data == NULL)
+    {
+      dither_entry_t *lru = dither_lru();
+
+      if (lru == NULL)
+        {
+          return NULL;
+        }
+      dither_free(lru);
+      entry->data = lv_tlsf_memalign(cache_tlsf, DITHER_BUF_ALIGN, stride * h);
+    }
+
+  lv_draw_buf_init(&entry->draw_buf, w, h, LV_COLOR_FORMAT_RGB565, stride, entry->data, stride * h);
+
+  start = lv_tick_get();
+  dither_generate(entry);
+  stats.gen_time += lv_tick_elaps(start);
+  stats.miss_cnt++;
+
+  entry->used = true;
+  entry->last_frame = cur_frame;
+
+  return entry;
+}
+
+static dither_entry_t *
+dither_lru (void)
+{
+  dither_entry_t *lru = NULL;
+  uint32_t i;
+
+  for (i = 0; i < DITHER_CACHE_CNT; i++)
+    {
+      if (entries[i].used && entries[i].last_frame != cur_frame &&
+          (lru == NULL || entries[i].last_frame < lru->last_frame))
+        {
+          lru = &entries[i];
+        }
+    }
+
+  return lru;
+}
+
+static void
+dither_free (dither_entry_t *entry)
+{
+  if (entry->data != NULL)
+    {
+      lv_image_cache_drop(&entry->draw_buf);
+      lv_tlsf_free(cache_tlsf, entry->data);
+      entry->data = NULL;
+    }
+
+  entry->used = false;
+}
+
+static void
+dither_generate (dither_entry_t *entry)
+{
+  const lv_gradient_stop_t *stops = entry->stops;
+  uint32_t last = entry->stops_count - 1;
+  uint32_t w = entry->draw_buf.header.w;
+  uint32_t h = entry->draw_buf.header.h;
+  uint32_t stride = entry->draw_buf.header.stride;
+  int32_t rgb[3];
+  int32_t pos_fp;
+  int32_t num;
+  int32_t den;
+  uint32_t pos;
+  uint32_t x;
+  uint32_t y;
+  uint32_t i;
+
+  for (pos = 0; pos < (uint32_t)entry->len; pos++)
+    {
+      /* position on the gradient in 1/256 of the stop fractions */
+      pos_fp = entry->len > 1 ? (int32_t)(pos * 255 * 256 / (entry->len - 1)) : 0;
+
+      for (i = 0; i < last && pos_fp > stops[i + 1].frac * 256; i++)
+        {
+        }
+
+      if (i == last || pos_fp <= stops[i].frac * 256)
+        {
+          num = 0;
+          den = 1;
+        }
+      else
+        {
+          num = pos_fp - stops[i].frac * 256;
+          den = (stops[i + 1].frac - stops[i].frac) * 256;
+        }
+
+      /* 24 bit color with 4 fraction bits, more than the dither matrix can resolve */
+      rgb[0] = stops[i].color.red * 16;
+      rgb[1] = stops[i].color.green * 16;
+      rgb[2] = stops[i].color.blue * 16;
+      if (num != 0)
+        {
+          rgb[0] += (stops[i + 1].color.red - stops[i].color.red) * 16 * num / den;
+          rgb[1] += (stops[i + 1].color.green - stops[i].color.green) * 16 * num / den;
+          rgb[2] += (stops[i + 1].color.blue - stops[i].color.blue) * 16 * num / den;
+        }
+
+      /* the color is constant across the gradient, so it's a line of the matrix period */
+      if (entry->dir == LV_GRAD_DIR_VER)
+        {
+          uint16_t *row = (uint16_t *)((uint8_t *)entry->data + pos * stride);
+
+          for (x = 0; x < w; x++)
+            {
+              row[x] = dither_pixel(rgb, bayer4[pos & 3][x & 3]);
+            }
+        }
+      else
+        {
+          for (y = 0; y < h; y++)
+            {
+              uint16_t *row = (uint16_t *)((uint8_t *)entry->data + y * stride);
+
+              row[pos] = dither_pixel(rgb, bayer4[y & 3][pos & 3]);
+            }
+        }
+    }
+}
+
+static uint16_t
+dither_pixel (const int32_t *rgb,
+              uint32_t       threshold)
+{
+  /* floor(c / 255 * max + (threshold + 0.5) / 16) with c in 1/16 steps */
+  int32_t bias = (2 * threshold + 1) * 2040;
+  int32_t r = (rgb[0] * 31 * 16 + bias) / 65280;
+  int32_t g = (rgb[1] * 63 * 16 + bias) / 65280;
+  int32_t b = (rgb[2] * 31 * 16 + bias) / 65280;
+
+  r = LV_MIN(r, 31);
+  g = LV_MIN(g, 63);
+  b = LV_MIN(b, 31);
+
+  return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void
+dither_draw_task_cb (lv_event_t *e)
+{
+  lv_draw_task_t *t = lv_event_get_draw_task(e);
+  lv_draw_fill_dsc_t *fill;
+  lv_draw_image_dsc_t img_dsc;
+  dither_entry_t *entry;
+  lv_area_t area;
+  lv_area_t part;
+  bool ver;
+  int32_t len;
+  int32_t cross;
+  int32_t rest;
+  int32_t pos;
+
+  if (lv_draw_task_get_type(t) != LV_DRAW_TASK_TYPE_FILL)
+    {
+      return;
+    }
+
+  fill = lv_draw_task_get_fill_dsc(t);
+  if (fill == NULL || !dither_is_supported(fill))
+    {
+      return;
+    }
+
+  lv_draw_task_get_area(t, &area);
+  ver = fill->grad.dir == LV_GRAD_DIR_VER;
+  len = ver ? lv_area_get_height(&area) : lv_area_get_width(&area);
+  if (len < DITHER_MIN_LEN)
+    {
+      return;
+    }
+
+  cross = ver ? lv_area_get_width(&area) : lv_area_get_height(&area);
+  rest = cross % DITHER_TILE;
+  if (rest != 0 && rest_cnt == DITHER_REST_CNT)
+    {
+      stats.skip_cnt++;
+      return;
+    }
+
+  entry = dither_get(&fill->grad, len);
+  if (entry == NULL)
+    {
+      stats.skip_cnt++;
+      return;
+    }
+
+  /* The texture is blitted side by side across the gradient, the original fill is
+   * kept in the queue but made a no-op. img_dsc.tile would take one task, but it
+   * isn't known whether NemaGFX honours it, so only plain blits are queued. */
+  lv_draw_image_dsc_init(&img_dsc);
+  img_dsc.src = &entry->draw_buf;
+
+  part = area;
+  for (pos = 0; pos + DITHER_TILE <= cross; pos += DITHER_TILE)
+    {
+      dither_set_part(&part, &area, ver, pos, DITHER_TILE);
+      lv_draw_image(fill->base.layer, &img_dsc, &part);
+    }
+
+  if (rest != 0)
+    {
+      lv_draw_buf_t *view = &rest_bufs[rest_cnt++];
+      uint32_t stride = entry->draw_buf.header.stride;
+
+      lv_draw_buf_init(view, ver ? rest : len, ver ? len : rest, LV_COLOR_FORMAT_RGB565,
+                       stride, entry->data, stride * (ver ? len : rest));
+      img_dsc.src = view;
+      dither_set_part(&part, &area, ver, pos, rest);
+      lv_draw_image(fill->base.layer, &img_dsc, &part);
+    }
+
+  fill->opa = LV_OPA_TRANSP;
+}
+
+static void
+dither_set_part (lv_area_t       *part,
+                 const lv_area_t *area,
+                 bool             ver,
+                 int32_t          pos,
+                 int32_t          size)
+{
+  if (ver)
+    {
+      part->x1 = area->x1 + pos;
+      part->x2 = part->x1 + size - 1;
+    }
+  else
+    {
+      part->y1 = area->y1 + pos;
+      part->y2 = part->y1 + size - 1;
+    }
+}
+
+static void
+dither_refr_start_cb (lv_event_t *e)
+{
+  uint32_t i;
+
+  LV_UNUSED(e);
+
+  cur_frame++;
+
+  /* the views are reused for other fills now */
+  for (i = 0; i < rest_cnt; i++)
+    {
+      lv_image_cache_drop(&rest_bufs[i]);
+    }
+  rest_cnt = 0;
+}
+
+#endif /* DITHER_ENABLE */
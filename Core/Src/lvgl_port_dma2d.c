@@ -0,0 +1,115 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_dma2d.h"
+#include "lvgl/src/display/lv_display_private.h"
+#include "cmsis_os2.h"
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void
+dma2d_flush_cb (lv_display_t *disp, const lv_area_t *area, uint8_t *px_map);
+
+static void
+dma2d_flush_release (void);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static osSemaphoreId_t dma2d_sem;
+
+static const osSemaphoreAttr_t dma2d_sem_attr =
+{
+  .name = "dma2d",
+};
+
+static lv_display_flush_cb_t orig_flush_cb;
+
+/* the lock is held for a flush's transfer, released by the interrupt or the flush */
+static bool flush_locked;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_dma2d_init (void)
+{
+  if (dma2d_sem == NULL)
+    {
+      dma2d_sem = osSemaphoreNew(1, 1, &dma2d_sem_attr);
+    }
+}
+
+void
+lvgl_dma2d_lock (void)
+{
+  /* before the scheduler starts there is only one user */
+  if (osKernelGetState() == osKernelRunning)
+    {
+      osSemaphoreAcquire(dma2d_sem, osWaitForever);
+    }
+}
+
+void
+lvgl_dma2d_unlock (void)
+{
+  if (osKernelGetState() == osKernelRunning)
+    {
+      osSemaphoreRelease(dma2d_sem);
+    }
+}
+
+void
+lvgl_dma2d_attach (lv_display_t *disp)
+{
+  /* the direct mode swaps the framebuffers, only the partial mode copies with the DMA2D */
+  if (lv_display_get_render_mode(disp) != LV_DISPLAY_RENDER_MODE_PARTIAL)
+    {
+      return;
+    }
+
+  orig_flush_cb = disp->flush_cb;
+  lv_display_set_flush_cb(disp, dma2d_flush_cb);
+}
+
+void
+lvgl_dma2d_irq_handler (void)
+{
+  dma2d_flush_release();
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void
+dma2d_flush_cb (lv_display_t    *disp,
+                const lv_area_t *area,
+                uint8_t         *px_map)
+{
+  lvgl_dma2d_lock();
+  __atomic_store_n(&flush_locked, true, __ATOMIC_RELEASE);
+
+  orig_flush_cb(disp, area, px_map);
+
+  /* a transfer still running is released by its interrupt, which also reports the
+   * flush ready. A flush done already released it then, or didn't use the DMA2D. */
+  if (!disp->flushing)
+    {
+      dma2d_flush_release();
+    }
+}
+
+static void
+dma2d_flush_release (void)
+{
+  if (__atomic_exchange_n(&flush_locked, false, __ATOMIC_ACQ_REL))
+    {
+      lvgl_dma2d_unlock();
+    }
+}
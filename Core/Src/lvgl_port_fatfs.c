@@ -0,0 +1,280 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_fatfs.h"
+#include "lvgl_port_sd.h"
+#include "main.h"
+#include "rtc.h"
+#include "ff.h"
+#include "diskio.h"
+#include "cmsis_os2.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#if LV_USE_FS_FATFS == 0
+  #error "lvgl_port_fatfs requires LV_USE_FS_FATFS"
+#endif
+
+#if FF_FS_REENTRANT == 0 || FF_USE_LFN == 1
+  #error "FatFs isn't configured by Core/Inc/ffconf.h, delete the ffconf.h of FatFs"
+#endif
+
+#define FATFS_CYCLES_TO_US(c)  ((uint32_t)((uint64_t)(c) * 1000000 / SystemCoreClock))
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static FATFS fatfs;
+
+/* the IDMA needs word aligned buffers, others are transferred through this. The disk
+ * functions are only called with the volume locked, so it's used by one task at a time. */
+static __attribute__((aligned(4))) uint8_t bounce_buf[SD_BLOCK_SIZE];
+
+static osMutexId_t volume_mutex[FF_VOLUMES];
+
+static const osMutexAttr_t volume_mutex_attr =
+{
+  .name = "fatfs",
+  .attr_bits = osMutexPrioInherit,
+};
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_fatfs_init (void)
+{
+  /* mounted on the first access, the card can't be read before the kernel runs */
+  f_mount(&fatfs, "", 0);
+}
+
+lv_result_t
+lvgl_fatfs_benchmark (const char         *path,
+                      void               *buf,
+                      uint32_t            buf_size,
+                      lvgl_fatfs_bench_t *bench)
+{
+  lv_fs_file_t file;
+  uint32_t sectors;
+  uint32_t start;
+  uint32_t cycles;
+  uint32_t total = 0;
+  uint32_t max = 0;
+  uint32_t br;
+  uint32_t i;
+
+  lv_memzero(bench, sizeof(*bench));
+
+  if (buf_size < FATFS_BENCH_RANDOM_SIZE || lv_fs_open(&file, path, LV_FS_MODE_RD) != LV_FS_RES_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  /* sequential, e.g. a video or a large image */
+  start = DWT->CYCCNT;
+  do
+    {
+      br = 0;
+      lv_fs_read(&file, buf, buf_size, &br);
+      bench->file_size += br;
+    }
+  while (br == buf_size);
+  cycles = DWT->CYCCNT - start;
+
+  bench->seq_time_ms = FATFS_CYCLES_TO_US(cycles) / 1000;
+  bench->seq_kbyte_per_s = (uint32_t)((uint64_t)bench->file_size * SystemCoreClock / 1024 /
+                                      LV_MAX(cycles, 1));
+
+  /* random, e.g. glyphs of a font or parts of an asset pack */
+  sectors = bench->file_size / FATFS_BENCH_RANDOM_SIZE;
+  for (i = 0; i < FATFS_BENCH_RANDOM_READS && sectors > 0; i++)
+    {
+      start = DWT->CYCCNT;
+      lv_fs_seek(&file, lv_rand(0, sectors - 1) * FATFS_BENCH_RANDOM_SIZE, LV_FS_SEEK_SET);
+      lv_fs_read(&file, buf, FATFS_BENCH_RANDOM_SIZE, &br);
+      cycles = DWT->CYCCNT - start;
+
+      total += cycles;
+      max = LV_MAX(max, cycles);
+    }
+
+  if (i > 0)
+    {
+      bench->random_avg_us = FATFS_CYCLES_TO_US(total / i);
+      bench->random_max_us = FATFS_CYCLES_TO_US(max);
+      bench->random_reads_per_s = 1000000 / LV_MAX(bench->random_avg_us, 1);
+    }
+
+  lv_fs_close(&file);
+
+  return LV_RESULT_OK;
+}
+
+/* FatFs volume lock (FF_FS_REENTRANT), created by f_mount() */
+int
+ff_mutex_create (int vol)
+{
+  if (volume_mutex[vol] == NULL)
+    {
+      volume_mutex[vol] = osMutexNew(&volume_mutex_attr);
+    }
+
+  return volume_mutex[vol] != NULL;
+}
+
+void
+ff_mutex_delete (int vol)
+{
+  osMutexDelete(volume_mutex[vol]);
+  volume_mutex[vol] = NULL;
+}
+
+int
+ff_mutex_take (int vol)
+{
+  return osMutexAcquire(volume_mutex[vol], FF_FS_TIMEOUT) == osOK;
+}
+
+void
+ff_mutex_give (int vol)
+{
+  osMutexRelease(volume_mutex[vol]);
+}
+
+/* FatFs disk I/O functions, the SD card is the only drive */
+DSTATUS
+disk_status (BYTE pdrv)
+{
+  return pdrv == 0 && lvgl_sd_is_ready() ? 0 : STA_NOINIT;
+}
+
+DSTATUS
+disk_initialize (BYTE pdrv)
+{
+  if (pdrv == 0 && !lvgl_sd_is_ready())
+    {
+      lvgl_sd_init();
+    }
+
+  return disk_status(pdrv);
+}
+
+DRESULT
+disk_read (BYTE  pdrv,
+           BYTE *buff,
+           LBA_t sector,
+           UINT  count)
+{
+  UINT i;
+
+  if (disk_status(pdrv) != 0)
+    {
+      return RES_NOTRDY;
+    }
+
+  /* FatFs reads whole clusters straight into the caller's buffer, a run of
+   * sectors is one multi-block transfer */
+  if ((uintptr_t)buff % 4 == 0)
+    {
+      return lvgl_sd_read(sector, buff, count) == LV_RESULT_OK ? RES_OK : RES_ERROR;
+    }
+
+  for (i = 0; i < count; i++)
+    {
+      if (lvgl_sd_read(sector + i, bounce_buf, 1) != LV_RESULT_OK)
+        {
+          return RES_ERROR;
+        }
+      lv_memcpy(buff + i * SD_BLOCK_SIZE, bounce_buf, SD_BLOCK_SIZE);
+    }
+
+  return RES_OK;
+}
+
+DRESULT
+disk_write (BYTE        pdrv,
+            const BYTE *buff,
+            LBA_t       sector,
+            UINT        count)
+{
+  UINT i;
+
+  if (disk_status(pdrv) != 0)
+    {
+      return RES_NOTRDY;
+    }
+
+  if ((uintptr_t)buff % 4 == 0)
+    {
+      return lvgl_sd_write(sector, buff, count) == LV_RESULT_OK ? RES_OK : RES_ERROR;
+    }
+
+  for (i = 0; i < count; i++)
+    {
+      lv_memcpy(bounce_buf, buff + i * SD_BLOCK_SIZE, SD_BLOCK_SIZE);
+      if (lvgl_sd_write(sector + i, bounce_buf, 1) != LV_RESULT_OK)
+        {
+          return RES_ERROR;
+        }
+    }
+
+  return RES_OK;
+}
+
+DRESULT
+disk_ioctl (BYTE  pdrv,
+            BYTE  cmd,
+            void *buff)
+{
+  if (disk_status(pdrv) != 0)
+    {
+      return RES_NOTRDY;
+    }
+
+  switch (cmd)
+    {
+      case CTRL_SYNC:
+        /* writes return when the card is done programming */
+        return RES_OK;
+      case GET_SECTOR_COUNT:
+        *(LBA_t *)buff = lvgl_sd_get_block_count();
+        return RES_OK;
+      case GET_SECTOR_SIZE:
+        *(WORD *)buff = SD_BLOCK_SIZE;
+        return RES_OK;
+      case GET_BLOCK_SIZE:
+        /* erase block size unknown */
+        *(DWORD *)buff = 1;
+        return RES_OK;
+      default:
+        return RES_PARERR;
+    }
+}
+
+DWORD
+get_fattime (void)
+{
+  RTC_TimeTypeDef time = {0};
+  RTC_DateTypeDef date = {0};
+
+  /* the RTC is initialized by the deferred init task, files may be written before */
+  if (hrtc.State != HAL_RTC_STATE_READY)
+    {
+      return ((DWORD)(2025 - 1980) << 25) | (1 << 21) | (1 << 16);
+    }
+
+  /* the date has to be read after the time to unlock the shadow registers */
+  HAL_RTC_GetTime(&hrtc, &time, RTC_FORMAT_BIN);
+  HAL_RTC_GetDate(&hrtc, &date, RTC_FORMAT_BIN);
+
+  return ((DWORD)(date.Year + 20) << 25) | ((DWORD)date.Month << 21) | ((DWORD)date.Date << 16) |
+         ((DWORD)time.Hours << 11) | ((DWORD)time.Minutes << 5) | ((DWORD)time.Seconds / 2);
+}
@@ -0,0 +1,647 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_fs_cache.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define FS_CACHE_FNV_PRIME  0x01000193
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  lv_fs_drv_t          *drv;
+  lv_fs_drv_t           orig;     /* the callbacks of the driver */
+  lvgl_fs_cache_stats_t stats;
+} fs_cache_slot_t;
+
+/* A file's identity, shared by its open handles and its blocks */
+typedef struct
+{
+  uint32_t refs;
+  uint32_t hash;                  /* of the path, compared before the path */
+  uint32_t file_size;             /* a file which changed size is another file */
+  char     path[];                /* of the driver, without the letter */
+} fs_cache_key_t;
+
+typedef struct
+{
+  fs_cache_slot_t *slot;
+  void            *file;          /* of the driver */
+  bool             cached;        /* false for files opened for writing */
+  fs_cache_key_t  *key;
+  uint32_t         size;
+  uint32_t         pos;
+  uint32_t         backend_pos;
+  uint32_t         end_pos;       /* where the last read stopped, to detect sequential reads */
+} fs_cache_file_t;
+
+typedef struct
+{
+  fs_cache_slot_t *slot;          /* NULL if free */
+  fs_cache_key_t  *key;
+  uint32_t         idx;
+  uint32_t         size;
+  uint32_t         stamp;         /* of the last use */
+  bool             ahead;         /* loaded by the read-ahead and not used yet */
+} fs_cache_block_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static fs_cache_slot_t *
+fs_cache_get_slot (const lv_fs_drv_t *drv);
+
+static uint32_t
+fs_cache_hash (const char *path);
+
+static fs_cache_key_t *
+fs_cache_key_get (const fs_cache_slot_t *slot, const char *path, uint32_t file_size);
+
+static void
+fs_cache_key_put (fs_cache_key_t *key);
+
+static void
+fs_cache_free (fs_cache_block_t *block);
+
+static void
+fs_cache_drop (const fs_cache_slot_t *slot, const char *path);
+
+static fs_cache_block_t *
+fs_cache_find (const fs_cache_file_t *file, uint32_t idx);
+
+static fs_cache_block_t *
+fs_cache_get (fs_cache_file_t *file, uint32_t idx, bool sequential);
+
+static fs_cache_block_t *
+fs_cache_load (fs_cache_file_t *file, uint32_t idx, bool ahead);
+
+static lv_fs_res_t
+fs_cache_backend_read (fs_cache_file_t *file, uint32_t pos, void *buf, uint32_t btr, uint32_t *br);
+
+static void *
+fs_cache_open_cb (lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode);
+
+static lv_fs_res_t
+fs_cache_close_cb (lv_fs_drv_t *drv, void *file_p);
+
+static lv_fs_res_t
+fs_cache_read_cb (lv_fs_drv_t *drv, void *file_p, void *buf, uint32_t btr, uint32_t *br);
+
+static lv_fs_res_t
+fs_cache_write_cb (lv_fs_drv_t *drv, void *file_p, const void *buf, uint32_t btw, uint32_t *bw);
+
+static lv_fs_res_t
+fs_cache_seek_cb (lv_fs_drv_t *drv, void *file_p, uint32_t pos, lv_fs_whence_t whence);
+
+static lv_fs_res_t
+fs_cache_tell_cb (lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static fs_cache_slot_t slots[FS_CACHE_DRV_MAX];
+
+static fs_cache_block_t blocks[FS_CACHE_BLOCK_CNT];
+
+/* word aligned, the SD card's DMA can fill the blocks directly */
+static __attribute__((aligned(4))) uint8_t block_data[FS_CACHE_BLOCK_CNT][FS_CACHE_BLOCK_SIZE];
+
+static uint32_t use_cnt;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_result_t
+lvgl_fs_cache_attach (char letter)
+{
+  lv_fs_drv_t *drv = lv_fs_get_drv(letter);
+  fs_cache_slot_t *slot;
+
+  if (drv == NULL || drv->open_cb == NULL || drv->close_cb == NULL || drv->read_cb == NULL ||
+      drv->seek_cb == NULL || drv->tell_cb == NULL || fs_cache_get_slot(drv) != NULL)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  slot = fs_cache_get_slot(NULL);
+  if (slot == NULL)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  slot->drv = drv;
+  slot->orig = *drv;
+
+  /* the blocks replace the per file cache of lv_fs */
+  drv->cache_size = 0;
+  drv->open_cb = fs_cache_open_cb;
+  drv->close_cb = fs_cache_close_cb;
+  drv->read_cb = fs_cache_read_cb;
+  drv->write_cb = slot->orig.write_cb != NULL ? fs_cache_write_cb : NULL;
+  drv->seek_cb = fs_cache_seek_cb;
+  drv->tell_cb = fs_cache_tell_cb;
+
+  return LV_RESULT_OK;
+}
+
+void
+lvgl_fs_cache_invalidate (char letter)
+{
+  uint32_t i;
+
+  for (i = 0; i < FS_CACHE_DRV_MAX; i++)
+    {
+      if (slots[i].drv != NULL && (letter == 0 || slots[i].drv->letter == letter))
+        {
+          fs_cache_drop(&slots[i], NULL);
+        }
+    }
+}
+
+void
+lvgl_fs_cache_get_stats (char                   letter,
+                         lvgl_fs_cache_stats_t *stats)
+{
+  const lvgl_fs_cache_stats_t *s;
+  uint32_t lookups;
+  uint32_t i;
+
+  lv_memzero(stats, sizeof(*stats));
+
+  for (i = 0; i < FS_CACHE_DRV_MAX; i++)
+    {
+      if (slots[i].drv == NULL || (letter != 0 && slots[i].drv->letter != letter))
+        {
+          continue;
+        }
+
+      s = &slots[i].stats;
+      stats->hits += s->hits;
+      stats->misses += s->misses;
+      stats->read_ahead += s->read_ahead;
+      stats->read_ahead_hits += s->read_ahead_hits;
+      stats->backend_reads += s->backend_reads;
+      stats->backend_bytes += s->backend_bytes;
+      stats->direct_bytes += s->direct_bytes;
+    }
+
+  lookups = stats->hits + stats->misses;
+  stats->hit_pct = lookups > 0 ? (uint32_t)((uint64_t)stats->hits * 100 / lookups) : 0;
+}
+
+void
+lvgl_fs_cache_reset_stats (void)
+{
+  uint32_t i;
+
+  for (i = 0; i < FS_CACHE_DRV_MAX; i++)
+    {
+      lv_memzero(&slots[i].stats, sizeof(slots[i].stats));
+    }
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static fs_cache_slot_t *
+fs_cache_get_slot (const lv_fs_drv_t *drv)
+{
+  uint32_t i;
+
+  for (i = 0; i < FS_CACHE_DRV_MAX; i++)
+    {
+      if (slots[i].drv == drv)
+        {
+          return &slots[i];
+        }
+    }
+
+  return NULL;
+}
+
+static uint32_t
+fs_cache_hash (const char *path)
+{
+  uint32_t h = 0x811C9DC5;
+
+  while (*path != '\0')
+    {
+      h ^= (uint8_t)*path++;
+      h *= FS_CACHE_FNV_PRIME;
+    }
+
+  return h;
+}
+
+/* The key of `path` which blocks of the slot use, or a new one */
+static fs_cache_key_t *
+fs_cache_key_get (const fs_cache_slot_t *slot,
+                  const char            *path,
+                  uint32_t               file_size)
+{
+  uint32_t hash = fs_cache_hash(path);
+  size_t len = lv_strlen(path);
+  fs_cache_key_t *key;
+  uint32_t i;
+
+  for (i = 0; i < FS_CACHE_BLOCK_CNT; i++)
+    {
+      key = blocks[i].key;
+      if (blocks[i].slot == slot && key->hash == hash && key->file_size == file_size &&
+          lv_strcmp(key->path, path) == 0)
+        {
+          key->refs++;
+          return key;
+        }
+    }
+
+  key = lv_malloc(sizeof(fs_cache_key_t) + len + 1);
+  if (key == NULL)
+    {
+      return NULL;
+    }
+
+  key->refs = 1;
+  key->hash = hash;
+  key->file_size = file_size;
+  lv_memcpy(key->path, path, len + 1);
+
+  return key;
+}
+
+static void
+fs_cache_key_put (fs_cache_key_t *key)
+{
+  if (--key->refs == 0)
+    {
+      lv_free(key);
+    }
+}
+
+static void
+fs_cache_free (fs_cache_block_t *block)
+{
+  if (block->slot != NULL)
+    {
+      block->slot = NULL;
+      fs_cache_key_put(block->key);
+      block->key = NULL;
+    }
+}
+
+/* Drop the blocks of `path`, or all of the slot with NULL */
+static void
+fs_cache_drop (const fs_cache_slot_t *slot,
+               const char            *path)
+{
+  uint32_t i;
+
+  for (i = 0; i < FS_CACHE_BLOCK_CNT; i++)
+    {
+      if (blocks[i].slot == slot && (path == NULL || lv_strcmp(blocks[i].key->path, path) == 0))
+        {
+          fs_cache_free(&blocks[i]);
+        }
+    }
+}
+
+static fs_cache_block_t *
+fs_cache_find (const fs_cache_file_t *file,
+               uint32_t               idx)
+{
+  uint32_t i;
+
+  /* a few dozen blocks, a scan is cheaper than keeping an index up to date */
+  for (i = 0; i < FS_CACHE_BLOCK_CNT; i++)
+    {
+      if (blocks[i].slot == file->slot && blocks[i].key == file->key && blocks[i].idx == idx)
+        {
+          return &blocks[i];
+        }
+    }
+
+  return NULL;
+}
+
+static fs_cache_block_t *
+fs_cache_get (fs_cache_file_t *file,
+              uint32_t         idx,
+              bool             sequential)
+{
+  lvgl_fs_cache_stats_t *stats = &file->slot->stats;
+  fs_cache_block_t *block = fs_cache_find(file, idx);
+  uint32_t i;
+
+  if (block != NULL)
+    {
+      stats->hits++;
+      if (block->ahead)
+        {
+          stats->read_ahead_hits++;
+          block->ahead = false;
+        }
+      block->stamp = ++use_cnt;
+      return block;
+    }
+
+  stats->misses++;
+  block = fs_cache_load(file, idx, false);
+
+  /* a reader which continues where it stopped gets the next blocks in the same
+   * pass, the driver reads on without seeking. Random reads don't, most of
+   * the blocks would be replaced unused. */
+  for (i = 1; block != NULL && sequential && i <= FS_CACHE_READ_AHEAD; i++)
+    {
+      if ((idx + i) * FS_CACHE_BLOCK_SIZE >= file->size || fs_cache_find(file, idx + i) != NULL ||
+          fs_cache_load(file, idx + i, true) == NULL)
+        {
+          break;
+        }
+      stats->read_ahead++;
+    }
+
+  return block;
+}
+
+static fs_cache_block_t *
+fs_cache_load (fs_cache_file_t *file,
+               uint32_t         idx,
+               bool             ahead)
+{
+  fs_cache_block_t *block = &blocks[0];
+  uint32_t br;
+  uint32_t i;
+
+  for (i = 0; i < FS_CACHE_BLOCK_CNT && block->slot != NULL; i++)
+    {
+      if (blocks[i].slot == NULL || blocks[i].stamp < block->stamp)
+        {
+          block = &blocks[i];
+        }
+    }
+
+  fs_cache_free(block);
+  if (fs_cache_backend_read(file, idx * FS_CACHE_BLOCK_SIZE, block_data[block - blocks],
+                            FS_CACHE_BLOCK_SIZE, &br) != LV_FS_RES_OK || br == 0)
+    {
+      return NULL;
+    }
+
+  block->slot = file->slot;
+  block->key = file->key;
+  block->key->refs++;
+  block->idx = idx;
+  block->size = br;
+  block->ahead = ahead;
+  block->stamp = ++use_cnt;
+
+  return block;
+}
+
+static lv_fs_res_t
+fs_cache_backend_read (fs_cache_file_t *file,
+                       uint32_t         pos,
+                       void            *buf,
+                       uint32_t         btr,
+                       uint32_t        *br)
+{
+  fs_cache_slot_t *slot = file->slot;
+  lv_fs_res_t res;
+
+  *br = 0;
+
+  if (file->backend_pos != pos)
+    {
+      res = slot->orig.seek_cb(slot->drv, file->file, pos, LV_FS_SEEK_SET);
+      if (res != LV_FS_RES_OK)
+        {
+          return res;
+        }
+      file->backend_pos = pos;
+    }
+
+  res = slot->orig.read_cb(slot->drv, file->file, buf, btr, br);
+  file->backend_pos += *br;
+
+  slot->stats.backend_reads++;
+  slot->stats.backend_bytes += *br;
+
+  return res;
+}
+
+static void *
+fs_cache_open_cb (lv_fs_drv_t *drv,
+                  const char  *path,
+                  lv_fs_mode_t mode)
+{
+  fs_cache_slot_t *slot = fs_cache_get_slot(drv);
+  fs_cache_file_t *file;
+
+  file = lv_malloc_zeroed(sizeof(fs_cache_file_t));
+  if (file == NULL)
+    {
+      return NULL;
+    }
+
+  file->file = slot->orig.open_cb(drv, path, mode);
+  if (file->file == NULL)
+    {
+      lv_free(file);
+      return NULL;
+    }
+
+  file->slot = slot;
+
+  if (mode & LV_FS_MODE_WR)
+    {
+      /* the blocks of the file are stale from the first write */
+      fs_cache_drop(slot, path);
+    }
+  else if (slot->orig.seek_cb(drv, file->file, 0, LV_FS_SEEK_END) != LV_FS_RES_OK ||
+           slot->orig.tell_cb(drv, file->file, &file->size) != LV_FS_RES_OK ||
+           slot->orig.seek_cb(drv, file->file, 0, LV_FS_SEEK_SET) != LV_FS_RES_OK)
+    {
+      slot->orig.close_cb(drv, file->file);
+      lv_free(file);
+      return NULL;
+    }
+
+  /* blocks are only shared by opens of the same path and size, a writer keeps the
+   * path to drop what readers loaded meanwhile */
+  file->key = fs_cache_key_get(slot, path, file->size);
+  if (file->key == NULL)
+    {
+      slot->orig.close_cb(drv, file->file);
+      lv_free(file);
+      return NULL;
+    }
+
+  file->cached = !(mode & LV_FS_MODE_WR);
+
+  return file;
+}
+
+static lv_fs_res_t
+fs_cache_close_cb (lv_fs_drv_t *drv,
+                   void        *file_p)
+{
+  fs_cache_file_t *file = file_p;
+  lv_fs_res_t res = file->slot->orig.close_cb(drv, file->file);
+
+  if (!file->cached)
+    {
+      /* a reader may have loaded blocks while the file was written */
+      fs_cache_drop(file->slot, file->key->path);
+    }
+
+  fs_cache_key_put(file->key);
+  lv_free(file);
+
+  return res;
+}
+
+static lv_fs_res_t
+fs_cache_read_cb (lv_fs_drv_t *drv,
+                  void        *file_p,
+                  void        *buf,
+                  uint32_t     btr,
+                  uint32_t    *br)
+{
+  fs_cache_file_t *file = file_p;
+  fs_cache_block_t *block;
+  uint8_t *dst = buf;
+  bool sequential;
+  uint32_t idx;
+  uint32_t off;
+  uint32_t n;
+  lv_fs_res_t res;
+
+  if (!file->cached)
+    {
+      return file->slot->orig.read_cb(drv, file->file, buf, btr, br);
+    }
+
+  *br = 0;
+  btr = LV_MIN(btr, file->size - file->pos);
+  sequential = file->pos > 0 && file->pos == file->end_pos;
+
+  while (btr > 0)
+    {
+      idx = file->pos / FS_CACHE_BLOCK_SIZE;
+      off = file->pos % FS_CACHE_BLOCK_SIZE;
+
+      /* large reads, e.g. a whole image, would only push out the small ones */
+      if (off == 0 && btr >= FS_CACHE_BLOCK_SIZE && fs_cache_find(file, idx) == NULL)
+        {
+          res = fs_cache_backend_read(file, file->pos, dst, btr - btr % FS_CACHE_BLOCK_SIZE, &n);
+          if (res != LV_FS_RES_OK)
+            {
+              return res;
+            }
+          file->slot->stats.direct_bytes += n;
+        }
+      else
+        {
+          block = fs_cache_get(file, idx, sequential);
+          if (block == NULL)
+            {
+              return LV_FS_RES_HW_ERR;
+            }
+          n = block->size > off ? LV_MIN(btr, block->size - off) : 0;
+          lv_memcpy(dst, block_data[block - blocks] + off, n);
+        }
+
+      if (n == 0)
+        {
+          /* the file is shorter than when it was opened */
+          break;
+        }
+
+      file->pos += n;
+      dst += n;
+      btr -= n;
+      *br += n;
+    }
+  file->end_pos = file->pos;
+
+  return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t
+fs_cache_write_cb (lv_fs_drv_t *drv,
+                   void        *file_p,
+                   const void  *buf,
+                   uint32_t     btw,
+                   uint32_t    *bw)
+{
+  fs_cache_file_t *file = file_p;
+
+  if (file->cached)
+    {
+      return LV_FS_RES_DENIED;
+    }
+
+  return file->slot->orig.write_cb(drv, file->file, buf, btw, bw);
+}
+
+static lv_fs_res_t
+fs_cache_seek_cb (lv_fs_drv_t   *drv,
+                  void          *file_p,
+                  uint32_t       pos,
+                  lv_fs_whence_t whence)
+{
+  fs_cache_file_t *file = file_p;
+
+  if (!file->cached)
+    {
+      return file->slot->orig.seek_cb(drv, file->file, pos, whence);
+    }
+
+  switch (whence)
+    {
+      case LV_FS_SEEK_CUR:
+        pos += file->pos;
+        break;
+      case LV_FS_SEEK_END:
+        pos += file->size;
+        break;
+      default:
+        break;
+    }
+
+  if (pos > file->size)
+    {
+      return LV_FS_RES_INV_PARAM;
+    }
+  file->pos = pos;
+
+  return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t
+fs_cache_tell_cb (lv_fs_drv_t *drv,
+                  void        *file_p,
+                  uint32_t    *pos_p)
+{
+  fs_cache_file_t *file = file_p;
+
+  if (!file->cached)
+    {
+      return file->slot->orig.tell_cb(drv, file->file, pos_p);
+    }
+
+  *pos_p = file->pos;
+
+  return LV_FS_RES_OK;
+}
@@ -0,0 +1,105 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_image_cache.h"
+#include "lvgl/src/draw/lv_draw_buf_private.h"
+#include "lvgl/src/stdlib/builtin/lv_tlsf.h"
+
+#if IMAGE_CACHE_ENABLE
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#if LV_CACHE_DEF_SIZE == 0
+  #error "lvgl_port_image_cache requires LV_CACHE_DEF_SIZE"
+#endif
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void *
+image_cache_malloc (size_t size, lv_color_format_t color_format);
+
+static void
+image_cache_free (void *buf);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static __attribute__((aligned(IMAGE_CACHE_ALIGN))) uint8_t pool_arena[IMAGE_CACHE_POOL_SIZE];
+static lv_tlsf_t pool_tlsf;
+
+static lvgl_image_cache_stats_t stats;
+
+static lv_draw_buf_malloc_cb heap_malloc_cb;
+static lv_draw_buf_free_cb heap_free_cb;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_image_cache_init (void)
+{
+  /* decoders allocate their output with the image handlers, layers and fonts
+   * use their own handlers and aren't affected */
+  lv_draw_buf_handlers_t *handlers = lv_draw_buf_get_image_handlers();
+
+  pool_tlsf = lv_tlsf_create_with_pool(pool_arena, sizeof(pool_arena));
+
+  heap_malloc_cb = handlers->buf_malloc_cb;
+  heap_free_cb = handlers->buf_free_cb;
+  handlers->buf_malloc_cb = image_cache_malloc;
+  handlers->buf_free_cb = image_cache_free;
+}
+
+void
+lvgl_image_cache_get_stats (lvgl_image_cache_stats_t *stats_out)
+{
+  *stats_out = stats;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void *
+image_cache_malloc (size_t            size,
+                    lv_color_format_t color_format)
+{
+  void *buf = lv_tlsf_memalign(pool_tlsf, IMAGE_CACHE_ALIGN, size);
+
+  if (buf == NULL)
+    {
+      stats.fallback_cnt++;
+      return heap_malloc_cb(size, color_format);
+    }
+
+  stats.used_bytes += lv_tlsf_block_size(buf);
+  if (stats.used_bytes > stats.peak_bytes)
+    {
+      stats.peak_bytes = stats.used_bytes;
+    }
+
+  return buf;
+}
+
+static void
+image_cache_free (void *buf)
+{
+  if ((uint8_t *)buf >= pool_arena && (uint8_t *)buf < pool_arena + IMAGE_CACHE_POOL_SIZE)
+    {
+      stats.used_bytes -= lv_tlsf_block_size(buf);
+      lv_tlsf_free(pool_tlsf, buf);
+    }
+  else
+    {
+      heap_free_cb(buf);
+    }
+}
+
+#endif /* IMAGE_CACHE_ENABLE */
@@ -0,0 +1,405 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_jpeg.h"
+#include "main.h"
+#include "lvgl/src/draw/lv_image_decoder_private.h"
+#include "lvgl/src/libs/tjpgd/tjpgd.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#if LV_USE_TJPGD == 0
+  #error "lvgl_port_jpeg requires LV_USE_TJPGD for the TJpgDec library"
+#endif
+
+/* the MCU bitmaps TJpgDec outputs are R, G, B bytes or RGB565 */
+#if JD_FORMAT != 0 && JD_FORMAT != 1
+  #error "lvgl_port_jpeg needs a color JD_FORMAT"
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  const uint8_t *data;    /* C array or memory-mapped flash */
+  uint32_t       size;
+  uint32_t       pos;
+  lv_fs_file_t  *file;    /* ... or a file */
+} jpeg_io_t;
+
+/* the JDEC device of a decoding */
+typedef struct
+{
+  lvgl_jpeg_in_cb_t in_cb;
+  void             *user_data;
+  uint8_t          *dst;
+  uint32_t          dst_stride;
+} jpeg_ctx_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static bool
+jpeg_is_jpeg_file (const char *path);
+
+static lv_result_t
+jpeg_io_open (const lv_image_decoder_dsc_t *dsc, jpeg_io_t *io, lv_fs_file_t *file);
+
+static void
+jpeg_io_close (jpeg_io_t *io);
+
+static size_t
+jpeg_io_read (void *user_data, uint8_t *buf, size_t len);
+
+static JRESULT
+jpeg_decomp (JDEC *jd, uint8_t *dst, uint32_t dst_stride);
+
+static size_t
+jpeg_in_func (JDEC *jd, uint8_t *buf, size_t len);
+
+static int
+jpeg_out_func (JDEC *jd, void *bitmap, JRECT *rect);
+
+static lv_result_t
+jpeg_info_cb (lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc, lv_image_header_t *header);
+
+static lv_result_t
+jpeg_open_cb (lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc);
+
+static void
+jpeg_close_cb (lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/* work area of the LVGL task, other tasks bring their own */
+static __attribute__((aligned(4))) uint8_t work[JPEG_WORK_SIZE];
+
+static lvgl_jpeg_stats_t stats;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_jpeg_init (void)
+{
+  lv_image_decoder_t *decoder = lv_image_decoder_create();
+
+  lv_image_decoder_set_info_cb(decoder, jpeg_info_cb);
+  lv_image_decoder_set_open_cb(decoder, jpeg_open_cb);
+  lv_image_decoder_set_close_cb(decoder, jpeg_close_cb);
+
+  DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+lv_result_t
+lvgl_jpeg_decode (lvgl_jpeg_job_t *job)
+{
+  jpeg_ctx_t ctx = {0};
+  JDEC jd;
+  JRESULT res;
+
+  ctx.in_cb = job->in_cb;
+  ctx.user_data = job->user_data;
+
+  res = jd_prepare(&jd, jpeg_in_func, job->work, job->work_size, &ctx);
+  if (res != JDR_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  job->w = jd.width;
+  job->h = jd.height;
+  job->work_used = job->work_size - jd.sz_pool;
+
+  if (jd.width > job->max_w || jd.height > job->max_h)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  res = jpeg_decomp(&jd, job->dst, job->dst_stride != 0 ? job->dst_stride : jd.width * 2);
+
+  return res == JDR_OK ? LV_RESULT_OK : LV_RESULT_INVALID;
+}
+
+void
+lvgl_jpeg_get_stats (lvgl_jpeg_stats_t *stats_out)
+{
+  *stats_out = stats;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static bool
+jpeg_is_jpeg_file (const char *path)
+{
+  const char *ext = lv_fs_get_ext(path);
+
+  return lv_strcmp(ext, "jpg") == 0 || lv_strcmp(ext, "JPG") == 0 ||
+         lv_strcmp(ext, "jpeg") == 0 || lv_strcmp(ext, "JPEG") == 0;
+}
+
+static lv_result_t
+jpeg_io_open (const lv_image_decoder_dsc_t *dsc,
+              jpeg_io_t                    *io,
+              lv_fs_file_t                 *file)
+{
+  lv_memzero(io, sizeof(*io));
+
+  if (dsc->src_type == LV_IMAGE_SRC_VARIABLE)
+    {
+      const lv_image_dsc_t *img = dsc->src;
+
+      /* JPEG data starts with the SOI marker */
+      if ((img->header.cf != LV_COLOR_FORMAT_RAW && img->header.cf != LV_COLOR_FORMAT_RAW_ALPHA) ||
+          img->data_size < 2 || img->data[0] != 0xFF || img->data[1] != 0xD8)
+        {
+          return LV_RESULT_INVALID;
+        }
+
+      io->data = img->data;
+      io->size = img->data_size;
+      return LV_RESULT_OK;
+    }
+
+  if (dsc->src_type == LV_IMAGE_SRC_FILE && jpeg_is_jpeg_file(dsc->src) &&
+      lv_fs_open(file, dsc->src, LV_FS_MODE_RD) == LV_FS_RES_OK)
+    {
+      io->file = file;
+      return LV_RESULT_OK;
+    }
+
+  return LV_RESULT_INVALID;
+}
+
+static void
+jpeg_io_close (jpeg_io_t *io)
+{
+  if (io->file != NULL)
+    {
+      lv_fs_close(io->file);
+    }
+}
+
+static size_t
+jpeg_io_read (void    *user_data,
+              uint8_t *buf,
+              size_t   len)
+{
+  jpeg_io_t *io = user_data;
+  uint32_t rn = 0;
+
+  if (io->file != NULL)
+    {
+      if (buf != NULL)
+        {
+          lv_fs_read(io->file, buf, len, &rn);
+        }
+      else if (lv_fs_seek(io->file, len, LV_FS_SEEK_CUR) == LV_FS_RES_OK)
+        {
+          rn = len;
+        }
+      return rn;
+    }
+
+  rn = LV_MIN(len, io->size - io->pos);
+  if (buf != NULL)
+    {
+      lv_memcpy(buf, io->data + io->pos, rn);
+    }
+  io->pos += rn;
+
+  return rn;
+}
+
+static JRESULT
+jpeg_decomp (JDEC     *jd,
+             uint8_t  *dst,
+             uint32_t  dst_stride)
+{
+  jpeg_ctx_t *ctx = jd->device;
+
+  ctx->dst = dst;
+  ctx->dst_stride = dst_stride;
+
+  return jd_decomp(jd, jpeg_out_func, 0);
+}
+
+static size_t
+jpeg_in_func (JDEC    *jd,
+              uint8_t *buf,
+              size_t   len)
+{
+  jpeg_ctx_t *ctx = jd->device;
+
+  return ctx->in_cb(ctx->user_data, buf, len);
+}
+
+static int
+jpeg_out_func (JDEC  *jd,
+               void  *bitmap,
+               JRECT *rect)
+{
+  jpeg_ctx_t *ctx = jd->device;
+  uint32_t w = rect->right - rect->left + 1;
+  uint32_t h = rect->bottom - rect->top + 1;
+  uint32_t y;
+
+  /* TJpgDec has converted the MCU from YCbCr already, it's only copied to its place
+   * in the image. A DMA2D transfer per MCU would convert at most RGB888 to RGB565,
+   * and it would have to be waited for, as TJpgDec reuses the bitmap. */
+  for (y = 0; y < h; y++)
+    {
+      uint16_t *row = (uint16_t *)(ctx->dst + (rect->top + y) * ctx->dst_stride + rect->left * 2);
+
+#if JD_FORMAT == 0
+      const uint8_t *src = (const uint8_t *)bitmap + y * w * 3;
+      uint32_t x;
+
+      for (x = 0; x < w; x++)
+        {
+          row[x] = (uint16_t)(((src[0] & 0xf8) << 8) | ((src[1] & 0xfc) << 3) | (src[2] >> 3));
+          src += 3;
+        }
+#else
+      lv_memcpy(row, (const uint16_t *)bitmap + y * w, w * 2);
+#endif
+    }
+
+  return 1;
+}
+
+static lv_result_t
+jpeg_info_cb (lv_image_decoder_t     *decoder,
+              lv_image_decoder_dsc_t *dsc,
+              lv_image_header_t      *header)
+{
+  lv_fs_file_t file;
+  jpeg_io_t io;
+  jpeg_ctx_t ctx = {jpeg_io_read, &io};
+  JDEC jd;
+  JRESULT res;
+
+  LV_UNUSED(decoder);
+
+  if (jpeg_io_open(dsc, &io, &file) != LV_RESULT_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  res = jd_prepare(&jd, jpeg_in_func, work, sizeof(work), &ctx);
+  jpeg_io_close(&io);
+
+  if (res != JDR_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  lv_memzero(header, sizeof(*header));
+  header->magic = LV_IMAGE_HEADER_MAGIC;
+  header->cf = LV_COLOR_FORMAT_RGB565;
+  header->w = jd.width;
+  header->h = jd.height;
+  header->stride = lv_draw_buf_width_to_stride(jd.width, LV_COLOR_FORMAT_RGB565);
+
+  return LV_RESULT_OK;
+}
+
+static lv_result_t
+jpeg_open_cb (lv_image_decoder_t     *decoder,
+              lv_image_decoder_dsc_t *dsc)
+{
+  lv_image_cache_data_t search_key;
+  lv_cache_entry_t *entry;
+  lv_draw_buf_t *decoded = NULL;
+  lv_fs_file_t file;
+  jpeg_io_t io;
+  jpeg_ctx_t ctx = {jpeg_io_read, &io};
+  JDEC jd;
+  JRESULT res;
+  uint32_t start = DWT->CYCCNT;
+
+  if (jpeg_io_open(dsc, &io, &file) != LV_RESULT_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  res = jd_prepare(&jd, jpeg_in_func, work, sizeof(work), &ctx);
+  if (res == JDR_OK)
+    {
+      decoded = lv_draw_buf_create_ex(lv_draw_buf_get_image_handlers(), jd.width, jd.height,
+                                      LV_COLOR_FORMAT_RGB565, LV_STRIDE_AUTO);
+      if (decoded == NULL)
+        {
+          res = JDR_MEM1;
+        }
+    }
+
+  if (res == JDR_OK)
+    {
+      res = jpeg_decomp(&jd, decoded->data, decoded->header.stride);
+    }
+  jpeg_io_close(&io);
+
+  if (res != JDR_OK)
+    {
+      LV_LOG_WARN("JPEG decoding failed (%d)", (int)res);
+      if (decoded != NULL)
+        {
+          lv_draw_buf_destroy(decoded);
+        }
+      return LV_RESULT_INVALID;
+    }
+
+  stats.w = jd.width;
+  stats.h = jd.height;
+  stats.time_us = (uint32_t)((uint64_t)(DWT->CYCCNT - start) * 1000000 / SystemCoreClock);
+  stats.work_bytes = sizeof(work) - jd.sz_pool;
+  stats.peak_bytes = stats.work_bytes + decoded->data_size;
+
+  dsc->decoded = decoded;
+
+  if (dsc->args.no_cache || !lv_image_cache_is_enabled())
+    {
+      return LV_RESULT_OK;
+    }
+
+  search_key.src_type = dsc->src_type;
+  search_key.src = dsc->src;
+  search_key.slot.size = decoded->data_size;
+
+  entry = lv_image_decoder_add_to_cache(decoder, &search_key, decoded, NULL);
+  if (entry == NULL)
+    {
+      lv_draw_buf_destroy(decoded);
+      dsc->decoded = NULL;
+      return LV_RESULT_INVALID;
+    }
+  dsc->cache_entry = entry;
+
+  return LV_RESULT_OK;
+}
+
+static void
+jpeg_close_cb (lv_image_decoder_t     *decoder,
+               lv_image_decoder_dsc_t *dsc)
+{
+  LV_UNUSED(decoder);
+
+  /* cached images are freed by the cache on eviction */
+  if (dsc->args.no_cache || !lv_image_cache_is_enabled())
+    {
+      lv_draw_buf_destroy((lv_draw_buf_t *)dsc->decoded);
+    }
+}
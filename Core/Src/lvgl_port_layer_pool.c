@@ -0,0 +1,257 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_layer_pool.h"
+#include "lvgl/src/draw/lv_draw_buf_private.h"
+
+#if LAYER_POOL_ENABLE
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define POOL_ALIGN_UP(x)  (((x) + LAYER_POOL_ALIGN - 1) & ~(uint32_t)(LAYER_POOL_ALIGN - 1))
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint8_t  *buf;
+  uint32_t  size;
+  bool      used;
+} layer_slot_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void *
+layer_pool_malloc (size_t size, lv_color_format_t color_format);
+
+static void
+layer_pool_free (void *buf);
+
+static layer_slot_t *
+layer_pool_split (layer_slot_t *slot, uint32_t size);
+
+static void
+layer_pool_merge (uint32_t i);
+
+static void
+layer_pool_refr_start_cb (lv_event_t *e);
+
+static void
+layer_pool_refr_ready_cb (lv_event_t *e);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static __attribute__((aligned(LAYER_POOL_ALIGN))) uint8_t pool_arena[LAYER_POOL_SIZE];
+static uint32_t arena_used;
+
+static layer_slot_t slots[LAYER_POOL_SLOT_CNT];
+static uint32_t slot_cnt;
+static uint32_t pooled_bytes;
+static bool rendering;
+
+static lvgl_layer_pool_stats_t frame_stats;
+static lvgl_layer_pool_stats_t last_stats;
+
+static lv_draw_buf_malloc_cb heap_malloc_cb;
+static lv_draw_buf_free_cb heap_free_cb;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_layer_pool_init (lv_display_t *disp)
+{
+  /* layers are created with the default draw buffer handlers, so hook them and
+   * keep the original ones for the buffers allocated outside of a refresh and for
+   * the requests the arena can't serve */
+  lv_draw_buf_handlers_t *handlers = lv_draw_buf_get_handlers();
+
+  heap_malloc_cb = handlers->buf_malloc_cb;
+  heap_free_cb = handlers->buf_free_cb;
+  handlers->buf_malloc_cb = layer_pool_malloc;
+  handlers->buf_free_cb = layer_pool_free;
+
+  lv_display_add_event_cb(disp, layer_pool_refr_start_cb, LV_EVENT_REFR_START, NULL);
+  lv_display_add_event_cb(disp, layer_pool_refr_ready_cb, LV_EVENT_REFR_READY, NULL);
+}
+
+void
+lvgl_layer_pool_get_stats (lvgl_layer_pool_stats_t *stats)
+{
+  *stats = last_stats;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void *
+layer_pool_malloc (size_t size,
+                   lv_color_format_t color_format)
+{
+  layer_slot_t *best = NULL;
+  uint32_t size_aligned = POOL_ALIGN_UP((uint32_t)size);
+  uint32_t i;
+
+  if (!rendering)
+    {
+      return heap_malloc_cb(size, color_format);
+    }
+
+  frame_stats.alloc_cnt++;
+
+  /* best fit among the released buffers, same-size layers hit exactly */
+  for (i = 0; i < slot_cnt; i++)
+    {
+      if (!slots[i].used && slots[i].size >= size_aligned &&
+          (best == NULL || slots[i].size < best->size))
+        {
+          best = &slots[i];
+        }
+    }
+
+  /* a small layer doesn't hold a large buffer, the rest of it stays free */
+  if (best != NULL && best->size - size_aligned > LAYER_POOL_SLACK_MAX)
+    {
+      best = layer_pool_split(best, size_aligned);
+    }
+
+  if (best != NULL)
+    {
+      frame_stats.reuse_cnt++;
+    }
+  else if (slot_cnt < LAYER_POOL_SLOT_CNT && arena_used + size_aligned <= LAYER_POOL_SIZE)
+    {
+      best = &slots[slot_cnt++];
+      best->buf = &pool_arena[arena_used];
+      best->size = size_aligned;
+      arena_used += size_aligned;
+    }
+
+  if (best == NULL)
+    {
+      frame_stats.fallback_cnt++;
+      return heap_malloc_cb(size, color_format);
+    }
+
+  best->used = true;
+  pooled_bytes += best->size;
+  if (pooled_bytes > frame_stats.peak_bytes)
+    {
+      frame_stats.peak_bytes = pooled_bytes;
+    }
+
+  return best->buf;
+}
+
+static void
+layer_pool_free (void *buf)
+{
+  uint32_t i;
+
+  if ((uint8_t *)buf >= pool_arena && (uint8_t *)buf < pool_arena + LAYER_POOL_SIZE)
+    {
+      for (i = 0; i < slot_cnt; i++)
+        {
+          if (slots[i].buf == buf)
+            {
+              slots[i].used = false;
+              pooled_bytes -= slots[i].size;
+              layer_pool_merge(i);
+              return;
+            }
+        }
+    }
+  else
+    {
+      heap_free_cb(buf);
+    }
+}
+
+/* Split `slot` after `size` bytes, NULL if no slot is left for the tail */
+static layer_slot_t *
+layer_pool_split (layer_slot_t *slot,
+                  uint32_t      size)
+{
+  uint32_t i = slot - slots;
+
+  if (slot_cnt == LAYER_POOL_SLOT_CNT)
+    {
+      return NULL;
+    }
+
+  lv_memmove(&slots[i + 2], &slots[i + 1], (slot_cnt - i - 1) * sizeof(layer_slot_t));
+  slots[i + 1].buf = slot->buf + size;
+  slots[i + 1].size = slot->size - size;
+  slots[i + 1].used = false;
+  slot->size = size;
+  slot_cnt++;
+
+  return slot;
+}
+
+/* The slots are carved in address order, so the free neighbours of the slot `i` are
+ * merged into one and a free slot at the end goes back to the arena */
+static void
+layer_pool_merge (uint32_t i)
+{
+  if (i + 1 < slot_cnt && !slots[i + 1].used)
+    {
+      slots[i].size += slots[i + 1].size;
+      lv_memmove(&slots[i + 1], &slots[i + 2], (slot_cnt - i - 2) * sizeof(layer_slot_t));
+      slot_cnt--;
+    }
+
+  if (i > 0 && !slots[i - 1].used)
+    {
+      slots[i - 1].size += slots[i].size;
+      lv_memmove(&slots[i], &slots[i + 1], (slot_cnt - i - 1) * sizeof(layer_slot_t));
+      slot_cnt--;
+      i--;
+    }
+
+  if (i == slot_cnt - 1)
+    {
+      arena_used -= slots[i].size;
+      slot_cnt--;
+    }
+}
+
+static void
+layer_pool_refr_start_cb (lv_event_t *e)
+{
+  LV_UNUSED(e);
+
+  lv_memzero(&frame_stats, sizeof(frame_stats));
+  frame_stats.peak_bytes = pooled_bytes;
+  rendering = true;
+}
+
+static void
+layer_pool_refr_ready_cb (lv_event_t *e)
+{
+  LV_UNUSED(e);
+
+  rendering = false;
+  frame_stats.arena_bytes = arena_used;
+  last_stats = frame_stats;
+
+  if (last_stats.alloc_cnt != 0)
+    {
+      LV_LOG_TRACE("layers: %u allocs, %u reused, %u fallback, peak %u bytes",
+                   (unsigned int)last_stats.alloc_cnt, (unsigned int)last_stats.reuse_cnt,
+                   (unsigned int)last_stats.fallback_cnt, (unsigned int)last_stats.peak_bytes);
+    }
+}
+
+#endif /* LAYER_POOL_ENABLE */
@@ -0,0 +1,201 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_littlefs.h"
+#include "lvgl_port_ospi.h"
+#include "lfs.h"
+#include "cmsis_os2.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#if LV_USE_FS_LITTLEFS == 0
+  #error "lvgl_port_littlefs requires LV_USE_FS_LITTLEFS"
+#endif
+
+#if LITTLEFS_CACHE_SIZE > OSPI_PAGE_SIZE || OSPI_SECTOR_SIZE % LITTLEFS_CACHE_SIZE != 0
+  #error "LITTLEFS_CACHE_SIZE has to divide the sector size and fit in a page"
+#endif
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static int
+littlefs_read (const struct lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer,
+               lfs_size_t size);
+
+static int
+littlefs_prog (const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer,
+               lfs_size_t size);
+
+static int
+littlefs_erase (const struct lfs_config *c, lfs_block_t block);
+
+static int
+littlefs_sync (const struct lfs_config *c);
+
+#ifdef LFS_THREADSAFE
+static int
+littlefs_lock (const struct lfs_config *c);
+
+static int
+littlefs_unlock (const struct lfs_config *c);
+#endif
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static lfs_t lfs;
+static struct lfs_config cfg;
+
+static __attribute__((aligned(4))) uint8_t read_buf[LITTLEFS_CACHE_SIZE];
+static __attribute__((aligned(4))) uint8_t prog_buf[LITTLEFS_CACHE_SIZE];
+static __attribute__((aligned(4))) uint8_t lookahead_buf[LITTLEFS_LOOKAHEAD_SIZE];
+
+#ifdef LFS_THREADSAFE
+static osMutexId_t littlefs_mutex;
+#endif
+
+static bool mounted;
+static lvgl_littlefs_stats_t stats;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_result_t
+lvgl_littlefs_init (void)
+{
+  int err;
+
+  cfg.read = littlefs_read;
+  cfg.prog = littlefs_prog;
+  cfg.erase = littlefs_erase;
+  cfg.sync = littlefs_sync;
+#ifdef LFS_THREADSAFE
+  littlefs_mutex = osMutexNew(NULL);
+  cfg.lock = littlefs_lock;
+  cfg.unlock = littlefs_unlock;
+#endif
+
+  cfg.read_size = LITTLEFS_READ_SIZE;
+  cfg.prog_size = LITTLEFS_PROG_SIZE;
+  cfg.block_size = OSPI_SECTOR_SIZE;
+  cfg.block_count = LITTLEFS_FLASH_SIZE / OSPI_SECTOR_SIZE;
+  cfg.block_cycles = LITTLEFS_BLOCK_CYCLES;
+  cfg.cache_size = LITTLEFS_CACHE_SIZE;
+  cfg.lookahead_size = LITTLEFS_LOOKAHEAD_SIZE;
+  cfg.read_buffer = read_buf;
+  cfg.prog_buffer = prog_buf;
+  cfg.lookahead_buffer = lookahead_buf;
+
+  /* only a region without a valid superblock is formatted (the first boot), other
+   * errors, e.g. of the flash or a newer on-disk version, leave the files alone */
+  err = lfs_mount(&lfs, &cfg);
+  if (err == LFS_ERR_CORRUPT)
+    {
+      LV_LOG_WARN("formatting the LittleFS region (mount: %d)", err);
+      err = lfs_format(&lfs, &cfg);
+      if (err == LFS_ERR_OK)
+        {
+          err = lfs_mount(&lfs, &cfg);
+        }
+    }
+
+  if (err != LFS_ERR_OK)
+    {
+      LV_LOG_ERROR("LittleFS can't be mounted (%d)", err);
+      return LV_RESULT_INVALID;
+    }
+  mounted = true;
+
+  lv_littlefs_set_handler(&lfs);
+
+  return LV_RESULT_OK;
+}
+
+void
+lvgl_littlefs_get_stats (lvgl_littlefs_stats_t *stats_out)
+{
+  lfs_ssize_t used = mounted ? lfs_fs_size(&lfs) : 0;
+
+  stats.block_size = cfg.block_size;
+  stats.block_count = cfg.block_count;
+  stats.blocks_used = used > 0 ? used : 0;
+  *stats_out = stats;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static int
+littlefs_read (const struct lfs_config *c,
+               lfs_block_t              block,
+               lfs_off_t                off,
+               void                    *buffer,
+               lfs_size_t               size)
+{
+  /* no command needed, the mapped flash is read like memory through the DCACHE,
+   * but not while another task programs or erases it */
+  lvgl_ospi_read_begin();
+  lv_memcpy(buffer, lvgl_ospi_get_ptr(LITTLEFS_FLASH_OFFSET + block * c->block_size + off), size);
+  lvgl_ospi_read_end();
+  stats.reads++;
+
+  return LFS_ERR_OK;
+}
+
+static int
+littlefs_prog (const struct lfs_config *c,
+               lfs_block_t              block,
+               lfs_off_t                off,
+               const void              *buffer,
+               lfs_size_t               size)
+{
+  stats.programs++;
+
+  return lvgl_ospi_program(LITTLEFS_FLASH_OFFSET + block * c->block_size + off, buffer, size) ==
+         LV_RESULT_OK ? LFS_ERR_OK : LFS_ERR_IO;
+}
+
+static int
+littlefs_erase (const struct lfs_config *c,
+                lfs_block_t              block)
+{
+  stats.erases++;
+
+  return lvgl_ospi_erase(LITTLEFS_FLASH_OFFSET + block * c->block_size, c->block_size) ==
+         LV_RESULT_OK ? LFS_ERR_OK : LFS_ERR_IO;
+}
+
+static int
+littlefs_sync (const struct lfs_config *c)
+{
+  LV_UNUSED(c);
+
+  /* programs are complete when lvgl_ospi_program() returns */
+  return LFS_ERR_OK;
+}
+
+#ifdef LFS_THREADSAFE
+static int
+littlefs_lock (const struct lfs_config *c)
+{
+  LV_UNUSED(c);
+
+  return osMutexAcquire(littlefs_mutex, osWaitForever) == osOK ? LFS_ERR_OK : LFS_ERR_IO;
+}
+
+static int
+littlefs_unlock (const struct lfs_config *c)
+{
+  LV_UNUSED(c);
+
+  return osMutexRelease(littlefs_mutex) == osOK ? LFS_ERR_OK : LFS_ERR_IO;
+}
+#endif
@@ -0,0 +1,658 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_mirror.h"
+#include "lvgl_port_replay.h"
+#include "lvgl_port_tile_filter.h"
+#include "lvgl_port_usb.h"
+#include "main.h"
+#include "cmsis_os2.h"
+
+#if MIRROR_ENABLE && !TILE_FILTER_ENABLE
+  #error "lvgl_port_mirror gets the changed tiles from lvgl_port_tile_filter, set TILE_FILTER_ENABLE"
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define MIRROR_CYCLES_TO_US(c)  ((uint32_t)((uint64_t)(c) * 1000000 / SystemCoreClock))
+
+/* device to host */
+#define MIRROR_MSG_RECT_RAW     1
+#define MIRROR_MSG_RECT_RLE     2
+#define MIRROR_MSG_FRAME        3
+#define MIRROR_MSG_DATA         4       /* the output of lvgl_port_replay */
+
+/* host to device */
+#define MIRROR_IN_POINTER       1
+#define MIRROR_IN_REFRESH       2
+
+/* how often the connection and the refresh requests are checked */
+#define MIRROR_TIMER_PERIOD     100
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/* Each message starts with this, little endian. The payload of the rectangles is
+ * w * h pixels, line by line. A frame message ends the rectangles of a refresh,
+ * its area is the whole display. */
+typedef struct __attribute__((packed))
+{
+  uint16_t magic;
+  uint8_t  type;
+  uint8_t  cf;                  /* lv_color_format_t */
+  uint16_t x;
+  uint16_t y;
+  uint16_t w;
+  uint16_t h;
+  uint32_t len;                 /* of the payload */
+} mirror_msg_t;
+
+typedef struct
+{
+  uint32_t seq;
+  uint32_t seq_ack;             /* the last pointer event read before the refresh */
+  uint32_t time_ms;
+  uint32_t encode_us;
+  uint32_t raw_bytes;
+  uint32_t encoded_bytes;
+} mirror_frame_t;
+
+/* Sent by the host, several can be in a transfer. The events of lvgl_port_replay
+ * are mixed in, they start with REPLAY_MAGIC. */
+typedef struct __attribute__((packed))
+{
+  uint16_t magic;
+  uint8_t  type;
+  uint8_t  pressed;
+  int16_t  x;
+  int16_t  y;
+  uint32_t seq;
+} mirror_in_t;
+
+typedef struct
+{
+  int16_t  x;
+  int16_t  y;
+  uint8_t  pressed;
+  uint32_t seq;
+} mirror_event_t;
+
+typedef struct
+{
+  uint32_t idx;
+  uint32_t len;
+} mirror_send_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void
+mirror_rect_cb (const lv_area_t *area, const uint8_t *px, uint32_t stride, void *user_data);
+
+static void
+mirror_refr_ready_cb (lv_event_t *e);
+
+static bool
+mirror_buf_reserve (uint32_t size);
+
+static void
+mirror_buf_submit (void);
+
+static bool
+mirror_buf_alloc (void);
+
+static void
+mirror_buf_free (void);
+
+static void
+mirror_put_msg (uint32_t pos, uint8_t type, uint8_t cf, const lv_area_t *area, uint32_t len);
+
+static void
+mirror_task (void *argument);
+
+static void
+mirror_rx_cb (const uint8_t *data, uint32_t size);
+
+static void
+mirror_indev_read (lv_indev_t *indev, lv_indev_data_t *data);
+
+static void
+mirror_timer_cb (lv_timer_t *timer);
+
+static void
+mirror_replay_output (const void *data, uint32_t len);
+
+static uint32_t
+mirror_replay_clock (void);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static const osThreadAttr_t mirror_task_attr =
+{
+  .name = "mirror",
+  .priority = (osPriority_t) MIRROR_TASK_PRIORITY,
+  .stack_size = MIRROR_TASK_STACK_SIZE,
+};
+
+/* NULL without a host */
+static uint8_t *bufs[MIRROR_BUF_CNT];
+
+/* indices of the buffers which can be filled, and the filled ones for the task */
+static osMessageQueueId_t free_q;
+static osMessageQueueId_t send_q;
+
+static osMessageQueueId_t event_q;
+
+static lv_display_t *display;
+
+/* the buffer filled by the LVGL task, -1 if none */
+static int32_t cur = -1;
+static uint32_t cur_len;
+
+/* the frame being refreshed */
+static uint32_t frame_seq;
+static uint32_t frame_rects;
+static uint32_t frame_raw;
+static uint32_t frame_encoded;
+static uint32_t frame_cycles;
+static bool frame_dropped;
+
+static int32_t last_x;
+static int32_t last_y;
+static lv_indev_state_t last_state = LV_INDEV_STATE_RELEASED;
+static uint32_t seq_ack;
+static uint32_t sent_ack;
+
+static volatile bool refresh_pending;
+/* the buffers are allocated and the tile filter calls mirror_rect_cb() */
+static bool attached;
+
+static lvgl_mirror_stats_t stats;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_result_t
+lvgl_mirror_init (lv_display_t *disp)
+{
+  lv_indev_t *indev;
+  uint32_t i;
+
+  if (display != NULL)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  free_q = osMessageQueueNew(MIRROR_BUF_CNT, sizeof(uint32_t), NULL);
+  send_q = osMessageQueueNew(MIRROR_BUF_CNT, sizeof(mirror_send_t), NULL);
+  event_q = osMessageQueueNew(MIRROR_EVENT_CNT, sizeof(mirror_event_t), NULL);
+  for (i = 0; i < MIRROR_BUF_CNT; i++)
+    {
+      osMessageQueuePut(free_q, &i, 0, 0);
+    }
+
+  if (osThreadNew(mirror_task, NULL, &mirror_task_attr) == NULL)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  display = disp;
+  lv_display_add_event_cb(disp, mirror_refr_ready_cb, LV_EVENT_REFR_READY, NULL);
+
+  /* the host's pointer, next to the touchscreen */
+  indev = lv_indev_create();
+  lv_indev_set_type(indev, LV_INDEV_TYPE_POINTER);
+  lv_indev_set_display(indev, disp);
+  lv_indev_set_read_cb(indev, mirror_indev_read);
+
+  lv_timer_create(mirror_timer_cb, MIRROR_TIMER_PERIOD, NULL);
+
+  lvgl_usb_set_rx_cb(mirror_rx_cb);
+
+  DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  /* the host injects and records input and replays it over the same connection */
+  lvgl_replay_init(disp);
+  lvgl_replay_set_clock(mirror_replay_clock, SystemCoreClock / 1000000);
+  lvgl_replay_set_output(mirror_replay_output);
+
+  return LV_RESULT_OK;
+}
+
+void
+lvgl_mirror_get_stats (lvgl_mirror_stats_t *stats_out)
+{
+  *stats_out = stats;
+
+  stats_out->ratio_pct = stats.raw_bytes ? (uint32_t)((uint64_t)stats.encoded_bytes * 100 / stats.raw_bytes) : 0;
+  stats_out->encode_kbyte_per_s = stats.encode_us ? (uint32_t)((uint64_t)stats.raw_bytes * 1000000 / 1024 / stats.encode_us) : 0;
+}
+
+void
+lvgl_mirror_reset_stats (void)
+{
+  lv_memzero(&stats, sizeof(stats));
+}
+
+uint32_t
+lvgl_mirror_rle_line (const uint16_t *px,
+                      uint32_t        w,
+                      uint8_t        *out)
+{
+  uint8_t *o = out;
+  uint32_t i = 0;
+  uint32_t n;
+
+  while (i < w)
+    {
+      for (n = 1; i + n < w && n < MIRROR_RLE_REPEAT_MAX && px[i + n] == px[i]; n++)
+        {
+        }
+
+      if (n >= 2)
+        {
+          *o++ = n + 126;
+          *o++ = px[i] & 0xFF;
+          *o++ = px[i] >> 8;
+          i += n;
+          continue;
+        }
+
+      /* literals up to the start of the next repeat */
+      for (n = 1; i + n < w && n < MIRROR_RLE_LITERAL_MAX &&
+                  !(i + n + 1 < w && px[i + n + 1] == px[i + n]); n++)
+        {
+        }
+
+      *o++ = n - 1;
+      lv_memcpy(o, &px[i], n * 2);
+      o += n * 2;
+      i += n;
+    }
+
+  return o - out;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void
+mirror_rect_cb (const lv_area_t *area,
+                const uint8_t   *px,
+                uint32_t         stride,
+                void            *user_data)
+{
+  lv_color_format_t cf = lv_display_get_color_format(display);
+  uint32_t bpp = lv_color_format_get_size(cf);
+  bool rle = bpp == 2;
+  uint32_t w = lv_area_get_width(area);
+  uint32_t h = lv_area_get_height(area);
+  uint32_t line_max = rle ? MIRROR_RLE_LINE_MAX(w) : w * bpp;
+  uint32_t start = DWT->CYCCNT;
+  uint32_t used = 0;
+  uint32_t pos;
+  uint32_t y = 0;
+  uint32_t y0;
+  lv_area_t band;
+
+  LV_UNUSED(user_data);
+
+  if (!attached || frame_dropped)
+    {
+      return;
+    }
+
+  /* a band of lines per buffer, the rest in the next one */
+  while (y < h)
+    {
+      if (!mirror_buf_reserve(sizeof(mirror_msg_t) + line_max))
+        {
+          /* the host is slower than the changes, it gets the whole screen later */
+          frame_dropped = true;
+          refresh_pending = true;
+          stats.dropped++;
+          break;
+        }
+
+      pos = cur_len;
+      cur_len += sizeof(mirror_msg_t);
+      y0 = y;
+
+      for (; y < h && MIRROR_BUF_SIZE - cur_len >= line_max; y++)
+        {
+          if (rle)
+            {
+              cur_len += lvgl_mirror_rle_line((const uint16_t *)(px + y * stride), w, &bufs[cur][cur_len]);
+            }
+          else
+            {
+              lv_memcpy(&bufs[cur][cur_len], px + y * stride, line_max);
+              cur_len += line_max;
+            }
+        }
+
+      band = *area;
+      band.y1 = area->y1 + y0;
+      band.y2 = area->y1 + y - 1;
+      mirror_put_msg(pos, rle ? MIRROR_MSG_RECT_RLE : MIRROR_MSG_RECT_RAW, cf, &band,
+                     cur_len - pos - sizeof(mirror_msg_t));
+
+      used += cur_len - pos;
+      frame_raw += (y - y0) * w * bpp;
+      frame_rects++;
+    }
+
+  frame_encoded += used;
+  frame_cycles += DWT->CYCCNT - start;
+}
+
+static void
+mirror_refr_ready_cb (lv_event_t *e)
+{
+  mirror_frame_t frame;
+  lv_area_t all;
+
+  LV_UNUSED(e);
+
+  /* nothing changed and no pointer event to acknowledge */
+  if (frame_rects == 0 && !frame_dropped && seq_ack == sent_ack)
+    {
+      return;
+    }
+
+  if (attached && !frame_dropped &&
+      mirror_buf_reserve(sizeof(mirror_msg_t) + sizeof(frame)))
+    {
+      frame.seq = frame_seq++;
+      frame.seq_ack = seq_ack;
+      frame.time_ms = lv_tick_get();
+      frame.encode_us = MIRROR_CYCLES_TO_US(frame_cycles);
+      frame.raw_bytes = frame_raw;
+      frame.encoded_bytes = frame_encoded;
+
+      lv_area_set(&all, 0, 0, lv_display_get_horizontal_resolution(display) - 1,
+                  lv_display_get_vertical_resolution(display) - 1);
+      mirror_put_msg(cur_len, MIRROR_MSG_FRAME, lv_display_get_color_format(display), &all, sizeof(frame));
+      lv_memcpy(&bufs[cur][cur_len + sizeof(mirror_msg_t)], &frame, sizeof(frame));
+      cur_len += sizeof(mirror_msg_t) + sizeof(frame);
+
+      sent_ack = seq_ack;
+      stats.frames++;
+      stats.rects += frame_rects;
+      stats.raw_bytes += frame_raw;
+      stats.encoded_bytes += frame_encoded;
+      stats.encode_us += frame.encode_us;
+    }
+
+  mirror_buf_submit();
+
+  frame_rects = 0;
+  frame_raw = 0;
+  frame_encoded = 0;
+  frame_cycles = 0;
+  frame_dropped = false;
+}
+
+static bool
+mirror_buf_reserve (uint32_t size)
+{
+  if (cur >= 0 && MIRROR_BUF_SIZE - cur_len < size)
+    {
+      mirror_buf_submit();
+    }
+
+  if (cur < 0)
+    {
+      uint32_t idx;
+
+      /* not waited for, the flush would stall the rendering for the host */
+      if (osMessageQueueGet(free_q, &idx, NULL, 0) != osOK)
+        {
+          return false;
+        }
+      cur = idx;
+      cur_len = 0;
+    }
+
+  return true;
+}
+
+static void
+mirror_buf_submit (void)
+{
+  mirror_send_t send;
+
+  if (cur < 0 || cur_len == 0)
+    {
+      return;
+    }
+
+  send.idx = cur;
+  send.len = cur_len;
+  osMessageQueuePut(send_q, &send, 0, 0);
+  cur = -1;
+}
+
+static bool
+mirror_buf_alloc (void)
+{
+  uint32_t i;
+
+  for (i = 0; i < MIRROR_BUF_CNT; i++)
+    {
+      if (bufs[i] == NULL)
+        {
+          bufs[i] = lv_malloc(MIRROR_BUF_SIZE);
+        }
+      if (bufs[i] == NULL)
+        {
+          LV_LOG_WARN("no memory for the mirror buffers");
+          return false;
+        }
+    }
+
+  return true;
+}
+
+static void
+mirror_buf_free (void)
+{
+  uint32_t i;
+
+  for (i = 0; i < MIRROR_BUF_CNT; i++)
+    {
+      lv_free(bufs[i]);
+      bufs[i] = NULL;
+    }
+}
+
+static void
+mirror_put_msg (uint32_t         pos,
+                uint8_t          type,
+                uint8_t          cf,
+                const lv_area_t *area,
+                uint32_t         len)
+{
+  mirror_msg_t msg;
+
+  msg.magic = MIRROR_MAGIC;
+  msg.type = type;
+  msg.cf = cf;
+  msg.x = area->x1;
+  msg.y = area->y1;
+  msg.w = lv_area_get_width(area);
+  msg.h = lv_area_get_height(area);
+  msg.len = len;
+
+  lv_memcpy(&bufs[cur][pos], &msg, sizeof(msg));
+}
+
+static void
+mirror_task (void *argument)
+{
+  mirror_send_t send;
+  uint32_t start;
+
+  for (;;)
+    {
+      osMessageQueueGet(send_q, &send, NULL, osWaitForever);
+
+      start = DWT->CYCCNT;
+      if (lvgl_usb_write(bufs[send.idx], send.len, MIRROR_WRITE_TIMEOUT) != LV_RESULT_OK)
+        {
+          /* the host missed a part of the screen */
+          refresh_pending = true;
+        }
+      stats.send_us += MIRROR_CYCLES_TO_US(DWT->CYCCNT - start);
+
+      osMessageQueuePut(free_q, &send.idx, 0, 0);
+    }
+}
+
+/* in the USB interrupt */
+static void
+mirror_rx_cb (const uint8_t *data,
+              uint32_t       size)
+{
+  lvgl_replay_event_t replay;
+  mirror_in_t in;
+  mirror_event_t ev;
+  uint32_t i;
+
+  for (i = 0; i + sizeof(in) <= size; i += sizeof(in))
+    {
+      lv_memcpy(&in, &data[i], sizeof(in));
+      if (in.magic == REPLAY_MAGIC && i + sizeof(replay) <= size)
+        {
+          lv_memcpy(&replay, &data[i], sizeof(replay));
+          lvgl_replay_feed(&replay);
+          i += sizeof(replay) - sizeof(in);
+          continue;
+        }
+      if (in.magic != MIRROR_MAGIC)
+        {
+          break;
+        }
+
+      if (in.type == MIRROR_IN_POINTER)
+        {
+          ev.x = in.x;
+          ev.y = in.y;
+          ev.pressed = in.pressed;
+          ev.seq = in.seq;
+          if (osMessageQueuePut(event_q, &ev, 0, 0) == osOK)
+            {
+              stats.events++;
+            }
+          else
+            {
+              stats.events_dropped++;
+            }
+        }
+      else if (in.type == MIRROR_IN_REFRESH)
+        {
+          refresh_pending = true;
+        }
+    }
+}
+
+static void
+mirror_indev_read (lv_indev_t      *indev,
+                   lv_indev_data_t *data)
+{
+  mirror_event_t ev;
+
+  LV_UNUSED(indev);
+
+  /* every event is read, so a click between two reads isn't lost */
+  if (osMessageQueueGet(event_q, &ev, NULL, 0) == osOK)
+    {
+      last_x = ev.x;
+      last_y = ev.y;
+      last_state = ev.pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+      seq_ack = ev.seq;
+      data->continue_reading = osMessageQueueGetCount(event_q) > 0;
+    }
+
+  data->point.x = last_x;
+  data->point.y = last_y;
+  data->state = last_state;
+}
+
+static void
+mirror_timer_cb (lv_timer_t *timer)
+{
+  bool configured = lvgl_usb_is_configured();
+
+  LV_UNUSED(timer);
+
+  /* The changed tiles are what the host needs, a flush may redraw unchanged ones.
+   * Without a host the filter doesn't compute the signatures for it, and the
+   * buffers don't take memory. */
+  if (configured && !attached)
+    {
+      if (!mirror_buf_alloc() || lvgl_tile_filter_add_cb(mirror_rect_cb, NULL) != LV_RESULT_OK)
+        {
+          return;
+        }
+      attached = true;
+      /* a new host has nothing of the screen */
+      refresh_pending = true;
+    }
+  else if (!configured && attached)
+    {
+      lvgl_tile_filter_remove_cb(mirror_rect_cb, NULL);
+      attached = false;
+    }
+
+  /* the writes of the task fail without a host, then all buffers are back */
+  if (!attached && bufs[0] != NULL && cur < 0 && osMessageQueueGetCount(free_q) == MIRROR_BUF_CNT)
+    {
+      mirror_buf_free();
+    }
+
+  /* once the buffers were sent, so the whole screen can be too */
+  if (refresh_pending && attached && cur < 0 && osMessageQueueGetCount(free_q) == MIRROR_BUF_CNT)
+    {
+      refresh_pending = false;
+      lvgl_tile_filter_invalidate();
+      lv_obj_invalidate(lv_display_get_screen_active(display));
+    }
+}
+
+/* in the LVGL task, the data is sent right away */
+static void
+mirror_replay_output (const void *data,
+                      uint32_t    len)
+{
+  lv_area_t none;
+
+  if (!attached || sizeof(mirror_msg_t) + len > MIRROR_BUF_SIZE ||
+      !mirror_buf_reserve(sizeof(mirror_msg_t) + len))
+    {
+      return;
+    }
+
+  lv_area_set(&none, 0, 0, -1, -1);
+  mirror_put_msg(cur_len, MIRROR_MSG_DATA, 0, &none, len);
+  lv_memcpy(&bufs[cur][cur_len + sizeof(mirror_msg_t)], data, len);
+  cur_len += sizeof(mirror_msg_t) + len;
+
+  mirror_buf_submit();
+}
+
+static uint32_t
+mirror_replay_clock (void)
+{
+  return DWT->CYCCNT;
+}
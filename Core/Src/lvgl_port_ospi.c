@@ -0,0 +1,563 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_ospi.h"
+#include "main.h"
+#include "octospi.h"
+#include "dcache.h"
+#include "mx25lm51245g.h"
+#include "cmsis_os2.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define OSPI_BLOCK_SIZE     (64 * 1024)
+
+/* DCACHE1 line */
+#define OSPI_CACHE_LINE     16
+
+#define OSPI_SLICE_CYCLES   (OSPI_SLICE_US * (SystemCoreClock / 1000000))
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  bool                erase;
+  uint32_t            offset;
+  const uint8_t      *buf;
+  uint32_t            size;
+  lvgl_ospi_done_cb_t cb;
+  void               *user_data;
+} ospi_job_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void
+ospi_lock (void);
+
+static void
+ospi_unlock (uint32_t offset, uint32_t size);
+
+static int32_t
+ospi_finish_suspended (void);
+
+static lv_result_t
+ospi_queue (const ospi_job_t *job);
+
+static void
+ospi_task (void *argument);
+
+static int32_t
+ospi_run (const ospi_job_t *job);
+
+static int32_t
+ospi_wait (uint32_t *slice, uint32_t *flushed, uint32_t addr);
+
+static bool
+ospi_slice_over (uint32_t slice);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static osMutexId_t ospi_mutex;
+
+/* recursive, a reader (the LVGL task) may program, e.g. a LittleFS file */
+static const osMutexAttr_t ospi_mutex_attr =
+{
+  .name = "ospi",
+  .attr_bits = osMutexPrioInherit | osMutexRecursive,
+};
+
+static const osThreadAttr_t ospi_task_attr =
+{
+  .name = "ospi",
+  .priority = (osPriority_t) OSPI_TASK_PRIORITY,
+  .stack_size = OSPI_TASK_STACK_SIZE,
+};
+
+static osMessageQueueId_t ospi_jobs;
+static osThreadId_t ospi_thread;
+
+/* queued jobs not done yet */
+static volatile uint32_t pending;
+
+/* tasks waiting in lvgl_ospi_read_begin(), the OSPI task gives way to them */
+static volatile uint32_t readers_waiting;
+
+/* the program or erase of the OSPI task is suspended, only changed with the mutex */
+static bool suspended;
+
+static lvgl_ospi_stats_t stats;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_ospi_init (void)
+{
+  if (ospi_mutex == NULL)
+    {
+      ospi_mutex = osMutexNew(&ospi_mutex_attr);
+      ospi_jobs = osMessageQueueNew(OSPI_QUEUE_LEN, sizeof(ospi_job_t), NULL);
+      ospi_thread = osThreadNew(ospi_task, NULL, &ospi_task_attr);
+    }
+
+  DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+const void *
+lvgl_ospi_get_ptr (uint32_t offset)
+{
+  return (const void *)(OSPI_MAP_ADDR + offset);
+}
+
+lv_result_t
+lvgl_ospi_program (uint32_t    offset,
+                   const void *buf,
+                   uint32_t    size)
+{
+  const uint8_t *src = buf;
+  uint32_t addr = offset;
+  uint32_t end = offset + size;
+  uint32_t n;
+  int32_t ret = MX25LM51245G_OK;
+
+  if (end > OSPI_FLASH_SIZE || end < offset)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  ospi_lock();
+  ret = ospi_finish_suspended();
+
+  /* a program wraps around at the end of its page */
+  while (addr < end && ret == MX25LM51245G_OK)
+    {
+      n = LV_MIN(end - addr, OSPI_PAGE_SIZE - addr % OSPI_PAGE_SIZE);
+
+      ret = MX25LM51245G_WriteEnable(&hospi1, MX25LM51245G_OPI_MODE, MX25LM51245G_STR_TRANSFER);
+      if (ret == MX25LM51245G_OK)
+        {
+          ret = MX25LM51245G_PageProgram(&hospi1, MX25LM51245G_OPI_MODE, MX25LM51245G_4BYTES_SIZE,
+                                         (uint8_t *)src, addr, n);
+        }
+      if (ret == MX25LM51245G_OK)
+        {
+          ret = MX25LM51245G_AutoPollingMemReady(&hospi1, MX25LM51245G_OPI_MODE,
+                                                 MX25LM51245G_STR_TRANSFER);
+        }
+
+      src += n;
+      addr += n;
+    }
+
+  ospi_unlock(offset, size);
+
+  return ret == MX25LM51245G_OK ? LV_RESULT_OK : LV_RESULT_INVALID;
+}
+
+lv_result_t
+lvgl_ospi_erase (uint32_t offset,
+                 uint32_t size)
+{
+  uint32_t addr = offset;
+  uint32_t end = offset + size;
+  MX25LM51245G_Erase_t type;
+  int32_t ret = MX25LM51245G_OK;
+
+  if (offset % OSPI_SECTOR_SIZE != 0 || size % OSPI_SECTOR_SIZE != 0 ||
+      end > OSPI_FLASH_SIZE || end < offset)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  ospi_lock();
+  ret = ospi_finish_suspended();
+
+  while (addr < end && ret == MX25LM51245G_OK)
+    {
+      /* whole 64K blocks are erased at once, that's much faster than 16 sectors */
+      type = (addr % OSPI_BLOCK_SIZE == 0 && end - addr >= OSPI_BLOCK_SIZE) ?
+             MX25LM51245G_ERASE_64K : MX25LM51245G_ERASE_4K;
+
+      ret = MX25LM51245G_WriteEnable(&hospi1, MX25LM51245G_OPI_MODE, MX25LM51245G_STR_TRANSFER);
+      if (ret == MX25LM51245G_OK)
+        {
+          ret = MX25LM51245G_BlockErase(&hospi1, MX25LM51245G_OPI_MODE, MX25LM51245G_STR_TRANSFER,
+                                        MX25LM51245G_4BYTES_SIZE, addr, type);
+        }
+      if (ret == MX25LM51245G_OK)
+        {
+          ret = MX25LM51245G_AutoPollingMemReady(&hospi1, MX25LM51245G_OPI_MODE,
+                                                 MX25LM51245G_STR_TRANSFER);
+        }
+
+      addr += type == MX25LM51245G_ERASE_64K ? OSPI_BLOCK_SIZE : OSPI_SECTOR_SIZE;
+    }
+
+  ospi_unlock(offset, size);
+
+  return ret == MX25LM51245G_OK ? LV_RESULT_OK : LV_RESULT_INVALID;
+}
+
+lv_result_t
+lvgl_ospi_program_async (uint32_t            offset,
+                         const void         *buf,
+                         uint32_t            size,
+                         lvgl_ospi_done_cb_t cb,
+                         void               *user_data)
+{
+  ospi_job_t job = {false, offset, buf, size, cb, user_data};
+
+  return ospi_queue(&job);
+}
+
+lv_result_t
+lvgl_ospi_erase_async (uint32_t            offset,
+                       uint32_t            size,
+                       lvgl_ospi_done_cb_t cb,
+                       void               *user_data)
+{
+  ospi_job_t job = {true, offset, NULL, size, cb, user_data};
+
+  if (offset % OSPI_SECTOR_SIZE != 0 || size % OSPI_SECTOR_SIZE != 0)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  return ospi_queue(&job);
+}
+
+void
+lvgl_ospi_read_begin (void)
+{
+  uint32_t start = DWT->CYCCNT;
+  uint32_t us;
+
+  if (osKernelGetState() != osKernelRunning || osThreadGetId() == ospi_thread)
+    {
+      return;
+    }
+
+  __atomic_fetch_add(&readers_waiting, 1, __ATOMIC_RELAXED);
+  osMutexAcquire(ospi_mutex, osWaitForever);
+  __atomic_fetch_sub(&readers_waiting, 1, __ATOMIC_RELAXED);
+
+  us = (uint32_t)((uint64_t)(DWT->CYCCNT - start) * 1000000 / SystemCoreClock);
+  stats.stall_us_max = LV_MAX(stats.stall_us_max, us);
+}
+
+void
+lvgl_ospi_read_end (void)
+{
+  if (osKernelGetState() != osKernelRunning || osThreadGetId() == ospi_thread)
+    {
+      return;
+    }
+
+  osMutexRelease(ospi_mutex);
+}
+
+bool
+lvgl_ospi_is_busy (void)
+{
+  return pending > 0;
+}
+
+void
+lvgl_ospi_get_stats (lvgl_ospi_stats_t *stats_out)
+{
+  *stats_out = stats;
+  stats_out->program_kbyte_per_s = stats.program_ms > 0 ?
+                                   (uint32_t)((uint64_t)stats.program_bytes * 1000 / 1024 / stats.program_ms) : 0;
+  stats_out->erase_kbyte_per_s = stats.erase_ms > 0 ?
+                                 (uint32_t)((uint64_t)stats.erase_bytes * 1000 / 1024 / stats.erase_ms) : 0;
+}
+
+void
+lvgl_ospi_reset_stats (void)
+{
+  lv_memzero(&stats, sizeof(stats));
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void
+ospi_lock (void)
+{
+  if (osKernelGetState() == osKernelRunning)
+    {
+      osMutexAcquire(ospi_mutex, osWaitForever);
+    }
+
+  /* commands can't be sent in memory-mapped mode */
+  HAL_OSPI_Abort(&hospi1);
+}
+
+static void
+ospi_unlock (uint32_t offset,
+             uint32_t size)
+{
+  uint32_t start = (OSPI_MAP_ADDR + offset) & ~(OSPI_CACHE_LINE - 1);
+  uint32_t end = OSPI_MAP_ADDR + offset + size;
+
+  if (MX25LM51245G_EnableMemoryMappedModeSTR(&hospi1, MX25LM51245G_OPI_MODE,
+                                             MX25LM51245G_4BYTES_SIZE) != MX25LM51245G_OK)
+    {
+      Error_Handler();
+    }
+
+  /* reads of the mapped flash may still be cached with the old content */
+  if (size > 0)
+    {
+      HAL_DCACHE_InvalidateByAddr(&hdcache1, (const uint32_t *)start,
+                                  (end - start + OSPI_CACHE_LINE - 1) & ~(OSPI_CACHE_LINE - 1));
+    }
+
+  if (osKernelGetState() == osKernelRunning)
+    {
+      osMutexRelease(ospi_mutex);
+    }
+}
+
+static int32_t
+ospi_finish_suspended (void)
+{
+  int32_t ret;
+
+  if (!suspended)
+    {
+      return MX25LM51245G_OK;
+    }
+
+  /* the flash can't start another program or erase while one is suspended, so
+   * the OSPI task's one is finished here and the task finds it done */
+  suspended = false;
+  ret = MX25LM51245G_Resume(&hospi1, MX25LM51245G_OPI_MODE, MX25LM51245G_STR_TRANSFER);
+  if (ret == MX25LM51245G_OK)
+    {
+      ret = MX25LM51245G_AutoPollingMemReady(&hospi1, MX25LM51245G_OPI_MODE,
+                                             MX25LM51245G_STR_TRANSFER);
+    }
+
+  return ret;
+}
+
+static lv_result_t
+ospi_queue (const ospi_job_t *job)
+{
+  if (job->offset + job->size > OSPI_FLASH_SIZE || job->offset + job->size < job->offset ||
+      ospi_jobs == NULL)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  __atomic_fetch_add(&pending, 1, __ATOMIC_RELAXED);
+  if (osMessageQueuePut(ospi_jobs, job, 0, 0) != osOK)
+    {
+      __atomic_fetch_sub(&pending, 1, __ATOMIC_RELAXED);
+      return LV_RESULT_INVALID;
+    }
+
+  return LV_RESULT_OK;
+}
+
+static void
+ospi_task (void *argument)
+{
+  ospi_job_t job;
+  uint32_t start;
+  uint32_t ms;
+  int32_t ret;
+
+  LV_UNUSED(argument);
+
+  for (;;)
+    {
+      if (osMessageQueueGet(ospi_jobs, &job, NULL, osWaitForever) != osOK)
+        {
+          continue;
+        }
+
+      start = HAL_GetTick();
+      ret = ospi_run(&job);
+      ms = HAL_GetTick() - start;
+
+      stats.jobs++;
+      if (ret != MX25LM51245G_OK)
+        {
+          stats.errors++;
+        }
+      else if (job.erase)
+        {
+          stats.erase_bytes += job.size;
+          stats.erase_ms += ms;
+        }
+      else
+        {
+          stats.program_bytes += job.size;
+          stats.program_ms += ms;
+        }
+
+      __atomic_fetch_sub(&pending, 1, __ATOMIC_RELAXED);
+
+      if (job.cb != NULL)
+        {
+          job.cb(ret == MX25LM51245G_OK ? LV_RESULT_OK : LV_RESULT_INVALID, job.user_data);
+        }
+    }
+}
+
+static int32_t
+ospi_run (const ospi_job_t *job)
+{
+  uint32_t addr = job->offset;
+  uint32_t end = job->offset + job->size;
+  uint32_t flushed = addr;      /* the readers see the changes before this */
+  uint32_t slice;
+  uint32_t n;
+  int32_t ret = MX25LM51245G_OK;
+
+  ospi_lock();
+  slice = DWT->CYCCNT;
+
+  while (addr < end && ret == MX25LM51245G_OK)
+    {
+      if (job->erase)
+        {
+          n = (addr % OSPI_BLOCK_SIZE == 0 && end - addr >= OSPI_BLOCK_SIZE) ?
+              OSPI_BLOCK_SIZE : OSPI_SECTOR_SIZE;
+        }
+      else
+        {
+          n = LV_MIN(end - addr, OSPI_PAGE_SIZE - addr % OSPI_PAGE_SIZE);
+        }
+
+      ret = MX25LM51245G_WriteEnable(&hospi1, MX25LM51245G_OPI_MODE, MX25LM51245G_STR_TRANSFER);
+      if (ret == MX25LM51245G_OK && job->erase)
+        {
+          ret = MX25LM51245G_BlockErase(&hospi1, MX25LM51245G_OPI_MODE, MX25LM51245G_STR_TRANSFER,
+                                        MX25LM51245G_4BYTES_SIZE, addr,
+                                        n == OSPI_BLOCK_SIZE ? MX25LM51245G_ERASE_64K :
+                                                               MX25LM51245G_ERASE_4K);
+        }
+      else if (ret == MX25LM51245G_OK)
+        {
+          ret = MX25LM51245G_PageProgram(&hospi1, MX25LM51245G_OPI_MODE, MX25LM51245G_4BYTES_SIZE,
+                                         (uint8_t *)job->buf + (addr - job->offset), addr, n);
+        }
+      if (ret == MX25LM51245G_OK)
+        {
+          ret = ospi_wait(&slice, &flushed, addr);
+        }
+      addr += n;
+
+      /* between two commands nothing has to be suspended */
+      if (ret == MX25LM51245G_OK && addr < end && ospi_slice_over(slice))
+        {
+          ospi_unlock(flushed, addr - flushed);
+          flushed = addr;
+          ospi_lock();
+          slice = DWT->CYCCNT;
+        }
+    }
+
+  ospi_unlock(flushed, LV_MIN(addr, end) - flushed);
+
+  return ret;
+}
+
+static int32_t
+ospi_wait (uint32_t *slice,
+           uint32_t *flushed,
+           uint32_t  addr)
+{
+  uint8_t reg[2];
+  int32_t ret;
+
+  for (;;)
+    {
+      ret = MX25LM51245G_ReadStatusRegister(&hospi1, MX25LM51245G_OPI_MODE,
+                                            MX25LM51245G_STR_TRANSFER, reg);
+      if (ret != MX25LM51245G_OK || (reg[0] & MX25LM51245G_SR_WIP) == 0)
+        {
+          break;
+        }
+
+      if (!ospi_slice_over(*slice))
+        {
+          continue;
+        }
+
+      /* a reader is waiting, the flash can be read again some 20 us after the suspend */
+      ret = MX25LM51245G_Suspend(&hospi1, MX25LM51245G_OPI_MODE, MX25LM51245G_STR_TRANSFER);
+      if (ret == MX25LM51245G_OK)
+        {
+          ret = MX25LM51245G_AutoPollingMemReady(&hospi1, MX25LM51245G_OPI_MODE,
+                                                 MX25LM51245G_STR_TRANSFER);
+        }
+      if (ret == MX25LM51245G_OK)
+        {
+          ret = MX25LM51245G_ReadSecurityRegister(&hospi1, MX25LM51245G_OPI_MODE,
+                                                  MX25LM51245G_STR_TRANSFER, reg);
+        }
+      if (ret != MX25LM51245G_OK)
+        {
+          break;
+        }
+
+      /* it may have completed instead */
+      suspended = (reg[0] & (MX25LM51245G_SECR_PSB | MX25LM51245G_SECR_ESB)) != 0;
+      if (suspended)
+        {
+          stats.suspends++;
+        }
+
+      /* the range in progress stays invalid until it's done */
+      ospi_unlock(*flushed, addr - *flushed);
+      *flushed = addr;
+      ospi_lock();
+
+      /* a program or erase of another task may have finished it meanwhile */
+      if (suspended)
+        {
+          suspended = false;
+          ret = MX25LM51245G_Resume(&hospi1, MX25LM51245G_OPI_MODE, MX25LM51245G_STR_TRANSFER);
+          if (ret != MX25LM51245G_OK)
+            {
+              break;
+            }
+        }
+      *slice = DWT->CYCCNT;
+    }
+
+  if (ret == MX25LM51245G_OK)
+    {
+      ret = MX25LM51245G_ReadSecurityRegister(&hospi1, MX25LM51245G_OPI_MODE,
+                                              MX25LM51245G_STR_TRANSFER, reg);
+    }
+  if (ret == MX25LM51245G_OK &&
+      (reg[0] & (MX25LM51245G_SECR_P_FAIL | MX25LM51245G_SECR_E_FAIL)) != 0)
+    {
+      ret = MX25LM51245G_ERROR;
+    }
+
+  return ret;
+}
+
+static bool
+ospi_slice_over (uint32_t slice)
+{
+  return readers_waiting > 0 && DWT->CYCCNT - slice >= OSPI_SLICE_CYCLES;
+}
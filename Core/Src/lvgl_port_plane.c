@@ -0,0 +1,286 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_plane.h"
+#include "ltdc.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define PLANE_MIN(a, b)  ((a) < (b) ? (a) : (b))
+#define PLANE_MAX(a, b)  ((a) > (b) ? (a) : (b))
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static uint32_t
+plane_lock (void);
+
+static void
+plane_unlock (uint32_t primask);
+
+static void
+plane_request (void);
+
+static void
+plane_arm (void);
+
+static bool
+plane_apply (void);
+
+static uint32_t
+plane_bpp (uint32_t pixel_format);
+
+static void
+plane_line_event_cb (LTDC_HandleTypeDef *ltdc);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static uint32_t lvgl_layer;
+static uint32_t plane_layer;
+
+/* shadow copy of the plane, latched into the LTDC in the vertical blanking */
+static lvgl_plane_cfg_t shadow;
+static bool shadow_visible;
+
+static volatile bool pending;
+static volatile lvgl_plane_vblank_cb_t vblank_cb;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_plane_init (void)
+{
+#if PLANE_MODE == PLANE_MODE_BACKGROUND
+  /* move LVGL to the upper layer with the settings CubeMX generated for layer 0 */
+  LTDC_LayerCfgTypeDef cfg = hltdc.LayerCfg[0];
+
+  lvgl_layer = 1;
+  plane_layer = 0;
+
+  if (HAL_LTDC_ConfigLayer(&hltdc, &cfg, lvgl_layer) != HAL_OK)
+    {
+      Error_Handler();
+    }
+  if (HAL_LTDC_ConfigColorKeying(&hltdc, PLANE_COLOR_KEY, lvgl_layer) != HAL_OK)
+    {
+      Error_Handler();
+    }
+  if (HAL_LTDC_EnableColorKeying(&hltdc, lvgl_layer) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+  /* the keyed pixels show the LTDC background color until a plane is shown */
+  __HAL_LTDC_LAYER_DISABLE(&hltdc, plane_layer);
+  __HAL_LTDC_RELOAD_IMMEDIATE_CONFIG(&hltdc);
+#else
+  lvgl_layer = 0;
+  plane_layer = 1;
+#endif
+
+  HAL_LTDC_RegisterCallback(&hltdc, HAL_LTDC_LINE_EVENT_CB_ID, plane_line_event_cb);
+}
+
+uint32_t
+lvgl_plane_get_lvgl_layer (void)
+{
+  return lvgl_layer;
+}
+
+void
+lvgl_plane_show (const lvgl_plane_cfg_t *cfg)
+{
+  uint32_t primask = plane_lock();
+
+  shadow = *cfg;
+  shadow_visible = true;
+  plane_request();
+
+  plane_unlock(primask);
+}
+
+void
+lvgl_plane_hide (void)
+{
+  uint32_t primask = plane_lock();
+
+  shadow_visible = false;
+  plane_request();
+
+  plane_unlock(primask);
+}
+
+void
+lvgl_plane_set_pos (int32_t x,
+                    int32_t y)
+{
+  uint32_t primask = plane_lock();
+
+  shadow.x = x;
+  shadow.y = y;
+  plane_request();
+
+  plane_unlock(primask);
+}
+
+void
+lvgl_plane_set_alpha (uint8_t alpha)
+{
+  uint32_t primask = plane_lock();
+
+  shadow.alpha = alpha;
+  plane_request();
+
+  plane_unlock(primask);
+}
+
+void
+lvgl_plane_set_buf (const void *buf)
+{
+  uint32_t primask = plane_lock();
+
+  shadow.buf = buf;
+  plane_request();
+
+  plane_unlock(primask);
+}
+
+bool
+lvgl_plane_is_pending (void)
+{
+  return pending;
+}
+
+void
+lvgl_plane_set_vblank_cb (lvgl_plane_vblank_cb_t cb)
+{
+  uint32_t primask = plane_lock();
+
+  vblank_cb = cb;
+  if (cb != NULL)
+    {
+      plane_arm();
+    }
+
+  plane_unlock(primask);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static uint32_t
+plane_lock (void)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+
+  return primask;
+}
+
+static void
+plane_unlock (uint32_t primask)
+{
+  __set_PRIMASK(primask);
+}
+
+static void
+plane_request (void)
+{
+  pending = true;
+  plane_arm();
+}
+
+static void
+plane_arm (void)
+{
+  /* first line of the vertical front porch, the rest of the blanking is long
+   * enough to write the shadow registers */
+  hltdc.Instance->LIPCR = hltdc.Init.AccumulatedActiveH + 1;
+  __HAL_LTDC_ENABLE_IT(&hltdc, LTDC_IT_LI);
+}
+
+static bool
+plane_apply (void)
+{
+  LTDC_LayerCfgTypeDef cfg = {0};
+  int32_t hor_res = hltdc.Init.AccumulatedActiveW - hltdc.Init.AccumulatedHBP;
+  int32_t ver_res = hltdc.Init.AccumulatedActiveH - hltdc.Init.AccumulatedVBP;
+  int32_t x0 = PLANE_MAX(shadow.x, 0);
+  int32_t y0 = PLANE_MAX(shadow.y, 0);
+  int32_t x1 = PLANE_MIN(shadow.x + shadow.w, hor_res);
+  int32_t y1 = PLANE_MIN(shadow.y + shadow.h, ver_res);
+  uint32_t bpp = plane_bpp(shadow.pixel_format);
+
+  if (!shadow_visible || shadow.buf == NULL || x1 <= x0 || y1 <= y0)
+    {
+      __HAL_LTDC_LAYER_DISABLE(&hltdc, plane_layer);
+      return true;
+    }
+
+  /* a partly off-screen plane is clipped by starting the scan-out inside the buffer */
+  cfg.WindowX0 = x0;
+  cfg.WindowX1 = x1;
+  cfg.WindowY0 = y0;
+  cfg.WindowY1 = y1;
+  cfg.PixelFormat = shadow.pixel_format;
+  cfg.Alpha = shadow.alpha;
+  cfg.Alpha0 = 0;
+  cfg.BlendingFactor1 = LTDC_BLENDING_FACTOR1_PAxCA;
+  cfg.BlendingFactor2 = LTDC_BLENDING_FACTOR2_PAxCA;
+  cfg.FBStartAdress = (uint32_t)shadow.buf + ((y0 - shadow.y) * shadow.w + (x0 - shadow.x)) * bpp;
+  cfg.ImageWidth = shadow.w;
+  cfg.ImageHeight = y1 - y0;
+
+  /* the handle is locked if the LVGL flush is just updating its layer, retry in the next frame */
+  return HAL_LTDC_ConfigLayer_NoReload(&hltdc, &cfg, plane_layer) == HAL_OK;
+}
+
+static uint32_t
+plane_bpp (uint32_t pixel_format)
+{
+  switch (pixel_format)
+    {
+      case LTDC_PIXEL_FORMAT_ARGB8888:
+        return 4;
+      case LTDC_PIXEL_FORMAT_RGB888:
+        return 3;
+      case LTDC_PIXEL_FORMAT_RGB565:
+      case LTDC_PIXEL_FORMAT_ARGB1555:
+      case LTDC_PIXEL_FORMAT_ARGB4444:
+      case LTDC_PIXEL_FORMAT_AL88:
+        return 2;
+      default:
+        return 1;
+    }
+}
+
+static void
+plane_line_event_cb (LTDC_HandleTypeDef *ltdc)
+{
+  if (pending && plane_apply())
+    {
+      /* immediate reload in the blanking, the reload interrupt stays owned by the LVGL driver */
+      __HAL_LTDC_RELOAD_IMMEDIATE_CONFIG(ltdc);
+      pending = false;
+    }
+
+  if (vblank_cb != NULL)
+    {
+      vblank_cb();
+    }
+
+  if (pending || vblank_cb != NULL)
+    {
+      plane_arm();
+    }
+}
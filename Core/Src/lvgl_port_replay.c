@@ -0,0 +1,767 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_replay.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define REPLAY_EV_TYPE(t)  ((t) & ~REPLAY_EV_SCRIPT)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  lvgl_replay_event_t ev;
+  uint32_t stamp;               /* of the clock when it was fed, 0 for a replayed event */
+} replay_item_t;
+
+/* One index is left free to tell a full queue from an empty one. The stream queue is
+ * written by its producer and read by the LVGL task, its indices are published with
+ * release stores, the others are used by the LVGL task only. */
+typedef struct
+{
+  replay_item_t items[REPLAY_QUEUE_CNT];
+  uint32_t head;
+  uint32_t tail;
+} replay_queue_t;
+
+typedef struct
+{
+  lv_indev_t *indev;
+  lv_indev_read_cb_t read_cb;
+  bool pressed;
+  int32_t x;
+  int32_t y;
+  uint32_t key;
+} replay_wrap_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void
+replay_poll (void);
+
+static void
+replay_command (const lvgl_replay_event_t *ev);
+
+static void
+replay_finish (void);
+
+static void
+replay_send_result (const lvgl_replay_result_t *result);
+
+static bool
+replay_queue_put (replay_queue_t *q, const lvgl_replay_event_t *ev, uint32_t stamp);
+
+static bool
+replay_queue_get (replay_queue_t *q, replay_item_t *item);
+
+static void
+replay_pointer_read (lv_indev_t *indev, lv_indev_data_t *data);
+
+static void
+replay_keypad_read (lv_indev_t *indev, lv_indev_data_t *data);
+
+static void
+replay_record_read (lv_indev_t *indev, lv_indev_data_t *data);
+
+static void
+replay_record_add (uint8_t type, bool pressed, int32_t x, int32_t y, uint32_t key);
+
+static void
+replay_latency (uint32_t stamp);
+
+static void
+replay_refr_cb (lv_event_t *e);
+
+static uint32_t
+replay_now (void);
+
+static uint32_t
+replay_percentile (uint32_t pct);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static lv_display_t *display;
+static lv_indev_t *pointer;
+static lv_indev_t *keypad;
+
+static lvgl_replay_clock_cb_t clock_cb;
+static uint32_t clock_ticks_per_us = 1;
+static lvgl_replay_output_cb_t output_cb;
+
+/* from the stream, and for each virtual indev */
+static replay_queue_t in_q;
+static replay_queue_t pointer_q;
+static replay_queue_t keypad_q;
+
+/* loaded or recorded over the stream */
+static lvgl_replay_event_t script[REPLAY_SCRIPT_MAX];
+static uint32_t script_cnt;
+
+static int32_t last_x;
+static int32_t last_y;
+static lv_indev_state_t last_state = LV_INDEV_STATE_RELEASED;
+static uint32_t last_key;
+static lv_indev_state_t last_key_state = LV_INDEV_STATE_RELEASED;
+
+/* the replay */
+static bool playing;
+static const lvgl_replay_event_t *play_events;
+static uint32_t play_cnt;
+static uint32_t play_pos;
+static uint32_t play_start;
+static uint32_t play_end_ms;
+static uint32_t play_applied;
+static lvgl_replay_done_cb_t play_done_cb;
+
+/* the refreshes during the replay */
+static uint32_t refr_start;
+static uint32_t hist[REPLAY_HIST_CNT];
+static uint32_t frames;
+static uint64_t frames_us;
+static uint32_t frames_max_us;
+
+/* the recording */
+static bool recording;
+static bool stream_recording;
+static lvgl_replay_event_t *rec_buf;
+static uint32_t rec_cnt;
+static uint32_t rec_max;
+static uint32_t rec_start;
+static replay_wrap_t wraps[REPLAY_RECORD_INDEV_MAX];
+static uint32_t wrap_cnt;
+
+static uint64_t latency_sum_us;
+static uint32_t latency_cnt;
+
+static lvgl_replay_stats_t stats;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_result_t
+lvgl_replay_init (lv_display_t *disp)
+{
+  if (display != NULL)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  display = disp;
+  lv_display_add_event_cb(disp, replay_refr_cb, LV_EVENT_REFR_START, NULL);
+  lv_display_add_event_cb(disp, replay_refr_cb, LV_EVENT_REFR_READY, NULL);
+
+  pointer = lv_indev_create();
+  lv_indev_set_type(pointer, LV_INDEV_TYPE_POINTER);
+  lv_indev_set_display(pointer, disp);
+  lv_indev_set_read_cb(pointer, replay_pointer_read);
+
+  keypad = lv_indev_create();
+  lv_indev_set_type(keypad, LV_INDEV_TYPE_KEYPAD);
+  lv_indev_set_display(keypad, disp);
+  lv_indev_set_read_cb(keypad, replay_keypad_read);
+
+  return LV_RESULT_OK;
+}
+
+void
+lvgl_replay_set_clock (lvgl_replay_clock_cb_t cb,
+                       uint32_t               ticks_per_us)
+{
+  clock_cb = cb;
+  clock_ticks_per_us = LV_MAX(ticks_per_us, 1);
+}
+
+void
+lvgl_replay_set_output (lvgl_replay_output_cb_t cb)
+{
+  output_cb = cb;
+}
+
+lv_indev_t *
+lvgl_replay_get_keypad (void)
+{
+  return keypad;
+}
+
+void
+lvgl_replay_feed (const lvgl_replay_event_t *ev)
+{
+  uint32_t head = __atomic_load_n(&in_q.head, __ATOMIC_RELAXED);
+  uint32_t next = (head + 1) % REPLAY_QUEUE_CNT;
+
+  if (ev->magic != REPLAY_MAGIC)
+    {
+      return;
+    }
+
+  if (next == __atomic_load_n(&in_q.tail, __ATOMIC_ACQUIRE))
+    {
+      stats.dropped++;
+      return;
+    }
+
+  /* never 0, that's a replayed event */
+  in_q.items[head].ev = *ev;
+  in_q.items[head].stamp = replay_now() | 1;
+  __atomic_store_n(&in_q.head, next, __ATOMIC_RELEASE);
+  stats.events++;
+}
+
+lv_result_t
+lvgl_replay_play (const lvgl_replay_event_t *events,
+                  uint32_t                   cnt,
+                  lvgl_replay_done_cb_t      done_cb)
+{
+  uint32_t i;
+
+  if (display == NULL || playing || recording)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  play_events = events;
+  play_cnt = cnt;
+  play_pos = 0;
+  play_end_ms = 0;
+  play_applied = 0;
+  play_done_cb = done_cb;
+  for (i = 0; i < cnt; i++)
+    {
+      play_end_ms = LV_MAX(play_end_ms, events[i].time_ms);
+    }
+
+  /* the same start every run */
+  pointer_q.head = pointer_q.tail = 0;
+  keypad_q.head = keypad_q.tail = 0;
+  last_state = LV_INDEV_STATE_RELEASED;
+  last_key_state = LV_INDEV_STATE_RELEASED;
+
+  lv_memzero(hist, sizeof(hist));
+  frames = 0;
+  frames_us = 0;
+  frames_max_us = 0;
+
+  play_start = lv_tick_get();
+  playing = true;
+
+  return LV_RESULT_OK;
+}
+
+lv_result_t
+lvgl_replay_record_start (lvgl_replay_event_t *buf,
+                          uint32_t             cnt)
+{
+  lv_indev_t *indev = NULL;
+  lv_indev_type_t type;
+
+  if (display == NULL || playing || recording || cnt < 2)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  rec_buf = buf;
+  rec_max = cnt;
+  rec_cnt = 0;
+  wrap_cnt = 0;
+
+  /* the read callback of each pointer and keypad is wrapped, so its data is seen as
+   * LVGL gets it */
+  while ((indev = lv_indev_get_next(indev)) != NULL && wrap_cnt < REPLAY_RECORD_INDEV_MAX)
+    {
+      type = lv_indev_get_type(indev);
+      if (type != LV_INDEV_TYPE_POINTER && type != LV_INDEV_TYPE_KEYPAD)
+        {
+          continue;
+        }
+
+      wraps[wrap_cnt].indev = indev;
+      wraps[wrap_cnt].read_cb = lv_indev_get_read_cb(indev);
+      wraps[wrap_cnt].pressed = false;
+      wraps[wrap_cnt].key = 0;
+      lv_indev_set_read_cb(indev, replay_record_read);
+      wrap_cnt++;
+    }
+
+  rec_start = lv_tick_get();
+  recording = true;
+
+  return LV_RESULT_OK;
+}
+
+uint32_t
+lvgl_replay_record_stop (void)
+{
+  uint32_t i;
+
+  if (!recording)
+    {
+      return 0;
+    }
+
+  for (i = 0; i < wrap_cnt; i++)
+    {
+      lv_indev_set_read_cb(wraps[i].indev, wraps[i].read_cb);
+    }
+  wrap_cnt = 0;
+
+  /* the room for it was kept */
+  rec_buf[rec_cnt].magic = REPLAY_MAGIC;
+  rec_buf[rec_cnt].type = REPLAY_EV_END;
+  rec_buf[rec_cnt].pressed = 0;
+  rec_buf[rec_cnt].time_ms = lv_tick_elaps(rec_start);
+  rec_buf[rec_cnt].x = 0;
+  rec_buf[rec_cnt].y = 0;
+  rec_buf[rec_cnt].key = 0;
+  rec_cnt++;
+
+  recording = false;
+
+  return rec_cnt;
+}
+
+lv_result_t
+lvgl_replay_compare (const lvgl_replay_result_t *run,
+                     const lvgl_replay_result_t *baseline,
+                     uint32_t                    tolerance_pct)
+{
+  lv_result_t res = LV_RESULT_OK;
+
+  if ((uint64_t)run->avg_us * 100 > (uint64_t)baseline->avg_us * (100 + tolerance_pct))
+    {
+      LV_LOG_WARN("replay: average refresh %u us, baseline %u us",
+                  (unsigned)run->avg_us, (unsigned)baseline->avg_us);
+      res = LV_RESULT_INVALID;
+    }
+  if ((uint64_t)run->p95_us * 100 > (uint64_t)baseline->p95_us * (100 + tolerance_pct))
+    {
+      LV_LOG_WARN("replay: 95%% of the refreshes within %u us, baseline %u us",
+                  (unsigned)run->p95_us, (unsigned)baseline->p95_us);
+      res = LV_RESULT_INVALID;
+    }
+  if (run->frames != baseline->frames)
+    {
+      /* not a regression by itself, but the replay didn't do the same */
+      LV_LOG_WARN("replay: %u refreshes, baseline %u", (unsigned)run->frames, (unsigned)baseline->frames);
+    }
+
+  return res;
+}
+
+void
+lvgl_replay_get_stats (lvgl_replay_stats_t *stats_out)
+{
+  *stats_out = stats;
+  stats_out->latency_us = latency_cnt ? (uint32_t)(latency_sum_us / latency_cnt) : 0;
+}
+
+void
+lvgl_replay_reset_stats (void)
+{
+  lv_memzero(&stats, sizeof(stats));
+  latency_sum_us = 0;
+  latency_cnt = 0;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/* Called by the reads of both virtual indevs */
+static void
+replay_poll (void)
+{
+  uint32_t tail = in_q.tail;
+  replay_item_t *item;
+  uint32_t elaps;
+  uint8_t type;
+
+  while (tail != __atomic_load_n(&in_q.head, __ATOMIC_ACQUIRE))
+    {
+      item = &in_q.items[tail];
+      type = REPLAY_EV_TYPE(item->ev.type);
+
+      if (item->ev.type & REPLAY_EV_SCRIPT)
+        {
+          if (script_cnt < REPLAY_SCRIPT_MAX && !playing && !recording)
+            {
+              script[script_cnt] = item->ev;
+              script[script_cnt].type = type;
+              script_cnt++;
+            }
+        }
+      else if (type == REPLAY_EV_POINTER)
+        {
+          replay_queue_put(&pointer_q, &item->ev, item->stamp);
+        }
+      else if (type == REPLAY_EV_KEY)
+        {
+          replay_queue_put(&keypad_q, &item->ev, item->stamp);
+        }
+      else
+        {
+          replay_command(&item->ev);
+        }
+
+      tail = (tail + 1) % REPLAY_QUEUE_CNT;
+      __atomic_store_n(&in_q.tail, tail, __ATOMIC_RELEASE);
+    }
+
+  if (!playing)
+    {
+      return;
+    }
+
+  /* the events which are due by now, each is read on its own */
+  elaps = lv_tick_elaps(play_start);
+  while (play_pos < play_cnt && play_events[play_pos].time_ms <= elaps)
+    {
+      type = play_events[play_pos].type;
+      if (type == REPLAY_EV_POINTER && replay_queue_put(&pointer_q, &play_events[play_pos], 0))
+        {
+          play_applied++;
+        }
+      else if (type == REPLAY_EV_KEY && replay_queue_put(&keypad_q, &play_events[play_pos], 0))
+        {
+          play_applied++;
+        }
+      play_pos++;
+    }
+
+  if (play_pos == play_cnt && elaps >= play_end_ms)
+    {
+      replay_finish();
+    }
+}
+
+static void
+replay_command (const lvgl_replay_event_t *ev)
+{
+  uint32_t cnt;
+
+  switch (ev->type)
+    {
+      case REPLAY_CMD_CLEAR:
+        if (!playing && !recording)
+          {
+            script_cnt = 0;
+          }
+        break;
+
+      case REPLAY_CMD_PLAY:
+        if (lvgl_replay_play(script, script_cnt, replay_send_result) != LV_RESULT_OK)
+          {
+            LV_LOG_WARN("replay: busy");
+          }
+        break;
+
+      case REPLAY_CMD_RECORD:
+        if (lvgl_replay_record_start(script, REPLAY_SCRIPT_MAX) == LV_RESULT_OK)
+          {
+            stream_recording = true;
+          }
+        break;
+
+      case REPLAY_CMD_STOP:
+        if (stream_recording)
+          {
+            /* it can be replayed with REPLAY_CMD_PLAY as it is */
+            stream_recording = false;
+            cnt = lvgl_replay_record_stop();
+            script_cnt = cnt;
+            if (output_cb != NULL)
+              {
+                output_cb(script, cnt * sizeof(lvgl_replay_event_t));
+              }
+          }
+        else if (playing)
+          {
+            replay_finish();
+          }
+        break;
+
+      default:
+        break;
+    }
+}
+
+static void
+replay_finish (void)
+{
+  lvgl_replay_result_t result;
+
+  playing = false;
+
+  result.events = play_applied;
+  result.frames = frames;
+  result.time_ms = lv_tick_elaps(play_start);
+  result.avg_us = frames ? (uint32_t)(frames_us / frames) : 0;
+  result.p50_us = replay_percentile(50);
+  result.p95_us = replay_percentile(95);
+  result.max_us = frames_max_us;
+
+  stats.replays++;
+  LV_LOG_USER("replay: %u events, %u refreshes, avg %u us, 95%% %u us, max %u us",
+              (unsigned)result.events, (unsigned)result.frames, (unsigned)result.avg_us,
+              (unsigned)result.p95_us, (unsigned)result.max_us);
+
+  if (play_done_cb != NULL)
+    {
+      play_done_cb(&result);
+    }
+}
+
+static void
+replay_send_result (const lvgl_replay_result_t *result)
+{
+  lvgl_replay_event_t msg;
+
+  if (output_cb == NULL)
+    {
+      return;
+    }
+
+  lv_memzero(&msg, sizeof(msg));
+  msg.magic = REPLAY_MAGIC;
+  msg.type = REPLAY_MSG_RESULT;
+  msg.time_ms = result->time_ms;
+  msg.key = sizeof(*result);
+  output_cb(&msg, sizeof(msg));
+  output_cb(result, sizeof(*result));
+}
+
+static bool
+replay_queue_put (replay_queue_t            *q,
+                  const lvgl_replay_event_t *ev,
+                  uint32_t                   stamp)
+{
+  uint32_t next = (q->head + 1) % REPLAY_QUEUE_CNT;
+
+  if (next == q->tail)
+    {
+      stats.dropped++;
+      return false;
+    }
+
+  q->items[q->head].ev = *ev;
+  q->items[q->head].stamp = stamp;
+  q->head = next;
+
+  return true;
+}
+
+static bool
+replay_queue_get (replay_queue_t *q,
+                  replay_item_t  *item)
+{
+  if (q->tail == q->head)
+    {
+      return false;
+    }
+
+  *item = q->items[q->tail];
+  q->tail = (q->tail + 1) % REPLAY_QUEUE_CNT;
+
+  return true;
+}
+
+static void
+replay_pointer_read (lv_indev_t      *indev,
+                     lv_indev_data_t *data)
+{
+  replay_item_t item;
+
+  LV_UNUSED(indev);
+
+  replay_poll();
+
+  /* every event is read, so a click between two reads isn't lost */
+  if (replay_queue_get(&pointer_q, &item))
+    {
+      last_x = item.ev.x;
+      last_y = item.ev.y;
+      last_state = item.ev.pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+      replay_latency(item.stamp);
+      data->continue_reading = pointer_q.head != pointer_q.tail;
+    }
+
+  data->point.x = last_x;
+  data->point.y = last_y;
+  data->state = last_state;
+}
+
+static void
+replay_keypad_read (lv_indev_t      *indev,
+                    lv_indev_data_t *data)
+{
+  replay_item_t item;
+
+  replay_poll();
+
+  if (replay_queue_get(&keypad_q, &item))
+    {
+      last_key = item.ev.key;
+      last_key_state = item.ev.pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+      replay_latency(item.stamp);
+      data->continue_reading = keypad_q.head != keypad_q.tail;
+
+      /* the UI may have created its group after the indev */
+      if (lv_indev_get_group(indev) == NULL && lv_group_get_default() != NULL)
+        {
+          lv_indev_set_group(indev, lv_group_get_default());
+        }
+    }
+
+  data->key = last_key;
+  data->state = last_key_state;
+}
+
+static void
+replay_record_read (lv_indev_t      *indev,
+                    lv_indev_data_t *data)
+{
+  replay_wrap_t *w = NULL;
+  bool pressed;
+  uint32_t i;
+
+  for (i = 0; i < wrap_cnt && w == NULL; i++)
+    {
+      if (wraps[i].indev == indev)
+        {
+          w = &wraps[i];
+        }
+    }
+  if (w == NULL)
+    {
+      return;
+    }
+
+  w->read_cb(indev, data);
+
+  pressed = data->state == LV_INDEV_STATE_PRESSED;
+  if (lv_indev_get_type(indev) == LV_INDEV_TYPE_POINTER)
+    {
+      /* the moves while released don't matter to the widgets */
+      if (pressed != w->pressed || (pressed && (data->point.x != w->x || data->point.y != w->y)))
+        {
+          replay_record_add(REPLAY_EV_POINTER, pressed, data->point.x, data->point.y, 0);
+        }
+      w->x = data->point.x;
+      w->y = data->point.y;
+    }
+  else if (pressed != w->pressed || data->key != w->key)
+    {
+      replay_record_add(REPLAY_EV_KEY, pressed, 0, 0, data->key);
+    }
+
+  w->pressed = pressed;
+  w->key = data->key;
+}
+
+static void
+replay_record_add (uint8_t type,
+                   bool    pressed,
+                   int32_t x,
+                   int32_t y,
+                   uint32_t key)
+{
+  lvgl_replay_event_t *ev;
+
+  /* the last one is kept for REPLAY_EV_END */
+  if (rec_cnt + 1 >= rec_max)
+    {
+      return;
+    }
+
+  ev = &rec_buf[rec_cnt++];
+  ev->magic = REPLAY_MAGIC;
+  ev->type = type;
+  ev->pressed = pressed;
+  ev->time_ms = lv_tick_elaps(rec_start);
+  ev->x = x;
+  ev->y = y;
+  ev->key = key;
+
+  stats.recorded++;
+}
+
+static void
+replay_latency (uint32_t stamp)
+{
+  uint32_t us;
+
+  if (stamp == 0)
+    {
+      return;
+    }
+
+  us = (replay_now() - stamp) / clock_ticks_per_us;
+  latency_sum_us += us;
+  latency_cnt++;
+  stats.latency_max_us = LV_MAX(stats.latency_max_us, us);
+}
+
+static void
+replay_refr_cb (lv_event_t *e)
+{
+  uint32_t us;
+
+  if (lv_event_get_code(e) == LV_EVENT_REFR_START)
+    {
+      refr_start = replay_now();
+      return;
+    }
+
+  if (!playing)
+    {
+      return;
+    }
+
+  us = (replay_now() - refr_start) / clock_ticks_per_us;
+  hist[LV_MIN(us / REPLAY_HIST_STEP_US, REPLAY_HIST_CNT - 1)]++;
+  frames++;
+  frames_us += us;
+  frames_max_us = LV_MAX(frames_max_us, us);
+}
+
+/* the differences are right across a wrap around */
+static uint32_t
+replay_now (void)
+{
+  return clock_cb != NULL ? clock_cb() : lv_tick_get() * 1000;
+}
+
+/* the upper end of the bucket `pct` percent of the refreshes fell in */
+static uint32_t
+replay_percentile (uint32_t pct)
+{
+  uint32_t want = (frames * pct + 99) / 100;
+  uint32_t sum = 0;
+  uint32_t i;
+
+  if (frames == 0)
+    {
+      return 0;
+    }
+
+  for (i = 0; i < REPLAY_HIST_CNT - 1; i++)
+    {
+      sum += hist[i];
+      if (sum >= want)
+        {
+          return (i + 1) * REPLAY_HIST_STEP_US;
+        }
+    }
+
+  return frames_max_us;
+}
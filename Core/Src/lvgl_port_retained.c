@@ -0,0 +1,398 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_retained.h"
+#include "lvgl/src/stdlib/builtin/lv_tlsf.h"
+
+#if RETAINED_ENABLE
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#if LV_USE_SNAPSHOT == 0
+  #error "lvgl_port_retained requires LV_USE_SNAPSHOT"
+#endif
+
+#define RETAINED_BUF_ALIGN  32
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum
+{
+  RETAINED_LIVE,      /* the subtree is rendered normally */
+  RETAINED_CACHED,    /* the subtree is hidden and the proxy blits its texture */
+} retained_state_t;
+
+typedef struct
+{
+  lv_obj_t         *obj;
+  lv_obj_t         *proxy;
+  lv_color_format_t cf;
+  retained_state_t  state;
+  uint32_t          quiet;
+  uint32_t          last_used;
+  void             *data;
+  lv_draw_buf_t     draw_buf;
+} retained_entry_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static retained_entry_t *
+retained_find (const lv_obj_t *obj);
+
+static void
+retained_capture (retained_entry_t *entry);
+
+static void
+retained_go_live (retained_entry_t *entry);
+
+static void *
+retained_alloc (uint32_t size, const retained_entry_t *requester);
+
+static void
+retained_free (retained_entry_t *entry);
+
+static void
+retained_timer_cb (lv_timer_t *timer);
+
+static void
+retained_invalidate_area_cb (lv_event_t *e);
+
+static void
+retained_proxy_draw_cb (lv_event_t *e);
+
+static void
+retained_proxy_delete_cb (lv_event_t *e);
+
+static void
+retained_obj_delete_cb (lv_event_t *e);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static __attribute__((aligned(RETAINED_BUF_ALIGN))) uint8_t cache_mem[RETAINED_CACHE_SIZE];
+static lv_tlsf_t cache_tlsf;
+
+static retained_entry_t entries[RETAINED_MAX_CNT];
+
+/* set while this module changes objects, so their invalidation doesn't count as a change */
+static bool guard;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_retained_init (lv_display_t *disp)
+{
+  cache_tlsf = lv_tlsf_create_with_pool(cache_mem, sizeof(cache_mem));
+
+  lv_display_add_event_cb(disp, retained_invalidate_area_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+  lv_timer_create(retained_timer_cb, LV_DEF_REFR_PERIOD, NULL);
+}
+
+lv_result_t
+lvgl_retained_add (lv_obj_t        *obj,
+                   lv_color_format_t cf)
+{
+  retained_entry_t *entry;
+
+  if (lv_obj_get_parent(obj) == NULL || retained_find(obj) != NULL)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  entry = retained_find(NULL);
+  if (entry == NULL)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  lv_memzero(entry, sizeof(*entry));
+  entry->obj = obj;
+  entry->cf = cf;
+  entry->state = RETAINED_LIVE;
+  entry->last_used = lv_tick_get();
+
+  /* the proxy is a sibling, so hiding the subtree with `opa` doesn't hide the proxy too */
+  guard = true;
+  entry->proxy = lv_image_create(lv_obj_get_parent(obj));
+  lv_obj_add_flag(entry->proxy, LV_OBJ_FLAG_HIDDEN | LV_OBJ_FLAG_IGNORE_LAYOUT);
+  lv_obj_remove_flag(entry->proxy, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+  guard = false;
+
+  lv_obj_add_event_cb(entry->proxy, retained_proxy_draw_cb, LV_EVENT_DRAW_MAIN_BEGIN, entry);
+  lv_obj_add_event_cb(entry->proxy, retained_proxy_delete_cb, LV_EVENT_DELETE, entry);
+  lv_obj_add_event_cb(obj, retained_obj_delete_cb, LV_EVENT_DELETE, entry);
+
+  return LV_RESULT_OK;
+}
+
+void
+lvgl_retained_remove (lv_obj_t *obj)
+{
+  retained_entry_t *entry = retained_find(obj);
+
+  if (entry == NULL)
+    {
+      return;
+    }
+
+  retained_go_live(entry);
+  retained_free(entry);
+  lv_obj_remove_event_cb(obj, retained_obj_delete_cb);
+
+  if (entry->proxy != NULL)
+    {
+      lv_obj_remove_event_cb(entry->proxy, retained_proxy_delete_cb);
+      lv_obj_delete(entry->proxy);
+    }
+
+  entry->obj = NULL;
+}
+
+void
+lvgl_retained_invalidate (lv_obj_t *obj)
+{
+  retained_entry_t *entry = retained_find(obj);
+
+  if (entry != NULL)
+    {
+      entry->last_used = lv_tick_get();
+      retained_go_live(entry);
+    }
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static retained_entry_t *
+retained_find (const lv_obj_t *obj)
+{
+  uint32_t i;
+
+  for (i = 0; i < RETAINED_MAX_CNT; i++)
+    {
+      if (entries[i].obj == obj)
+        {
+          return &entries[i];
+        }
+    }
+
+  return NULL;
+}
+
+static void
+retained_capture (retained_entry_t *entry)
+{
+  int32_t ext = lv_obj_get_ext_draw_size(entry->obj);
+  uint32_t w = lv_obj_get_width(entry->obj) + 2 * ext;
+  uint32_t h = lv_obj_get_height(entry->obj) + 2 * ext;
+  uint32_t stride = lv_draw_buf_width_to_stride(w, entry->cf);
+
+  if (entry->proxy == NULL)
+    {
+      return;
+    }
+
+  /* a resized object can't reuse its previous texture */
+  if (entry->data != NULL && (entry->draw_buf.header.w != w || entry->draw_buf.header.h != h))
+    {
+      retained_free(entry);
+    }
+
+  if (entry->data == NULL)
+    {
+      entry->data = retained_alloc(stride * h, entry);
+      if (entry->data == NULL)
+        {
+          /* over budget, keep rendering it live and retry later */
+          entry->quiet = 0;
+          return;
+        }
+      lv_draw_buf_init(&entry->draw_buf, w, h, entry->cf, stride, entry->data, stride * h);
+    }
+
+  /* the subtree is drawn by the GPU into the texture with the display's draw units */
+  if (lv_snapshot_take_to_draw_buf(entry->obj, entry->cf, &entry->draw_buf) != LV_RESULT_OK)
+    {
+      retained_free(entry);
+      entry->quiet = 0;
+      return;
+    }
+
+  guard = true;
+  lv_image_cache_drop(&entry->draw_buf);
+  lv_image_set_src(entry->proxy, &entry->draw_buf);
+  lv_obj_set_pos(entry->proxy, lv_obj_get_x(entry->obj) - ext, lv_obj_get_y(entry->obj) - ext);
+  lv_obj_move_to_index(entry->proxy, lv_obj_get_index(entry->obj) + 1);
+  lv_obj_remove_flag(entry->proxy, LV_OBJ_FLAG_HIDDEN);
+  lv_obj_set_style_opa(entry->obj, LV_OPA_TRANSP, LV_PART_MAIN);
+  guard = false;
+
+  entry->state = RETAINED_CACHED;
+  entry->last_used = lv_tick_get();
+}
+
+static void
+retained_go_live (retained_entry_t *entry)
+{
+  entry->quiet = 0;
+
+  if (entry->state != RETAINED_CACHED)
+    {
+      return;
+    }
+
+  guard = true;
+  if (entry->proxy != NULL)
+    {
+      lv_obj_add_flag(entry->proxy, LV_OBJ_FLAG_HIDDEN);
+    }
+  lv_obj_remove_local_style_prop(entry->obj, LV_STYLE_OPA, LV_PART_MAIN);
+  guard = false;
+
+  entry->state = RETAINED_LIVE;
+}
+
+static void *
+retained_alloc (uint32_t                size,
+                const retained_entry_t *requester)
+{
+  void *data = lv_tlsf_memalign(cache_tlsf, RETAINED_BUF_ALIGN, size);
+  retained_entry_t *lru;
+  uint32_t i;
+
+  while (data == NULL)
+    {
+      /* evict only textures drawn less recently than the requester's, so an
+       * over-budget set of objects doesn't keep evicting each other. The ticks are
+       * compared by their difference, which stays right when the tick wraps. */
+      lru = NULL;
+      for (i = 0; i < RETAINED_MAX_CNT; i++)
+        {
+          if (entries[i].obj != NULL && &entries[i] != requester && entries[i].data != NULL &&
+              (int32_t)(entries[i].last_used - requester->last_used) < 0 &&
+              (lru == NULL || (int32_t)(entries[i].last_used - lru->last_used) < 0))
+            {
+              lru = &entries[i];
+            }
+        }
+
+      if (lru == NULL)
+        {
+          break;
+        }
+
+      retained_go_live(lru);
+      retained_free(lru);
+      data = lv_tlsf_memalign(cache_tlsf, RETAINED_BUF_ALIGN, size);
+    }
+
+  return data;
+}
+
+static void
+retained_free (retained_entry_t *entry)
+{
+  if (entry->data == NULL)
+    {
+      return;
+    }
+
+  lv_image_cache_drop(&entry->draw_buf);
+  lv_tlsf_free(cache_tlsf, entry->data);
+  entry->data = NULL;
+}
+
+static void
+retained_timer_cb (lv_timer_t *timer)
+{
+  uint32_t i;
+
+  LV_UNUSED(timer);
+
+  for (i = 0; i < RETAINED_MAX_CNT; i++)
+    {
+      if (entries[i].obj != NULL && entries[i].state == RETAINED_LIVE &&
+          ++entries[i].quiet >= RETAINED_SETTLE_PERIODS)
+        {
+          retained_capture(&entries[i]);
+        }
+    }
+}
+
+static void
+retained_invalidate_area_cb (lv_event_t *e)
+{
+  const lv_area_t *area = lv_event_get_param(e);
+  lv_area_t coords;
+  int32_t ext;
+  uint32_t i;
+
+  if (guard || area == NULL)
+    {
+      return;
+    }
+
+  for (i = 0; i < RETAINED_MAX_CNT; i++)
+    {
+      if (entries[i].obj == NULL)
+        {
+          continue;
+        }
+
+      lv_obj_get_coords(entries[i].obj, &coords);
+      ext = lv_obj_get_ext_draw_size(entries[i].obj);
+
+      /* something inside the subtree changed, render it live until it settles */
+      if (area->x1 <= coords.x2 + ext && area->x2 >= coords.x1 - ext &&
+          area->y1 <= coords.y2 + ext && area->y2 >= coords.y1 - ext)
+        {
+          entries[i].last_used = lv_tick_get();
+          retained_go_live(&entries[i]);
+        }
+    }
+}
+
+static void
+retained_proxy_draw_cb (lv_event_t *e)
+{
+  retained_entry_t *entry = lv_event_get_user_data(e);
+
+  entry->last_used = lv_tick_get();
+}
+
+static void
+retained_proxy_delete_cb (lv_event_t *e)
+{
+  retained_entry_t *entry = lv_event_get_user_data(e);
+
+  entry->proxy = NULL;
+}
+
+static void
+retained_obj_delete_cb (lv_event_t *e)
+{
+  retained_entry_t *entry = lv_event_get_user_data(e);
+
+  retained_free(entry);
+
+  if (entry->proxy != NULL)
+    {
+      lv_obj_remove_event_cb(entry->proxy, retained_proxy_delete_cb);
+      lv_obj_delete(entry->proxy);
+    }
+
+  entry->obj = NULL;
+}
+
+#endif /* RETAINED_ENABLE */
@@ -0,0 +1,126 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_rotation.h"
+#include "lvgl_port_display.h"
+#include "main.h"
+#include "ltdc.h"
+#include "nema_core.h"
+
+#if MY_DISP_ROTATION != 0
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#if LV_USE_NEMA_GFX == 0
+  #error "lvgl_port_rotation requires LV_USE_NEMA_GFX"
+#endif
+
+#if LV_COLOR_DEPTH != 16
+  #error "lvgl_port_rotation supports LV_COLOR_DEPTH 16 only"
+#endif
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void
+rotation_flush_cb (lv_display_t *disp, const lv_area_t *area, uint8_t *px_map);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static __attribute__((aligned(32))) uint8_t buf_1[MY_DISP_VER_RES * ROTATION_BUF_LINES * 2];
+static __attribute__((aligned(32))) uint8_t buf_2[MY_DISP_VER_RES * ROTATION_BUF_LINES * 2];
+
+static nema_cmdlist_t rotate_cl;
+static uintptr_t fb;
+static uint32_t nema_rotation;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_display_t *
+lvgl_rotation_create (lv_display_rotation_t rotation,
+                      uint32_t              layer_idx)
+{
+  lv_display_t * disp;
+
+  /* LVGL rotates counter-clockwise, see lv_display_rotate_area() */
+  switch (rotation)
+    {
+      case LV_DISPLAY_ROTATION_90:
+        nema_rotation = NEMA_ROT_090_CCW;
+        break;
+      case LV_DISPLAY_ROTATION_180:
+        nema_rotation = NEMA_ROT_180_CCW;
+        break;
+      case LV_DISPLAY_ROTATION_270:
+        nema_rotation = NEMA_ROT_270_CCW;
+        break;
+      default:
+        nema_rotation = NEMA_ROT_000_CCW;
+        break;
+    }
+
+  /* the layer keeps scanning out the framebuffer CubeMX configured, in the native orientation */
+  fb = hltdc.LayerCfg[layer_idx].FBStartAdress;
+
+  /* nema_init() was called by lv_init() */
+  rotate_cl = nema_cl_create_sized(ROTATION_CL_SIZE);
+
+  disp = lv_display_create(MY_DISP_HOR_RES, MY_DISP_VER_RES);
+  lv_display_set_color_format(disp, LV_COLOR_FORMAT_RGB565);
+  lv_display_set_buffers(disp, buf_1, buf_2, sizeof(buf_1), LV_DISPLAY_RENDER_MODE_PARTIAL);
+  lv_display_set_flush_cb(disp, rotation_flush_cb);
+
+  /* LVGL swaps the resolution and rotates the touch coordinates too */
+  lv_display_set_rotation(disp, rotation);
+
+  return disp;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void
+rotation_flush_cb (lv_display_t    *disp,
+                   const lv_area_t *area,
+                   uint8_t         *px_map)
+{
+  lv_area_t native = *area;
+  int32_t w = lv_area_get_width(area);
+  int32_t h = lv_area_get_height(area);
+  nema_cmdlist_t *draw_cl = nema_cl_get_bound();
+
+  lv_display_rotate_area(disp, &native);
+
+  /* the LVGL draw units are idle while flushing, borrow the GPU for a rotating blit */
+  nema_cl_bind(&rotate_cl);
+  nema_cl_rewind(&rotate_cl);
+
+  nema_bind_dst_tex(fb, MY_DISP_HOR_RES, MY_DISP_VER_RES, NEMA_RGB565, -1);
+  nema_set_clip(0, 0, MY_DISP_HOR_RES, MY_DISP_VER_RES);
+  nema_bind_src_tex((uintptr_t)px_map, w, h, NEMA_RGB565,
+                    lv_draw_buf_width_to_stride(w, LV_COLOR_FORMAT_RGB565), NEMA_FILTER_PS);
+  nema_set_blend_blit(NEMA_BL_SRC);
+  nema_blit_rotate(native.x1, native.y1, nema_rotation);
+
+  nema_cl_submit(&rotate_cl);
+  nema_cl_wait(&rotate_cl);
+
+  /* give the GPU back to the NemaGFX draw unit */
+  if (draw_cl != NULL)
+    {
+      nema_cl_bind_circular(draw_cl);
+    }
+
+  lv_display_flush_ready(disp);
+}
+
+#endif /* MY_DISP_ROTATION */
@@ -0,0 +1,330 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_sd.h"
+#include "main.h"
+#include "sdmmc.h"
+#include "cmsis_os2.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* the timeouts of CMSIS-RTOS2 are in kernel ticks */
+#define SD_MS_TO_TICKS(ms)  ((uint32_t)(((uint64_t)(ms) * osKernelGetTickFreq() + 999) / 1000))
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static lv_result_t
+sd_start (uint32_t lba, void *buf, uint32_t cnt, bool write);
+
+static lv_result_t
+sd_finish (void);
+
+static void
+sd_done (bool err);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/* held while a transfer is started or finished, not while it runs */
+static osMutexId_t sd_mutex;
+static osSemaphoreId_t sd_sem;
+
+static const osMutexAttr_t sd_mutex_attr =
+{
+  .name = "sd",
+  .attr_bits = osMutexPrioInherit,
+};
+
+static bool ready;
+static volatile bool done = true;
+static volatile bool error;
+
+/* a transfer was started and nobody waited for it yet */
+static bool busy;
+
+/* the task whose read was started, and the result of the read once another
+ * task had to finish it to use the card */
+static osThreadId_t stream_owner;
+static lv_result_t stream_res;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_result_t
+lvgl_sd_init (void)
+{
+  if (sd_mutex == NULL)
+    {
+      sd_mutex = osMutexNew(&sd_mutex_attr);
+      sd_sem = osSemaphoreNew(1, 0, NULL);
+    }
+
+  osMutexAcquire(sd_mutex, osWaitForever);
+
+  if (busy)
+    {
+      stream_res = sd_finish();
+    }
+
+  if (ready)
+    {
+      HAL_SD_DeInit(&hsd1);
+      ready = false;
+    }
+
+  /* the settings of MX_SDMMC1_SD_Init() */
+  hsd1.Instance = SDMMC1;
+  hsd1.Init.ClockEdge = SDMMC_CLOCK_EDGE_RISING;
+  hsd1.Init.ClockPowerSave = SDMMC_CLOCK_POWER_SAVE_DISABLE;
+  hsd1.Init.BusWide = SDMMC_BUS_WIDE_4B;
+  hsd1.Init.HardwareFlowControl = SDMMC_HARDWARE_FLOW_CONTROL_DISABLE;
+  hsd1.Init.ClockDiv = 0;
+
+  if (HAL_SD_Init(&hsd1) == HAL_OK)
+    {
+      HAL_NVIC_SetPriority(SDMMC1_IRQn, SD_IRQ_PRIORITY, 0);
+      HAL_NVIC_EnableIRQ(SDMMC1_IRQn);
+      ready = true;
+    }
+  else
+    {
+      LV_LOG_WARN("no SD card");
+    }
+
+  osMutexRelease(sd_mutex);
+
+  return ready ? LV_RESULT_OK : LV_RESULT_INVALID;
+}
+
+bool
+lvgl_sd_is_ready (void)
+{
+  return ready;
+}
+
+uint32_t
+lvgl_sd_get_block_count (void)
+{
+  return ready ? hsd1.SdCard.BlockNbr * (hsd1.SdCard.BlockSize / SD_BLOCK_SIZE) : 0;
+}
+
+lv_result_t
+lvgl_sd_read_start (uint32_t lba,
+                    void    *buf,
+                    uint32_t cnt)
+{
+  osThreadId_t self = osThreadGetId();
+  lv_result_t res;
+
+  if (!ready)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  osMutexAcquire(sd_mutex, osWaitForever);
+
+  /* the result of another task's read is kept until it waits for it */
+  if (stream_owner != NULL && stream_owner != self)
+    {
+      osMutexRelease(sd_mutex);
+      return LV_RESULT_INVALID;
+    }
+
+  /* a read of its own it didn't wait for is dropped */
+  if (busy)
+    {
+      sd_finish();
+    }
+  stream_owner = NULL;
+
+  res = sd_start(lba, buf, cnt, false);
+  if (res == LV_RESULT_OK)
+    {
+      stream_owner = self;
+    }
+
+  osMutexRelease(sd_mutex);
+
+  return res;
+}
+
+bool
+lvgl_sd_read_is_done (void)
+{
+  return !busy || done;
+}
+
+lv_result_t
+lvgl_sd_read_wait (void)
+{
+  lv_result_t res = LV_RESULT_INVALID;
+
+  osMutexAcquire(sd_mutex, osWaitForever);
+
+  if (stream_owner == osThreadGetId())
+    {
+      /* still running, or finished by another task which wanted the card */
+      res = busy ? sd_finish() : stream_res;
+      stream_owner = NULL;
+    }
+
+  osMutexRelease(sd_mutex);
+
+  return res;
+}
+
+lv_result_t
+lvgl_sd_read (uint32_t lba,
+              void    *buf,
+              uint32_t cnt)
+{
+  lv_result_t res;
+
+  if (!ready)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  osMutexAcquire(sd_mutex, osWaitForever);
+
+  if (busy)
+    {
+      stream_res = sd_finish();
+    }
+
+  res = sd_start(lba, buf, cnt, false);
+  if (res == LV_RESULT_OK)
+    {
+      res = sd_finish();
+    }
+
+  osMutexRelease(sd_mutex);
+
+  return res;
+}
+
+lv_result_t
+lvgl_sd_write (uint32_t    lba,
+               const void *buf,
+               uint32_t    cnt)
+{
+  lv_result_t res;
+
+  if (!ready)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  osMutexAcquire(sd_mutex, osWaitForever);
+
+  if (busy)
+    {
+      stream_res = sd_finish();
+    }
+
+  res = sd_start(lba, (void *)buf, cnt, true);
+  if (res == LV_RESULT_OK)
+    {
+      res = sd_finish();
+    }
+
+  osMutexRelease(sd_mutex);
+
+  return res;
+}
+
+/* the HAL's weak callbacks, USE_HAL_SD_REGISTER_CALLBACKS is 0 */
+void
+HAL_SD_RxCpltCallback (SD_HandleTypeDef *hsd)
+{
+  LV_UNUSED(hsd);
+
+  sd_done(false);
+}
+
+void
+HAL_SD_TxCpltCallback (SD_HandleTypeDef *hsd)
+{
+  LV_UNUSED(hsd);
+
+  sd_done(false);
+}
+
+void
+HAL_SD_ErrorCallback (SD_HandleTypeDef *hsd)
+{
+  LV_UNUSED(hsd);
+
+  sd_done(true);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static lv_result_t
+sd_start (uint32_t lba,
+          void    *buf,
+          uint32_t cnt,
+          bool     write)
+{
+  HAL_StatusTypeDef status;
+
+  /* a completion nobody waited for mustn't end this transfer */
+  osSemaphoreAcquire(sd_sem, 0);
+  done = false;
+  error = false;
+
+  status = write ? HAL_SD_WriteBlocks_DMA(&hsd1, buf, lba, cnt) : HAL_SD_ReadBlocks_DMA(&hsd1, buf, lba, cnt);
+  if (status != HAL_OK)
+    {
+      done = true;
+      return LV_RESULT_INVALID;
+    }
+
+  busy = true;
+
+  return LV_RESULT_OK;
+}
+
+static lv_result_t
+sd_finish (void)
+{
+  uint32_t start;
+
+  if (osSemaphoreAcquire(sd_sem, SD_MS_TO_TICKS(SD_TIMEOUT)) != osOK)
+    {
+      HAL_SD_Abort(&hsd1);
+      done = true;
+      error = true;
+    }
+
+  /* the card is busy until the data is programmed, it accepts the next command in the transfer state */
+  start = HAL_GetTick();
+  while (!error && HAL_SD_GetCardState(&hsd1) != HAL_SD_CARD_TRANSFER)
+    {
+      if (HAL_GetTick() - start > SD_TIMEOUT)
+        {
+          error = true;
+        }
+    }
+
+  busy = false;
+
+  return error ? LV_RESULT_INVALID : LV_RESULT_OK;
+}
+
+static void
+sd_done (bool err)
+{
+  error = err;
+  done = true;
+  osSemaphoreRelease(sd_sem);
+}
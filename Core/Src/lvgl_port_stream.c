@@ -0,0 +1,851 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_stream.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define STREAM_SHIFT      ((uint32_t)__builtin_ctz(STREAM_LEVEL_FACTOR))
+
+/* the oldest samples can be overwritten by the producer while they're read */
+#define STREAM_MARGIN(n)  ((n) / 8)
+
+#define STREAM_MIN_CAPACITY 64
+
+/* LVGL redraws the whole screen past this many invalidated areas (LV_INV_BUF_SIZE) */
+#define STREAM_DIRTY_MAX    32
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  int16_t min;
+  int16_t max;                  /* below `min` for no samples */
+} stream_pair_t;
+
+typedef struct
+{
+  lv_area_t area;               /* the union of the areas invalidated */
+  uint32_t  cnt;                /* of areas, STREAM_DIRTY_MAX when they aren't known */
+} stream_dirty_t;
+
+typedef struct
+{
+  lv_obj_t          *obj;
+  lvgl_stream_mode_t mode;
+
+  /* the samples, written by the producer at `head` */
+  int16_t           *raw;
+  uint32_t           capacity;
+  uint32_t           head;
+  uint32_t           taken;
+
+  /* level L holds a pair for every STREAM_LEVEL_FACTOR^L samples, level 0 is `raw` */
+  stream_pair_t     *level[STREAM_LEVEL_MAX + 1];
+  uint32_t           levels;
+
+  /* Samples taken, a sample's index in the history. The producer wrote it `skew`
+   * further, which grows when samples are skipped after an overrun. */
+  uint64_t           total;
+  uint32_t           skew;
+  uint64_t           start;     /* the first one that can be read */
+
+  int32_t            min;
+  int32_t            max;
+  uint32_t           spp;
+  bool               follow;
+
+  /* column k is at cols[k % width], `end` is the newest one shown */
+  int64_t            end;
+  uint32_t           width;
+  stream_pair_t      cols[STREAM_WIDTH_MAX];
+  stream_pair_t      band;      /* scroll mode: the values of the columns shown */
+
+  lvgl_stream_stats_t stats;
+} stream_entry_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static stream_entry_t *
+stream_find (const lv_obj_t *obj);
+
+static void
+stream_take (stream_entry_t *entry);
+
+static void
+stream_add (stream_entry_t *entry, int16_t v);
+
+static stream_pair_t
+stream_query (const stream_entry_t *entry, uint64_t a, uint64_t b);
+
+static stream_pair_t
+stream_column (stream_entry_t *entry, int64_t k);
+
+static void
+stream_rebuild (stream_entry_t *entry);
+
+static stream_pair_t
+stream_band (const stream_entry_t *entry);
+
+static void
+stream_invalidate (stream_entry_t *entry, int64_t first, uint32_t cnt, const stream_pair_t *band);
+
+static bool
+stream_is_transformed (const lv_obj_t *obj);
+
+static int32_t
+stream_map_y (const stream_entry_t *entry, int32_t v, const lv_area_t *coords);
+
+static void
+stream_timer_cb (lv_timer_t *t);
+
+static void
+stream_draw_cb (lv_event_t *e);
+
+static void
+stream_size_cb (lv_event_t *e);
+
+static void
+stream_delete_cb (lv_event_t *e);
+
+static void
+stream_invalidate_area_cb (lv_event_t *e);
+
+static void
+stream_dirty_add (stream_dirty_t *d, const lv_area_t *area);
+
+static void
+stream_refr_cb (lv_event_t *e);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static stream_entry_t entries[STREAM_MAX_CNT];
+
+static lv_timer_t *timer;
+
+/* the display of the charts, and what was invalidated on it for its refreshes */
+static lv_display_t *display;
+static stream_dirty_t dirty;
+static stream_dirty_t pending;
+static bool refreshing;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_obj_t *
+lvgl_stream_create (lv_obj_t          *parent,
+                    void              *buf,
+                    uint32_t           size,
+                    lvgl_stream_mode_t mode)
+{
+  stream_entry_t *entry = stream_find(NULL);
+  uint8_t *p = (uint8_t *)LV_ROUND_UP((uintptr_t)buf, 4);
+  uint32_t need;
+  uint32_t n;
+  uint32_t l;
+
+  if (entry == NULL || (uintptr_t)p - (uintptr_t)buf + STREAM_MIN_CAPACITY * sizeof(int16_t) > size)
+    {
+      return NULL;
+    }
+  size -= (uintptr_t)p - (uintptr_t)buf;
+
+  /* the largest power of 2 of samples which fits with its pyramid */
+  for (n = 1U << (31 - __builtin_clz(size / sizeof(int16_t))); n >= STREAM_MIN_CAPACITY; n >>= 1)
+    {
+      need = n * sizeof(int16_t);
+      for (l = 1; l <= STREAM_LEVEL_MAX && (n >> (STREAM_SHIFT * l)) > 0; l++)
+        {
+          need += (n >> (STREAM_SHIFT * l)) * sizeof(stream_pair_t);
+        }
+      if (need <= size)
+        {
+          break;
+        }
+    }
+  if (n < STREAM_MIN_CAPACITY)
+    {
+      return NULL;
+    }
+
+  lv_memzero(entry, sizeof(*entry));
+  entry->mode = mode;
+  entry->raw = (int16_t *)p;
+  entry->capacity = n;
+  p += n * sizeof(int16_t);
+  for (l = 1; l <= STREAM_LEVEL_MAX && (n >> (STREAM_SHIFT * l)) > 0; l++)
+    {
+      entry->level[l] = (stream_pair_t *)p;
+      p += (n >> (STREAM_SHIFT * l)) * sizeof(stream_pair_t);
+    }
+  entry->levels = l - 1;
+  entry->min = INT16_MIN;
+  entry->max = INT16_MAX;
+  entry->spp = 1;
+  entry->follow = true;
+  entry->end = -1;
+  entry->stats.capacity = n;
+  entry->stats.levels = entry->levels;
+
+  entry->obj = lv_obj_create(parent);
+  lv_obj_remove_flag(entry->obj, LV_OBJ_FLAG_SCROLLABLE);
+  lv_obj_add_event_cb(entry->obj, stream_draw_cb, LV_EVENT_DRAW_MAIN, entry);
+  lv_obj_add_event_cb(entry->obj, stream_size_cb, LV_EVENT_SIZE_CHANGED, entry);
+  lv_obj_add_event_cb(entry->obj, stream_delete_cb, LV_EVENT_DELETE, entry);
+
+  if (timer == NULL)
+    {
+      timer = lv_timer_create(stream_timer_cb, LV_DEF_REFR_PERIOD, NULL);
+
+      /* the areas invalidated before aren't known */
+      display = lv_obj_get_display(entry->obj);
+      dirty.cnt = STREAM_DIRTY_MAX;
+      pending.cnt = STREAM_DIRTY_MAX;
+      lv_display_add_event_cb(display, stream_invalidate_area_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+      lv_display_add_event_cb(display, stream_refr_cb, LV_EVENT_REFR_START, NULL);
+      lv_display_add_event_cb(display, stream_refr_cb, LV_EVENT_REFR_READY, NULL);
+    }
+
+  return entry->obj;
+}
+
+void
+lvgl_stream_set_range (lv_obj_t *obj,
+                       int32_t   min,
+                       int32_t   max)
+{
+  stream_entry_t *entry = stream_find(obj);
+
+  if (entry == NULL || min >= max)
+    {
+      return;
+    }
+
+  entry->min = min;
+  entry->max = max;
+  lv_obj_invalidate(obj);
+}
+
+void
+lvgl_stream_set_view (lv_obj_t *obj,
+                      uint32_t  samples_per_px,
+                      uint32_t  columns_back)
+{
+  stream_entry_t *entry = stream_find(obj);
+
+  if (entry == NULL)
+    {
+      return;
+    }
+
+  stream_take(entry);
+
+  entry->spp = LV_MAX(samples_per_px, 1);
+  entry->follow = columns_back == 0;
+  entry->end = entry->total > 0 ? (int64_t)((entry->total - 1) / entry->spp) - columns_back : -1;
+  entry->end = LV_MAX(entry->end, -1);
+  stream_rebuild(entry);
+}
+
+int32_t
+lvgl_stream_get_id (lv_obj_t *obj)
+{
+  stream_entry_t *entry = stream_find(obj);
+
+  return entry != NULL && obj != NULL ? (int32_t)(entry - entries) : -1;
+}
+
+void
+lvgl_stream_write (int32_t        id,
+                   const int16_t *samples,
+                   uint32_t       cnt)
+{
+  stream_entry_t *entry;
+  uint32_t mask;
+  uint32_t head;
+  uint32_t pos;
+  uint32_t len;
+
+  /* the entries are scanned and changed by the LVGL task, the id selects one
+   * without reading them */
+  if (id < 0 || id >= STREAM_MAX_CNT)
+    {
+      return;
+    }
+  entry = &entries[id];
+
+  mask = entry->capacity - 1;
+  head = entry->head;
+
+  /* more than the history holds, only the last ones are kept */
+  if (cnt > entry->capacity)
+    {
+      head += cnt - entry->capacity;
+      samples += cnt - entry->capacity;
+      cnt = entry->capacity;
+    }
+
+  pos = head & mask;
+  len = LV_MIN(cnt, entry->capacity - pos);
+  lv_memcpy(&entry->raw[pos], samples, len * sizeof(int16_t));
+  lv_memcpy(entry->raw, samples + len, (cnt - len) * sizeof(int16_t));
+
+  __atomic_store_n(&entry->head, head + cnt, __ATOMIC_RELEASE);
+}
+
+void
+lvgl_stream_update (lv_obj_t *obj)
+{
+  stream_entry_t *entry = stream_find(obj);
+
+  if (entry != NULL)
+    {
+      stream_take(entry);
+    }
+}
+
+void
+lvgl_stream_get_stats (lv_obj_t            *obj,
+                       lvgl_stream_stats_t *stats)
+{
+  stream_entry_t *entry = stream_find(obj);
+
+  if (entry == NULL)
+    {
+      lv_memzero(stats, sizeof(*stats));
+      return;
+    }
+
+  *stats = entry->stats;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static stream_entry_t *
+stream_find (const lv_obj_t *obj)
+{
+  uint32_t i;
+
+  for (i = 0; i < STREAM_MAX_CNT; i++)
+    {
+      if (entries[i].obj == obj)
+        {
+          return &entries[i];
+        }
+    }
+
+  return NULL;
+}
+
+/* The samples written since the last call are added to the pyramid, then the
+ * columns they fall into are computed and invalidated */
+static void
+stream_take (stream_entry_t *entry)
+{
+  uint32_t head = __atomic_load_n(&entry->head, __ATOMIC_ACQUIRE);
+  uint32_t mask = entry->capacity - 1;
+  uint32_t limit = entry->capacity - STREAM_MARGIN(entry->capacity);
+  uint32_t cnt = head - entry->taken;
+  uint64_t old_total = entry->total;
+  stream_pair_t band;
+  stream_pair_t shown;
+  int64_t old_newest;
+  int64_t newest;
+  int64_t first;
+  int64_t k;
+
+  if (cnt == 0)
+    {
+      return;
+    }
+
+  /* the producer went round the history, the older samples are gone */
+  if (cnt > limit)
+    {
+      entry->stats.overruns += cnt - limit;
+      entry->taken += cnt - limit;
+      entry->skew += cnt - limit;
+      entry->start = entry->total;
+      cnt = limit;
+    }
+
+  for (; cnt > 0; cnt--)
+    {
+      stream_add(entry, entry->raw[entry->taken & mask]);
+      entry->taken++;
+      entry->stats.samples++;
+    }
+
+  if (!entry->follow || entry->width == 0)
+    {
+      return;
+    }
+
+  old_newest = old_total > 0 ? (int64_t)((old_total - 1) / entry->spp) : 0;
+  newest = (int64_t)((entry->total - 1) / entry->spp);
+  first = LV_MAX(old_newest, newest - (int64_t)entry->width + 1);
+  entry->end = newest;
+
+  for (k = first; k <= newest; k++)
+    {
+      entry->cols[k % entry->width] = stream_column(entry, k);
+    }
+
+  if (entry->mode == STREAM_MODE_SCROLL)
+    {
+      /* LVGL can't move what's drawn, so every column is redrawn when a new one
+       * starts. Only the values shown before and after change. */
+      band = stream_band(entry);
+      if (newest != old_newest)
+        {
+          shown.min = LV_MIN(entry->band.min, band.min);
+          shown.max = LV_MAX(entry->band.max, band.max);
+          stream_invalidate(entry, newest - entry->width + 1, entry->width, &shown);
+        }
+      else
+        {
+          stream_invalidate(entry, newest, 1, NULL);
+        }
+      entry->band = band;
+    }
+  else
+    {
+      /* the gap moves on, and the oldest column after it isn't joined to the one
+       * before anymore */
+      stream_invalidate(entry, first, (uint32_t)(newest - first) + 1 + STREAM_SWEEP_GAP + 1, NULL);
+    }
+}
+
+/* A finished pair is added to the pair of the next level, up to a pair which isn't
+ * finished. A pair is only read when it's finished. */
+static void
+stream_add (stream_entry_t *entry,
+            int16_t         v)
+{
+  uint64_t t = entry->total++;
+  uint64_t j = t >> STREAM_SHIFT;
+  stream_pair_t *p;
+  stream_pair_t child;
+  uint32_t l;
+
+  p = &entry->level[1][j & ((entry->capacity >> STREAM_SHIFT) - 1)];
+  if ((t & (STREAM_LEVEL_FACTOR - 1)) == 0)
+    {
+      p->min = v;
+      p->max = v;
+    }
+  else
+    {
+      p->min = LV_MIN(p->min, v);
+      p->max = LV_MAX(p->max, v);
+    }
+
+  for (l = 1; l < entry->levels && (t & (STREAM_LEVEL_FACTOR - 1)) == STREAM_LEVEL_FACTOR - 1; l++)
+    {
+      child = *p;
+      t = j;
+      j >>= STREAM_SHIFT;
+      p = &entry->level[l + 1][j & ((entry->capacity >> (STREAM_SHIFT * (l + 1))) - 1)];
+      if ((t & (STREAM_LEVEL_FACTOR - 1)) == 0)
+        {
+          *p = child;
+        }
+      else
+        {
+          p->min = LV_MIN(p->min, child.min);
+          p->max = LV_MAX(p->max, child.max);
+        }
+    }
+}
+
+/* The min/max of the samples in [a, b), from the largest finished pairs which fit */
+static stream_pair_t
+stream_query (const stream_entry_t *entry,
+              uint64_t              a,
+              uint64_t              b)
+{
+  stream_pair_t res = { INT16_MAX, INT16_MIN };
+  stream_pair_t p;
+  uint32_t shift;
+  uint32_t l;
+
+  while (a < b)
+    {
+      for (l = 0; l < entry->levels; l++)
+        {
+          shift = STREAM_SHIFT * (l + 1);
+          if ((a & ((1ULL << shift) - 1)) != 0 || a + (1ULL << shift) > b)
+            {
+              break;
+            }
+        }
+
+      if (l == 0)
+        {
+          p.min = entry->raw[(uint32_t)(a + entry->skew) & (entry->capacity - 1)];
+          p.max = p.min;
+          a++;
+        }
+      else
+        {
+          shift = STREAM_SHIFT * l;
+          p = entry->level[l][(a >> shift) & ((entry->capacity >> shift) - 1)];
+          a += 1ULL << shift;
+        }
+
+      res.min = LV_MIN(res.min, p.min);
+      res.max = LV_MAX(res.max, p.max);
+    }
+
+  return res;
+}
+
+static stream_pair_t
+stream_column (stream_entry_t *entry,
+               int64_t         k)
+{
+  stream_pair_t empty = { INT16_MAX, INT16_MIN };
+  uint32_t history = entry->capacity - STREAM_MARGIN(entry->capacity);
+  uint64_t floor = entry->start;
+  uint64_t a;
+  uint64_t b;
+
+  if (k < 0)
+    {
+      return empty;
+    }
+
+  if (entry->total > history)
+    {
+      floor = LV_MAX(floor, entry->total - history);
+    }
+
+  a = LV_MAX((uint64_t)k * entry->spp, floor);
+  b = LV_MIN((uint64_t)(k + 1) * entry->spp, entry->total);
+  if (a >= b)
+    {
+      return empty;
+    }
+
+  entry->stats.columns++;
+  return stream_query(entry, a, b);
+}
+
+static void
+stream_rebuild (stream_entry_t *entry)
+{
+  int64_t k;
+
+  entry->width = LV_MIN(lv_obj_get_content_width(entry->obj), STREAM_WIDTH_MAX);
+  if (entry->width == 0)
+    {
+      return;
+    }
+
+  if (entry->follow)
+    {
+      entry->end = entry->total > 0 ? (int64_t)((entry->total - 1) / entry->spp) : -1;
+    }
+
+  /* the columns before the first sample aren't drawn */
+  for (k = LV_MAX(entry->end - (int64_t)entry->width + 1, 0); k <= entry->end; k++)
+    {
+      entry->cols[k % entry->width] = stream_column(entry, k);
+    }
+  entry->band = stream_band(entry);
+
+  entry->stats.rebuilds++;
+  lv_obj_invalidate(entry->obj);
+}
+
+/* The min/max of the columns shown, an empty pair when none are */
+static stream_pair_t
+stream_band (const stream_entry_t *entry)
+{
+  stream_pair_t band = { INT16_MAX, INT16_MIN };
+  stream_pair_t c;
+  int64_t k;
+
+  for (k = LV_MAX(entry->end - (int64_t)entry->width + 1, 0); k <= entry->end; k++)
+    {
+      c = entry->cols[k % entry->width];
+      band.min = LV_MIN(band.min, c.min);
+      band.max = LV_MAX(band.max, c.max);
+    }
+
+  return band;
+}
+
+/* Invalidate `cnt` columns from column `first`, from the min to the max of `band`
+ * or the whole height */
+static void
+stream_invalidate (stream_entry_t      *entry,
+                   int64_t              first,
+                   uint32_t             cnt,
+                   const stream_pair_t *band)
+{
+  lv_area_t coords;
+  lv_area_t area;
+  uint32_t x;
+  uint32_t len;
+
+  if (band != NULL && band->min > band->max)
+    {
+      return;
+    }
+
+  lv_obj_get_content_coords(entry->obj, &coords);
+  area.y1 = band != NULL ? stream_map_y(entry, band->max, &coords) : coords.y1;
+  area.y2 = band != NULL ? stream_map_y(entry, band->min, &coords) : coords.y2;
+
+  if (cnt >= entry->width)
+    {
+      cnt = entry->width;
+      x = 0;
+    }
+  else if (entry->mode == STREAM_MODE_SCROLL)
+    {
+      x = entry->width - 1 - (uint32_t)(entry->end - first);
+    }
+  else
+    {
+      x = (uint32_t)(first % entry->width);
+    }
+
+  /* wrapped round in sweep mode, in two parts */
+  while (cnt > 0)
+    {
+      len = LV_MIN(cnt, entry->width - x);
+      area.x1 = coords.x1 + x;
+      area.x2 = area.x1 + len - 1;
+      lv_obj_invalidate_area(entry->obj, &area);
+      entry->stats.invalidated_px += len * lv_area_get_height(&area);
+      cnt -= len;
+      x = 0;
+    }
+}
+
+static int32_t
+stream_map_y (const stream_entry_t *entry,
+              int32_t               v,
+              const lv_area_t      *coords)
+{
+  int32_t h = lv_area_get_height(coords);
+
+  v = LV_CLAMP(entry->min, v, entry->max);
+
+  return coords->y2 - (int32_t)((int64_t)(v - entry->min) * (h - 1) / (entry->max - entry->min));
+}
+
+static void
+stream_timer_cb (lv_timer_t *t)
+{
+  uint32_t i;
+
+  LV_UNUSED(t);
+
+  for (i = 0; i < STREAM_MAX_CNT; i++)
+    {
+      if (entries[i].obj != NULL)
+        {
+          stream_take(&entries[i]);
+        }
+    }
+}
+
+/* Only the columns in the area invalidated for the refresh are drawn, as 1 px wide
+ * fills from the min to the max of each column. LVGL clips them to the part it's
+ * drawing. Neighbours with the same span are filled together. */
+static void
+stream_draw_cb (lv_event_t *e)
+{
+  stream_entry_t *entry = lv_event_get_user_data(e);
+  lv_layer_t *layer = lv_event_get_layer(e);
+  lv_draw_fill_dsc_t dsc;
+  lv_area_t coords;
+  lv_area_t run = { 0 };
+  lv_area_t col;
+  bool has_run = false;
+  stream_pair_t c;
+  stream_pair_t prev;
+  int64_t oldest;
+  int64_t k;
+  int32_t x1;
+  int32_t x2;
+  int32_t x;
+
+  if (entry->width == 0 || entry->end < 0)
+    {
+      return;
+    }
+
+  lv_obj_get_content_coords(entry->obj, &coords);
+  x1 = 0;
+  x2 = (int32_t)entry->width - 1;
+
+  /* a snapshot or a transformed parent draws it outside of the invalidated area */
+  if (refreshing && dirty.cnt < STREAM_DIRTY_MAX && lv_obj_get_display(entry->obj) == display &&
+      !stream_is_transformed(entry->obj))
+    {
+      x1 = LV_MAX(dirty.area.x1 - coords.x1, x1);
+      x2 = LV_MIN(dirty.area.x2 - coords.x1, x2);
+    }
+
+  lv_draw_fill_dsc_init(&dsc);
+  dsc.color = lv_obj_get_style_line_color(entry->obj, LV_PART_MAIN);
+  dsc.opa = lv_obj_get_style_line_opa(entry->obj, LV_PART_MAIN);
+  dsc.base.layer = layer;
+
+  /* the oldest column shown, in sweep mode the gap is before it */
+  oldest = entry->end - entry->width + 1 + (entry->mode == STREAM_MODE_SWEEP ? STREAM_SWEEP_GAP : 0);
+  oldest = LV_MAX(oldest, 0);
+
+  for (x = x1; x <= x2; x++)
+    {
+      if (entry->mode == STREAM_MODE_SCROLL)
+        {
+          k = entry->end - (entry->width - 1 - x);
+        }
+      else
+        {
+          k = entry->end - (entry->end % entry->width + entry->width - x) % entry->width;
+        }
+      if (k < oldest)
+        {
+          continue;
+        }
+
+      c = entry->cols[k % entry->width];
+      if (c.min > c.max)
+        {
+          continue;
+        }
+
+      /* joined to the column before, so a steep edge has no holes */
+      if (k > oldest)
+        {
+          prev = entry->cols[(k - 1) % entry->width];
+          if (prev.min <= prev.max)
+            {
+              c.min = LV_MIN(c.min, prev.max);
+              c.max = LV_MAX(c.max, prev.min);
+            }
+        }
+
+      col.x1 = coords.x1 + x;
+      col.x2 = col.x1;
+      col.y1 = stream_map_y(entry, c.max, &coords);
+      col.y2 = stream_map_y(entry, c.min, &coords);
+
+      if (has_run && run.x2 == col.x1 - 1 && run.y1 == col.y1 && run.y2 == col.y2)
+        {
+          run.x2 = col.x2;
+          continue;
+        }
+      if (has_run)
+        {
+          lv_draw_fill(layer, &dsc, &run);
+          entry->stats.drawn += lv_area_get_width(&run);
+        }
+      run = col;
+      has_run = true;
+    }
+
+  if (has_run)
+    {
+      lv_draw_fill(layer, &dsc, &run);
+      entry->stats.drawn += lv_area_get_width(&run);
+    }
+}
+
+/* A transformed chart is drawn in a layer of its own coordinates, which the
+ * invalidated area isn't in */
+static bool
+stream_is_transformed (const lv_obj_t *obj)
+{
+  for (; obj != NULL; obj = lv_obj_get_parent(obj))
+    {
+      if (lv_obj_get_style_transform_rotation(obj, LV_PART_MAIN) != 0 ||
+          lv_obj_get_style_transform_scale_x(obj, LV_PART_MAIN) != LV_SCALE_NONE ||
+          lv_obj_get_style_transform_scale_y(obj, LV_PART_MAIN) != LV_SCALE_NONE ||
+          lv_obj_get_style_transform_skew_x(obj, LV_PART_MAIN) != 0 ||
+          lv_obj_get_style_transform_skew_y(obj, LV_PART_MAIN) != 0)
+        {
+          return true;
+        }
+    }
+
+  return false;
+}
+
+static void
+stream_size_cb (lv_event_t *e)
+{
+  stream_entry_t *entry = lv_event_get_user_data(e);
+
+  stream_rebuild(entry);
+}
+
+static void
+stream_delete_cb (lv_event_t *e)
+{
+  stream_entry_t *entry = lv_event_get_user_data(e);
+
+  entry->obj = NULL;
+}
+
+/* The areas LVGL redraws are the ones invalidated or joined from them, so they're
+ * inside the union of them. An area invalidated while the layout is updated at the
+ * start of a refresh is drawn by it, the others by the next one. */
+static void
+stream_invalidate_area_cb (lv_event_t *e)
+{
+  const lv_area_t *area = lv_event_get_param(e);
+
+  if (area != NULL)
+    {
+      stream_dirty_add(&dirty, area);
+      stream_dirty_add(&pending, area);
+    }
+}
+
+static void
+stream_dirty_add (stream_dirty_t  *d,
+                  const lv_area_t *area)
+{
+  if (d->cnt == 0)
+    {
+      d->area = *area;
+    }
+  else
+    {
+      d->area.x1 = LV_MIN(d->area.x1, area->x1);
+      d->area.y1 = LV_MIN(d->area.y1, area->y1);
+      d->area.x2 = LV_MAX(d->area.x2, area->x2);
+      d->area.y2 = LV_MAX(d->area.y2, area->y2);
+    }
+  d->cnt = LV_MIN(d->cnt + 1, STREAM_DIRTY_MAX);
+}
+
+static void
+stream_refr_cb (lv_event_t *e)
+{
+  refreshing = lv_event_get_code(e) == LV_EVENT_REFR_START;
+  if (refreshing)
+    {
+      dirty = pending;
+      pending.cnt = 0;
+    }
+}
@@ -0,0 +1,177 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_subject.h"
+#include "main.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define SUBJECT_WORDS  ((SUBJECT_MAX + 31) / 32)
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void
+subject_refr_start_cb (lv_event_t *e);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static lv_subject_t *subjects[SUBJECT_MAX];
+static uint32_t subject_cnt;
+
+/* Written by the producers: the value first, then its bit in `pending`. A refresh
+ * takes the bits of a word at once, so a value published meanwhile is applied by
+ * the next refresh. */
+static int32_t values[SUBJECT_MAX];
+static uint32_t pending[SUBJECT_WORDS];
+
+/* DWT cycles of the oldest value not applied yet, 0 for none */
+static uint32_t stamps[SUBJECT_MAX];
+
+static lvgl_subject_stats_t stats;
+static uint64_t latency_sum_us;
+static uint32_t latency_cnt;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_subject_init (lv_display_t *disp)
+{
+  DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  lv_display_add_event_cb(disp, subject_refr_start_cb, LV_EVENT_REFR_START, NULL);
+}
+
+int32_t
+lvgl_subject_bind (lv_subject_t *subject)
+{
+  uint32_t idx = subject_cnt;
+
+  if (idx == SUBJECT_MAX || subject->type != LV_SUBJECT_TYPE_INT)
+    {
+      return -1;
+    }
+
+  values[idx] = lv_subject_get_int(subject);
+  subjects[idx] = subject;
+
+  /* a producer which sees the new count sees the entry */
+  __atomic_store_n(&subject_cnt, idx + 1, __ATOMIC_RELEASE);
+
+  return (int32_t)idx;
+}
+
+void
+lvgl_subject_publish (int32_t idx,
+                      int32_t value)
+{
+  uint32_t stamp = 0;
+  uint32_t bit;
+  uint32_t old;
+
+  /* bound in the LVGL task, published from any other */
+  if (idx < 0 || (uint32_t)idx >= __atomic_load_n(&subject_cnt, __ATOMIC_ACQUIRE))
+    {
+      return;
+    }
+  bit = 1UL << (idx % 32);
+
+  /* only if the previous value was applied, the latency is counted from the first
+   * value a refresh replaces */
+  __atomic_compare_exchange_n(&stamps[idx], &stamp, DWT->CYCCNT | 1, false,
+                              __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+
+  __atomic_store_n(&values[idx], value, __ATOMIC_RELAXED);
+  old = __atomic_fetch_or(&pending[idx / 32], bit, __ATOMIC_RELEASE);
+
+  __atomic_fetch_add(&stats.published, 1, __ATOMIC_RELAXED);
+  if (old & bit)
+    {
+      __atomic_fetch_add(&stats.dropped, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void
+lvgl_subject_get_stats (lvgl_subject_stats_t *stats_out)
+{
+  *stats_out = stats;
+  stats_out->latency_us = latency_cnt ? (uint32_t)(latency_sum_us / latency_cnt) : 0;
+}
+
+void
+lvgl_subject_reset_stats (void)
+{
+  lv_memzero(&stats, sizeof(stats));
+  latency_sum_us = 0;
+  latency_cnt = 0;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/* Once per refresh, before the widgets are laid out and rendered, so the observers
+ * invalidate them for this refresh */
+static void
+subject_refr_start_cb (lv_event_t *e)
+{
+  uint32_t ticks_per_us = SystemCoreClock / 1000000;
+  bool any = false;
+  uint32_t bits;
+  uint32_t stamp;
+  uint32_t us;
+  uint32_t w;
+  uint32_t s;
+  int32_t value;
+
+  LV_UNUSED(e);
+
+  for (w = 0; w < SUBJECT_WORDS; w++)
+    {
+      if (__atomic_load_n(&pending[w], __ATOMIC_RELAXED) == 0)
+        {
+          continue;
+        }
+
+      bits = __atomic_exchange_n(&pending[w], 0, __ATOMIC_ACQUIRE);
+      for (; bits != 0; bits &= bits - 1)
+        {
+          s = w * 32 + __builtin_ctz(bits);
+          value = __atomic_load_n(&values[s], __ATOMIC_RELAXED);
+          stamp = __atomic_exchange_n(&stamps[s], 0, __ATOMIC_RELAXED);
+
+          /* 0 if a value published after the exchange above took the stamp, which
+           * was counted by this refresh then */
+          if (stamp != 0)
+            {
+              us = (DWT->CYCCNT - stamp) / ticks_per_us;
+              latency_sum_us += us;
+              latency_cnt++;
+              stats.latency_max_us = LV_MAX(stats.latency_max_us, us);
+            }
+
+          stats.applied++;
+          any = true;
+          if (lv_subject_get_int(subjects[s]) == value)
+            {
+              stats.unchanged++;
+              continue;
+            }
+          lv_subject_set_int(subjects[s], value);
+        }
+    }
+
+  if (any)
+    {
+      stats.refreshes++;
+    }
+}
@@ -0,0 +1,451 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_tile_filter.h"
+#include "lvgl_port_dma2d.h"
+#include "lvgl/src/display/lv_display_private.h"
+#include "main.h"
+#include "ltdc.h"
+#include "dma2d.h"
+#include "crc.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define FILTER_CYCLES_TO_US(c)  ((uint32_t)((uint64_t)(c) * 1000000 / SystemCoreClock))
+
+/* the part of its tile an area covers */
+#define FILTER_RECT(x, y, w, h) \
+  ((uint32_t)(x) | (uint32_t)(y) << 8 | (uint32_t)(w) << 16 | (uint32_t)(h) << 24)
+
+#define FILTER_RECT_NONE        0xFFFFFFFF
+
+#if TILE_FILTER_TILE_SIZE > 255
+  #error "the tile rect is packed into bytes"
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint32_t crc;
+  uint32_t rect;                /* FILTER_RECT_NONE until flushed */
+} filter_sig_t;
+
+typedef struct
+{
+  lvgl_tile_filter_cb_t cb;
+  void                 *user_data;
+} filter_cb_dsc_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void
+filter_flush_cb (lv_display_t *disp, const lv_area_t *area, uint8_t *px_map);
+
+static bool
+filter_tile_changed (const uint8_t *px, uint32_t stride, uint32_t bpp, const lv_area_t *part);
+
+static void
+filter_copy_begin (uint32_t bpp);
+
+static void
+filter_copy (const uint8_t *src, uint32_t stride, uint32_t bpp, const lv_area_t *run);
+
+static void
+filter_notify (const lv_area_t *run, const uint8_t *px, uint32_t stride);
+
+static bool
+filter_has_cb (void);
+
+static uint32_t
+filter_layer_bpp (uint32_t layer_idx);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static lv_display_t *display;
+static lv_display_flush_cb_t orig_flush_cb;
+static uint32_t layer;
+
+static filter_sig_t *sigs;
+static uint32_t cols;
+static uint32_t rows;
+
+static filter_cb_dsc_t cbs[TILE_FILTER_CB_MAX];
+
+static lvgl_tile_filter_stats_t stats;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_result_t
+lvgl_tile_filter_attach (lv_display_t *disp,
+                         uint32_t      layer_idx)
+{
+  int32_t hor_res = lv_display_get_horizontal_resolution(disp);
+  int32_t ver_res = lv_display_get_vertical_resolution(disp);
+
+  if (display != NULL || disp->flush_cb == NULL)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  cols = (hor_res + TILE_FILTER_TILE_SIZE - 1) / TILE_FILTER_TILE_SIZE;
+  rows = (ver_res + TILE_FILTER_TILE_SIZE - 1) / TILE_FILTER_TILE_SIZE;
+  sigs = lv_malloc(cols * rows * sizeof(filter_sig_t));
+  if (sigs == NULL)
+    {
+      return LV_RESULT_INVALID;
+    }
+  lvgl_tile_filter_invalidate();
+
+  DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  display = disp;
+  layer = layer_idx;
+  orig_flush_cb = disp->flush_cb;
+  lv_display_set_flush_cb(disp, filter_flush_cb);
+
+  return LV_RESULT_OK;
+}
+
+lv_result_t
+lvgl_tile_filter_add_cb (lvgl_tile_filter_cb_t cb,
+                         void                 *user_data)
+{
+  uint32_t i;
+
+  for (i = 0; i < TILE_FILTER_CB_MAX; i++)
+    {
+      if (cbs[i].cb == NULL)
+        {
+          cbs[i].user_data = user_data;
+          cbs[i].cb = cb;
+          return LV_RESULT_OK;
+        }
+    }
+
+  return LV_RESULT_INVALID;
+}
+
+void
+lvgl_tile_filter_remove_cb (lvgl_tile_filter_cb_t cb,
+                            void                 *user_data)
+{
+  uint32_t i;
+
+  for (i = 0; i < TILE_FILTER_CB_MAX; i++)
+    {
+      if (cbs[i].cb == cb && cbs[i].user_data == user_data)
+        {
+          cbs[i].cb = NULL;
+        }
+    }
+}
+
+void
+lvgl_tile_filter_invalidate (void)
+{
+  uint32_t i;
+
+  for (i = 0; sigs != NULL && i < cols * rows; i++)
+    {
+      sigs[i].rect = FILTER_RECT_NONE;
+    }
+}
+
+void
+lvgl_tile_filter_get_stats (lvgl_tile_filter_stats_t *stats_out)
+{
+  *stats_out = stats;
+}
+
+void
+lvgl_tile_filter_reset_stats (void)
+{
+  lv_memzero(&stats, sizeof(stats));
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void
+filter_flush_cb (lv_display_t    *disp,
+                 const lv_area_t *area,
+                 uint8_t         *px_map)
+{
+  lv_color_format_t cf = lv_display_get_color_format(disp);
+  uint32_t bpp = lv_color_format_get_size(cf);
+  bool partial = lv_display_get_render_mode(disp) == LV_DISPLAY_RENDER_MODE_PARTIAL;
+  bool copy;
+  const uint8_t *px;
+  uint32_t stride;
+  uint32_t area_bytes = lv_area_get_size(area) * bpp;
+  uint32_t changed_bytes = 0;
+  uint32_t crc_cycles = 0;
+  int32_t band_y1 = LV_COORD_MAX;
+  int32_t band_y2 = LV_COORD_MIN;
+  int32_t tx;
+  int32_t ty;
+  lv_area_t part;
+  lv_area_t run;
+  bool in_run;
+
+  /* nothing to skip in the direct mode without a callback */
+  if (!partial && !filter_has_cb())
+    {
+      orig_flush_cb(disp, area, px_map);
+      return;
+    }
+
+  /* the partial mode renders the area alone, the direct mode to the whole screen */
+  if (partial)
+    {
+      stride = lv_draw_buf_width_to_stride(lv_area_get_width(area), cf);
+      px = px_map;
+    }
+  else
+    {
+      stride = lv_draw_buf_width_to_stride(lv_display_get_horizontal_resolution(disp), cf);
+      px = px_map + area->y1 * stride + area->x1 * bpp;
+    }
+
+  /* the LTDC layer is written here if it's the framebuffer of the display as it is */
+  copy = partial && lv_display_get_rotation(disp) == LV_DISPLAY_ROTATION_0 &&
+         lv_display_get_horizontal_resolution(disp) == (int32_t)hltdc.LayerCfg[layer].ImageWidth &&
+         lv_display_get_vertical_resolution(disp) == (int32_t)hltdc.LayerCfg[layer].ImageHeight &&
+         filter_layer_bpp(layer) == bpp;
+  if (copy)
+    {
+      filter_copy_begin(bpp);
+    }
+
+  stats.flushes++;
+
+  for (ty = area->y1 / TILE_FILTER_TILE_SIZE; ty <= area->y2 / TILE_FILTER_TILE_SIZE; ty++)
+    {
+      part.y1 = LV_MAX(area->y1, ty * TILE_FILTER_TILE_SIZE);
+      part.y2 = LV_MIN(area->y2, (ty + 1) * TILE_FILTER_TILE_SIZE - 1);
+      run.y1 = part.y1;
+      run.y2 = part.y2;
+      in_run = false;
+
+      /* adjacent changed tiles are copied and passed on as one run */
+      for (tx = area->x1 / TILE_FILTER_TILE_SIZE; tx <= area->x2 / TILE_FILTER_TILE_SIZE + 1; tx++)
+        {
+          part.x1 = LV_MAX(area->x1, tx * TILE_FILTER_TILE_SIZE);
+          part.x2 = LV_MIN(area->x2, (tx + 1) * TILE_FILTER_TILE_SIZE - 1);
+
+          if (part.x1 <= part.x2)
+            {
+              uint32_t c = DWT->CYCCNT;
+              bool changed = filter_tile_changed(px + (part.y1 - area->y1) * stride +
+                                                 (part.x1 - area->x1) * bpp, stride, bpp, &part);
+
+              crc_cycles += DWT->CYCCNT - c;
+              stats.tiles++;
+
+              if (changed)
+                {
+                  if (!in_run)
+                    {
+                      run.x1 = part.x1;
+                      in_run = true;
+                    }
+                  run.x2 = part.x2;
+                  continue;
+                }
+
+              stats.tiles_skipped++;
+            }
+
+          if (in_run)
+            {
+              const uint8_t *run_px = px + (run.y1 - area->y1) * stride + (run.x1 - area->x1) * bpp;
+
+              if (copy)
+                {
+                  filter_copy(run_px, stride, bpp, &run);
+                }
+              filter_notify(&run, run_px, stride);
+
+              changed_bytes += lv_area_get_size(&run) * bpp;
+              band_y1 = LV_MIN(band_y1, run.y1);
+              band_y2 = LV_MAX(band_y2, run.y2);
+              in_run = false;
+            }
+        }
+    }
+
+  stats.crc_us += FILTER_CYCLES_TO_US(crc_cycles);
+
+  if (copy)
+    {
+      lvgl_dma2d_unlock();
+      lv_display_flush_ready(disp);
+    }
+  else if (!partial)
+    {
+      /* the direct mode shows the rendered buffer, only the callbacks were filtered,
+       * so nothing was saved on the display */
+      changed_bytes = area_bytes;
+      orig_flush_cb(disp, area, px_map);
+    }
+  else if (band_y1 > band_y2)
+    {
+      lv_display_flush_ready(disp);
+    }
+  else
+    {
+      /* the lines with changed tiles, they have the stride of the whole area */
+      run = *area;
+      run.y1 = band_y1;
+      run.y2 = band_y2;
+      changed_bytes = lv_area_get_size(&run) * bpp;
+      orig_flush_cb(disp, &run, px_map + (band_y1 - area->y1) * stride);
+    }
+
+  stats.bytes_flushed += changed_bytes;
+  stats.bytes_saved += area_bytes - changed_bytes;
+}
+
+static bool
+filter_tile_changed (const uint8_t   *px,
+                     uint32_t         stride,
+                     uint32_t         bpp,
+                     const lv_area_t *part)
+{
+  filter_sig_t *sig = &sigs[(part->y1 / TILE_FILTER_TILE_SIZE) * cols + part->x1 / TILE_FILTER_TILE_SIZE];
+  int32_t w = lv_area_get_width(part);
+  int32_t h = lv_area_get_height(part);
+  uint32_t rect = FILTER_RECT(part->x1 % TILE_FILTER_TILE_SIZE, part->y1 % TILE_FILTER_TILE_SIZE, w - 1, h - 1);
+  uint32_t line = w * bpp;
+  const uint8_t *p;
+  uint32_t n;
+  uint32_t crc;
+  int32_t y;
+
+  /* the CRC unit takes a word per AHB cycle, the lines aren't word aligned in general */
+  CRC->CR |= CRC_CR_RESET;
+  for (y = 0; y < h; y++)
+    {
+      p = px + y * stride;
+      for (n = line; n >= 4; n -= 4)
+        {
+          CRC->DR = __UNALIGNED_UINT32_READ(p);
+          p += 4;
+        }
+      for (; n > 0; n--)
+        {
+          *(__IO uint8_t *)&CRC->DR = *p++;
+        }
+    }
+  crc = CRC->DR;
+
+  /* the same part of the tile with the same pixels is in the framebuffer already */
+  if (sig->rect == rect && sig->crc == crc)
+    {
+      return false;
+    }
+
+  sig->rect = rect;
+  sig->crc = crc;
+
+  return true;
+}
+
+static void
+filter_copy_begin (uint32_t bpp)
+{
+  lvgl_dma2d_lock();
+
+  /* the offsets are set in bytes for each run, the colors aren't converted */
+  hdma2d.Init.Mode = DMA2D_M2M;
+  hdma2d.Init.ColorMode = bpp == 4 ? DMA2D_OUTPUT_ARGB8888 :
+                          bpp == 3 ? DMA2D_OUTPUT_RGB888 : DMA2D_OUTPUT_RGB565;
+  hdma2d.Init.OutputOffset = 0;
+  hdma2d.Init.LineOffsetMode = DMA2D_LOM_BYTES;
+  hdma2d.LayerCfg[1].InputOffset = 0;
+  hdma2d.LayerCfg[1].InputColorMode = bpp == 4 ? DMA2D_INPUT_ARGB8888 :
+                                      bpp == 3 ? DMA2D_INPUT_RGB888 : DMA2D_INPUT_RGB565;
+  HAL_DMA2D_Init(&hdma2d);
+  HAL_DMA2D_ConfigLayer(&hdma2d, 1);
+}
+
+static void
+filter_copy (const uint8_t   *src,
+             uint32_t         stride,
+             uint32_t         bpp,
+             const lv_area_t *run)
+{
+  LTDC_LayerCfgTypeDef *cfg = &hltdc.LayerCfg[layer];
+  uint32_t w = lv_area_get_width(run);
+  uint32_t dst = cfg->FBStartAdress + (run->y1 * cfg->ImageWidth + run->x1) * bpp;
+
+  WRITE_REG(DMA2D->FGOR, stride - w * bpp);
+  WRITE_REG(DMA2D->OOR, (cfg->ImageWidth - w) * bpp);
+
+  if (HAL_DMA2D_Start(&hdma2d, (uint32_t)src, dst, w, lv_area_get_height(run)) == HAL_OK)
+    {
+      HAL_DMA2D_PollForTransfer(&hdma2d, 100);
+    }
+}
+
+static void
+filter_notify (const lv_area_t *run,
+               const uint8_t   *px,
+               uint32_t         stride)
+{
+  uint32_t i;
+
+  for (i = 0; i < TILE_FILTER_CB_MAX; i++)
+    {
+      if (cbs[i].cb != NULL)
+        {
+          cbs[i].cb(run, px, stride, cbs[i].user_data);
+        }
+    }
+}
+
+static bool
+filter_has_cb (void)
+{
+  uint32_t i;
+
+  for (i = 0; i < TILE_FILTER_CB_MAX; i++)
+    {
+      if (cbs[i].cb != NULL)
+        {
+          return true;
+        }
+    }
+
+  return false;
+}
+
+static uint32_t
+filter_layer_bpp (uint32_t layer_idx)
+{
+  switch (hltdc.LayerCfg[layer_idx].PixelFormat)
+    {
+      case LTDC_PIXEL_FORMAT_ARGB8888:
+        return 4;
+      case LTDC_PIXEL_FORMAT_RGB888:
+        return 3;
+      case LTDC_PIXEL_FORMAT_RGB565:
+        return 2;
+      default:
+        return 0;
+    }
+}
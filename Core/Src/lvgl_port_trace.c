@@ -0,0 +1,46 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_trace.h"
+#include "main.h"
+#include "cmsis_os2.h"
+#include <stdarg.h>
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_trace (const char *format,
+            ...)
+{
+  char line[TRACE_LINE_MAX];
+  va_list args;
+  int32_t lock;
+  uint32_t i;
+
+  if ((ITM->TCR & ITM_TCR_ITMENA_Msk) == 0 || (ITM->TER & (1UL << TRACE_ITM_PORT)) == 0)
+    {
+      return;
+    }
+
+  va_start(args, format);
+  lv_vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+
+  /* a whole line at a time, the lines of several tasks would be mixed otherwise */
+  lock = osKernelLock();
+  for (i = 0; line[i] != '\0'; i++)
+    {
+      while (ITM->PORT[TRACE_ITM_PORT].u32 == 0)
+        {
+        }
+      ITM->PORT[TRACE_ITM_PORT].u8 = (uint8_t)line[i];
+    }
+  while (ITM->PORT[TRACE_ITM_PORT].u32 == 0)
+    {
+    }
+  ITM->PORT[TRACE_ITM_PORT].u8 = '\n';
+  osKernelRestoreLock(lock);
+}
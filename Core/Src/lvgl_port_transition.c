@@ -0,0 +1,268 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_transition.h"
+#include "lvgl/src/display/lv_display_private.h"
+#include "lvgl_port_plane.h"
+#include "lvgl_port_display.h"
+#include "lvgl_port_dma2d.h"
+#include "lvgl_port_tile_filter.h"
+#include "main.h"
+#include "ltdc.h"
+#include "dma2d.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#if LV_USE_SNAPSHOT == 0
+  #error "lvgl_port_transition requires LV_USE_SNAPSHOT"
+#endif
+
+/* the transition is drawn on the plane above LVGL in the LVGL back buffer,
+ * this needs the overlay plane and the two native framebuffers of direct mode */
+#define TRANSITION_ON_LTDC  (PLANE_MODE == PLANE_MODE_OVERLAY && LV_COLOR_DEPTH == 16 && \
+                             MY_DISP_ROTATION == 0)
+
+/* fixed point resolution of the animation progress */
+#define TRANSITION_RES      1024
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef enum
+{
+  TRANSITION_IDLE,
+  TRANSITION_RUNNING,    /* the vblank callback moves the plane */
+  TRANSITION_FINISHING,  /* the end position is about to be latched */
+  TRANSITION_HIDING,     /* the new screen is in the LVGL layer too, the plane is removed */
+} transition_state_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+#if TRANSITION_ON_LTDC
+static void
+transition_vblank_cb (void);
+
+static void
+transition_poll_cb (lv_timer_t *timer);
+
+static void
+transition_copy_to_front (void);
+#endif
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+#if TRANSITION_ON_LTDC
+static volatile transition_state_t state;
+
+static lv_obj_t *new_scr;
+static bool del_prev;
+static lv_display_t *disp;
+static lv_draw_buf_t *back_buf;
+
+/* read by the vblank callback, only written while it's not installed */
+static int32_t start_x;
+static int32_t start_y;
+static uint8_t start_alpha;
+static uint32_t start_tick;
+static uint32_t anim_time;
+static uint32_t anim_delay;
+#endif
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_result_t
+lvgl_transition_load (lv_obj_t             *scr,
+                      lv_screen_load_anim_t anim_type,
+                      uint32_t              time,
+                      uint32_t              delay,
+                      bool                  auto_del)
+{
+#if TRANSITION_ON_LTDC
+  lvgl_plane_cfg_t cfg = {0};
+  int32_t hor_res;
+  int32_t ver_res;
+
+  if (state != TRANSITION_IDLE)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  disp = lv_obj_get_display(scr);
+  hor_res = lv_display_get_horizontal_resolution(disp);
+  ver_res = lv_display_get_vertical_resolution(disp);
+
+  start_x = 0;
+  start_y = 0;
+  start_alpha = LV_OPA_COVER;
+
+  switch (anim_type)
+    {
+      case LV_SCREEN_LOAD_ANIM_OVER_LEFT:
+        start_x = hor_res;
+        break;
+      case LV_SCREEN_LOAD_ANIM_OVER_RIGHT:
+        start_x = -hor_res;
+        break;
+      case LV_SCREEN_LOAD_ANIM_OVER_TOP:
+        start_y = ver_res;
+        break;
+      case LV_SCREEN_LOAD_ANIM_OVER_BOTTOM:
+        start_y = -ver_res;
+        break;
+      case LV_SCREEN_LOAD_ANIM_FADE_IN:
+        start_alpha = LV_OPA_TRANSP;
+        break;
+      default:
+        /* the old screen moves or fades too, that needs LVGL to render it */
+        lv_screen_load_anim(scr, anim_type, time, delay, auto_del);
+        return LV_RESULT_OK;
+    }
+
+  /* the last flush of a refresh makes the other buffer active at once, but the LTDC
+   * scans it out until the new address is reloaded at the next vblank. After that
+   * the active buffer is the one not scanned out, the new screen is rendered into
+   * it once and the LVGL refresh is held until the end, when the whole screen is
+   * invalidated anyway. */
+  lv_timer_pause(lv_display_get_refr_timer(disp));
+  while (disp->flushing)
+    {
+      if (disp->flush_wait_cb != NULL)
+        {
+          disp->flush_wait_cb(disp);
+        }
+    }
+  back_buf = lv_display_get_buf_active(disp);
+
+  lv_obj_update_layout(scr);
+  if (back_buf == NULL ||
+      lv_snapshot_take_to_draw_buf(scr, LV_COLOR_FORMAT_RGB565, back_buf) != LV_RESULT_OK)
+    {
+      lv_timer_resume(lv_display_get_refr_timer(disp));
+      lv_screen_load_anim(scr, anim_type, time, delay, auto_del);
+      return LV_RESULT_OK;
+    }
+
+  new_scr = scr;
+  del_prev = auto_del;
+  anim_time = time;
+  anim_delay = delay;
+  start_tick = HAL_GetTick();
+  state = TRANSITION_RUNNING;
+
+  cfg.buf = back_buf->data;
+  cfg.pixel_format = LTDC_PIXEL_FORMAT_RGB565;
+  cfg.w = hor_res;
+  cfg.h = ver_res;
+  cfg.x = start_x;
+  cfg.y = start_y;
+  cfg.alpha = start_alpha;
+  lvgl_plane_show(&cfg);
+  lvgl_plane_set_vblank_cb(transition_vblank_cb);
+
+  lv_timer_create(transition_poll_cb, TRANSITION_POLL_PERIOD, NULL);
+
+  return LV_RESULT_OK;
+#else
+  lv_screen_load_anim(scr, anim_type, time, delay, auto_del);
+
+  return LV_RESULT_OK;
+#endif
+}
+
+bool
+lvgl_transition_is_running (void)
+{
+#if TRANSITION_ON_LTDC
+  return state != TRANSITION_IDLE;
+#else
+  return false;
+#endif
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+#if TRANSITION_ON_LTDC
+static void
+transition_vblank_cb (void)
+{
+  uint32_t elapsed = HAL_GetTick() - start_tick;
+  int32_t p;
+
+  if (elapsed < anim_delay)
+    {
+      return;
+    }
+  elapsed -= anim_delay;
+
+  p = elapsed >= anim_time ? TRANSITION_RES : (int32_t)(elapsed * TRANSITION_RES / anim_time);
+
+  /* ease out, most of the movement happens in the first frames */
+  p = p * (2 * TRANSITION_RES - p) / TRANSITION_RES;
+
+  lvgl_plane_set_pos(start_x - start_x * p / TRANSITION_RES,
+                     start_y - start_y * p / TRANSITION_RES);
+  lvgl_plane_set_alpha(start_alpha + (LV_OPA_COVER - start_alpha) * p / TRANSITION_RES);
+
+  if (elapsed >= anim_time)
+    {
+      lvgl_plane_set_vblank_cb(NULL);
+      state = TRANSITION_FINISHING;
+    }
+}
+
+static void
+transition_poll_cb (lv_timer_t *timer)
+{
+  if (state == TRANSITION_FINISHING && !lvgl_plane_is_pending())
+    {
+      /* the opaque plane covers the whole screen, so the LVGL layer can be
+       * brought up to date under it without being seen */
+      transition_copy_to_front();
+      lvgl_plane_hide();
+      state = TRANSITION_HIDING;
+    }
+  else if (state == TRANSITION_HIDING && !lvgl_plane_is_pending())
+    {
+      lv_screen_load_anim(new_scr, LV_SCREEN_LOAD_ANIM_NONE, 0, 0, del_prev);
+      lv_timer_resume(lv_display_get_refr_timer(disp));
+      lv_timer_delete(timer);
+      new_scr = NULL;
+      state = TRANSITION_IDLE;
+    }
+}
+
+static void
+transition_copy_to_front (void)
+{
+  uint32_t front = LTDC_LAYER(&hltdc, lvgl_plane_get_lvgl_layer())->CFBAR;
+
+  lvgl_dma2d_lock();
+
+  /* LVGL's flush or a JPEG decoding may have left the DMA2D in another mode,
+   * restore the RGB565 memory to memory copy */
+  MX_DMA2D_Init();
+
+  if (HAL_DMA2D_Start(&hdma2d, (uint32_t)back_buf->data, front,
+                      back_buf->header.w, back_buf->header.h) == HAL_OK)
+    {
+      HAL_DMA2D_PollForTransfer(&hdma2d, 100);
+    }
+
+  lvgl_dma2d_unlock();
+
+  /* the framebuffer holds other pixels than the tiles flushed last */
+  lvgl_tile_filter_invalidate();
+}
+#endif
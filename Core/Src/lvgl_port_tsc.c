@@ -0,0 +1,137 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_tsc.h"
+#include "lvgl/src/draw/lv_image_decoder_private.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#if LV_USE_NEMA_GFX == 0
+  #error "lvgl_port_tsc requires LV_USE_NEMA_GFX"
+#endif
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static lv_result_t
+tsc_info_cb (lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc, lv_image_header_t *header);
+
+static lv_result_t
+tsc_open_cb (lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc);
+
+static void
+tsc_close_cb (lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc);
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_tsc_init (void)
+{
+  lv_image_decoder_t *decoder = lv_image_decoder_create();
+
+  lv_image_decoder_set_info_cb(decoder, tsc_info_cb);
+  lv_image_decoder_set_open_cb(decoder, tsc_open_cb);
+  lv_image_decoder_set_close_cb(decoder, tsc_close_cb);
+}
+
+bool
+lvgl_tsc_is_tsc (lv_color_format_t cf)
+{
+  return cf >= LV_COLOR_FORMAT_NEMA_TSC_START && cf <= LV_COLOR_FORMAT_NEMA_TSC_END;
+}
+
+uint32_t
+lvgl_tsc_get_size (lv_color_format_t cf,
+                   uint32_t          w,
+                   uint32_t          h)
+{
+  uint32_t blocks = ((w + TSC_BLOCK_SIZE - 1) / TSC_BLOCK_SIZE) *
+                    ((h + TSC_BLOCK_SIZE - 1) / TSC_BLOCK_SIZE);
+
+  /* every 4x4 block is coded in 16 * bpp bits */
+  switch (cf)
+    {
+      case LV_COLOR_FORMAT_NEMA_TSC4:
+        return blocks * 8;
+      case LV_COLOR_FORMAT_NEMA_TSC6:
+      case LV_COLOR_FORMAT_NEMA_TSC6A:
+      case LV_COLOR_FORMAT_NEMA_TSC6AP:
+        return blocks * 12;
+      case LV_COLOR_FORMAT_NEMA_TSC12:
+      case LV_COLOR_FORMAT_NEMA_TSC12A:
+        return blocks * 24;
+      default:
+        return 0;
+    }
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static lv_result_t
+tsc_info_cb (lv_image_decoder_t     *decoder,
+             lv_image_decoder_dsc_t *dsc,
+             lv_image_header_t      *header)
+{
+  const lv_image_dsc_t *img = dsc->src;
+
+  LV_UNUSED(decoder);
+
+  /* only C arrays and memory-mapped data can be sampled without a copy */
+  if (dsc->src_type != LV_IMAGE_SRC_VARIABLE || !lvgl_tsc_is_tsc(img->header.cf))
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  *header = img->header;
+
+  return LV_RESULT_OK;
+}
+
+static lv_result_t
+tsc_open_cb (lv_image_decoder_t     *decoder,
+             lv_image_decoder_dsc_t *dsc)
+{
+  const lv_image_dsc_t *img = dsc->src;
+  lv_draw_buf_t *decoded;
+
+  LV_UNUSED(decoder);
+
+  if ((uintptr_t)img->data % TSC_ALIGN != 0 ||
+      img->header.w % TSC_BLOCK_SIZE != 0 || img->header.h % TSC_BLOCK_SIZE != 0 ||
+      img->data_size < lvgl_tsc_get_size(img->header.cf, img->header.w, img->header.h))
+    {
+      LV_LOG_WARN("TSC image %dx%d isn't block aligned or too short",
+                  (int)img->header.w, (int)img->header.h);
+      return LV_RESULT_INVALID;
+    }
+
+  /* only the descriptor is allocated, it points to the compressed data */
+  decoded = lv_malloc_zeroed(sizeof(lv_draw_buf_t));
+  if (decoded == NULL)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  lv_draw_buf_from_image(decoded, img);
+  dsc->decoded = decoded;
+
+  return LV_RESULT_OK;
+}
+
+static void
+tsc_close_cb (lv_image_decoder_t     *decoder,
+              lv_image_decoder_dsc_t *dsc)
+{
+  LV_UNUSED(decoder);
+
+  lv_free((void *)dsc->decoded);
+  dsc->decoded = NULL;
+}
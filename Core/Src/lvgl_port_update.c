@@ -0,0 +1,653 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_update.h"
+#include "lvgl_port_bundle.h"
+#include "lvgl_port_trace.h"
+#include "main.h"
+#include "hash.h"
+#include "usart.h"
+#include "cmsis_os2.h"
+#include <stddef.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define UPDATE_RECORD_MAGIC  0x5255564C   /* "LVUR" */
+
+/* programmed over the erased word after the rest of the record */
+#define UPDATE_COMMIT        0x00C0FFEE
+
+/* the HASH takes a few us for a chunk */
+#define UPDATE_HASH_TIMEOUT  100
+
+#define UPDATE_ALIGN_UP(x)  (((x) + OSPI_SECTOR_SIZE - 1) & ~(uint32_t)(OSPI_SECTOR_SIZE - 1))
+
+#define UPDATE_UART_ACK      'K'
+#define UPDATE_UART_NAK      'E'
+
+#if UPDATE_CHUNK_CNT < 2
+  #error "a chunk is received while the previous one is hashed and programmed"
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/* In the last sector of a slot. It's valid with the commit word, which is programmed
+ * last, so a slot is never active with a partly written record or image. */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t seq;        /* higher than the one of the other slot */
+  uint32_t size;
+  uint32_t reserved;
+  uint8_t  digest[UPDATE_DIGEST_SIZE];
+  uint32_t commit;
+} update_record_t;
+
+/* Sent by the host before the image, the device answers UPDATE_UART_ACK when it
+ * can take the next chunk and after the switch, UPDATE_UART_NAK on errors */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t size;
+  uint8_t  digest[UPDATE_DIGEST_SIZE];
+} update_uart_header_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static const update_record_t *
+update_get_record (uint32_t slot);
+
+static lv_result_t
+update_submit (void);
+
+static lv_result_t
+update_hash_wait (void);
+
+static void
+update_drain (void);
+
+static lv_result_t
+update_fail (void);
+
+static void
+update_job_done_cb (lv_result_t res, void *user_data);
+
+static void
+update_uart_task (void *argument);
+
+static lv_result_t
+update_uart_receive (void *buf, uint32_t size);
+
+static void
+update_uart_reply (uint8_t c);
+
+static void
+update_uart_rx_cplt_cb (UART_HandleTypeDef *huart);
+
+static void
+update_uart_error_cb (UART_HandleTypeDef *huart);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static const osThreadAttr_t update_task_attr =
+{
+  .name = "update",
+  .priority = (osPriority_t) UPDATE_TASK_PRIORITY,
+  .stack_size = UPDATE_TASK_STACK_SIZE,
+};
+
+static uint8_t chunks[UPDATE_CHUNK_CNT][UPDATE_CHUNK_SIZE] __attribute__((aligned(4)));
+
+/* chunks not queued for the flash */
+static osSemaphoreId_t free_sem;
+
+/* the HASH's DMA has read its chunk */
+static osSemaphoreId_t hash_sem;
+
+static osSemaphoreId_t uart_sem;
+
+static uint32_t active_slot;
+static uint32_t active_seq;
+
+/* the slot of the bundle in use since the boot, an update can't be written to it */
+static uint32_t mounted_slot;
+
+/* the update in progress */
+static bool running;
+static uint32_t slot;
+static uint32_t total;
+static uint32_t queued;        /* bytes handed to the HASH and the OSPI task */
+static uint32_t fill;          /* bytes in the current chunk */
+static uint32_t chunk_idx;
+static uint32_t start_tick;
+static uint8_t expected[UPDATE_DIGEST_SIZE];
+static bool hashing;
+static volatile bool failed;
+
+static volatile bool uart_error;
+
+static lvgl_update_stats_t stats;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_update_init (void)
+{
+  const update_record_t *rec;
+  uint32_t i;
+
+  if (free_sem == NULL)
+    {
+      free_sem = osSemaphoreNew(UPDATE_CHUNK_CNT, UPDATE_CHUNK_CNT, NULL);
+      hash_sem = osSemaphoreNew(1, 0, NULL);
+      uart_sem = osSemaphoreNew(1, 0, NULL);
+    }
+
+  /* the 1st slot without a record is the bundle of the programmer */
+  active_slot = 0;
+  active_seq = 0;
+
+  lvgl_ospi_read_begin();
+  for (i = 0; i < UPDATE_SLOT_CNT; i++)
+    {
+      rec = update_get_record(i);
+      if (rec != NULL && rec->seq > active_seq)
+        {
+          active_slot = i;
+          active_seq = rec->seq;
+        }
+    }
+  lvgl_ospi_read_end();
+
+  mounted_slot = active_slot;
+}
+
+const void *
+lvgl_update_get_bundle (void)
+{
+  return lvgl_ospi_get_ptr(active_slot * UPDATE_SLOT_SIZE);
+}
+
+uint32_t
+lvgl_update_get_active_slot (void)
+{
+  return active_slot;
+}
+
+lv_result_t
+lvgl_update_begin (uint32_t       size,
+                   const uint8_t  digest[UPDATE_DIGEST_SIZE])
+{
+  uint32_t next = (active_slot + 1) % UPDATE_SLOT_CNT;
+  uint32_t offset = next * UPDATE_SLOT_SIZE;
+
+  if (running || size == 0 || size > UPDATE_MAX_SIZE || free_sem == NULL ||
+      hhash.State == HAL_HASH_STATE_RESET || hhash.hdmain == NULL)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  /* after an update the next one would overwrite the bundle the UI still uses */
+  if (next == mounted_slot)
+    {
+      lvgl_trace("update: refused, slot %u is in use until the reboot", (unsigned)next);
+      return LV_RESULT_INVALID;
+    }
+
+  slot = next;
+
+  /* the record first, the slot is inactive from here on even if the update is lost */
+  if (lvgl_ospi_erase_async(offset + UPDATE_RECORD_OFFSET, OSPI_SECTOR_SIZE,
+                            update_job_done_cb, NULL) != LV_RESULT_OK ||
+      lvgl_ospi_erase_async(offset, UPDATE_ALIGN_UP(size),
+                            update_job_done_cb, NULL) != LV_RESULT_OK)
+    {
+      update_drain();
+      return LV_RESULT_INVALID;
+    }
+
+  /* a new digest, the chunks but the last are fed with MDMAT set so the HASH
+   * waits for more data rather than computing the digest at the end of each */
+  HAL_HASH_Init(&hhash);
+  if (size > UPDATE_CHUNK_SIZE)
+    {
+      __HAL_HASH_SET_MDMAT();
+    }
+
+  lv_memcpy(expected, digest, UPDATE_DIGEST_SIZE);
+  total = size;
+  queued = 0;
+  fill = 0;
+  hashing = false;
+  failed = false;
+  running = true;
+
+  start_tick = HAL_GetTick();
+  stats.wait_ms = 0;
+  stats.hash_wait_us = 0;
+
+  return LV_RESULT_OK;
+}
+
+lv_result_t
+lvgl_update_write (const void *data,
+                   uint32_t    size)
+{
+  const uint8_t *src = data;
+  uint32_t start;
+  uint32_t n;
+
+  if (!running)
+    {
+      return LV_RESULT_INVALID;
+    }
+  if (size > total - queued - fill)
+    {
+      return update_fail();
+    }
+
+  while (size > 0)
+    {
+      /* the chunks are freed in the order they were queued, the next one is the oldest */
+      if (fill == 0)
+        {
+          start = HAL_GetTick();
+          osSemaphoreAcquire(free_sem, osWaitForever);
+          stats.wait_ms += HAL_GetTick() - start;
+        }
+
+      n = LV_MIN(size, UPDATE_CHUNK_SIZE - fill);
+      lv_memcpy(&chunks[chunk_idx][fill], src, n);
+      fill += n;
+      src += n;
+      size -= n;
+
+      if ((fill == UPDATE_CHUNK_SIZE || queued + fill == total) && update_submit() != LV_RESULT_OK)
+        {
+          return update_fail();
+        }
+    }
+
+  return failed ? update_fail() : LV_RESULT_OK;
+}
+
+lv_result_t
+lvgl_update_finish (void)
+{
+  update_record_t rec;
+  uint8_t digest[UPDATE_DIGEST_SIZE];
+  uint32_t offset = slot * UPDATE_SLOT_SIZE + UPDATE_RECORD_OFFSET;
+  bool valid;
+
+  if (!running)
+    {
+      return LV_RESULT_INVALID;
+    }
+  if (queued != total)
+    {
+      return update_fail();
+    }
+
+  update_drain();
+
+  if (failed || HAL_HASHEx_SHA256_Finish(&hhash, digest, UPDATE_HASH_TIMEOUT) != HAL_OK ||
+      lv_memcmp(digest, expected, UPDATE_DIGEST_SIZE) != 0)
+    {
+      return update_fail();
+    }
+
+  /* a program of another task leaves the memory-mapped mode, not while it's read */
+  lvgl_ospi_read_begin();
+  valid = lvgl_bundle_is_valid(lvgl_ospi_get_ptr(slot * UPDATE_SLOT_SIZE));
+  lvgl_ospi_read_end();
+  if (!valid)
+    {
+      return update_fail();
+    }
+
+  lv_memset(&rec, 0xFF, sizeof(rec));
+  rec.magic = UPDATE_RECORD_MAGIC;
+  rec.seq = active_seq + 1;
+  rec.size = total;
+  lv_memcpy(rec.digest, digest, UPDATE_DIGEST_SIZE);
+
+  /* the switch: the slot becomes active with the single word program of the commit */
+  if (lvgl_ospi_program(offset, &rec, offsetof(update_record_t, commit)) != LV_RESULT_OK)
+    {
+      return update_fail();
+    }
+  rec.commit = UPDATE_COMMIT;
+  if (lvgl_ospi_program(offset + offsetof(update_record_t, commit), &rec.commit,
+                        sizeof(rec.commit)) != LV_RESULT_OK)
+    {
+      return update_fail();
+    }
+
+  lvgl_ospi_read_begin();
+  valid = update_get_record(slot) != NULL;
+  lvgl_ospi_read_end();
+  if (!valid)
+    {
+      return update_fail();
+    }
+
+  active_slot = slot;
+  active_seq = rec.seq;
+  running = false;
+
+  stats.updates++;
+  stats.bytes = total;
+  stats.ms = HAL_GetTick() - start_tick;
+
+  return LV_RESULT_OK;
+}
+
+void
+lvgl_update_abort (void)
+{
+  if (running)
+    {
+      update_fail();
+    }
+}
+
+void
+lvgl_update_uart_start (void)
+{
+  /* faster than the 115200 of CubeMX, the flash takes ~1 MB/s */
+  UPDATE_UART.Init.BaudRate = UPDATE_UART_BAUDRATE;
+  if (HAL_UART_Init(&UPDATE_UART) != HAL_OK)
+    {
+      return;
+    }
+
+  /* the UARTs are shared by several services, each registers its own callbacks */
+  HAL_UART_RegisterCallback(&UPDATE_UART, HAL_UART_RX_COMPLETE_CB_ID, update_uart_rx_cplt_cb);
+  HAL_UART_RegisterCallback(&UPDATE_UART, HAL_UART_ERROR_CB_ID, update_uart_error_cb);
+
+  HAL_NVIC_SetPriority(UPDATE_UART_IRQn, UPDATE_UART_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(UPDATE_UART_IRQn);
+
+  osThreadNew(update_uart_task, NULL, &update_task_attr);
+}
+
+void
+lvgl_update_get_stats (lvgl_update_stats_t *stats_out)
+{
+  *stats_out = stats;
+  stats_out->kbyte_per_s = stats.ms > 0 ? (uint32_t)((uint64_t)stats.bytes * 1000 / 1024 / stats.ms) : 0;
+}
+
+void
+lvgl_update_reset_stats (void)
+{
+  lv_memzero(&stats, sizeof(stats));
+}
+
+/* the HAL's weak callbacks, USE_HAL_HASH_REGISTER_CALLBACKS is 0 */
+void
+HAL_HASH_InCpltCallback (HASH_HandleTypeDef *hhash_p)
+{
+  LV_UNUSED(hhash_p);
+
+  osSemaphoreRelease(hash_sem);
+}
+
+void
+HAL_HASH_ErrorCallback (HASH_HandleTypeDef *hhash_p)
+{
+  LV_UNUSED(hhash_p);
+
+  failed = true;
+  osSemaphoreRelease(hash_sem);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/* Called between lvgl_ospi_read_begin() and lvgl_ospi_read_end() */
+static const update_record_t *
+update_get_record (uint32_t slot_idx)
+{
+  const update_record_t *rec = lvgl_ospi_get_ptr(slot_idx * UPDATE_SLOT_SIZE + UPDATE_RECORD_OFFSET);
+
+  if (rec->magic != UPDATE_RECORD_MAGIC || rec->commit != UPDATE_COMMIT ||
+      rec->size == 0 || rec->size > UPDATE_MAX_SIZE || rec->seq == 0xFFFFFFFF)
+    {
+      return NULL;
+    }
+
+  return rec;
+}
+
+static lv_result_t
+update_submit (void)
+{
+  uint8_t *chunk = chunks[chunk_idx];
+  uint32_t offset = slot * UPDATE_SLOT_SIZE + queued;
+  uint32_t size = fill;
+
+  /* one chunk is fed at a time, it took a few us while this one was received */
+  if (update_hash_wait() != LV_RESULT_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  if (queued + size == total)
+    {
+      __HAL_HASH_RESET_MDMAT();
+    }
+
+  if (HAL_HASHEx_SHA256_Start_DMA(&hhash, chunk, size) != HAL_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+  hashing = true;
+
+  /* the DMA only reads the chunk, the OSPI task programs it at the same time */
+  if (lvgl_ospi_program_async(offset, chunk, size, update_job_done_cb, chunk) != LV_RESULT_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  queued += size;
+  fill = 0;
+  chunk_idx = (chunk_idx + 1) % UPDATE_CHUNK_CNT;
+
+  return LV_RESULT_OK;
+}
+
+static lv_result_t
+update_hash_wait (void)
+{
+  uint32_t start = DWT->CYCCNT;
+  osStatus_t res;
+
+  if (!hashing)
+    {
+      return LV_RESULT_OK;
+    }
+
+  res = osSemaphoreAcquire(hash_sem, UPDATE_HASH_TIMEOUT);
+  hashing = false;
+  stats.hash_wait_us += (uint32_t)((uint64_t)(DWT->CYCCNT - start) * 1000000 / SystemCoreClock);
+
+  if (res != osOK)
+    {
+      HAL_DMA_Abort(hhash.hdmain);
+      return LV_RESULT_INVALID;
+    }
+
+  return failed ? LV_RESULT_INVALID : LV_RESULT_OK;
+}
+
+static void
+update_drain (void)
+{
+  uint32_t i;
+
+  update_hash_wait();
+
+  /* all the chunks are free once the OSPI task has programmed them, the erases
+   * were queued before them */
+  for (i = 0; i < UPDATE_CHUNK_CNT; i++)
+    {
+      osSemaphoreAcquire(free_sem, osWaitForever);
+    }
+  for (i = 0; i < UPDATE_CHUNK_CNT; i++)
+    {
+      osSemaphoreRelease(free_sem);
+    }
+
+  while (lvgl_ospi_is_busy())
+    {
+      osDelay(1);
+    }
+}
+
+static lv_result_t
+update_fail (void)
+{
+  /* a chunk taken but not queued is given back */
+  if (fill > 0)
+    {
+      osSemaphoreRelease(free_sem);
+    }
+
+  update_drain();
+
+  /* the slot keeps no record, so the active one stays */
+  HAL_HASH_Init(&hhash);
+  fill = 0;
+  running = false;
+  stats.failures++;
+
+  return LV_RESULT_INVALID;
+}
+
+static void
+update_job_done_cb (lv_result_t res,
+                    void       *user_data)
+{
+  if (res != LV_RESULT_OK)
+    {
+      failed = true;
+    }
+
+  /* a chunk, NULL for the erases */
+  if (user_data != NULL)
+    {
+      osSemaphoreRelease(free_sem);
+    }
+}
+
+static void
+update_uart_task (void *argument)
+{
+  static uint8_t buf[UPDATE_CHUNK_SIZE] __attribute__((aligned(4)));
+  update_uart_header_t header;
+  uint32_t left;
+  uint32_t n;
+  lv_result_t res;
+
+  LV_UNUSED(argument);
+
+  for (;;)
+    {
+      /* the host starts over after a timeout, anything but a header is dropped */
+      if (update_uart_receive(&header, sizeof(header)) != LV_RESULT_OK)
+        {
+          continue;
+        }
+      if (header.magic != UPDATE_UART_MAGIC ||
+          lvgl_update_begin(header.size, header.digest) != LV_RESULT_OK)
+        {
+          update_uart_reply(UPDATE_UART_NAK);
+          continue;
+        }
+      update_uart_reply(UPDATE_UART_ACK);
+
+      /* the next chunk is received while this one is hashed and programmed */
+      res = LV_RESULT_OK;
+      for (left = header.size; left > 0 && res == LV_RESULT_OK; left -= n)
+        {
+          n = LV_MIN(left, UPDATE_CHUNK_SIZE);
+          res = update_uart_receive(buf, n);
+          if (res == LV_RESULT_OK)
+            {
+              res = lvgl_update_write(buf, n);
+            }
+          if (res == LV_RESULT_OK && left > n)
+            {
+              update_uart_reply(UPDATE_UART_ACK);
+            }
+        }
+
+      if (res == LV_RESULT_OK)
+        {
+          res = lvgl_update_finish();
+        }
+      else
+        {
+          lvgl_update_abort();
+        }
+
+      update_uart_reply(res == LV_RESULT_OK ? UPDATE_UART_ACK : UPDATE_UART_NAK);
+      lvgl_trace("update: %s, slot %u", res == LV_RESULT_OK ? "done" : "failed", (unsigned)slot);
+    }
+}
+
+static lv_result_t
+update_uart_receive (void    *buf,
+                     uint32_t size)
+{
+  uart_error = false;
+
+  if (HAL_UART_Receive_IT(&UPDATE_UART, buf, size) != HAL_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  if (osSemaphoreAcquire(uart_sem, UPDATE_UART_TIMEOUT) != osOK)
+    {
+      HAL_UART_AbortReceive(&UPDATE_UART);
+      return LV_RESULT_INVALID;
+    }
+
+  return uart_error ? LV_RESULT_INVALID : LV_RESULT_OK;
+}
+
+static void
+update_uart_reply (uint8_t c)
+{
+  HAL_UART_Transmit(&UPDATE_UART, &c, 1, UPDATE_UART_TIMEOUT);
+}
+
+static void
+update_uart_rx_cplt_cb (UART_HandleTypeDef *huart)
+{
+  LV_UNUSED(huart);
+
+  osSemaphoreRelease(uart_sem);
+}
+
+static void
+update_uart_error_cb (UART_HandleTypeDef *huart)
+{
+  LV_UNUSED(huart);
+
+  uart_error = true;
+  osSemaphoreRelease(uart_sem);
+}
@@ -0,0 +1,495 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_usb.h"
+#include "main.h"
+#include "usb_otg.h"
+#include "cmsis_os2.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define USB_EP0_MPS            64
+#define USB_MPS_HS             512
+#define USB_MPS_FS             64
+
+/* FIFO sizes in words, 1024 in total: all the OUT endpoints share the RX FIFO */
+#define USB_FIFO_RX            0x200
+#define USB_FIFO_TX0           0x40
+#define USB_FIFO_TX1           0x180
+
+#define USB_CONFIG_SIZE        (9 + 9 + 7 + 7)
+
+/* standard requests */
+#define USB_REQ_GET_STATUS     0x00
+#define USB_REQ_CLEAR_FEATURE  0x01
+#define USB_REQ_SET_ADDRESS    0x05
+#define USB_REQ_GET_DESCRIPTOR 0x06
+#define USB_REQ_GET_CONFIG     0x08
+#define USB_REQ_SET_CONFIG     0x09
+#define USB_REQ_SET_INTERFACE  0x0B
+
+#define USB_DESC_DEVICE        0x01
+#define USB_DESC_CONFIG        0x02
+#define USB_DESC_STRING        0x03
+#define USB_DESC_QUALIFIER     0x06
+#define USB_DESC_OTHER_SPEED   0x07
+
+#define USB_REQ_TYPE_MASK      0x60
+#define USB_REQ_TYPE_STANDARD  0x00
+#define USB_REQ_RECIPIENT_MASK 0x1F
+#define USB_REQ_RECIPIENT_EP   0x02
+
+#define USB_STRING_MAX         ((USB_EP0_MPS - 2) / 2)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint8_t  bmRequestType;
+  uint8_t  bRequest;
+  uint16_t wValue;
+  uint16_t wIndex;
+  uint16_t wLength;
+} usb_setup_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void
+usb_setup (PCD_HandleTypeDef *hpcd, const usb_setup_t *req);
+
+static uint32_t
+usb_get_descriptor (PCD_HandleTypeDef *hpcd, uint16_t value, const uint8_t **desc);
+
+static uint32_t
+usb_make_config (uint8_t type, uint16_t mps);
+
+static uint32_t
+usb_make_string (const char *str);
+
+static void
+usb_ep0_send (PCD_HandleTypeDef *hpcd, const uint8_t *data, uint32_t size, uint16_t max);
+
+static void
+usb_ep0_status (PCD_HandleTypeDef *hpcd);
+
+static void
+usb_ep0_stall (PCD_HandleTypeDef *hpcd);
+
+static void
+usb_configure (PCD_HandleTypeDef *hpcd, uint8_t config);
+
+static uint16_t
+usb_get_mps (PCD_HandleTypeDef *hpcd, bool other_speed);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static const uint8_t device_desc[18] = {
+  18, USB_DESC_DEVICE,
+  0x00, 0x02,                   /* USB 2.0 */
+  0x00, 0x00, 0x00,             /* the class is given by the interface */
+  USB_EP0_MPS,
+  USB_VID & 0xFF, USB_VID >> 8,
+  USB_PID & 0xFF, USB_PID >> 8,
+  0x00, 0x01,                   /* bcdDevice 1.00 */
+  1, 2, 3,                      /* manufacturer, product, serial number */
+  1
+};
+
+static const uint8_t qualifier_desc[10] = {
+  10, USB_DESC_QUALIFIER,
+  0x00, 0x02,
+  0x00, 0x00, 0x00,
+  USB_EP0_MPS,
+  1,
+  0
+};
+
+static const uint8_t langid_desc[4] = {
+  4, USB_DESC_STRING, 0x09, 0x04  /* English (US) */
+};
+
+/* the EP0 answers are built here, they fit into a packet */
+static uint8_t ep0_buf[USB_EP0_MPS] __attribute__((aligned(4)));
+static bool ep0_data_in;
+
+static uint8_t rx_buf[USB_RX_SIZE] __attribute__((aligned(4)));
+static lvgl_usb_rx_cb_t rx_cb;
+
+static osSemaphoreId_t tx_sem;
+static volatile bool tx_zlp;
+static volatile bool tx_busy;
+
+static volatile uint8_t config_value;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_usb_start (void)
+{
+  tx_sem = osSemaphoreNew(1, 0, NULL);
+
+  HAL_PCDEx_SetRxFiFo(&hpcd_USB_OTG_HS, USB_FIFO_RX);
+  HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_HS, 0, USB_FIFO_TX0);
+  HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_HS, 1, USB_FIFO_TX1);
+
+  HAL_PCD_Start(&hpcd_USB_OTG_HS);
+}
+
+bool
+lvgl_usb_is_configured (void)
+{
+  return config_value != 0;
+}
+
+void
+lvgl_usb_set_rx_cb (lvgl_usb_rx_cb_t cb)
+{
+  rx_cb = cb;
+}
+
+lv_result_t
+lvgl_usb_write (const void *data,
+                uint32_t    size,
+                uint32_t    timeout)
+{
+  if (config_value == 0 || tx_busy)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  /* the host can't tell where a transfer of whole packets ends without a ZLP */
+  tx_zlp = size > 0 && size % usb_get_mps(&hpcd_USB_OTG_HS, false) == 0;
+  tx_busy = true;
+
+  if (HAL_PCD_EP_Transmit(&hpcd_USB_OTG_HS, USB_EP_IN, (uint8_t *)data, size) != HAL_OK)
+    {
+      tx_busy = false;
+      return LV_RESULT_INVALID;
+    }
+
+  if (osSemaphoreAcquire(tx_sem, timeout) != osOK)
+    {
+      /* the host doesn't read, `data` mustn't be used after the return */
+      HAL_PCD_EP_Abort(&hpcd_USB_OTG_HS, USB_EP_IN);
+      HAL_PCD_EP_Flush(&hpcd_USB_OTG_HS, USB_EP_IN);
+      tx_busy = false;
+      return LV_RESULT_INVALID;
+    }
+
+  /* a reset or an unconfigure released the semaphore too */
+  return config_value != 0 ? LV_RESULT_OK : LV_RESULT_INVALID;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void
+usb_setup (PCD_HandleTypeDef *hpcd,
+           const usb_setup_t *req)
+{
+  const uint8_t *desc;
+  uint32_t size;
+
+  if ((req->bmRequestType & USB_REQ_TYPE_MASK) != USB_REQ_TYPE_STANDARD)
+    {
+      usb_ep0_stall(hpcd);
+      return;
+    }
+
+  switch (req->bRequest)
+    {
+      case USB_REQ_GET_DESCRIPTOR:
+        size = usb_get_descriptor(hpcd, req->wValue, &desc);
+        if (size == 0)
+          {
+            usb_ep0_stall(hpcd);
+            break;
+          }
+        usb_ep0_send(hpcd, desc, size, req->wLength);
+        break;
+
+      case USB_REQ_SET_ADDRESS:
+        /* the OTG core applies the address after the status stage by itself */
+        HAL_PCD_SetAddress(hpcd, req->wValue & 0x7F);
+        usb_ep0_status(hpcd);
+        break;
+
+      case USB_REQ_SET_CONFIG:
+        if (req->wValue > 1)
+          {
+            usb_ep0_stall(hpcd);
+            break;
+          }
+        usb_configure(hpcd, req->wValue);
+        usb_ep0_status(hpcd);
+        break;
+
+      case USB_REQ_GET_CONFIG:
+        ep0_buf[0] = config_value;
+        usb_ep0_send(hpcd, ep0_buf, 1, req->wLength);
+        break;
+
+      case USB_REQ_GET_STATUS:
+        /* bus powered, no remote wakeup, no halted endpoint as it's cleared on the host's request */
+        ep0_buf[0] = 0;
+        ep0_buf[1] = 0;
+        usb_ep0_send(hpcd, ep0_buf, 2, req->wLength);
+        break;
+
+      case USB_REQ_CLEAR_FEATURE:
+        if ((req->bmRequestType & USB_REQ_RECIPIENT_MASK) == USB_REQ_RECIPIENT_EP &&
+            (req->wIndex & 0x7F) != 0)
+          {
+            HAL_PCD_EP_ClrStall(hpcd, req->wIndex & 0xFF);
+          }
+        usb_ep0_status(hpcd);
+        break;
+
+      case USB_REQ_SET_INTERFACE:
+        /* only the alternate setting 0 */
+        if (req->wValue != 0)
+          {
+            usb_ep0_stall(hpcd);
+            break;
+          }
+        usb_ep0_status(hpcd);
+        break;
+
+      default:
+        usb_ep0_stall(hpcd);
+        break;
+    }
+}
+
+static uint32_t
+usb_get_descriptor (PCD_HandleTypeDef *hpcd,
+                    uint16_t           value,
+                    const uint8_t    **desc)
+{
+  char serial[25];
+
+  switch (value >> 8)
+    {
+      case USB_DESC_DEVICE:
+        *desc = device_desc;
+        return sizeof(device_desc);
+
+      case USB_DESC_QUALIFIER:
+        *desc = qualifier_desc;
+        return sizeof(qualifier_desc);
+
+      case USB_DESC_CONFIG:
+        *desc = ep0_buf;
+        return usb_make_config(USB_DESC_CONFIG, usb_get_mps(hpcd, false));
+
+      case USB_DESC_OTHER_SPEED:
+        *desc = ep0_buf;
+        return usb_make_config(USB_DESC_OTHER_SPEED, usb_get_mps(hpcd, true));
+
+      case USB_DESC_STRING:
+        *desc = ep0_buf;
+        switch (value & 0xFF)
+          {
+            case 0:
+              *desc = langid_desc;
+              return sizeof(langid_desc);
+            case 1:
+              return usb_make_string(USB_MANUFACTURER_STRING);
+            case 2:
+              return usb_make_string(USB_PRODUCT_STRING);
+            case 3:
+              /* the unique ID of the MCU, so several panels can be told apart */
+              lv_snprintf(serial, sizeof(serial), "%08lX%08lX%08lX", (unsigned long)HAL_GetUIDw0(),
+                          (unsigned long)HAL_GetUIDw1(), (unsigned long)HAL_GetUIDw2());
+              return usb_make_string(serial);
+            default:
+              return 0;
+          }
+
+      default:
+        return 0;
+    }
+}
+
+static uint32_t
+usb_make_config (uint8_t  type,
+                 uint16_t mps)
+{
+  static const uint8_t config[USB_CONFIG_SIZE] = {
+    /* configuration */
+    9, USB_DESC_CONFIG, USB_CONFIG_SIZE, 0, 1, 1, 0, 0x80, 250,
+    /* vendor specific interface */
+    9, 0x04, 0, 0, 2, 0xFF, 0x00, 0x00, 0,
+    /* bulk endpoints, the packet size is filled in */
+    7, 0x05, USB_EP_OUT, 0x02, 0, 0, 0,
+    7, 0x05, USB_EP_IN, 0x02, 0, 0, 0,
+  };
+
+  lv_memcpy(ep0_buf, config, sizeof(config));
+  ep0_buf[1] = type;
+  ep0_buf[18 + 4] = mps & 0xFF;
+  ep0_buf[18 + 5] = mps >> 8;
+  ep0_buf[25 + 4] = mps & 0xFF;
+  ep0_buf[25 + 5] = mps >> 8;
+
+  return sizeof(config);
+}
+
+static uint32_t
+usb_make_string (const char *str)
+{
+  uint32_t n;
+
+  /* UTF-16LE of an ASCII string */
+  for (n = 0; str[n] != '\0' && n < USB_STRING_MAX; n++)
+    {
+      ep0_buf[2 + n * 2] = str[n];
+      ep0_buf[3 + n * 2] = 0;
+    }
+  ep0_buf[0] = 2 + n * 2;
+  ep0_buf[1] = USB_DESC_STRING;
+
+  return ep0_buf[0];
+}
+
+static void
+usb_ep0_send (PCD_HandleTypeDef *hpcd,
+              const uint8_t     *data,
+              uint32_t           size,
+              uint16_t           max)
+{
+  /* the status stage is received in HAL_PCD_DataInStageCallback() */
+  ep0_data_in = true;
+  HAL_PCD_EP_Transmit(hpcd, 0x00, (uint8_t *)data, LV_MIN(size, max));
+}
+
+static void
+usb_ep0_status (PCD_HandleTypeDef *hpcd)
+{
+  ep0_data_in = false;
+  HAL_PCD_EP_Transmit(hpcd, 0x00, NULL, 0);
+}
+
+static void
+usb_ep0_stall (PCD_HandleTypeDef *hpcd)
+{
+  HAL_PCD_EP_SetStall(hpcd, 0x80);
+  HAL_PCD_EP_SetStall(hpcd, 0x00);
+}
+
+static void
+usb_configure (PCD_HandleTypeDef *hpcd,
+               uint8_t            config)
+{
+  uint16_t mps = usb_get_mps(hpcd, false);
+
+  if (config_value != 0)
+    {
+      HAL_PCD_EP_Close(hpcd, USB_EP_OUT);
+      HAL_PCD_EP_Close(hpcd, USB_EP_IN);
+      config_value = 0;
+    }
+
+  /* a writer waiting for the host is released */
+  if (tx_busy)
+    {
+      tx_busy = false;
+      osSemaphoreRelease(tx_sem);
+    }
+
+  if (config != 0)
+    {
+      HAL_PCD_EP_Open(hpcd, USB_EP_OUT, mps, EP_TYPE_BULK);
+      HAL_PCD_EP_Open(hpcd, USB_EP_IN, mps, EP_TYPE_BULK);
+      HAL_PCD_EP_Receive(hpcd, USB_EP_OUT, rx_buf, sizeof(rx_buf));
+      config_value = config;
+    }
+}
+
+static uint16_t
+usb_get_mps (PCD_HandleTypeDef *hpcd,
+             bool               other_speed)
+{
+  bool high_speed = hpcd->Init.speed == PCD_SPEED_HIGH;
+
+  return high_speed != other_speed ? USB_MPS_HS : USB_MPS_FS;
+}
+
+/* The HAL_PCD callbacks are weak functions, USE_HAL_PCD_REGISTER_CALLBACKS is 0 */
+
+void
+HAL_PCD_SetupStageCallback (PCD_HandleTypeDef *hpcd)
+{
+  usb_setup_t req;
+
+  lv_memcpy(&req, hpcd->Setup, sizeof(req));
+  usb_setup(hpcd, &req);
+}
+
+void
+HAL_PCD_DataInStageCallback (PCD_HandleTypeDef *hpcd,
+                             uint8_t            epnum)
+{
+  if (epnum == 0)
+    {
+      if (ep0_data_in)
+        {
+          /* the status stage of a control read */
+          ep0_data_in = false;
+          HAL_PCD_EP_Receive(hpcd, 0x00, NULL, 0);
+        }
+    }
+  else if (epnum == (USB_EP_IN & 0x7F) && tx_busy)
+    {
+      if (tx_zlp)
+        {
+          tx_zlp = false;
+          HAL_PCD_EP_Transmit(hpcd, USB_EP_IN, NULL, 0);
+          return;
+        }
+      tx_busy = false;
+      osSemaphoreRelease(tx_sem);
+    }
+}
+
+void
+HAL_PCD_DataOutStageCallback (PCD_HandleTypeDef *hpcd,
+                              uint8_t            epnum)
+{
+  if (epnum == USB_EP_OUT && config_value != 0)
+    {
+      if (rx_cb != NULL)
+        {
+          rx_cb(rx_buf, HAL_PCD_EP_GetRxCount(hpcd, USB_EP_OUT));
+        }
+      HAL_PCD_EP_Receive(hpcd, USB_EP_OUT, rx_buf, sizeof(rx_buf));
+    }
+}
+
+void
+HAL_PCD_ResetCallback (PCD_HandleTypeDef *hpcd)
+{
+  /* the speed is known now, the host configures the device again */
+  usb_configure(hpcd, 0);
+
+  HAL_PCD_EP_Open(hpcd, 0x00, USB_EP0_MPS, EP_TYPE_CTRL);
+  HAL_PCD_EP_Open(hpcd, 0x80, USB_EP0_MPS, EP_TYPE_CTRL);
+}
+
+void
+HAL_PCD_DisconnectCallback (PCD_HandleTypeDef *hpcd)
+{
+  usb_configure(hpcd, 0);
+}
@@ -0,0 +1,652 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_video.h"
+#include "lvgl_port_jpeg.h"
+#include "lvgl_port_plane.h"
+#include "lvgl_port_sd.h"
+#include "main.h"
+#include "ff.h"
+#include "cmsis_os2.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define VIDEO_READ_SIZE     (VIDEO_READ_BLOCKS * SD_BLOCK_SIZE)
+
+/* osDelay() takes kernel ticks */
+#define VIDEO_MS_TO_TICKS(ms)  ((uint32_t)(((uint64_t)(ms) * osKernelGetTickFreq() + 999) / 1000))
+
+/* the size of the link map, then a cluster count and the first cluster per fragment */
+#define VIDEO_MAP_LEN       (1 + VIDEO_FRAGMENTS_MAX * 2 + 1)
+
+#define VIDEO_FOURCC(a, b, c, d)  ((uint32_t)(a) | ((uint32_t)(b) << 8) | \
+                                   ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+#define VIDEO_ID_RIFF       VIDEO_FOURCC('R', 'I', 'F', 'F')
+#define VIDEO_ID_LIST       VIDEO_FOURCC('L', 'I', 'S', 'T')
+#define VIDEO_ID_AVIH       VIDEO_FOURCC('a', 'v', 'i', 'h')
+#define VIDEO_ID_MOVI       VIDEO_FOURCC('m', 'o', 'v', 'i')
+#define VIDEO_ID_IDX1       VIDEO_FOURCC('i', 'd', 'x', '1')
+#define VIDEO_ID_00DC       VIDEO_FOURCC('0', '0', 'd', 'c')
+#define VIDEO_ID_00DB       VIDEO_FOURCC('0', '0', 'd', 'b')
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/* the AVI file read sequentially through two buffers */
+typedef struct
+{
+  uint32_t next_block;    /* next block of the file to read */
+  uint32_t cur;           /* buffer being parsed, the other one is being read */
+  uint32_t pos;
+  uint32_t len;
+  bool     in_flight;
+  uint32_t in_flight_len;
+  uint32_t offset;        /* file offset of `pos` */
+  uint32_t chunk_left;    /* part of the frame the JPEG decoder may still read */
+} video_stream_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void
+video_task (void *argument);
+
+static lv_result_t
+video_map (const char *path);
+
+static uint32_t
+video_lba (uint32_t block, uint32_t *cnt);
+
+static lv_result_t
+video_open (video_stream_t *s, uint32_t *movi_offset);
+
+static void
+video_play_movi (video_stream_t *s, uint32_t movi_offset);
+
+static bool
+video_frame (video_stream_t *s, uint32_t size, uint32_t frame_idx, uint32_t *back);
+
+static uint32_t
+video_now (void);
+
+static void
+video_stream_seek (video_stream_t *s, uint32_t offset);
+
+static void
+video_stream_prefetch (video_stream_t *s);
+
+static bool
+video_stream_next (video_stream_t *s);
+
+static uint32_t
+video_stream_read (video_stream_t *s, void *buf, uint32_t len);
+
+static bool
+video_stream_read_u32 (video_stream_t *s, uint32_t *v);
+
+static void
+video_stream_skip (video_stream_t *s, uint32_t len);
+
+static size_t
+video_jpeg_in (void *user_data, uint8_t *buf, size_t len);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static const osThreadAttr_t video_task_attr =
+{
+  .name = "video",
+  .priority = (osPriority_t) VIDEO_TASK_PRIORITY,
+  .stack_size = VIDEO_TASK_STACK_SIZE,
+};
+
+static __attribute__((aligned(4))) uint8_t read_buf[2][VIDEO_READ_SIZE];
+static __attribute__((aligned(4))) uint8_t work[JPEG_WORK_SIZE];
+
+static lvgl_video_cfg_t cfg;
+
+/* where the file is on the card */
+static DWORD map[VIDEO_MAP_LEN];
+static uint32_t file_size;
+static uint32_t data_lba;       /* of cluster 2 */
+static uint32_t cluster_blocks;
+
+static volatile bool playing;
+static volatile bool stop_req;
+static bool plane_shown;
+static uint32_t clock_base;
+static volatile uint32_t pos_ms;
+
+static lvgl_video_stats_t stats;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_result_t
+lvgl_video_play (const lvgl_video_cfg_t *video_cfg)
+{
+  if (playing)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  if (video_map(video_cfg->path) != LV_RESULT_OK)
+    {
+      LV_LOG_WARN("can't map %s", video_cfg->path);
+      return LV_RESULT_INVALID;
+    }
+
+  cfg = *video_cfg;
+  cfg.path = NULL;
+  stop_req = false;
+  playing = true;
+
+  if (osThreadNew(video_task, NULL, &video_task_attr) == NULL)
+    {
+      playing = false;
+      return LV_RESULT_INVALID;
+    }
+
+  return LV_RESULT_OK;
+}
+
+void
+lvgl_video_stop (void)
+{
+  stop_req = true;
+}
+
+bool
+lvgl_video_is_playing (void)
+{
+  return playing;
+}
+
+uint32_t
+lvgl_video_get_pos (void)
+{
+  return pos_ms;
+}
+
+void
+lvgl_video_get_stats (lvgl_video_stats_t *stats_out)
+{
+  *stats_out = stats;
+}
+
+void
+lvgl_video_reset_stats (void)
+{
+  stats.decoded = 0;
+  stats.shown = 0;
+  stats.dropped = 0;
+  stats.underruns = 0;
+  stats.errors = 0;
+  stats.decode_us = 0;
+  stats.decode_us_max = 0;
+  stats.av_offset_ms = 0;
+  stats.av_offset_max_ms = 0;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void
+video_task (void *argument)
+{
+  video_stream_t s = {0};
+  uint32_t movi_offset;
+
+  LV_UNUSED(argument);
+
+  DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  plane_shown = false;
+
+  if (video_open(&s, &movi_offset) == LV_RESULT_OK)
+    {
+      video_play_movi(&s, movi_offset);
+    }
+  else
+    {
+      LV_LOG_WARN("can't play the video");
+      stats.errors++;
+    }
+
+  /* the frame buffers are the caller's again once the plane doesn't scan them out */
+  if (plane_shown)
+    {
+      while (lvgl_plane_is_pending())
+        {
+          osDelay(1);
+        }
+      lvgl_plane_hide();
+      while (lvgl_plane_is_pending())
+        {
+          osDelay(1);
+        }
+    }
+
+  if (s.in_flight)
+    {
+      lvgl_sd_read_wait();
+    }
+
+  playing = false;
+  osThreadExit();
+}
+
+static lv_result_t
+video_map (const char *path)
+{
+  FIL file;
+  FRESULT res;
+
+  /* a drive letter of lv_fs, FatFs has only the one volume */
+  if (path[0] != '\0' && path[1] == ':')
+    {
+      path += 2;
+    }
+
+  if (f_open(&file, path, FA_READ) != FR_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  /* the fast seek link map lists the fragments of the file */
+  map[0] = VIDEO_MAP_LEN;
+  file.cltbl = map;
+  res = f_lseek(&file, CREATE_LINKMAP);
+
+  file_size = f_size(&file);
+  data_lba = file.obj.fs->database;
+  cluster_blocks = file.obj.fs->csize;
+  f_close(&file);
+
+  return res == FR_OK ? LV_RESULT_OK : LV_RESULT_INVALID;
+}
+
+/* The card block of the file's `block`, and how many blocks are contiguous from it */
+static uint32_t
+video_lba (uint32_t  block,
+           uint32_t *cnt)
+{
+  const DWORD *frag = &map[1];
+  uint32_t cluster = block / cluster_blocks;
+
+  while (frag[0] != 0 && cluster >= frag[0])
+    {
+      cluster -= frag[0];
+      frag += 2;
+    }
+
+  if (frag[0] == 0)
+    {
+      *cnt = 0;
+      return 0;
+    }
+
+  *cnt = (frag[0] - cluster) * cluster_blocks - block % cluster_blocks;
+
+  return data_lba + (frag[1] - 2 + cluster) * cluster_blocks + block % cluster_blocks;
+}
+
+static lv_result_t
+video_open (video_stream_t *s,
+            uint32_t       *movi_offset)
+{
+  uint32_t avih[10];
+  uint32_t id = 0;
+  uint32_t size;
+  uint32_t type = 0;
+  uint32_t n;
+
+  video_stream_seek(s, 0);
+
+  if (!video_stream_read_u32(s, &id) || !video_stream_read_u32(s, &size) ||
+      !video_stream_read_u32(s, &type) || id != VIDEO_ID_RIFF)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  stats.w = 0;
+  stats.h = 0;
+
+  /* walk into every list until the frames start, only the main header is needed */
+  while (video_stream_read_u32(s, &id) && video_stream_read_u32(s, &size))
+    {
+      if (id == VIDEO_ID_LIST)
+        {
+          if (!video_stream_read_u32(s, &type))
+            {
+              break;
+            }
+          if (type == VIDEO_ID_MOVI)
+            {
+              *movi_offset = s->offset;
+              break;
+            }
+        }
+      else if (id == VIDEO_ID_AVIH)
+        {
+          n = video_stream_read(s, avih, LV_MIN(size, sizeof(avih)));
+          if (n == sizeof(avih))
+            {
+              stats.frame_period_us = avih[0];
+              stats.w = avih[8];
+              stats.h = avih[9];
+            }
+          video_stream_skip(s, size - n + (size & 1));
+        }
+      else
+        {
+          video_stream_skip(s, size + (size & 1));
+        }
+    }
+
+  if (id != VIDEO_ID_LIST || type != VIDEO_ID_MOVI || stats.w == 0 || stats.h == 0 ||
+      stats.w > UINT16_MAX || stats.h > UINT16_MAX || stats.frame_period_us == 0 ||
+      stats.w * stats.h * 2 > cfg.frame_buf_size)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  return LV_RESULT_OK;
+}
+
+static void
+video_play_movi (video_stream_t *s,
+                 uint32_t        movi_offset)
+{
+  uint32_t frame_idx = 0;
+  uint32_t back = 0;
+  uint32_t id;
+  uint32_t size;
+  uint32_t type;
+  bool end;
+
+  clock_base = cfg.clock_cb != NULL ? cfg.clock_cb() : HAL_GetTick();
+
+  while (!stop_req)
+    {
+      end = !video_stream_read_u32(s, &id) || !video_stream_read_u32(s, &size) ||
+            id == VIDEO_ID_IDX1;
+
+      if (end && cfg.loop && frame_idx > 0)
+        {
+          video_stream_seek(s, movi_offset);
+          frame_idx = 0;
+          clock_base = cfg.clock_cb != NULL ? cfg.clock_cb() : HAL_GetTick();
+          continue;
+        }
+      if (end)
+        {
+          break;
+        }
+
+      if (id == VIDEO_ID_LIST)
+        {
+          /* 'rec ' lists group the chunks of a frame, the chunks are read in place */
+          video_stream_read_u32(s, &type);
+        }
+      else if (id == VIDEO_ID_00DC || id == VIDEO_ID_00DB)
+        {
+          video_frame(s, size, frame_idx, &back);
+          frame_idx++;
+        }
+      else
+        {
+          /* audio and padding */
+          video_stream_skip(s, size + (size & 1));
+        }
+    }
+}
+
+static bool
+video_frame (video_stream_t *s,
+             uint32_t        size,
+             uint32_t        frame_idx,
+             uint32_t       *back)
+{
+  lvgl_jpeg_job_t job = {0};
+  lvgl_plane_cfg_t plane = {0};
+  uint32_t due = (uint32_t)((uint64_t)frame_idx * stats.frame_period_us / 1000);
+  uint32_t period = stats.frame_period_us / 1000;
+  uint32_t start;
+  uint32_t us;
+  int32_t wait;
+  int32_t offset;
+  lv_result_t res;
+
+  /* a frame which can't be on time anymore isn't decoded, so the next one can be */
+  if (frame_idx > 0 && video_now() > due + period)
+    {
+      stats.dropped++;
+      video_stream_skip(s, size + (size & 1));
+      return false;
+    }
+
+  /* the back buffer was scanned out until the last buffer change was latched */
+  while (lvgl_plane_is_pending())
+    {
+      osDelay(1);
+    }
+
+  job.in_cb = video_jpeg_in;
+  job.user_data = s;
+  job.work = work;
+  job.work_size = sizeof(work);
+  job.dst = cfg.frame_buf[*back];
+  job.dst_stride = stats.w * 2;
+  job.max_w = stats.w;
+  job.max_h = stats.h;
+
+  start = DWT->CYCCNT;
+  s->chunk_left = size;
+  res = lvgl_jpeg_decode(&job);
+  video_stream_skip(s, s->chunk_left + (size & 1));
+
+  us = (uint32_t)((uint64_t)(DWT->CYCCNT - start) * 1000000 / SystemCoreClock);
+  stats.decode_us = us;
+  stats.decode_us_max = LV_MAX(stats.decode_us_max, us);
+
+  if (res != LV_RESULT_OK)
+    {
+      stats.errors++;
+      return false;
+    }
+  stats.decoded++;
+
+  while (!stop_req && (wait = (int32_t)(due - video_now())) > 0)
+    {
+      osDelay(VIDEO_MS_TO_TICKS(wait));
+    }
+
+  if (!plane_shown)
+    {
+      plane.buf = cfg.frame_buf[*back];
+      plane.pixel_format = LTDC_PIXEL_FORMAT_RGB565;
+      plane.w = stats.w;
+      plane.h = stats.h;
+      plane.x = cfg.x;
+      plane.y = cfg.y;
+      plane.alpha = LV_OPA_COVER;
+      lvgl_plane_show(&plane);
+      plane_shown = true;
+    }
+  else
+    {
+      lvgl_plane_set_buf(cfg.frame_buf[*back]);
+    }
+  *back ^= 1;
+
+  offset = (int32_t)(video_now() - due);
+  stats.shown++;
+  stats.av_offset_ms = offset;
+  if (LV_ABS(offset) > LV_ABS(stats.av_offset_max_ms))
+    {
+      stats.av_offset_max_ms = offset;
+    }
+  pos_ms = due;
+
+  return true;
+}
+
+static uint32_t
+video_now (void)
+{
+  return (cfg.clock_cb != NULL ? cfg.clock_cb() : HAL_GetTick()) - clock_base;
+}
+
+static void
+video_stream_seek (video_stream_t *s,
+                   uint32_t        offset)
+{
+  if (s->in_flight)
+    {
+      lvgl_sd_read_wait();
+      s->in_flight = false;
+    }
+
+  s->next_block = offset / SD_BLOCK_SIZE;
+  s->pos = 0;
+  s->len = 0;
+  s->offset = offset - offset % SD_BLOCK_SIZE;
+
+  video_stream_prefetch(s);
+  if (video_stream_next(s))
+    {
+      s->pos = LV_MIN(offset % SD_BLOCK_SIZE, s->len);
+      s->offset += s->pos;
+    }
+}
+
+static void
+video_stream_prefetch (video_stream_t *s)
+{
+  uint32_t offset = s->next_block * SD_BLOCK_SIZE;
+  uint32_t lba;
+  uint32_t cnt;
+
+  if (s->in_flight || offset >= file_size)
+    {
+      return;
+    }
+
+  /* a read doesn't cross the end of a fragment */
+  lba = video_lba(s->next_block, &cnt);
+  cnt = LV_MIN(cnt, VIDEO_READ_BLOCKS);
+  cnt = LV_MIN(cnt, (file_size - offset + SD_BLOCK_SIZE - 1) / SD_BLOCK_SIZE);
+  if (cnt == 0 || lvgl_sd_read_start(lba, read_buf[s->cur ^ 1], cnt) != LV_RESULT_OK)
+    {
+      stats.errors++;
+      return;
+    }
+
+  s->next_block += cnt;
+  s->in_flight = true;
+  s->in_flight_len = LV_MIN(cnt * SD_BLOCK_SIZE, file_size - offset);
+}
+
+static bool
+video_stream_next (video_stream_t *s)
+{
+  if (!s->in_flight)
+    {
+      return false;
+    }
+
+  if (!lvgl_sd_read_is_done())
+    {
+      stats.underruns++;
+    }
+
+  s->in_flight = false;
+  if (lvgl_sd_read_wait() != LV_RESULT_OK)
+    {
+      stats.errors++;
+      return false;
+    }
+
+  s->cur ^= 1;
+  s->pos = 0;
+  s->len = s->in_flight_len;
+
+  /* the next read runs while this buffer is parsed */
+  video_stream_prefetch(s);
+
+  return true;
+}
+
+static uint32_t
+video_stream_read (video_stream_t *s,
+                   void           *buf,
+                   uint32_t        len)
+{
+  uint32_t done = 0;
+  uint32_t n;
+
+  while (done < len)
+    {
+      if (s->pos == s->len && !video_stream_next(s))
+        {
+          break;
+        }
+
+      n = LV_MIN(len - done, s->len - s->pos);
+      if (buf != NULL)
+        {
+          lv_memcpy((uint8_t *)buf + done, &read_buf[s->cur][s->pos], n);
+        }
+      s->pos += n;
+      s->offset += n;
+      done += n;
+    }
+
+  return done;
+}
+
+static bool
+video_stream_read_u32 (video_stream_t *s,
+                       uint32_t       *v)
+{
+  /* AVI is little endian like the Cortex-M */
+  return video_stream_read(s, v, sizeof(*v)) == sizeof(*v);
+}
+
+static void
+video_stream_skip (video_stream_t *s,
+                   uint32_t        len)
+{
+  /* past what's buffered or being read, the read is restarted at the target */
+  if (len > s->len - s->pos + VIDEO_READ_SIZE)
+    {
+      video_stream_seek(s, s->offset + len);
+      return;
+    }
+
+  video_stream_read(s, NULL, len);
+}
+
+static size_t
+video_jpeg_in (void    *user_data,
+               uint8_t *buf,
+               size_t   len)
+{
+  video_stream_t *s = user_data;
+  uint32_t n = video_stream_read(s, buf, LV_MIN(len, s->chunk_left));
+
+  s->chunk_left -= n;
+
+  return n;
+}
@@ -0,0 +1,415 @@
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "lvgl_port_zimg.h"
+#include "main.h"
+#include "lvgl/src/draw/lv_image_decoder_private.h"
+#if LV_USE_LZ4_INTERNAL
+  #include "lvgl/src/libs/lz4/lz4.h"
+#elif LV_USE_LZ4_EXTERNAL
+  #include <lz4.h>
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#if LV_USE_RLE == 0 && LV_USE_LZ4 == 0
+  #error "lvgl_port_zimg requires LV_USE_RLE or LV_USE_LZ4_INTERNAL/EXTERNAL"
+#endif
+
+/* method, compressed and decompressed size in front of the compressed data */
+#define ZIMG_HEADER_SIZE  12
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+  uint32_t       method;
+  uint32_t       compressed_size;
+  uint32_t       decompressed_size;
+  const uint8_t *data;
+} zimg_compressed_t;
+
+typedef struct
+{
+  uint8_t  *row;        /* output row being written */
+  uint32_t  col;        /* bytes already written to it */
+  uint32_t  row_bytes;  /* bytes of a row in the compressed stream */
+  uint32_t  stride;     /* bytes of a row in the output */
+  uint32_t  rows_left;
+} zimg_writer_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static bool
+zimg_parse (const lv_image_dsc_t *img, zimg_compressed_t *c);
+
+static bool
+zimg_is_supported (const lv_image_decoder_dsc_t *dsc, zimg_compressed_t *c);
+
+static void
+zimg_put (zimg_writer_t *w, const uint8_t *src, uint32_t len);
+
+#if LV_USE_RLE
+static bool
+zimg_rle (const zimg_compressed_t *c, lv_draw_buf_t *decoded, uint32_t src_stride, uint32_t blk_size);
+#endif
+
+#if LV_USE_LZ4
+static bool
+zimg_lz4 (const zimg_compressed_t *c, lv_draw_buf_t *decoded, uint32_t src_stride);
+#endif
+
+static lv_result_t
+zimg_info_cb (lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc, lv_image_header_t *header);
+
+static lv_result_t
+zimg_open_cb (lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc);
+
+static void
+zimg_close_cb (lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc);
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void
+lvgl_zimg_init (void)
+{
+  lv_image_decoder_t *decoder = lv_image_decoder_create();
+
+  lv_image_decoder_set_info_cb(decoder, zimg_info_cb);
+  lv_image_decoder_set_open_cb(decoder, zimg_open_cb);
+  lv_image_decoder_set_close_cb(decoder, zimg_close_cb);
+}
+
+lv_result_t
+lvgl_zimg_benchmark (const lv_image_dsc_t *src,
+                     lvgl_zimg_bench_t    *bench)
+{
+  lv_image_decoder_args_t args = {0};
+  lv_image_decoder_dsc_t dsc;
+  zimg_compressed_t c;
+  uint32_t start;
+  lv_result_t res;
+
+  if (!zimg_parse(src, &c))
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  /* a cache hit would measure nothing */
+  args.no_cache = true;
+
+  start = DWT->CYCCNT;
+  res = lv_image_decoder_open(&dsc, src, &args);
+  bench->cycles = DWT->CYCCNT - start;
+
+  if (res != LV_RESULT_OK)
+    {
+      return res;
+    }
+  lv_image_decoder_close(&dsc);
+
+  bench->compressed_size = c.compressed_size;
+  bench->decompressed_size = c.decompressed_size;
+  bench->time_us = (uint32_t)((uint64_t)bench->cycles * 1000000 / SystemCoreClock);
+  bench->kbyte_per_s = bench->time_us != 0 ?
+                       (uint32_t)((uint64_t)c.decompressed_size * 1000000 / 1024 / bench->time_us) : 0;
+
+  return LV_RESULT_OK;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static bool
+zimg_parse (const lv_image_dsc_t *img,
+            zimg_compressed_t    *c)
+{
+  uint32_t words[3];
+
+  if (!(img->header.flags & LV_IMAGE_FLAGS_COMPRESSED) || img->data_size < ZIMG_HEADER_SIZE)
+    {
+      return false;
+    }
+
+  /* the header isn't necessarily word aligned in the C array */
+  lv_memcpy(words, img->data, sizeof(words));
+  c->method = words[0] & 0xF;
+  c->compressed_size = words[1];
+  c->decompressed_size = words[2];
+  c->data = img->data + ZIMG_HEADER_SIZE;
+
+  return c->compressed_size <= img->data_size - ZIMG_HEADER_SIZE;
+}
+
+static bool
+zimg_is_supported (const lv_image_decoder_dsc_t *dsc,
+                   zimg_compressed_t            *c)
+{
+  const lv_image_dsc_t *img = dsc->src;
+
+  /* files go through the bin decoder which has to read them to RAM anyway */
+  if (dsc->src_type != LV_IMAGE_SRC_VARIABLE || !zimg_parse(img, c))
+    {
+      return false;
+    }
+
+  /* single plane formats, the rows can be moved to the GPU stride independently */
+  switch (img->header.cf)
+    {
+      case LV_COLOR_FORMAT_RGB565:
+      case LV_COLOR_FORMAT_RGB888:
+      case LV_COLOR_FORMAT_ARGB8888:
+      case LV_COLOR_FORMAT_XRGB8888:
+      case LV_COLOR_FORMAT_ARGB8565:
+      case LV_COLOR_FORMAT_AL88:
+      case LV_COLOR_FORMAT_L8:
+      case LV_COLOR_FORMAT_A8:
+        break;
+      default:
+        return false;
+    }
+
+#if LV_USE_RLE
+  if (c->method == LV_IMAGE_COMPRESS_RLE)
+    {
+      return true;
+    }
+#endif
+#if LV_USE_LZ4
+  if (c->method == LV_IMAGE_COMPRESS_LZ4)
+    {
+      return true;
+    }
+#endif
+
+  return false;
+}
+
+static void
+zimg_put (zimg_writer_t *w,
+          const uint8_t *src,
+          uint32_t       len)
+{
+  uint32_t n;
+
+  while (len > 0 && w->rows_left > 0)
+    {
+      n = LV_MIN(len, w->row_bytes - w->col);
+      lv_memcpy(w->row + w->col, src, n);
+      w->col += n;
+      src += n;
+      len -= n;
+
+      if (w->col == w->row_bytes)
+        {
+          w->row += w->stride;
+          w->col = 0;
+          w->rows_left--;
+        }
+    }
+}
+
+#if LV_USE_RLE
+static bool
+zimg_rle (const zimg_compressed_t *c,
+          lv_draw_buf_t           *decoded,
+          uint32_t                 src_stride,
+          uint32_t                 blk_size)
+{
+  const uint8_t *in = c->data;
+  const uint8_t *end = c->data + c->compressed_size;
+  zimg_writer_t w;
+  uint32_t ctrl;
+  uint32_t len;
+
+  w.row = decoded->data;
+  w.col = 0;
+  w.row_bytes = src_stride;
+  w.stride = decoded->header.stride;
+  w.rows_left = decoded->header.h;
+
+  /* runs are written line by line at the output stride as they are decoded,
+   * so the flash is read once and nothing is staged */
+  while (in < end && w.rows_left > 0)
+    {
+      ctrl = *in++;
+      if (ctrl & 0x80)
+        {
+          len = (ctrl & 0x7F) * blk_size;
+          if (len > (uint32_t)(end - in))
+            {
+              return false;
+            }
+          zimg_put(&w, in, len);
+          in += len;
+        }
+      else
+        {
+          if (blk_size > (uint32_t)(end - in))
+            {
+              return false;
+            }
+          for (; ctrl > 0; ctrl--)
+            {
+              zimg_put(&w, in, blk_size);
+            }
+          in += blk_size;
+        }
+    }
+
+  return w.rows_left == 0;
+}
+#endif
+
+#if LV_USE_LZ4
+static bool
+zimg_lz4 (const zimg_compressed_t *c,
+          lv_draw_buf_t           *decoded,
+          uint32_t                 src_stride)
+{
+  uint32_t stride = decoded->header.stride;
+  uint32_t y;
+  int len;
+
+  /* LZ4 matches refer back into the output, so it's decoded in one go into the
+   * final buffer which is at least as large as the packed image */
+  len = LZ4_decompress_safe((const char *)c->data, (char *)decoded->data,
+                            (int)c->compressed_size, (int)c->decompressed_size);
+  if (len != (int)c->decompressed_size)
+    {
+      return false;
+    }
+
+  /* spread the rows to the output stride in place, from the last one */
+  if (stride != src_stride)
+    {
+      for (y = decoded->header.h - 1; y > 0; y--)
+        {
+          lv_memmove(decoded->data + y * stride, decoded->data + y * src_stride, src_stride);
+        }
+    }
+
+  return true;
+}
+#endif
+
+static lv_result_t
+zimg_info_cb (lv_image_decoder_t     *decoder,
+              lv_image_decoder_dsc_t *dsc,
+              lv_image_header_t      *header)
+{
+  zimg_compressed_t c;
+
+  LV_UNUSED(decoder);
+
+  if (!zimg_is_supported(dsc, &c))
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  *header = ((const lv_image_dsc_t *)dsc->src)->header;
+  header->flags &= ~LV_IMAGE_FLAGS_COMPRESSED;
+  header->stride = lv_draw_buf_width_to_stride(header->w, header->cf);
+
+  return LV_RESULT_OK;
+}
+
+static lv_result_t
+zimg_open_cb (lv_image_decoder_t     *decoder,
+              lv_image_decoder_dsc_t *dsc)
+{
+  const lv_image_dsc_t *img = dsc->src;
+  uint32_t bpp = lv_color_format_get_bpp(img->header.cf);
+  uint32_t src_stride = img->header.stride != 0 ? img->header.stride : (img->header.w * bpp + 7) / 8;
+  lv_image_cache_data_t search_key;
+  lv_cache_entry_t *entry;
+  zimg_compressed_t c;
+  lv_draw_buf_t *decoded;
+  bool ok = false;
+
+  if (!zimg_is_supported(dsc, &c) || c.decompressed_size != src_stride * img->header.h)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  /* allocated with the image handlers, i.e. in the image cache arena */
+  decoded = lv_draw_buf_create_ex(lv_draw_buf_get_image_handlers(), img->header.w, img->header.h,
+                                  img->header.cf, LV_STRIDE_AUTO);
+  if (decoded == NULL)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  if (decoded->header.stride >= src_stride)
+    {
+#if LV_USE_RLE
+      if (c.method == LV_IMAGE_COMPRESS_RLE)
+        {
+          ok = zimg_rle(&c, decoded, src_stride, (bpp + 7) / 8);
+        }
+#endif
+#if LV_USE_LZ4
+      if (c.method == LV_IMAGE_COMPRESS_LZ4)
+        {
+          ok = zimg_lz4(&c, decoded, src_stride);
+        }
+#endif
+    }
+
+  if (!ok)
+    {
+      LV_LOG_WARN("corrupt compressed image %p", (const void *)img);
+      lv_draw_buf_destroy(decoded);
+      return LV_RESULT_INVALID;
+    }
+
+  lv_draw_buf_flush_cache(decoded, NULL);
+  dsc->decoded = decoded;
+
+  if (dsc->args.no_cache || !lv_image_cache_is_enabled())
+    {
+      return LV_RESULT_OK;
+    }
+
+  /* decompressed once, later draws sample it from the cache */
+  search_key.src_type = dsc->src_type;
+  search_key.src = dsc->src;
+  search_key.slot.size = decoded->data_size;
+
+  entry = lv_image_decoder_add_to_cache(decoder, &search_key, decoded, NULL);
+  if (entry == NULL)
+    {
+      lv_draw_buf_destroy(decoded);
+      dsc->decoded = NULL;
+      return LV_RESULT_INVALID;
+    }
+  dsc->cache_entry = entry;
+
+  return LV_RESULT_OK;
+}
+
+static void
+zimg_close_cb (lv_image_decoder_t     *decoder,
+               lv_image_decoder_dsc_t *dsc)
+{
+  LV_UNUSED(decoder);
+
+  /* cached buffers are freed by the cache on eviction */
+  if (dsc->args.no_cache || !lv_image_cache_is_enabled())
+    {
+      lv_draw_buf_destroy((lv_draw_buf_t *)dsc->decoded);
+    }
+}
@@ -51,6 +51,7 @@
 #include "lvgl/demos/lv_demos.h"
 #include "lvgl_port_touch.h"
 #include "lvgl_port_display.h"
+#include "lvgl_port_boot.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -118,69 +119,67 @@ int main(void)
 	SystemPower_Config();
 
 	/* USER CODE BEGIN SysInit */
+	/* the boot stages are timed from here, the clock doesn't change anymore */
+	lvgl_boot_init();
 
 	/* USER CODE END SysInit */
 
 	/* Initialize all configured peripherals */
 	MX_GPIO_Init();
-	MX_ADC1_Init();
-	MX_ADC2_Init();
-	MX_CORDIC_Init();
 	MX_CRC_Init();
-	MX_DAC1_Init();
 	MX_DCACHE1_Init();
 	// MX_DCACHE2_Init();
 	MX_DMA2D_Init();
-	MX_FDCAN1_Init();
 	MX_GPU2D_Init();
-	MX_HASH_Init();
 	MX_I2C1_Init();
-	MX_I2C2_Init();
-	MX_I2C4_Init();
 	MX_ICACHE_Init();
-	MX_LPTIM2_Init();
 	MX_LTDC_Init();
-	MX_OCTOSPI1_Init();
-	MX_RNG_Init();
-	MX_RTC_Init();
-	MX_SPI1_Init();
-	MX_SPI2_Init();
-	MX_TIM3_Init();
-	MX_TIM5_Init();
-	MX_TIM6_Init();
-	MX_TIM8_Init();
 	MX_TIM15_Init();
-	MX_USART1_UART_Init();
-	MX_USART3_UART_Init();
-	MX_USART6_UART_Init();
-	MX_USB_OTG_HS_USB_Init();
 //	MX_FLASH_Init();    /*If enabled Nema (NeoChrome) can't read the images and fonts from flash*/
 
 	/* Initialize interrupts */
 	MX_NVIC_Init();
 	/* USER CODE BEGIN 2 */
+	/* only the peripherals of the display are initialized here, the OSPI after
+	 * the splash and the others in Deferred_Init() by a low priority task once
+	 * the kernel runs */
+	lvgl_boot_mark("peripherals");
+
+	/* the port modules create their mutexes, queues and tasks from here on, which
+	 * needs the kernel initialized. The call below then returns osError. */
+	osKernelInitialize();
+
+	/* reset display */
+	HAL_GPIO_WritePin(LCD_DISP_RESET_GPIO_Port, LCD_DISP_RESET_Pin, GPIO_PIN_SET);
+
+	/* the backlight is turned on when the panel shows a defined image */
+	lvgl_boot_splash();
+
 	if (HAL_TIM_PWM_Start(&htim15, TIM_CHANNEL_1) != HAL_OK)
 	{
 		/* PWM Generation Error */
 		Error_Handler();
 	}
+	lvgl_boot_mark("splash");
 
-	/* reset display */
-	HAL_GPIO_WritePin(LCD_DISP_RESET_GPIO_Port, LCD_DISP_RESET_Pin, GPIO_PIN_SET);
+	/* the reset and the octal mode switch of the NOR take some 140 ms, the
+	 * splash is on the screen meanwhile */
+	MX_OCTOSPI1_Init();
+	lvgl_boot_mark("ospi");
 
 	/* initialize LVGL framework */
 	lv_init();
 //	while(1);
 	lv_tick_set_cb(HAL_GetTick);
+	lvgl_boot_mark("lvgl");
 
 	/* initialize display and touchscreen */
 	lvgl_display_init();
 	lvgl_touchscreen_init();
+	lvgl_boot_watch(lv_display_get_default());
+	lvgl_boot_mark("display");
 
-	/* lvgl demo */
-	//  lv_demo_widgets();
-	//lv_demo_music();
-	lv_demo_benchmark();
+	/* the UI is created by the LVGL task, see LVGLTimer() */
 
 	/* USER CODE END 2 */
 
@@ -330,6 +329,33 @@ static void MX_NVIC_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+/**
+ * @brief  Peripherals which aren't needed for the first frame, their calls
+ *         aren't generated in main() (.ioc: Project Manager => Advanced Settings)
+ * @retval None
+ */
+void Deferred_Init(void)
+{
+	static void (*const inits[])(void) =
+	{
+		MX_ADC1_Init, MX_ADC2_Init, MX_CORDIC_Init, MX_DAC1_Init, MX_FDCAN1_Init,
+		MX_HASH_Init, MX_I2C2_Init, MX_I2C4_Init, MX_LPTIM2_Init, MX_RNG_Init,
+		MX_RTC_Init, MX_SPI1_Init, MX_SPI2_Init, MX_TIM3_Init, MX_TIM5_Init,
+		MX_TIM6_Init, MX_TIM8_Init, MX_USART1_UART_Init, MX_USART3_UART_Init,
+		MX_USART6_UART_Init, MX_USB_OTG_HS_USB_Init,
+	};
+	uint32_t i;
+
+	/* the MSP functions read-modify-write the RCC registers, which the LVGL task
+	 * also does, e.g. when the SD card is initialized. Each init runs with the
+	 * scheduler locked, HAL_Delay() still counts with the TIM2 interrupt. */
+	for (i = 0; i < sizeof(inits) / sizeof(inits[0]); i++)
+	{
+		osKernelLock();
+		inits[i]();
+		osKernelUnlock();
+	}
+}
 
 /* USER CODE END 4 */
 
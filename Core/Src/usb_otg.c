@@ -22,6 +22,9 @@
 
 /* USER CODE BEGIN 0 */
 
+/* the device of lvgl_port_usb.c, the peripheral is left to it by CubeMX */
+PCD_HandleTypeDef hpcd_USB_OTG_HS;
+
 /* USER CODE END 0 */
 
 /* USB_OTG_HS init function */
@@ -37,11 +40,79 @@ void MX_USB_OTG_HS_USB_Init(void)
 
   /* USER CODE END USB_OTG_HS_Init 1 */
   /* USER CODE BEGIN USB_OTG_HS_Init 2 */
-
+  hpcd_USB_OTG_HS.Instance = USB_OTG_HS;
+  hpcd_USB_OTG_HS.Init.dev_endpoints = 9;
+  hpcd_USB_OTG_HS.Init.speed = PCD_SPEED_HIGH;
+  hpcd_USB_OTG_HS.Init.phy_itface = USB_OTG_HS_EMBEDDED_PHY;
+  hpcd_USB_OTG_HS.Init.dma_enable = DISABLE;
+  hpcd_USB_OTG_HS.Init.Sof_enable = DISABLE;
+  hpcd_USB_OTG_HS.Init.low_power_enable = DISABLE;
+  hpcd_USB_OTG_HS.Init.lpm_enable = DISABLE;
+  hpcd_USB_OTG_HS.Init.battery_charging_enable = DISABLE;
+  hpcd_USB_OTG_HS.Init.vbus_sensing_enable = DISABLE;
+  hpcd_USB_OTG_HS.Init.use_dedicated_ep1 = DISABLE;
+  hpcd_USB_OTG_HS.Init.use_external_vbus = DISABLE;
+  if (HAL_PCD_Init(&hpcd_USB_OTG_HS) != HAL_OK)
+  {
+    Error_Handler();
+  }
   /* USER CODE END USB_OTG_HS_Init 2 */
 
 }
 
 /* USER CODE BEGIN 1 */
 
+void HAL_PCD_MspInit(PCD_HandleTypeDef* pcdHandle)
+{
+  RCC_PeriphCLKInitTypeDef PeriphClkInit = {0};
+
+  if(pcdHandle->Instance==USB_OTG_HS)
+  {
+    /* the embedded HS PHY runs from the 16 MHz HSE */
+    PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_USBPHY;
+    PeriphClkInit.UsbPhyClockSelection = RCC_USBPHYCLKSOURCE_HSE;
+    if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) != HAL_OK)
+    {
+      Error_Handler();
+    }
+    /* the SYSCFG holds the PHY's reference clock and enable bits */
+    __HAL_RCC_SYSCFG_CLK_ENABLE();
+    HAL_SYSCFG_SetOTGPHYReferenceClockSelection(SYSCFG_OTG_HS_PHY_CLK_SELECT_1);
+
+    __HAL_RCC_USB_OTG_HS_CLK_ENABLE();
+    __HAL_RCC_USBPHYC_CLK_ENABLE();
+
+    /* VDDUSB and the supply of the HS transceiver */
+    if(__HAL_RCC_PWR_IS_CLK_DISABLED())
+    {
+      __HAL_RCC_PWR_CLK_ENABLE();
+      HAL_PWREx_EnableVddUSB();
+      HAL_PWREx_EnableUSBHSTranceiverSupply();
+      __HAL_RCC_PWR_CLK_DISABLE();
+    }
+    else
+    {
+      HAL_PWREx_EnableVddUSB();
+      HAL_PWREx_EnableUSBHSTranceiverSupply();
+    }
+
+    HAL_SYSCFG_EnableOTGPHY(SYSCFG_OTG_HS_PHY_ENABLE);
+
+    HAL_NVIC_SetPriority(OTG_HS_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(OTG_HS_IRQn);
+  }
+}
+
+void HAL_PCD_MspDeInit(PCD_HandleTypeDef* pcdHandle)
+{
+  if(pcdHandle->Instance==USB_OTG_HS)
+  {
+    __HAL_RCC_USB_OTG_HS_CLK_DISABLE();
+    __HAL_RCC_USBPHYC_CLK_DISABLE();
+    HAL_SYSCFG_EnableOTGPHY(SYSCFG_OTG_HS_PHY_UNDERRESET);
+
+    HAL_NVIC_DisableIRQ(OTG_HS_IRQn);
+  }
+}
+
 /* USER CODE END 1 */
@@ -0,0 +1,168 @@
+/* The parts of the CMSIS-RTOS2 API which the port modules built into the host tools
+ * use, with one task and no scheduler. Put Tools/host in front of the include path. */
+
+#ifndef CMSIS_OS2_H_
+#define CMSIS_OS2_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef void *osMutexId_t;
+typedef void *osThreadId_t;
+
+/* a count, acquiring an empty one times out at once as nothing could release it */
+typedef struct
+{
+  uint32_t max;
+  uint32_t count;
+} host_sem_t;
+
+typedef host_sem_t *osSemaphoreId_t;
+
+typedef enum
+{
+  osPriorityLow = 8,
+  osPriorityBelowNormal = 16,
+  osPriorityNormal = 24,
+} osPriority_t;
+
+typedef struct
+{
+  const char  *name;
+  uint32_t     attr_bits;
+  void        *cb_mem;
+  uint32_t     cb_size;
+  void        *stack_mem;
+  uint32_t     stack_size;
+  osPriority_t priority;
+} osThreadAttr_t;
+
+typedef struct
+{
+  const char *name;
+  uint32_t    attr_bits;
+  void       *cb_mem;
+  uint32_t    cb_size;
+} osSemaphoreAttr_t;
+
+typedef void (*osThreadFunc_t)(void *argument);
+
+typedef enum
+{
+  osOK = 0,
+  osError = -1,
+  osErrorTimeout = -2,
+  osErrorResource = -3,
+} osStatus_t;
+
+typedef enum
+{
+  osKernelInactive = 0,
+  osKernelRunning = 2,
+} osKernelState_t;
+
+#define osWaitForever            0xFFFFFFFFU
+
+/* no scheduler, so the modules skip their locks */
+static inline osKernelState_t
+osKernelGetState (void)
+{
+  return osKernelInactive;
+}
+
+static inline osMutexId_t
+osMutexNew (const void *attr)
+{
+  (void)attr;
+  return (osMutexId_t)1;
+}
+
+static inline osStatus_t
+osMutexAcquire (osMutexId_t mutex_id,
+                uint32_t    timeout)
+{
+  (void)mutex_id;
+  (void)timeout;
+  return osOK;
+}
+
+static inline osStatus_t
+osMutexRelease (osMutexId_t mutex_id)
+{
+  (void)mutex_id;
+  return osOK;
+}
+
+static inline osSemaphoreId_t
+osSemaphoreNew (uint32_t                 max_count,
+                uint32_t                 initial_count,
+                const osSemaphoreAttr_t *attr)
+{
+  static host_sem_t sems[16];
+  static uint32_t sem_cnt;
+
+  (void)attr;
+  if (sem_cnt == sizeof(sems) / sizeof(sems[0]))
+    {
+      return NULL;
+    }
+  sems[sem_cnt].max = max_count;
+  sems[sem_cnt].count = initial_count;
+
+  return &sems[sem_cnt++];
+}
+
+static inline osStatus_t
+osSemaphoreAcquire (osSemaphoreId_t semaphore_id,
+                    uint32_t        timeout)
+{
+  (void)timeout;
+  if (semaphore_id->count == 0)
+    {
+      return osErrorTimeout;
+    }
+  semaphore_id->count--;
+
+  return osOK;
+}
+
+static inline osStatus_t
+osSemaphoreRelease (osSemaphoreId_t semaphore_id)
+{
+  if (semaphore_id->count == semaphore_id->max)
+    {
+      return osErrorResource;
+    }
+  semaphore_id->count++;
+
+  return osOK;
+}
+
+/* no tasks are started on the host */
+static inline osThreadId_t
+osThreadNew (osThreadFunc_t        func,
+             void                 *argument,
+             const osThreadAttr_t *attr)
+{
+  (void)func;
+  (void)argument;
+  (void)attr;
+  return NULL;
+}
+
+static inline osStatus_t
+osDelay (uint32_t ticks)
+{
+  (void)ticks;
+  return osOK;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CMSIS_OS2_H_ */
@@ -0,0 +1,126 @@
+/* The parts of the FDCAN HAL which the port modules built into the host tools use.
+ * The filter elements are programmed by the host tool, which defines
+ * HAL_FDCAN_ConfigFilter() and hfdcan1. Put Tools/host in front of Core/Inc in the
+ * include path. */
+
+#ifndef __FDCAN_H__
+#define __FDCAN_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "main.h"
+
+#define FDCAN_STANDARD_ID                 0x00000000U
+#define FDCAN_EXTENDED_ID                 0x40000000U
+
+#define FDCAN_FILTER_RANGE                0x00000000U
+#define FDCAN_FILTER_DUAL                 0x00000001U
+
+#define FDCAN_FILTER_TO_RXFIFO0           0x00000001U
+#define FDCAN_FILTER_TO_RXFIFO1           0x00000002U
+
+#define FDCAN_REJECT                      0x00000002U
+#define FDCAN_REJECT_REMOTE               0x00000001U
+
+#define FDCAN_RX_FIFO0                    0x00000000U
+#define FDCAN_RX_FIFO1                    0x00000001U
+#define FDCAN_RX_FIFO_OVERWRITE           0x00000080U
+
+#define FDCAN_IT_RX_FIFO0_NEW_MESSAGE     0x00000001U
+#define FDCAN_IT_RX_FIFO0_MESSAGE_LOST    0x00000004U
+#define FDCAN_IT_RX_FIFO1_NEW_MESSAGE     0x00000008U
+#define FDCAN_IT_RX_FIFO1_MESSAGE_LOST    0x00000020U
+
+#define FDCAN_RXF0S_F0FL                  0x0000000FU
+#define FDCAN_RXF0S_F0GI_Pos              8U
+#define FDCAN_RXF0S_F0GI                  0x00000300U
+#define FDCAN_RXF0S_F0F                   0x01000000U
+
+typedef struct
+{
+  volatile uint32_t RXF0S;
+  volatile uint32_t RXF0A;
+  volatile uint32_t RXF1S;
+  volatile uint32_t RXF1A;
+} FDCAN_GlobalTypeDef;
+
+/* addresses, which take 64 bits on the host */
+typedef struct
+{
+  uintptr_t RxFIFO0SA;
+  uintptr_t RxFIFO1SA;
+} FDCAN_MsgRamAddressTypeDef;
+
+typedef struct
+{
+  FDCAN_GlobalTypeDef       *Instance;
+  FDCAN_MsgRamAddressTypeDef msgRam;
+} FDCAN_HandleTypeDef;
+
+typedef struct
+{
+  uint32_t IdType;
+  uint32_t FilterIndex;
+  uint32_t FilterType;
+  uint32_t FilterConfig;
+  uint32_t FilterID1;
+  uint32_t FilterID2;
+} FDCAN_FilterTypeDef;
+
+extern FDCAN_HandleTypeDef hfdcan1;
+
+HAL_StatusTypeDef
+HAL_FDCAN_ConfigFilter (FDCAN_HandleTypeDef *hfdcan, const FDCAN_FilterTypeDef *filter);
+
+static inline HAL_StatusTypeDef
+HAL_FDCAN_ConfigGlobalFilter (FDCAN_HandleTypeDef *hfdcan,
+                              uint32_t             non_matching_std,
+                              uint32_t             non_matching_ext,
+                              uint32_t             reject_remote_std,
+                              uint32_t             reject_remote_ext)
+{
+  (void)hfdcan;
+  (void)non_matching_std;
+  (void)non_matching_ext;
+  (void)reject_remote_std;
+  (void)reject_remote_ext;
+  return HAL_OK;
+}
+
+static inline HAL_StatusTypeDef
+HAL_FDCAN_ConfigRxFifoOverwrite (FDCAN_HandleTypeDef *hfdcan,
+                                 uint32_t             fifo,
+                                 uint32_t             mode)
+{
+  (void)hfdcan;
+  (void)fifo;
+  (void)mode;
+  return HAL_OK;
+}
+
+static inline HAL_StatusTypeDef
+HAL_FDCAN_ActivateNotification (FDCAN_HandleTypeDef *hfdcan,
+                                uint32_t             its,
+                                uint32_t             buffer_indexes)
+{
+  (void)hfdcan;
+  (void)its;
+  (void)buffer_indexes;
+  return HAL_OK;
+}
+
+static inline HAL_StatusTypeDef
+HAL_FDCAN_Start (FDCAN_HandleTypeDef *hfdcan)
+{
+  (void)hfdcan;
+  return HAL_OK;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FDCAN_H__ */
@@ -0,0 +1,62 @@
+/* The parts of the HASH HAL which lvgl_port_update uses. Put Tools/host in front of
+ * Core/Inc in the include path. The functions are defined by the host tool, e.g. with
+ * a software SHA-256 which models the multi-buffer DMA mode (MDMAT). */
+
+#ifndef __HASH_H__
+#define __HASH_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "main.h"
+
+typedef enum
+{
+  HAL_HASH_STATE_RESET = 0,
+  HAL_HASH_STATE_READY = 1,
+} HAL_HASH_StateTypeDef;
+
+typedef struct
+{
+  uint32_t dummy;
+} DMA_HandleTypeDef;
+
+typedef struct
+{
+  HAL_HASH_StateTypeDef State;
+  DMA_HandleTypeDef    *hdmain;
+} HASH_HandleTypeDef;
+
+extern HASH_HandleTypeDef hhash;
+
+/* MDMAT, more DMA transfers follow the current one */
+extern int host_hash_mdmat;
+
+#define __HAL_HASH_SET_MDMAT()    (host_hash_mdmat = 1)
+#define __HAL_HASH_RESET_MDMAT()  (host_hash_mdmat = 0)
+
+HAL_StatusTypeDef
+HAL_HASH_Init (HASH_HandleTypeDef *hhash_p);
+
+HAL_StatusTypeDef
+HAL_HASHEx_SHA256_Start_DMA (HASH_HandleTypeDef *hhash_p, uint8_t *in, uint32_t size);
+
+HAL_StatusTypeDef
+HAL_HASHEx_SHA256_Finish (HASH_HandleTypeDef *hhash_p, uint8_t *out, uint32_t timeout);
+
+HAL_StatusTypeDef
+HAL_DMA_Abort (DMA_HandleTypeDef *hdma);
+
+void
+HAL_HASH_InCpltCallback (HASH_HandleTypeDef *hhash_p);
+
+void
+HAL_HASH_ErrorCallback (HASH_HandleTypeDef *hhash_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HASH_H__ */
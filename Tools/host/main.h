@@ -0,0 +1,83 @@
+/* The parts of main.h and of the CMSIS device header which the port modules built
+ * into the host tools use. Put Tools/host in front of Core/Inc in the include path,
+ * so it's found instead of the one of the firmware. The cycle counter doesn't count,
+ * the host tools time with the host's clock. */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+typedef struct
+{
+  volatile uint32_t CTRL;
+  volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+  volatile uint32_t DEMCR;
+} DCB_Type;
+
+static DWT_Type host_dwt __attribute__((unused));
+static DCB_Type host_dcb __attribute__((unused));
+
+#define DWT                      (&host_dwt)
+#define DCB                      (&host_dcb)
+#define DWT_CTRL_CYCCNTENA_Msk   (1UL << 0)
+#define DCB_DEMCR_TRCENA_Msk     (1UL << 24)
+
+#define SystemCoreClock          160000000UL
+
+typedef enum
+{
+  HAL_OK = 0,
+  HAL_ERROR = 1,
+  HAL_BUSY = 2,
+  HAL_TIMEOUT = 3,
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+  FDCAN1_IT0_IRQn = 39,
+  USART1_IRQn = 61,
+} IRQn_Type;
+
+/* the HAL's time base doesn't advance */
+static inline uint32_t
+HAL_GetTick (void)
+{
+  return 0;
+}
+
+static inline void
+HAL_NVIC_SetPriority (IRQn_Type irqn,
+                      uint32_t  preempt,
+                      uint32_t  sub)
+{
+  (void)irqn;
+  (void)preempt;
+  (void)sub;
+}
+
+static inline void
+HAL_NVIC_EnableIRQ (IRQn_Type irqn)
+{
+  (void)irqn;
+}
+
+static inline void
+HAL_NVIC_DisableIRQ (IRQn_Type irqn)
+{
+  (void)irqn;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MAIN_H */
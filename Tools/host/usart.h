@@ -0,0 +1,87 @@
+/* The parts of the UART HAL which the port modules built into the host tools use,
+ * nothing is received or sent. Put Tools/host in front of Core/Inc in the include path. */
+
+#ifndef __USART_H__
+#define __USART_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "main.h"
+
+typedef struct
+{
+  uint32_t BaudRate;
+} UART_InitTypeDef;
+
+typedef struct __UART_HandleTypeDef
+{
+  UART_InitTypeDef Init;
+} UART_HandleTypeDef;
+
+typedef enum
+{
+  HAL_UART_RX_COMPLETE_CB_ID = 0x03,
+  HAL_UART_ERROR_CB_ID = 0x06,
+} HAL_UART_CallbackIDTypeDef;
+
+typedef void (*pUART_CallbackTypeDef)(UART_HandleTypeDef *huart);
+
+static UART_HandleTypeDef huart1 __attribute__((unused));
+
+static inline HAL_StatusTypeDef
+HAL_UART_Init (UART_HandleTypeDef *huart)
+{
+  (void)huart;
+  return HAL_ERROR;
+}
+
+static inline HAL_StatusTypeDef
+HAL_UART_RegisterCallback (UART_HandleTypeDef        *huart,
+                           HAL_UART_CallbackIDTypeDef id,
+                           pUART_CallbackTypeDef      cb)
+{
+  (void)huart;
+  (void)id;
+  (void)cb;
+  return HAL_ERROR;
+}
+
+static inline HAL_StatusTypeDef
+HAL_UART_Receive_IT (UART_HandleTypeDef *huart,
+                     uint8_t            *buf,
+                     uint16_t            size)
+{
+  (void)huart;
+  (void)buf;
+  (void)size;
+  return HAL_ERROR;
+}
+
+static inline HAL_StatusTypeDef
+HAL_UART_AbortReceive (UART_HandleTypeDef *huart)
+{
+  (void)huart;
+  return HAL_OK;
+}
+
+static inline HAL_StatusTypeDef
+HAL_UART_Transmit (UART_HandleTypeDef *huart,
+                   const uint8_t      *buf,
+                   uint16_t            size,
+                   uint32_t            timeout)
+{
+  (void)huart;
+  (void)buf;
+  (void)size;
+  (void)timeout;
+  return HAL_ERROR;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USART_H__ */
@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+"""Pack images, fonts and strings into an asset bundle for lvgl_port_bundle.
+
+The bundle is flashed to the memory-mapped octal NOR (BUNDLE_ADDR) and its
+images and strings are used in place by name, e.g. `lv_image_set_src(img,
+"B:icons/home")`. Fonts are read into RAM by lv_binfont_create("B:...").
+Images are LVGL binary images (LVGLImage.py --ofmt BIN), fonts LVGL binary
+fonts (lv_font_conv --format bin). Names are the paths relative to --root
+without the extension.
+
+    lvgl_bundle.py -o assets.lvpk --root assets --image assets/icons/*.bin \\
+                   --font assets/fonts/*.fnt --string assets/text/*.txt
+    STM32_Programmer_CLI -c port=SWD -el <MX25LM51245G loader> -w assets.lvpk 0x90000000
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = 0x4B50564C  # "LVPK"
+VERSION = 1
+MIN_ALIGN = 32
+
+TYPE_BLOB = 0
+TYPE_IMAGE = 1
+TYPE_FONT = 2
+TYPE_STRING = 3
+
+IMAGE_HEADER_MAGIC = 0x19
+
+HEADER = struct.Struct("<IHHIIIIII")
+ENTRY = struct.Struct("<IIIBBHHHHH")
+IMAGE_HEADER = struct.Struct("<BBHHHHH")
+
+FNV_BASIS = 0x811C9DC5
+FNV_PRIME = 0x01000193
+
+# seeds tried per bucket before giving up, a few hundred are enough in practice
+MAX_SEED = 1 << 20
+
+
+def fnv(name, seed):
+    """FNV-1a with the seed mixed into the offset basis, as bundle_hash()"""
+    h = FNV_BASIS ^ seed
+    for b in name.encode("utf-8"):
+        h ^= b
+        h = (h * FNV_PRIME) & 0xFFFFFFFF
+    return h
+
+
+def perfect_hash(names):
+    """Hash and displace: every bucket of the 1st hash gets a seed which puts
+    its names on free slots with the 2nd hash. Returns the seeds and the slot of each name."""
+    n = len(names)
+    buckets = [[] for _ in range(n)]
+    for name in names:
+        buckets[fnv(name, 0) % n].append(name)
+
+    seeds = [0] * n
+    slots = {}
+    taken = [False] * n
+
+    # the largest buckets are placed first while most slots are free
+    for b in sorted(range(n), key=lambda i: -len(buckets[i])):
+        bucket = buckets[b]
+        if not bucket:
+            continue
+        for seed in range(1, MAX_SEED):
+            pos = [fnv(name, seed) % n for name in bucket]
+            if len(set(pos)) == len(pos) and not any(taken[p] for p in pos):
+                break
+        else:
+            sys.exit("no perfect hash found for %s" % bucket)
+        seeds[b] = seed
+        for name, p in zip(bucket, pos):
+            slots[name] = p
+            taken[p] = True
+
+    return seeds, slots
+
+
+def lookup(seeds, name):
+    n = len(seeds)
+    return fnv(name, seeds[fnv(name, 0) % n]) % n
+
+
+def asset_name(path, root):
+    name = os.path.relpath(path, root) if root else os.path.basename(path)
+    return os.path.splitext(name)[0].replace(os.sep, "/")
+
+
+def load_image(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < IMAGE_HEADER.size:
+        sys.exit("%s: too short for an LVGL image" % path)
+    magic, cf, flags, w, h, stride, _ = IMAGE_HEADER.unpack_from(data)
+    if magic != IMAGE_HEADER_MAGIC:
+        sys.exit("%s: not an LVGL v9 binary image" % path)
+    return dict(type=TYPE_IMAGE, cf=cf, flags=flags, w=w, h=h, stride=stride,
+                data=data[IMAGE_HEADER.size:])
+
+
+def load_file(path, kind):
+    with open(path, "rb") as f:
+        data = f.read()
+    if kind == TYPE_STRING:
+        data += b"\0"
+    return dict(type=kind, cf=0, flags=0, w=0, h=0, stride=0, data=data)
+
+
+def align_up(v, align):
+    return (v + align - 1) // align * align
+
+
+def pack(assets, align):
+    names = sorted(assets)
+    n = len(names)
+    seeds, slots = perfect_hash(names)
+
+    # the index is checked the way the firmware reads it
+    for name in names:
+        if lookup(seeds, name) != slots[name]:
+            sys.exit("%s: index lookup mismatch" % name)
+
+    seeds_off = HEADER.size
+    entries_off = seeds_off + 4 * n
+    names_off = entries_off + ENTRY.size * n
+
+    name_table = b""
+    name_offs = {}
+    for name in names:
+        name_offs[name] = len(name_table)
+        name_table += name.encode("utf-8") + b"\0"
+
+    pos = align_up(names_off + len(name_table), align)
+    data_offs = {}
+    payload = b""
+    for name in names:
+        data_offs[name] = pos
+        data = assets[name]["data"]
+        payload += data + b"\0" * (align_up(len(data), align) - len(data))
+        pos += align_up(len(data), align)
+
+    entries = [None] * n
+    for name in names:
+        a = assets[name]
+        entries[slots[name]] = ENTRY.pack(name_offs[name], data_offs[name], len(a["data"]),
+                                          a["type"], a["cf"], a["flags"], a["w"], a["h"],
+                                          a["stride"], 0)
+
+    out = HEADER.pack(MAGIC, VERSION, align, n, seeds_off, entries_off, names_off, pos, 0)
+    out += struct.pack("<%dI" % n, *seeds)
+    out += b"".join(entries)
+    out += name_table
+    out += b"\0" * (align_up(len(out), align) - len(out))
+    out += payload
+    assert len(out) == pos
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("-o", "--output", required=True, help="bundle file")
+    parser.add_argument("--root", help="asset names are relative to this directory")
+    parser.add_argument("--image", nargs="*", default=[], help="LVGL binary images")
+    parser.add_argument("--font", nargs="*", default=[], help="LVGL binary fonts")
+    parser.add_argument("--string", nargs="*", default=[], help="UTF-8 text files")
+    parser.add_argument("--blob", nargs="*", default=[], help="any other file")
+    parser.add_argument("--align", type=int, default=64,
+                        help="payload alignment, a power of 2 of at least %d" % MIN_ALIGN)
+    args = parser.parse_args()
+
+    if args.align < MIN_ALIGN or args.align & (args.align - 1):
+        sys.exit("--align has to be a power of 2 of at least %d" % MIN_ALIGN)
+
+    assets = {}
+    inputs = ([(p, TYPE_IMAGE) for p in args.image] + [(p, TYPE_FONT) for p in args.font] +
+              [(p, TYPE_STRING) for p in args.string] + [(p, TYPE_BLOB) for p in args.blob])
+    for path, kind in inputs:
+        name = asset_name(path, args.root)
+        if name in assets:
+            sys.exit("%s: the name %s is used twice" % (path, name))
+        assets[name] = load_image(path) if kind == TYPE_IMAGE else load_file(path, kind)
+
+    if not assets:
+        sys.exit("no assets given")
+
+    data = pack(assets, args.align)
+    with open(args.output, "wb") as f:
+        f.write(data)
+
+    print("%s: %d assets, %d bytes" % (args.output, len(assets), len(data)))
+
+
+if __name__ == "__main__":
+    main()
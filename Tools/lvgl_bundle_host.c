@@ -0,0 +1,370 @@
+/* Unit tests of lvgl_port_bundle on the host.
+ *
+ * A bundle with images, a font and strings is built in memory with the layout of
+ * Tools/lvgl_bundle.py. Its assets have to be found by name and read through the
+ * B: drive, then copies of it with one field broken each have to be refused by
+ * lvgl_bundle_is_valid(): counts which overflow the offsets, sections out of order,
+ * names without their NUL, payloads out of the bundle and strings without their NUL.
+ * Build it with LVGL and an lv_conf.h for the host (LV_USE_OS LV_OS_NONE), e.g. from
+ * the directory above lvgl/:
+ *
+ *   cc -O2 -I. -Ipath/to/Core/Inc -DLV_CONF_INCLUDE_SIMPLE \
+ *      path/to/Tools/lvgl_bundle_host.c path/to/Core/Src/lvgl_port_bundle.c \
+ *      $(find lvgl/src -name '*.c') -lm -o lvgl_bundle_host
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lvgl/lvgl.h"
+#include "lvgl_port_bundle.h"
+
+#define HOST_ALIGN      BUNDLE_MIN_ALIGN
+#define HOST_SIZE       4096
+#define HOST_MAX_SEED   (1 << 20)
+
+typedef struct
+{
+  const char *name;
+  uint8_t     type;
+  const char *data;
+  uint32_t    size;
+} host_asset_t;
+
+typedef struct
+{
+  const char *what;
+  void      (*mutate)(uint8_t *b);
+} host_case_t;
+
+/* the font last, its payload fills its slot to the end of the bundle */
+static const host_asset_t assets[] =
+{
+  { "icons/home", BUNDLE_TYPE_IMAGE, "\x1f\x00\xe0\x07\x00\xf8\xff\xff\x1f\x00\xe0\x07\x00\xf8\xff\xff", 16 },
+  { "icons/back", BUNDLE_TYPE_IMAGE, "\x00\x00\xff\xff\x00\x00\xff\xff\x00\x00\xff\xff\x00\x00\xff\xff", 16 },
+  { "text/title", BUNDLE_TYPE_STRING, "Settings", 9 },
+  { "text/ok", BUNDLE_TYPE_STRING, "OK", 3 },
+  { "fonts/roboto_24", BUNDLE_TYPE_FONT, "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ+-", 64 },
+};
+
+#define HOST_CNT        (sizeof(assets) / sizeof(assets[0]))
+
+static __attribute__((aligned(HOST_ALIGN))) uint8_t valid[HOST_SIZE];
+static __attribute__((aligned(HOST_ALIGN))) uint8_t work[HOST_SIZE + HOST_ALIGN];
+static uint32_t failed;
+
+static uint32_t
+host_fnv (const char *name,
+          uint32_t    seed)
+{
+  uint32_t h = 0x811C9DC5 ^ seed;
+
+  while (*name != '\0')
+    {
+      h ^= (uint8_t)*name++;
+      h *= 0x01000193;
+    }
+
+  return h;
+}
+
+static uint32_t
+host_align_up (uint32_t v)
+{
+  return (v + HOST_ALIGN - 1) / HOST_ALIGN * HOST_ALIGN;
+}
+
+/* Hash and displace like lvgl_bundle.py, the largest buckets are placed first */
+static void
+host_index (uint32_t *seeds,
+            uint32_t *slots)
+{
+  bool taken[HOST_CNT] = { false };
+  bool done[HOST_CNT] = { false };
+  uint32_t pos[HOST_CNT];
+  uint32_t bucket;
+  uint32_t best;
+  uint32_t cnt;
+  uint32_t seed;
+  uint32_t i;
+  uint32_t j;
+  uint32_t k;
+  bool ok;
+
+  for (k = 0; k < HOST_CNT; k++)
+    {
+      best = 0;
+      bucket = HOST_CNT;
+      for (i = 0; i < HOST_CNT; i++)
+        {
+          for (cnt = 0, j = 0; j < HOST_CNT; j++)
+            {
+              cnt += host_fnv(assets[j].name, 0) % HOST_CNT == i;
+            }
+          if (!done[i] && (bucket == HOST_CNT || cnt > best))
+            {
+              best = cnt;
+              bucket = i;
+            }
+        }
+      done[bucket] = true;
+      seeds[bucket] = 0;
+
+      for (seed = 1; best != 0 && seed < HOST_MAX_SEED; seed++)
+        {
+          ok = true;
+          for (i = 0; i < HOST_CNT && ok; i++)
+            {
+              pos[i] = host_fnv(assets[i].name, seed) % HOST_CNT;
+              if (host_fnv(assets[i].name, 0) % HOST_CNT != bucket)
+                {
+                  continue;
+                }
+              ok = !taken[pos[i]];
+              for (j = 0; j < i && ok; j++)
+                {
+                  ok = host_fnv(assets[j].name, 0) % HOST_CNT != bucket || pos[j] != pos[i];
+                }
+            }
+          if (ok)
+            {
+              seeds[bucket] = seed;
+              for (i = 0; i < HOST_CNT; i++)
+                {
+                  if (host_fnv(assets[i].name, 0) % HOST_CNT == bucket)
+                    {
+                      slots[i] = pos[i];
+                      taken[pos[i]] = true;
+                    }
+                }
+              break;
+            }
+        }
+    }
+}
+
+static void
+host_build (void)
+{
+  lvgl_bundle_header_t *hdr = (lvgl_bundle_header_t *)valid;
+  lvgl_bundle_entry_t *entries;
+  uint32_t seeds[HOST_CNT];
+  uint32_t slots[HOST_CNT];
+  uint32_t names_len = 0;
+  uint32_t pos;
+  uint32_t i;
+
+  host_index(seeds, slots);
+
+  hdr->magic = BUNDLE_MAGIC;
+  hdr->version = BUNDLE_VERSION;
+  hdr->align = HOST_ALIGN;
+  hdr->count = HOST_CNT;
+  hdr->seeds_off = sizeof(lvgl_bundle_header_t);
+  hdr->entries_off = hdr->seeds_off + HOST_CNT * sizeof(uint32_t);
+  hdr->names_off = hdr->entries_off + HOST_CNT * sizeof(lvgl_bundle_entry_t);
+  memcpy(valid + hdr->seeds_off, seeds, sizeof(seeds));
+  entries = (lvgl_bundle_entry_t *)(valid + hdr->entries_off);
+
+  for (i = 0; i < HOST_CNT; i++)
+    {
+      strcpy((char *)valid + hdr->names_off + names_len, assets[i].name);
+      entries[slots[i]].name_off = names_len;
+      names_len += strlen(assets[i].name) + 1;
+    }
+
+  pos = host_align_up(hdr->names_off + names_len);
+  for (i = 0; i < HOST_CNT; i++)
+    {
+      lvgl_bundle_entry_t *e = &entries[slots[i]];
+
+      e->data_off = pos;
+      e->data_size = assets[i].size;
+      e->type = assets[i].type;
+      if (e->type == BUNDLE_TYPE_IMAGE)
+        {
+          e->cf = LV_COLOR_FORMAT_RGB565;
+          e->w = 4;
+          e->h = 2;
+          e->stride = 8;
+        }
+      memcpy(valid + pos, assets[i].data, assets[i].size);
+      pos += host_align_up(assets[i].size);
+    }
+
+  hdr->size = pos;
+}
+
+static lvgl_bundle_header_t *
+host_hdr (uint8_t *b)
+{
+  return (lvgl_bundle_header_t *)b;
+}
+
+static lvgl_bundle_entry_t *
+host_entry (uint8_t *b,
+            uint8_t  type)
+{
+  lvgl_bundle_entry_t *e = (lvgl_bundle_entry_t *)(b + host_hdr(b)->entries_off);
+
+  while (e->type != type)
+    {
+      e++;
+    }
+
+  return e;
+}
+
+static void
+host_check (bool        ok,
+            const char *what)
+{
+  printf("%-40s %s\n", what, ok ? "ok" : "FAIL");
+  failed += !ok;
+}
+
+static void mut_magic (uint8_t *b) { host_hdr(b)->magic ^= 1; }
+static void mut_version (uint8_t *b) { host_hdr(b)->version++; }
+static void mut_count_zero (uint8_t *b) { host_hdr(b)->count = 0; }
+static void mut_count_wraps (uint8_t *b) { host_hdr(b)->count = 0x40000001; }
+static void mut_count_over (uint8_t *b) { host_hdr(b)->count++; }
+static void mut_seeds_in_header (uint8_t *b) { host_hdr(b)->seeds_off = 0; }
+static void mut_entries_first (uint8_t *b) { host_hdr(b)->entries_off = host_hdr(b)->seeds_off - 4; }
+static void mut_names_first (uint8_t *b) { host_hdr(b)->names_off = host_hdr(b)->entries_off - 24; }
+static void mut_names_end (uint8_t *b) { host_hdr(b)->names_off = host_hdr(b)->size; }
+static void mut_size (uint8_t *b) { host_hdr(b)->size = BUNDLE_MAX_SIZE + HOST_ALIGN; }
+static void mut_align (uint8_t *b) { host_hdr(b)->align = 48; }
+static void mut_name_end (uint8_t *b)
+{
+  host_entry(b, BUNDLE_TYPE_FONT)->name_off = host_hdr(b)->size - host_hdr(b)->names_off;
+}
+static void mut_name_nul (uint8_t *b)
+{
+  /* the font's last byte, the end of the bundle */
+  host_entry(b, BUNDLE_TYPE_FONT)->name_off = host_hdr(b)->size - host_hdr(b)->names_off - 1;
+}
+static void mut_data_align (uint8_t *b) { host_entry(b, BUNDLE_TYPE_IMAGE)->data_off += 4; }
+static void mut_data_end (uint8_t *b)
+{
+  lvgl_bundle_entry_t *e = host_entry(b, BUNDLE_TYPE_IMAGE);
+
+  e->data_size = host_hdr(b)->size - e->data_off + 1;
+}
+static void mut_data_wraps (uint8_t *b)
+{
+  lvgl_bundle_entry_t *e = host_entry(b, BUNDLE_TYPE_IMAGE);
+
+  e->data_off = 0xFFFFFFE0;
+  e->data_size = 0x40;
+}
+static void mut_string_nul (uint8_t *b)
+{
+  lvgl_bundle_entry_t *e = host_entry(b, BUNDLE_TYPE_STRING);
+
+  b[e->data_off + e->data_size - 1] = 'x';
+}
+static void mut_string_empty (uint8_t *b) { host_entry(b, BUNDLE_TYPE_STRING)->data_size = 0; }
+
+static const host_case_t cases[] =
+{
+  { "wrong magic", mut_magic },
+  { "wrong version", mut_version },
+  { "no assets", mut_count_zero },
+  { "count wrapping the seeds", mut_count_wraps },
+  { "count over the index", mut_count_over },
+  { "seeds in the header", mut_seeds_in_header },
+  { "entries before the seeds", mut_entries_first },
+  { "names before the entries", mut_names_first },
+  { "names at the end", mut_names_end },
+  { "size over the max.", mut_size },
+  { "alignment not a power of 2", mut_align },
+  { "name past the end", mut_name_end },
+  { "name without NUL", mut_name_nul },
+  { "payload not aligned", mut_data_align },
+  { "payload past the end", mut_data_end },
+  { "payload offset wrapping", mut_data_wraps },
+  { "string without NUL", mut_string_nul },
+  { "empty string", mut_string_empty },
+};
+
+static void
+host_test_lookup (void)
+{
+  const lvgl_bundle_entry_t *e;
+  lv_image_dsc_t img;
+  lv_fs_file_t f;
+  char path[64];
+  uint8_t buf[128];
+  uint32_t br;
+  uint32_t pos;
+  bool ok = true;
+  uint32_t i;
+
+  host_check(lvgl_bundle_is_valid(valid), "valid bundle accepted");
+  host_check(lvgl_bundle_init(valid) == LV_RESULT_OK, "valid bundle used");
+
+  for (i = 0; i < HOST_CNT; i++)
+    {
+      e = lvgl_bundle_find(assets[i].name);
+      ok &= e != NULL && e->type == assets[i].type && e->data_size == assets[i].size &&
+            memcmp(lvgl_bundle_get_data(e), assets[i].data, assets[i].size) == 0;
+    }
+  host_check(ok, "every asset found");
+
+  host_check(lvgl_bundle_find("icons/hom") == NULL && lvgl_bundle_find("") == NULL &&
+             lvgl_bundle_find("text/title/x") == NULL, "unknown names not found");
+
+  host_check(lvgl_bundle_get_string("text/title") != NULL &&
+             strcmp(lvgl_bundle_get_string("text/title"), "Settings") == 0 &&
+             lvgl_bundle_get_string("icons/home") == NULL, "string by name");
+
+  host_check(lvgl_bundle_get_image("icons/back", &img) == LV_RESULT_OK &&
+             img.header.w == 4 && img.header.h == 2 && img.header.cf == LV_COLOR_FORMAT_RGB565 &&
+             img.data_size == 16 && lvgl_bundle_get_image("text/ok", &img) != LV_RESULT_OK,
+             "image by name");
+
+  /* the way lv_binfont_create() reads a font */
+  snprintf(path, sizeof(path), "%c:/fonts/roboto_24", BUNDLE_LETTER);
+  ok = lv_fs_open(&f, path, LV_FS_MODE_RD) == LV_FS_RES_OK;
+  if (ok)
+    {
+      ok &= lv_fs_seek(&f, 10, LV_FS_SEEK_SET) == LV_FS_RES_OK &&
+            lv_fs_read(&f, buf, sizeof(buf), &br) == LV_FS_RES_OK && br == 54 &&
+            memcmp(buf, assets[4].data + 10, br) == 0 &&
+            lv_fs_tell(&f, &pos) == LV_FS_RES_OK && pos == 64 &&
+            lv_fs_seek(&f, 65, LV_FS_SEEK_SET) != LV_FS_RES_OK;
+      lv_fs_close(&f);
+    }
+  host_check(ok, "font read through the drive");
+}
+
+int
+main (void)
+{
+  uint32_t i;
+
+  lv_init();
+  host_build();
+  host_test_lookup();
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+      memcpy(work, valid, sizeof(valid));
+      cases[i].mutate(work);
+      host_check(!lvgl_bundle_is_valid(work), cases[i].what);
+    }
+
+  /* the GPU reads the payloads at the bundle's alignment */
+  memcpy(work + 4, valid, sizeof(valid));
+  host_check(!lvgl_bundle_is_valid(work + 4), "bundle not aligned");
+
+  /* a broken bundle leaves no assets behind */
+  memcpy(work, valid, sizeof(valid));
+  mut_count_wraps(work);
+  host_check(lvgl_bundle_init(work) != LV_RESULT_OK && lvgl_bundle_find("text/ok") == NULL,
+             "broken bundle not used");
+
+  printf("%u failed\n", (unsigned)failed);
+
+  return failed != 0;
+}
@@ -0,0 +1,420 @@
+/* Test the signal decoding and the filter planning of lvgl_port_can on the host.
+ *
+ * The module is included, so its static functions can be called. can_extract() is
+ * checked against frames worked out by hand, Motorola signals across bytes and
+ * signed ones among them, then against a bit by bit reference of the DBC layout for
+ * random signals and frames. lvgl_can_start() is run with tables of identifiers and
+ * the filter elements it programs are recorded: adjacent identifiers have to become
+ * one range element, single ones share dual elements, and when there are more than
+ * the elements hold, the merged ranges still have to accept every identifier of the
+ * table once, with ids_extra counting the others they let through. A few frames are
+ * decoded and latched like at the start of a refresh at the end. Build it with LVGL,
+ * e.g. from the directory above lvgl/:
+ *
+ *   cc -O2 -I. -Ipath/to/Tools/host -Ipath/to/Core/Inc -Ipath/to/Core/Src \
+ *      -DLV_CONF_INCLUDE_SIMPLE path/to/Tools/lvgl_can_host.c \
+ *      $(find lvgl/src -name '*.c') -lm -o lvgl_can_host
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lvgl_port_can.c"
+
+#define HOST_RANDOM_SIGNALS  200000
+#define HOST_FILTER_MAX      64
+
+FDCAN_HandleTypeDef hfdcan1;
+
+/* the elements programmed, standard ones at 0 and extended ones at 1 */
+static FDCAN_FilterTypeDef filters[2][HOST_FILTER_MAX];
+static uint32_t filter_cnt[2];
+static bool filter_bad;
+
+static uint32_t failed;
+
+/**********************
+ *   FDCAN MODEL
+ **********************/
+
+HAL_StatusTypeDef
+HAL_FDCAN_ConfigFilter (FDCAN_HandleTypeDef       *hfdcan,
+                        const FDCAN_FilterTypeDef *filter)
+{
+  uint32_t ext = filter->IdType == FDCAN_EXTENDED_ID;
+  uint32_t max = ext ? CAN_EXT_FILTER_MAX : CAN_STD_FILTER_MAX;
+
+  (void)hfdcan;
+
+  /* the elements are written from the first one on, into the FIFO of their type */
+  if (filter->FilterIndex != filter_cnt[ext] || filter->FilterIndex >= max ||
+      filter->FilterConfig != (ext ? FDCAN_FILTER_TO_RXFIFO1 : FDCAN_FILTER_TO_RXFIFO0) ||
+      (filter->FilterType == FDCAN_FILTER_RANGE && filter->FilterID1 > filter->FilterID2))
+    {
+      filter_bad = true;
+      return HAL_ERROR;
+    }
+
+  filters[ext][filter_cnt[ext]++] = *filter;
+
+  return HAL_OK;
+}
+
+/* The number of elements which accept `id` */
+static uint32_t
+host_accepts (uint32_t ext,
+              uint32_t id)
+{
+  uint32_t n = 0;
+  uint32_t i;
+
+  for (i = 0; i < filter_cnt[ext]; i++)
+    {
+      const FDCAN_FilterTypeDef *f = &filters[ext][i];
+
+      if (f->FilterType == FDCAN_FILTER_RANGE ? id >= f->FilterID1 && id <= f->FilterID2 :
+                                                id == f->FilterID1 || id == f->FilterID2)
+        {
+          n++;
+        }
+    }
+
+  return n;
+}
+
+/**********************
+ *   REFERENCE
+ **********************/
+
+/* The raw value bit by bit, as a DBC lays a signal out. Motorola signals run from
+ * their MSB down to bit 0 of a byte, then on with bit 7 of the next byte. */
+static bool
+host_ref_raw (const lvgl_can_signal_t *sig,
+              const uint8_t           *data,
+              uint32_t                 len,
+              uint32_t                *raw)
+{
+  uint32_t pos = sig->start;
+  uint32_t i;
+
+  *raw = 0;
+  for (i = 0; i < sig->length; i++)
+    {
+      if (sig->flags & CAN_SIGNAL_BIG_ENDIAN)
+        {
+          if (i > 0)
+            {
+              pos = pos % 8 == 0 ? pos + 15 : pos - 1;
+            }
+          if (pos / 8 >= len)
+            {
+              return false;
+            }
+          *raw = (*raw << 1) | ((data[pos / 8] >> (pos % 8)) & 1);
+        }
+      else
+        {
+          pos = sig->start + i;
+          if (pos / 8 >= len)
+            {
+              return false;
+            }
+          *raw |= (uint32_t)((data[pos / 8] >> (pos % 8)) & 1) << i;
+        }
+    }
+
+  return true;
+}
+
+static float
+host_ref_value (const lvgl_can_signal_t *sig,
+                uint32_t                 raw)
+{
+  uint32_t mask = (uint32_t)((1ULL << sig->length) - 1);
+
+  if ((sig->flags & CAN_SIGNAL_SIGNED) && (raw & (1UL << (sig->length - 1))))
+    {
+      return (float)(int32_t)(raw | ~mask) * sig->scale + sig->offset;
+    }
+
+  return (float)raw * sig->scale + sig->offset;
+}
+
+/**********************
+ *   TEST
+ **********************/
+
+static void
+host_check (bool        ok,
+            const char *what)
+{
+  printf("%-40s %s\n", what, ok ? "ok" : "FAIL");
+  failed += !ok;
+}
+
+static bool
+host_extract_is (uint16_t       start,
+                 uint8_t        length,
+                 uint8_t        flags,
+                 const uint8_t *data,
+                 uint32_t       len,
+                 float          expected)
+{
+  lvgl_can_signal_t sig = { 0x100, start, length, flags, 1.0f, 0.0f };
+  float value;
+
+  return can_extract(&sig, data, len, &value) && value == expected;
+}
+
+static void
+host_test_extract (void)
+{
+  static const uint8_t d1[] = { 0xAB, 0xCD };
+  static const uint8_t d2[] = { 0x00, 0xAB, 0xCD };
+  static const uint8_t d3[] = { 0x1F, 0xFF, 0xFF, 0xFF, 0xE0 };
+  static const uint8_t d4[] = { 0x80, 0x00 };
+  static const uint8_t d5[] = { 0x12, 0x34, 0x56 };
+  static const uint8_t d6[] = { 0xFF };
+  lvgl_can_signal_t scaled = { 0x100, 0, 8, CAN_SIGNAL_SIGNED, 0.5f, 10.0f };
+  lvgl_can_signal_t sig;
+  uint8_t data[8];
+  uint32_t mismatches = 0;
+  uint32_t raw;
+  uint32_t len;
+  float value;
+  bool ok;
+  bool ref_ok;
+  uint32_t i;
+  uint32_t j;
+
+  /* 4 bits of byte 0 from bit 3 down, then all of byte 1 */
+  host_check(host_extract_is(3, 12, CAN_SIGNAL_BIG_ENDIAN, d1, 2, 0xBCD), "Motorola 12 bits across 2 bytes");
+  /* 6 bits of byte 1 from bit 5 down, then the top 4 bits of byte 2 */
+  host_check(host_extract_is(13, 10, CAN_SIGNAL_BIG_ENDIAN, d2, 3, 0x2BC), "Motorola 10 bits from byte 1");
+  /* 5 + 8 + 8 + 8 + 3 bits, the widest window */
+  host_check(host_extract_is(4, 32, CAN_SIGNAL_BIG_ENDIAN, d3, 5, 4294967295.0f), "Motorola 32 bits across 5 bytes");
+  host_check(host_extract_is(4, 32, CAN_SIGNAL_BIG_ENDIAN | CAN_SIGNAL_SIGNED, d3, 5, -1.0f),
+             "Motorola signed 32 bits");
+  host_check(host_extract_is(7, 12, CAN_SIGNAL_BIG_ENDIAN | CAN_SIGNAL_SIGNED, d4, 2, -2048.0f),
+             "Motorola sign extension");
+  host_check(host_extract_is(7, 12, CAN_SIGNAL_BIG_ENDIAN, d4, 2, 2048.0f), "Motorola unsigned MSB set");
+  host_check(host_extract_is(4, 12, 0, d5, 3, 0x341), "Intel 12 bits across 2 bytes");
+  host_check(host_extract_is(4, 12, CAN_SIGNAL_SIGNED, d5, 3, 0x341), "Intel signed, positive");
+  host_check(host_extract_is(0, 8, CAN_SIGNAL_SIGNED, d6, 1, -1.0f), "Intel sign extension");
+  host_check(can_extract(&scaled, d6, 1, &value) && value == 9.5f, "scale and offset");
+  host_check(!host_extract_is(7, 16, CAN_SIGNAL_BIG_ENDIAN, d1, 1, 0xABCD), "Motorola past a short frame");
+  host_check(!host_extract_is(12, 8, 0, d1, 2, 0), "Intel past a short frame");
+
+  /* random signals in random classic frames, against the reference */
+  srand(1);
+  for (i = 0; i < HOST_RANDOM_SIGNALS; i++)
+    {
+      sig.id = 0x100;
+      sig.start = rand() % 64;
+      sig.length = 1 + rand() % 32;
+      sig.flags = rand() % 4;
+      sig.scale = 1.0f;
+      sig.offset = 0.0f;
+      len = rand() % 9;
+      for (j = 0; j < sizeof(data); j++)
+        {
+          data[j] = rand();
+        }
+
+      ref_ok = host_ref_raw(&sig, data, len, &raw);
+      ok = can_extract(&sig, data, len, &value);
+      if (ok != ref_ok || (ok && value != host_ref_value(&sig, raw)))
+        {
+          if (mismatches++ < 5)
+            {
+              printf("  start %u length %u flags %u len %u: %s %g, reference %s %g\n",
+                     (unsigned)sig.start, (unsigned)sig.length, (unsigned)sig.flags, (unsigned)len,
+                     ok ? "ok" : "short", ok ? value : 0.0, ref_ok ? "ok" : "short",
+                     ref_ok ? host_ref_value(&sig, raw) : 0.0);
+            }
+        }
+    }
+  host_check(mismatches == 0, "random signals match the reference");
+}
+
+/* lvgl_can_start() again, with the filters recorded from scratch */
+static lv_result_t
+host_start (const lvgl_can_signal_t *signals,
+            uint32_t                 cnt)
+{
+  running = false;
+  lv_memzero(&stats, sizeof(stats));
+  lv_memzero(live, sizeof(live));
+  lv_memzero(front, sizeof(front));
+  lv_memzero(dirty, sizeof(dirty));
+  filter_cnt[0] = 0;
+  filter_cnt[1] = 0;
+  filter_bad = false;
+
+  return lvgl_can_start(signals, cnt);
+}
+
+/* If every identifier of `signals` up to `id_max` is accepted by one element, the
+ * others by at most one, and ids_extra counts those */
+static bool
+host_filters_cover (const lvgl_can_signal_t *signals,
+                    uint32_t                 cnt,
+                    uint32_t                 ext,
+                    uint32_t                 id_max)
+{
+  uint32_t extra = 0;
+  uint32_t id;
+  uint32_t n;
+  uint32_t i;
+  bool used;
+
+  for (id = 0; id <= id_max; id++)
+    {
+      used = false;
+      for (i = 0; i < cnt; i++)
+        {
+          used |= signals[i].id == (id | ext);
+        }
+
+      n = host_accepts(ext != 0, id);
+      if (n > 1 || (used && n != 1))
+        {
+          return false;
+        }
+      extra += !used && n == 1;
+    }
+
+  return extra == stats.ids_extra;
+}
+
+static void
+host_test_filters (void)
+{
+  static const lvgl_can_signal_t table[] =
+  {
+    { 0x101,                  0,  8, 0,                     1.0f, 0.0f },
+    { 0x100,                  0, 16, 0,                     1.0f, 0.0f },
+    { 0x102,                  7, 12, CAN_SIGNAL_BIG_ENDIAN, 1.0f, 0.0f },
+    { 0x200,                  0,  8, CAN_SIGNAL_SIGNED,     1.0f, 0.0f },
+    { 0x300,                  0,  8, 0,                     0.1f, 0.0f },
+    { 0x400,                  0,  8, 0,                     1.0f, 0.0f },
+    { 0x101,                  8,  8, 0,                     1.0f, 0.0f },
+    { 0x18FF0001 | CAN_ID_EXT, 0, 16, 0,                     1.0f, 0.0f },
+    { 0x18FF0002 | CAN_ID_EXT, 0, 16, 0,                     1.0f, 0.0f },
+  };
+  static lvgl_can_signal_t many[CAN_SIGNAL_MAX];
+  const FDCAN_FilterTypeDef *f = filters[0];
+  uint32_t id;
+  uint32_t i;
+  uint32_t j;
+  bool ok;
+
+  ok = host_start(table, sizeof(table) / sizeof(table[0])) == LV_RESULT_OK && !filter_bad;
+  host_check(ok, "filters programmed");
+
+  /* 0x100-0x102 adjacent, 0x200 and 0x300 paired, 0x400 alone */
+  ok = filter_cnt[0] == 3 && stats.std_filters == 3 &&
+       f[0].FilterType == FDCAN_FILTER_RANGE && f[0].FilterID1 == 0x100 && f[0].FilterID2 == 0x102 &&
+       f[1].FilterType == FDCAN_FILTER_DUAL && f[1].FilterID1 == 0x200 && f[1].FilterID2 == 0x300 &&
+       f[2].FilterType == FDCAN_FILTER_DUAL && f[2].FilterID1 == 0x400 && f[2].FilterID2 == 0x400;
+  host_check(ok, "adjacent ids in a range, singles paired");
+  host_check(filter_cnt[1] == 1 && filters[1][0].FilterType == FDCAN_FILTER_RANGE &&
+             filters[1][0].FilterID1 == 0x18FF0001 && filters[1][0].FilterID2 == 0x18FF0002,
+             "extended ids in their own elements");
+  host_check(stats.ids_extra == 0 && host_filters_cover(table, sizeof(table) / sizeof(table[0]), 0, 0x7FF),
+             "exactly the table is accepted");
+
+  /* more single identifiers than the standard elements hold, some close together */
+  srand(2);
+  for (i = 0; i < CAN_SIGNAL_MAX; i++)
+    {
+      do
+        {
+          id = i < 16 ? 0x500 + i * 3 + rand() % 2 : (uint32_t)rand() % 0x800;
+          for (j = 0; j < i && many[j].id != id; j++)
+            {
+            }
+        }
+      while (j < i);
+      many[i] = (lvgl_can_signal_t) { id, 0, 8, 0, 1.0f, 0.0f };
+    }
+  ok = host_start(many, CAN_SIGNAL_MAX) == LV_RESULT_OK && !filter_bad;
+  host_check(ok && filter_cnt[0] <= CAN_STD_FILTER_MAX && filter_cnt[1] == 0,
+             "64 standard ids in 28 elements");
+  host_check(ok && stats.ids_extra > 0 && host_filters_cover(many, CAN_SIGNAL_MAX, 0, 0x7FF),
+             "merged ranges cover the table once");
+
+  /* the same for extended identifiers, spread over a small part of the 29 bits */
+  srand(3);
+  for (i = 0; i < 24; i++)
+    {
+      do
+        {
+          id = 0x1000 + rand() % 0x400;
+          for (j = 0; j < i && many[j].id != (id | CAN_ID_EXT); j++)
+            {
+            }
+        }
+      while (j < i);
+      many[i] = (lvgl_can_signal_t) { id | CAN_ID_EXT, 0, 8, 0, 1.0f, 0.0f };
+    }
+  ok = host_start(many, 24) == LV_RESULT_OK && !filter_bad;
+  host_check(ok && filter_cnt[1] <= CAN_EXT_FILTER_MAX && filter_cnt[0] == 0,
+             "24 extended ids in 8 elements");
+  host_check(ok && host_filters_cover(many, 24, CAN_ID_EXT, 0x1FFF), "merged extended ranges");
+  for (i = 0; i < filter_cnt[1]; i++)
+    {
+      ok &= filters[1][i].FilterID1 >= 0x1000 && filters[1][i].FilterID2 < 0x1400;
+    }
+  host_check(ok, "no extended id outside the table's span");
+
+  host_check(host_start(many, 0) != LV_RESULT_OK, "empty table refused");
+}
+
+static void
+host_test_decode (void)
+{
+  static const lvgl_can_signal_t table[] =
+  {
+    { 0x101,                  0,  8, 0,                                         1.0f,  0.0f },
+    { 0x101,                  11, 12, CAN_SIGNAL_BIG_ENDIAN | CAN_SIGNAL_SIGNED, 0.25f, 0.0f },
+    { 0x18FF0001 | CAN_ID_EXT, 8, 16, 0,                                         1.0f,  -100.0f },
+  };
+  static const uint8_t std_data[8] = { 0x2A, 0x0F, 0xFE, 0, 0, 0, 0, 0 };
+  static const uint8_t ext_data[8] = { 0, 0x10, 0x27, 0, 0, 0, 0, 0 };
+  bool ok;
+
+  ok = host_start(table, sizeof(table) / sizeof(table[0])) == LV_RESULT_OK;
+
+  /* the words of a message RAM element: the identifier, then the DLC */
+  can_decode(0x101 << CAN_ELEMENT_STDID_POS, 8 << 16, std_data);
+  can_decode(CAN_ELEMENT_XTD | 0x18FF0001, 8 << 16, ext_data);
+  can_decode(0x555 << CAN_ELEMENT_STDID_POS, 8 << 16, std_data);
+  host_check(ok && lvgl_can_get(0) == 0.0f && !lvgl_can_is_changed(0), "values kept until the refresh");
+
+  can_refr_start_cb(NULL);
+  /* 4 bits of byte 1 from bit 3 down and byte 2: 0xFFE, -2 * 0.25 */
+  ok = lvgl_can_get(0) == 42.0f && lvgl_can_get(1) == -0.5f && lvgl_can_get(2) == 10000.0f - 100.0f &&
+       lvgl_can_is_changed(0) && lvgl_can_is_changed(2);
+  host_check(ok, "frames decoded at the refresh");
+  host_check(stats.frames == 2 && stats.unmatched == 1 && stats.latches == 1, "frames and unmatched counted");
+
+  /* a DLC of 1 holds the first signal only */
+  can_decode(0x101 << CAN_ELEMENT_STDID_POS, 1 << 16, ext_data);
+  can_refr_start_cb(NULL);
+  host_check(lvgl_can_get(0) == 0.0f && lvgl_can_get(1) == -0.5f && !lvgl_can_is_changed(1) &&
+             !lvgl_can_is_changed(2) && stats.truncated == 1, "short frame keeps the value");
+}
+
+int
+main (void)
+{
+  host_test_extract();
+  host_test_filters();
+  host_test_decode();
+
+  printf("%u failed\n", (unsigned)failed);
+
+  return failed != 0;
+}
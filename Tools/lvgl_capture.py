@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+"""Take a screenshot from lvgl_port_capture over the service port.
+
+The device switches to the requested rate for the transfer and sends only the
+tiles changed since the last capture the tool kept in the state file. Needs
+pyserial.
+
+    lvgl_capture.py -p /dev/ttyUSB0 -o screen.png
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+import zlib
+
+import serial
+
+MAGIC = 0x4353564C  # "LVSC"
+REQUEST = struct.Struct("<IIII")
+HEADER = struct.Struct("<IIIHHBBBB")
+TILE = struct.Struct("<HH")
+TILE_END = 0xFFFF
+FLAG_RLE = 0x01
+
+ACK = b"K"
+NAK = b"E"
+
+# the rate of the request, as set in CubeMX
+BASE_BAUDRATE = 115200
+
+# the device waits CAPTURE_UART_SWITCH_MS after its answer
+SWITCH_S = 0.005
+
+# lv_color_format_t
+CF_RGB565 = 0x12
+CF_BPP = {0x12: 2, 0x0F: 3, 0x10: 4}
+
+STATE = struct.Struct("<IHHB")
+
+
+def read_exactly(port, size, what):
+    data = port.read(size)
+    if len(data) != size:
+        sys.exit("%s: the device stopped sending" % what)
+    return data
+
+
+def decode_rle_line(data, pos, w):
+    """A line of `w` RGB565 pixels, returns them and the position after them"""
+    out = bytearray()
+    while len(out) < w * 2:
+        ctrl = data[pos]
+        pos += 1
+        if ctrl < 128:
+            n = (ctrl + 1) * 2
+            out += data[pos:pos + n]
+            pos += n
+        else:
+            out += data[pos:pos + 2] * (ctrl - 126)
+            pos += 2
+    if len(out) != w * 2:
+        raise ValueError("corrupt RLE line")
+    return out, pos
+
+
+def load_state(path):
+    try:
+        with open(path, "rb") as f:
+            data = f.read()
+        cap_id, w, h, cf = STATE.unpack_from(data)
+        return cap_id, w, h, cf, bytearray(data[STATE.size:])
+    except (OSError, struct.error):
+        return 0, 0, 0, 0, None
+
+
+def save_state(path, cap_id, w, h, cf, fb):
+    with open(path, "wb") as f:
+        f.write(STATE.pack(cap_id, w, h, cf))
+        f.write(fb)
+
+
+def write_png(path, w, h, cf, fb):
+    bpp = CF_BPP[cf]
+    rows = bytearray()
+    for y in range(h):
+        line = fb[y * w * bpp:(y + 1) * w * bpp]
+        rows.append(0)
+        if cf == CF_RGB565:
+            for px, in struct.iter_unpack("<H", line):
+                rows += bytes((((px >> 11) & 0x1F) << 3, ((px >> 5) & 0x3F) << 2, (px & 0x1F) << 3))
+        else:
+            for x in range(w):
+                b, g, r = line[x * bpp:x * bpp + 3]
+                rows += bytes((r, g, b))
+
+    def chunk(kind, data):
+        return struct.pack(">I", len(data)) + kind + data + struct.pack(">I", zlib.crc32(kind + data))
+
+    with open(path, "wb") as f:
+        f.write(b"\x89PNG\r\n\x1a\n")
+        f.write(chunk(b"IHDR", struct.pack(">IIBBBBB", w, h, 8, 2, 0, 0, 0)))
+        f.write(chunk(b"IDAT", zlib.compress(bytes(rows), 6)))
+        f.write(chunk(b"IEND", b""))
+
+
+def capture(port, baudrate, base_id):
+    """Request a capture against `base_id`, returns its header and tiles"""
+    port.baudrate = BASE_BAUDRATE
+    port.reset_input_buffer()
+    port.write(REQUEST.pack(MAGIC, baudrate, base_id, 0))
+
+    reply = port.read(1)
+    if reply == NAK:
+        sys.exit("request: rejected by the device")
+    if reply != ACK:
+        sys.exit("request: no answer from the device")
+    rate, = struct.unpack("<I", read_exactly(port, 4, "request"))
+
+    port.baudrate = rate
+    time.sleep(SWITCH_S)
+
+    start = time.monotonic()
+    header = HEADER.unpack(read_exactly(port, HEADER.size, "header"))
+    if header[0] != MAGIC:
+        sys.exit("header: out of step, try again")
+
+    tiles = []
+    adler = 1
+    size = HEADER.size
+    while True:
+        rec = read_exactly(port, TILE.size, "tiles")
+        idx, length = TILE.unpack(rec)
+        data = read_exactly(port, length, "tiles") if length else b""
+        adler = zlib.adler32(rec + data, adler)
+        size += TILE.size + length
+        if idx == TILE_END:
+            break
+        tiles.append((idx, data))
+    check, = struct.unpack("<I", read_exactly(port, 4, "checksum"))
+    secs = time.monotonic() - start
+
+    return header, tiles, check == adler, rate, size + 4, secs
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("-p", "--port", required=True, help="serial port of USART3 or USART6")
+    parser.add_argument("-b", "--baudrate", type=int, default=921600, help="of the transfer")
+    parser.add_argument("-o", "--output", default="screen.png")
+    parser.add_argument("--state", help="the last capture, default the output with .state")
+    parser.add_argument("--full", action="store_true", help="ignore the last capture")
+    args = parser.parse_args()
+
+    state = args.state or os.path.splitext(args.output)[0] + ".state"
+    base_id, w, h, cf, fb = (0, 0, 0, 0, None) if args.full else load_state(state)
+
+    with serial.Serial(args.port, BASE_BAUDRATE, timeout=2) as port:
+        header, tiles, ok, rate, size, secs = capture(port, args.baudrate, base_id)
+        if not ok:
+            print("checksum mismatch, requesting a full capture")
+            header, tiles, ok, rate, size, secs = capture(port, args.baudrate, 0)
+            if not ok:
+                sys.exit("checksum mismatch")
+
+    _, cap_id, cap_base, cw, ch, ccf, tile, flags, _ = header
+    if ccf not in CF_BPP:
+        sys.exit("color format 0x%02x isn't supported" % ccf)
+    bpp = CF_BPP[ccf]
+    if cap_base == 0 or cap_base != base_id or fb is None or (w, h, cf) != (cw, ch, ccf):
+        fb = bytearray(cw * ch * bpp)
+    w, h, cf = cw, ch, ccf
+
+    cols = (w + tile - 1) // tile
+    for idx, data in tiles:
+        x = idx % cols * tile
+        y = idx // cols * tile
+        tw = min(tile, w - x)
+        pos = 0
+        for row in range(y, min(y + tile, h)):
+            if flags & FLAG_RLE:
+                line, pos = decode_rle_line(data, pos, tw)
+            else:
+                line = data[pos:pos + tw * bpp]
+                pos += tw * bpp
+            dst = (row * w + x) * bpp
+            fb[dst:dst + tw * bpp] = line
+
+    write_png(args.output, w, h, cf, fb)
+    save_state(state, cap_id, w, h, cf, fb)
+
+    total = cols * ((h + tile - 1) // tile)
+    print("capture %d%s: %d of %d tiles, %d bytes at %d baud in %.2f s, %.1f KB/s" %
+          (cap_id, " against %d" % cap_base if cap_base else "", len(tiles), total,
+           size, rate, secs, size / max(secs, 1e-6) / 1024))
+
+
+if __name__ == "__main__":
+    main()
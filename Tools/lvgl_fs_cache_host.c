@@ -0,0 +1,360 @@
+/* Unit tests of lvgl_port_fs_cache on the host.
+ *
+ * A fake drive F: keeps a few files in memory and counts the reads which reach it.
+ * The cache is attached to it, then repeated reads have to be served from the
+ * blocks, two paths with the same FNV-1a hash and size have to keep their own
+ * content, sequential readers have to get the read-ahead, large reads have to
+ * bypass the blocks, and a write or an invalidation has to drop what was cached.
+ * Build it with LVGL and an lv_conf.h for the host (LV_USE_OS LV_OS_NONE), e.g. from
+ * the directory above lvgl/:
+ *
+ *   cc -O2 -I. -Ipath/to/Core/Inc -DLV_CONF_INCLUDE_SIMPLE \
+ *      path/to/Tools/lvgl_fs_cache_host.c path/to/Core/Src/lvgl_port_fs_cache.c \
+ *      $(find lvgl/src -name '*.c') -lm -o lvgl_fs_cache_host
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lvgl/lvgl.h"
+#include "lvgl_port_fs_cache.h"
+
+#define HOST_LETTER     'F'
+#define HOST_SMALL      3000
+#define HOST_BIG        (FS_CACHE_BLOCK_SIZE * 20)
+
+typedef struct
+{
+  const char *path;
+  uint32_t    size;
+  uint8_t     seed;
+  uint8_t     data[HOST_BIG];
+} host_file_t;
+
+typedef struct
+{
+  host_file_t *f;
+  uint32_t     pos;
+} host_handle_t;
+
+/* the first two have the same FNV-1a hash, 0x0ffff46c */
+static host_file_t files[] =
+{
+  { "icon649192.bin", HOST_SMALL, 1, { 0 } },
+  { "icon412789.bin", HOST_SMALL, 2, { 0 } },
+  { "big.bin", HOST_BIG, 3, { 0 } },
+  { "log.txt", HOST_SMALL, 4, { 0 } },
+};
+
+#define HOST_CNT        (sizeof(files) / sizeof(files[0]))
+
+static lv_fs_drv_t drv;
+static uint32_t drv_reads;
+static uint32_t failed;
+
+/**********************
+ *   FAKE DRIVE
+ **********************/
+
+static void *
+host_open_cb (lv_fs_drv_t *d,
+              const char  *path,
+              lv_fs_mode_t mode)
+{
+  host_handle_t *h;
+  uint32_t i;
+
+  LV_UNUSED(d);
+  LV_UNUSED(mode);
+
+  for (i = 0; i < HOST_CNT; i++)
+    {
+      if (strcmp(files[i].path, path) == 0)
+        {
+          h = lv_malloc_zeroed(sizeof(host_handle_t));
+          h->f = &files[i];
+          return h;
+        }
+    }
+
+  return NULL;
+}
+
+static lv_fs_res_t
+host_close_cb (lv_fs_drv_t *d,
+               void        *file_p)
+{
+  LV_UNUSED(d);
+
+  lv_free(file_p);
+
+  return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t
+host_read_cb (lv_fs_drv_t *d,
+              void        *file_p,
+              void        *buf,
+              uint32_t     btr,
+              uint32_t    *br)
+{
+  host_handle_t *h = file_p;
+
+  LV_UNUSED(d);
+
+  *br = LV_MIN(btr, h->f->size - h->pos);
+  memcpy(buf, h->f->data + h->pos, *br);
+  h->pos += *br;
+  drv_reads++;
+
+  return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t
+host_write_cb (lv_fs_drv_t *d,
+               void        *file_p,
+               const void  *buf,
+               uint32_t     btw,
+               uint32_t    *bw)
+{
+  host_handle_t *h = file_p;
+
+  LV_UNUSED(d);
+
+  *bw = LV_MIN(btw, h->f->size - h->pos);
+  memcpy(h->f->data + h->pos, buf, *bw);
+  h->pos += *bw;
+
+  return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t
+host_seek_cb (lv_fs_drv_t   *d,
+              void          *file_p,
+              uint32_t       pos,
+              lv_fs_whence_t whence)
+{
+  host_handle_t *h = file_p;
+
+  LV_UNUSED(d);
+
+  if (whence == LV_FS_SEEK_CUR)
+    {
+      pos += h->pos;
+    }
+  else if (whence == LV_FS_SEEK_END)
+    {
+      pos += h->f->size;
+    }
+
+  if (pos > h->f->size)
+    {
+      return LV_FS_RES_INV_PARAM;
+    }
+  h->pos = pos;
+
+  return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t
+host_tell_cb (lv_fs_drv_t *d,
+              void        *file_p,
+              uint32_t    *pos_p)
+{
+  host_handle_t *h = file_p;
+
+  LV_UNUSED(d);
+
+  *pos_p = h->pos;
+
+  return LV_FS_RES_OK;
+}
+
+/**********************
+ *   TESTS
+ **********************/
+
+static void
+host_check (bool        ok,
+            const char *what)
+{
+  printf("%-40s %s\n", what, ok ? "ok" : "FAIL");
+  failed += !ok;
+}
+
+/* Read `len` bytes of file `i` at `pos` in reads of `chunk` and compare them */
+static bool
+host_read (uint32_t i,
+           uint32_t pos,
+           uint32_t len,
+           uint32_t chunk)
+{
+  static uint8_t buf[HOST_BIG];
+  lv_fs_file_t f;
+  char path[32];
+  uint32_t done = 0;
+  uint32_t br;
+  bool ok;
+
+  snprintf(path, sizeof(path), "%c:%s", HOST_LETTER, files[i].path);
+  if (lv_fs_open(&f, path, LV_FS_MODE_RD) != LV_FS_RES_OK)
+    {
+      return false;
+    }
+
+  ok = lv_fs_seek(&f, pos, LV_FS_SEEK_SET) == LV_FS_RES_OK;
+  while (ok && done < len)
+    {
+      ok = lv_fs_read(&f, buf + done, LV_MIN(chunk, len - done), &br) == LV_FS_RES_OK && br > 0;
+      done += br;
+    }
+  ok &= memcmp(buf, files[i].data + pos, len) == 0;
+  lv_fs_close(&f);
+
+  return ok;
+}
+
+static void
+host_reset (void)
+{
+  lvgl_fs_cache_invalidate(0);
+  lvgl_fs_cache_reset_stats();
+  drv_reads = 0;
+}
+
+static void
+host_test_hits (void)
+{
+  lvgl_fs_cache_stats_t stats;
+  bool ok;
+
+  host_reset();
+  ok = host_read(0, 100, 200, 200);
+  ok &= drv_reads == 1;
+  ok &= host_read(0, 300, 100, 100) && host_read(0, 0, 50, 50);
+  lvgl_fs_cache_get_stats(HOST_LETTER, &stats);
+  host_check(ok && drv_reads == 1 && stats.hits == 2 && stats.misses == 1 &&
+             stats.backend_reads == drv_reads, "repeated reads from the cache");
+}
+
+static void
+host_test_same_hash (void)
+{
+  bool ok;
+
+  host_reset();
+  ok = host_read(0, 0, 100, 100);
+  ok &= host_read(1, 0, 100, 100);
+  ok &= host_read(0, 0, 100, 100);
+  host_check(ok && drv_reads == 2, "same hash and size kept apart");
+}
+
+static void
+host_test_read_ahead (void)
+{
+  lvgl_fs_cache_stats_t stats;
+  bool ok;
+
+  /* the first block, then a miss which continues it loads the 2nd and 3 more */
+  host_reset();
+  ok = host_read(2, 0, 5 * FS_CACHE_BLOCK_SIZE, 128);
+  lvgl_fs_cache_get_stats(HOST_LETTER, &stats);
+  host_check(ok && drv_reads == 1 + 1 + FS_CACHE_READ_AHEAD &&
+             stats.read_ahead == FS_CACHE_READ_AHEAD &&
+             stats.read_ahead_hits == FS_CACHE_READ_AHEAD, "sequential reads ahead");
+
+  /* random reads don't */
+  host_reset();
+  ok = host_read(2, 7 * FS_CACHE_BLOCK_SIZE + 10, 100, 100);
+  ok &= host_read(2, 2 * FS_CACHE_BLOCK_SIZE + 10, 100, 100);
+  lvgl_fs_cache_get_stats(HOST_LETTER, &stats);
+  host_check(ok && drv_reads == 2 && stats.read_ahead == 0, "random reads not ahead");
+}
+
+static void
+host_test_direct (void)
+{
+  lvgl_fs_cache_stats_t stats;
+  bool ok;
+
+  host_reset();
+  ok = host_read(2, FS_CACHE_BLOCK_SIZE, 8 * FS_CACHE_BLOCK_SIZE + 100, 8 * FS_CACHE_BLOCK_SIZE + 100);
+  lvgl_fs_cache_get_stats(HOST_LETTER, &stats);
+  host_check(ok && stats.direct_bytes == 8 * FS_CACHE_BLOCK_SIZE && stats.misses == 1,
+             "large reads past the blocks");
+}
+
+static void
+host_test_write (void)
+{
+  lv_fs_file_t f;
+  char path[32];
+  uint8_t buf[64];
+  uint32_t bw;
+  bool ok;
+
+  host_reset();
+  ok = host_read(3, 0, 64, 64);
+
+  memset(buf, 0xA5, sizeof(buf));
+  snprintf(path, sizeof(path), "%c:%s", HOST_LETTER, files[3].path);
+  ok &= lv_fs_open(&f, path, LV_FS_MODE_WR) == LV_FS_RES_OK &&
+        lv_fs_write(&f, buf, sizeof(buf), &bw) == LV_FS_RES_OK && bw == sizeof(buf);
+  lv_fs_close(&f);
+
+  /* host_read() compares with the new content */
+  ok &= host_read(3, 0, 64, 64);
+  host_check(ok && drv_reads == 2, "a write drops the file's blocks");
+
+  /* the other files keep theirs */
+  ok = host_read(0, 0, 64, 64);
+  drv_reads = 0;
+  lv_fs_open(&f, path, LV_FS_MODE_WR);
+  lv_fs_close(&f);
+  ok &= host_read(0, 0, 64, 64);
+  host_check(ok && drv_reads == 0, "other files kept");
+
+  lvgl_fs_cache_invalidate(HOST_LETTER);
+  ok = host_read(0, 0, 64, 64);
+  host_check(ok && drv_reads == 1, "invalidated");
+}
+
+int
+main (void)
+{
+  uint32_t i;
+  uint32_t j;
+
+  for (i = 0; i < HOST_CNT; i++)
+    {
+      for (j = 0; j < files[i].size; j++)
+        {
+          files[i].data[j] = (uint8_t)(j * 7 + j / 256 + files[i].seed * 31);
+        }
+    }
+
+  lv_init();
+
+  lv_fs_drv_init(&drv);
+  drv.letter = HOST_LETTER;
+  drv.open_cb = host_open_cb;
+  drv.close_cb = host_close_cb;
+  drv.read_cb = host_read_cb;
+  drv.write_cb = host_write_cb;
+  drv.seek_cb = host_seek_cb;
+  drv.tell_cb = host_tell_cb;
+  lv_fs_drv_register(&drv);
+
+  host_check(lvgl_fs_cache_attach(HOST_LETTER) == LV_RESULT_OK &&
+             lvgl_fs_cache_attach(HOST_LETTER) != LV_RESULT_OK, "attached once");
+
+  host_test_hits();
+  host_test_same_hash();
+  host_test_read_ahead();
+  host_test_direct();
+  host_test_write();
+
+  printf("%u failed\n", (unsigned)failed);
+
+  return failed != 0;
+}
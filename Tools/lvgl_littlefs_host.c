@@ -0,0 +1,368 @@
+/* Test lvgl_port_littlefs on the host against a RAM model of the octal NOR.
+ *
+ * The model stands in for lvgl_port_ospi. Like the MX25LM51245G, a program can only
+ * clear bits and has to stay within a page, and an erase sets a whole sector. A
+ * program which would have to set a bit fails the test, as does an unaligned erase.
+ * Files are written through the L: drive, then the power is cut after a random
+ * number of programs and erases: the cut program writes only a part of its bytes
+ * and everything after it fails. After each cut the file system is mounted again,
+ * and every file has to hold either its old or its new content. The erases per
+ * sector are printed at the end. Every read of the mapped flash has to be in an
+ * lvgl_ospi_read_begin() bracket. Build it with LVGL, LittleFS and an lv_conf.h for
+ * the host (LV_USE_OS LV_OS_NONE, LV_USE_FS_LITTLEFS 1, LV_FS_LITTLEFS_LETTER 'L'),
+ * e.g. from the directory above lvgl/ and littlefs/:
+ *
+ *   cc -O2 -I. -Ilittlefs -Ipath/to/Tools/host -Ipath/to/Core/Inc -DLV_CONF_INCLUDE_SIMPLE \
+ *      path/to/Tools/lvgl_littlefs_host.c path/to/Core/Src/lvgl_port_littlefs.c \
+ *      littlefs/lfs.c littlefs/lfs_util.c $(find lvgl/src -name '*.c') -lm -o lvgl_littlefs_host
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lvgl/lvgl.h"
+#include "lvgl_port_littlefs.h"
+#include "lvgl_port_ospi.h"
+
+#define HOST_FILES        8
+#define HOST_FILE_MAX     3000
+/* every file keeps its size, lv_fs has no truncate and LVGL's drive may not open with one */
+#define HOST_FILE_SIZE(i) (200 + (i) * 350)
+#define HOST_ROUNDS       300
+#define HOST_CUT_MAX      80          /* programs and erases before a power cut */
+#define HOST_SECTORS      (LITTLEFS_FLASH_SIZE / OSPI_SECTOR_SIZE)
+
+typedef struct
+{
+  uint8_t  data[HOST_FILE_MAX];
+  uint32_t size;
+  bool     exists;
+} host_file_t;
+
+static uint8_t *flash;
+static uint32_t erase_cnt[HOST_SECTORS];
+
+/* operations left before the power is cut, -1 for none */
+static int32_t power_left = -1;
+static bool power_off;
+
+/* depth of the lvgl_ospi_read_begin() brackets */
+static uint32_t read_depth;
+
+static host_file_t files[HOST_FILES];
+static host_file_t next[HOST_FILES];
+static uint32_t failed;
+
+/**********************
+ *   NOR MODEL
+ **********************/
+
+static bool
+host_power (void)
+{
+  if (power_off)
+    {
+      return false;
+    }
+  if (power_left > 0)
+    {
+      power_left--;
+    }
+  else if (power_left == 0)
+    {
+      power_off = true;
+    }
+
+  return true;
+}
+
+static void
+host_fail (const char *what,
+           uint32_t    offset)
+{
+  printf("FAIL %s at 0x%08x\n", what, (unsigned)offset);
+  failed++;
+}
+
+void
+lvgl_ospi_read_begin (void)
+{
+  read_depth++;
+}
+
+void
+lvgl_ospi_read_end (void)
+{
+  if (read_depth == 0)
+    {
+      host_fail("read bracket not open", 0);
+      return;
+    }
+  read_depth--;
+}
+
+static uint8_t *
+host_ptr (uint32_t offset)
+{
+  if (offset < LITTLEFS_FLASH_OFFSET || offset >= LITTLEFS_FLASH_OFFSET + LITTLEFS_FLASH_SIZE)
+    {
+      host_fail("read outside the region", offset);
+      return flash;
+    }
+
+  return flash + offset - LITTLEFS_FLASH_OFFSET;
+}
+
+/* the file system reads the mapped flash, a program or an erase may run meanwhile */
+const void *
+lvgl_ospi_get_ptr (uint32_t offset)
+{
+  if (read_depth == 0)
+    {
+      host_fail("read outside a read bracket", offset);
+    }
+
+  return host_ptr(offset);
+}
+
+lv_result_t
+lvgl_ospi_program (uint32_t    offset,
+                   const void *buf,
+                   uint32_t    size)
+{
+  const uint8_t *src = buf;
+  uint8_t *dst = host_ptr(offset);
+  uint32_t i;
+
+  if (offset / OSPI_PAGE_SIZE != (offset + size - 1) / OSPI_PAGE_SIZE)
+    {
+      host_fail("program across a page", offset);
+    }
+
+  if (!host_power())
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  /* the program the power is cut in writes only a part */
+  if (power_off)
+    {
+      size = rand() % (size + 1);
+    }
+
+  for (i = 0; i < size; i++)
+    {
+      if ((dst[i] & src[i]) != src[i])
+        {
+          host_fail("program without erase", offset + i);
+        }
+      dst[i] &= src[i];
+    }
+
+  return power_off ? LV_RESULT_INVALID : LV_RESULT_OK;
+}
+
+lv_result_t
+lvgl_ospi_erase (uint32_t offset,
+                 uint32_t size)
+{
+  uint8_t *dst = host_ptr(offset);
+  uint32_t i;
+
+  if (offset % OSPI_SECTOR_SIZE != 0 || size % OSPI_SECTOR_SIZE != 0)
+    {
+      host_fail("erase not sector aligned", offset);
+    }
+
+  if (!host_power())
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  /* an erase cut short leaves the sector neither erased nor as it was */
+  if (power_off)
+    {
+      for (i = 0; i < size; i++)
+        {
+          dst[i] |= rand() % 2 ? 0xFF : 0x00;
+        }
+      return LV_RESULT_INVALID;
+    }
+
+  memset(dst, 0xFF, size);
+  for (i = 0; i < size / OSPI_SECTOR_SIZE; i++)
+    {
+      erase_cnt[(offset - LITTLEFS_FLASH_OFFSET) / OSPI_SECTOR_SIZE + i]++;
+    }
+
+  return LV_RESULT_OK;
+}
+
+/**********************
+ *   TEST
+ **********************/
+
+static void
+host_path (char    *path,
+           uint32_t i)
+{
+  sprintf(path, "%c:/file%u.bin", LV_FS_LITTLEFS_LETTER, (unsigned)i);
+}
+
+static bool
+host_write (uint32_t           i,
+            const host_file_t *f)
+{
+  lv_fs_file_t file;
+  char path[32];
+  uint32_t bw;
+  bool ok;
+
+  host_path(path, i);
+  if (lv_fs_open(&file, path, LV_FS_MODE_WR) != LV_FS_RES_OK)
+    {
+      return false;
+    }
+
+  ok = lv_fs_write(&file, f->data, f->size, &bw) == LV_FS_RES_OK && bw == f->size;
+  ok &= lv_fs_close(&file) == LV_FS_RES_OK;
+
+  return ok;
+}
+
+/* The content of the file `i`, or exists = false */
+static void
+host_read (uint32_t     i,
+           host_file_t *f)
+{
+  lv_fs_file_t file;
+  char path[32];
+  uint8_t extra;
+  uint32_t br;
+
+  host_path(path, i);
+  f->exists = lv_fs_open(&file, path, LV_FS_MODE_RD) == LV_FS_RES_OK;
+  f->size = 0;
+  if (!f->exists)
+    {
+      return;
+    }
+
+  lv_fs_read(&file, f->data, HOST_FILE_MAX, &f->size);
+  if (lv_fs_read(&file, &extra, 1, &br) == LV_FS_RES_OK && br != 0)
+    {
+      f->size = HOST_FILE_MAX + 1;
+    }
+  lv_fs_close(&file);
+}
+
+static bool
+host_same (const host_file_t *a,
+           const host_file_t *b)
+{
+  if (!a->exists || !b->exists)
+    {
+      return a->exists == b->exists;
+    }
+
+  return a->size == b->size && memcmp(a->data, b->data, a->size) == 0;
+}
+
+static void
+host_round (uint32_t round)
+{
+  host_file_t now;
+  uint32_t i;
+  uint32_t j;
+  uint32_t k = rand() % HOST_FILES;
+  bool written;
+
+  memcpy(next, files, sizeof(files));
+  next[k].exists = true;
+  next[k].size = HOST_FILE_SIZE(k);
+  for (j = 0; j < next[k].size; j++)
+    {
+      next[k].data[j] = (uint8_t)(rand() ^ round);
+    }
+
+  /* every other round is cut short */
+  power_left = round % 2 ? rand() % HOST_CUT_MAX : -1;
+  power_off = false;
+
+  written = host_write(k, &next[k]);
+  if (!written && power_left == -1)
+    {
+      printf("FAIL file %u not written in round %u\n", (unsigned)k, (unsigned)round);
+      failed++;
+    }
+
+  /* a reboot */
+  power_left = -1;
+  power_off = false;
+  if (lvgl_littlefs_init() != LV_RESULT_OK)
+    {
+      printf("FAIL not mounted after round %u\n", (unsigned)round);
+      failed++;
+      return;
+    }
+
+  for (i = 0; i < HOST_FILES; i++)
+    {
+      host_read(i, &now);
+      if ((i == k && written) ? !host_same(&now, &next[k]) :
+          !host_same(&now, &files[i]) && !(i == k && host_same(&now, &next[k])))
+        {
+          printf("FAIL file %u neither old nor new after round %u\n", (unsigned)i, (unsigned)round);
+          failed++;
+        }
+      if (i == k)
+        {
+          files[k] = now;
+        }
+    }
+}
+
+int
+main (void)
+{
+  lvgl_littlefs_stats_t stats;
+  uint32_t erases = 0;
+  uint32_t max = 0;
+  uint32_t i;
+
+  srand(1);
+  flash = malloc(LITTLEFS_FLASH_SIZE);
+  memset(flash, 0xFF, LITTLEFS_FLASH_SIZE);
+
+  lv_init();
+
+  /* a blank region is formatted by the first mount */
+  if (lvgl_littlefs_init() != LV_RESULT_OK)
+    {
+      printf("FAIL the blank region isn't formatted\n");
+      return 1;
+    }
+
+  for (i = 0; i < HOST_ROUNDS; i++)
+    {
+      host_round(i);
+    }
+
+  for (i = 0; i < HOST_SECTORS; i++)
+    {
+      erases += erase_cnt[i];
+      max = LV_MAX(max, erase_cnt[i]);
+    }
+  lvgl_littlefs_get_stats(&stats);
+
+  printf("%u rounds, %u blocks used, %u erases, at most %u per sector\n", (unsigned)HOST_ROUNDS,
+         (unsigned)stats.blocks_used, (unsigned)erases, (unsigned)max);
+  if (read_depth != 0)
+    {
+      host_fail("read bracket left open", 0);
+    }
+  printf("%u failed\n", (unsigned)failed);
+
+  return failed != 0;
+}
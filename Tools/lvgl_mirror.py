@@ -0,0 +1,278 @@
+#!/usr/bin/env python3
+"""Show the display mirrored by lvgl_port_mirror over USB and drive it with the mouse.
+
+The device sends the changed rectangles of each refresh, RGB565 run length
+encoded, and reads pointer events back. Needs pyusb, the viewer needs pygame
+and numpy too.
+
+    lvgl_mirror.py --view              show the display, the mouse is its pointer
+    lvgl_mirror.py                     print the throughput each second
+    lvgl_mirror.py --bench 200         measure the latency of pointer events
+"""
+
+import argparse
+import statistics
+import struct
+import sys
+import time
+
+import usb.core
+import usb.util
+
+VID = 0x1209
+PID = 0x0001
+EP_IN = 0x81
+EP_OUT = 0x01
+
+MAGIC = 0x4D4C  # "LM"
+
+MSG = struct.Struct("<HBBHHHHI")
+MSG_RECT_RAW = 1
+MSG_RECT_RLE = 2
+MSG_FRAME = 3
+MSG_DATA = 4
+
+FRAME = struct.Struct("<IIIIII")
+
+IN = struct.Struct("<HBBhhI")
+IN_POINTER = 1
+IN_REFRESH = 2
+
+# lv_color_format_t
+CF_RGB565 = 0x12
+CF_BPP = {0x12: 2, 0x0F: 3, 0x10: 4, 0x11: 4}
+
+READ_SIZE = 256 * 1024
+
+
+def decode_rle(data, count):
+    """RGB565 pixels of the device's run length encoding, as little endian bytes"""
+    out = bytearray()
+    pos = 0
+    while len(out) < count * 2:
+        ctrl = data[pos]
+        pos += 1
+        if ctrl < 128:
+            n = (ctrl + 1) * 2
+            out += data[pos:pos + n]
+            pos += n
+        else:
+            out += data[pos:pos + 2] * (ctrl - 126)
+            pos += 2
+    if len(out) != count * 2 or pos != len(data):
+        raise ValueError("corrupt RLE rectangle")
+    return out
+
+
+class Mirror:
+    def __init__(self):
+        self.dev = usb.core.find(idVendor=VID, idProduct=PID)
+        if self.dev is None:
+            sys.exit("no device %04x:%04x" % (VID, PID))
+        self.dev.set_configuration()
+        usb.util.claim_interface(self.dev, 0)
+
+        self.stream = bytearray()
+        self.data = bytearray()  # of lvgl_port_replay
+        self.rects = []
+        self.fb = None
+        self.size = (0, 0)
+        self.bpp = 2
+        self.cf = CF_RGB565
+        self.seq = 0
+
+        self.wire_bytes = 0
+        self.decode_s = 0.0
+
+    def send_pointer(self, x, y, pressed):
+        self.seq += 1
+        self.dev.write(EP_OUT, IN.pack(MAGIC, IN_POINTER, pressed, x, y, self.seq))
+        return self.seq
+
+    def write(self, data):
+        self.dev.write(EP_OUT, data)
+
+    def request_refresh(self):
+        self.dev.write(EP_OUT, IN.pack(MAGIC, IN_REFRESH, 0, 0, 0, 0))
+
+    def poll(self, timeout=100):
+        """Read what the device sent, returns the completed frames"""
+        try:
+            data = self.dev.read(EP_IN, READ_SIZE, timeout)
+        except usb.core.USBTimeoutError:
+            return []
+        self.wire_bytes += len(data)
+        self.stream += data
+
+        frames = []
+        while len(self.stream) >= MSG.size:
+            magic, kind, cf, x, y, w, h, size = MSG.unpack_from(self.stream)
+            if magic != MAGIC:
+                # out of step, e.g. after a dropped transfer
+                self.stream.clear()
+                self.rects.clear()
+                self.request_refresh()
+                break
+            if len(self.stream) < MSG.size + size:
+                break
+            payload = bytes(self.stream[MSG.size:MSG.size + size])
+            del self.stream[:MSG.size + size]
+
+            if kind == MSG_FRAME:
+                frames.append(self.apply_frame(cf, w, h, FRAME.unpack(payload)))
+            elif kind == MSG_DATA:
+                self.data += payload
+            else:
+                self.rects.append((kind, x, y, w, h, payload))
+        return frames
+
+    def apply_frame(self, cf, w, h, frame):
+        if self.fb is None or self.size != (w, h) or self.cf != cf:
+            self.size = (w, h)
+            self.cf = cf
+            self.bpp = CF_BPP.get(cf, 2)
+            self.fb = bytearray(w * h * self.bpp)
+
+        start = time.perf_counter()
+        for kind, x, y, rw, rh, payload in self.rects:
+            if kind == MSG_RECT_RLE:
+                payload = decode_rle(payload, rw * rh)
+            line = rw * self.bpp
+            for row in range(rh):
+                dst = ((y + row) * w + x) * self.bpp
+                self.fb[dst:dst + line] = payload[row * line:(row + 1) * line]
+        self.decode_s += time.perf_counter() - start
+        self.rects.clear()
+
+        keys = ("seq", "seq_ack", "time_ms", "encode_us", "raw_bytes", "encoded_bytes")
+        return dict(zip(keys, frame))
+
+
+def print_stats(mirror):
+    frames = raw = encoded = encode_us = 0
+    last = time.monotonic()
+    while True:
+        for f in mirror.poll():
+            frames += 1
+            raw += f["raw_bytes"]
+            encoded += f["encoded_bytes"]
+            encode_us += f["encode_us"]
+        now = time.monotonic()
+        if now - last >= 1:
+            secs = now - last
+            print("%3d fps  %6.2f MB/s on the wire  %5.1f%% of raw  encoder %6.1f MB/s  decoder %6.1f MB/s" %
+                  (frames / secs, mirror.wire_bytes / secs / 1e6, encoded * 100 / max(raw, 1),
+                   raw / max(encode_us, 1), raw / max(mirror.decode_s, 1e-6) / 1e6))
+            frames = raw = encoded = encode_us = 0
+            mirror.wire_bytes = 0
+            mirror.decode_s = 0.0
+            last = now
+
+
+def bench(mirror, count, x, y):
+    """Time from a pointer event to the frame which was rendered after it was read.
+
+    This includes the indev read period, the rendering, the encoding and the
+    transfer, so the UI has to refresh, e.g. the benchmark demo."""
+    # the first frames bring the whole screen
+    end = time.monotonic() + 2
+    while time.monotonic() < end:
+        mirror.poll()
+    mirror.wire_bytes = 0
+    mirror.decode_s = 0.0
+
+    latencies = []
+    raw = encoded = encode_us = 0
+    start = time.monotonic()
+    for _ in range(count):
+        sent = time.perf_counter()
+        seq = mirror.send_pointer(x, y, 0)
+        deadline = sent + 1
+        done = False
+        while not done and time.perf_counter() < deadline:
+            for f in mirror.poll(10):
+                raw += f["raw_bytes"]
+                encoded += f["encoded_bytes"]
+                encode_us += f["encode_us"]
+                if f["seq_ack"] >= seq:
+                    latencies.append((time.perf_counter() - sent) * 1000)
+                    done = True
+        if not done:
+            print("event %d: no frame within 1 s" % seq)
+    secs = time.monotonic() - start
+
+    if not latencies:
+        sys.exit("no event was acknowledged, does the UI refresh?")
+    latencies.sort()
+    print("latency of %d events: min %.1f ms, median %.1f ms, 95%% %.1f ms, max %.1f ms" %
+          (len(latencies), latencies[0], statistics.median(latencies),
+           latencies[int(len(latencies) * 0.95) - 1], latencies[-1]))
+    print("encoder: %.1f MB of pixels in %.1f ms, %.1f MB/s, %.1f%% of raw" %
+          (raw / 1e6, encode_us / 1000, raw / max(encode_us, 1), encoded * 100 / max(raw, 1)))
+    print("wire: %.2f MB/s, decoder: %.1f MB/s" %
+          (mirror.wire_bytes / secs / 1e6, raw / max(mirror.decode_s, 1e-6) / 1e6))
+
+
+def view(mirror, scale):
+    import numpy
+    import pygame
+
+    pygame.init()
+    screen = None
+    pressed = 0
+
+    while True:
+        frames = mirror.poll(10)
+        if frames and mirror.fb is not None:
+            w, h = mirror.size
+            if screen is None:
+                screen = pygame.display.set_mode((w * scale, h * scale))
+                pygame.display.set_caption("LVGL mirror")
+            if mirror.bpp == 2:
+                px = numpy.frombuffer(mirror.fb, "<u2").reshape(h, w)
+                rgb = numpy.dstack((((px >> 11) & 0x1F) << 3, ((px >> 5) & 0x3F) << 2, (px & 0x1F) << 3))
+            else:
+                px = numpy.frombuffer(mirror.fb, numpy.uint8).reshape(h, w, mirror.bpp)
+                rgb = px[:, :, 2::-1]
+            surface = pygame.surfarray.make_surface(rgb.astype(numpy.uint8).swapaxes(0, 1))
+            screen.blit(pygame.transform.scale(surface, screen.get_size()), (0, 0))
+            pygame.display.flip()
+
+        for event in pygame.event.get():
+            if event.type == pygame.QUIT:
+                return
+            if event.type == pygame.MOUSEBUTTONDOWN and event.button == 1:
+                pressed = 1
+            elif event.type == pygame.MOUSEBUTTONUP and event.button == 1:
+                pressed = 0
+            elif event.type != pygame.MOUSEMOTION:
+                continue
+            mx, my = pygame.mouse.get_pos()
+            mirror.send_pointer(mx // scale, my // scale, pressed)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--view", action="store_true", help="show the display in a window")
+    parser.add_argument("--scale", type=int, default=1, help="of the window")
+    parser.add_argument("--bench", type=int, metavar="N", help="send N pointer events and time the frames")
+    parser.add_argument("--x", type=int, default=0, help="of the benchmark events, released")
+    parser.add_argument("--y", type=int, default=0)
+    args = parser.parse_args()
+
+    mirror = Mirror()
+    mirror.request_refresh()
+
+    try:
+        if args.bench:
+            bench(mirror, args.bench, args.x, args.y)
+        elif args.view:
+            view(mirror, args.scale)
+        else:
+            print_stats(mirror)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""Record, inject and replay input of lvgl_port_replay over the mirror's USB link.
+
+A recording is a file of 16 byte events, the same the device and
+lvgl_replay_host.c replay. A replay reports the refresh times measured on the
+device, which are compared with a baseline. Needs pyusb.
+
+    lvgl_replay.py record session.lvrp        until Ctrl-C
+    lvgl_replay.py play session.lvrp --baseline base.json
+    lvgl_replay.py play session.lvrp --save-baseline base.json
+    lvgl_replay.py tap 400 240
+    lvgl_replay.py key 10                     LV_KEY_ENTER
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+
+from lvgl_mirror import Mirror
+
+MAGIC = 0x524C  # "LR"
+EVENT = struct.Struct("<HBBIhhI")
+
+EV_POINTER = 0x01
+EV_KEY = 0x02
+EV_END = 0x03
+EV_SCRIPT = 0x80
+
+CMD_CLEAR = 0x10
+CMD_PLAY = 0x11
+CMD_RECORD = 0x12
+CMD_STOP = 0x13
+
+MSG_RESULT = 0x20
+RESULT = struct.Struct("<7I")
+RESULT_KEYS = ("events", "frames", "time_ms", "avg_us", "p50_us", "p95_us", "max_us")
+
+# the device takes REPLAY_QUEUE_CNT events per indev read, every 33 ms
+UPLOAD_BATCH = 32
+UPLOAD_PAUSE_MS = 50
+
+
+def command(mirror, cmd):
+    mirror.write(EVENT.pack(MAGIC, cmd, 0, 0, 0, 0, 0))
+
+
+def read_events(mirror, until, timeout):
+    """Poll until `until(events, result)` is true, returns both"""
+    end = time.monotonic() + timeout
+    while time.monotonic() < end:
+        mirror.poll(20)
+        events = []
+        result = None
+        pos = 0
+        data = mirror.data
+        while pos + EVENT.size <= len(data):
+            ev = EVENT.unpack_from(data, pos)
+            pos += EVENT.size
+            if ev[1] == MSG_RESULT:
+                if pos + ev[6] > len(data):
+                    break
+                result = dict(zip(RESULT_KEYS, RESULT.unpack_from(data, pos)))
+                pos += ev[6]
+            else:
+                events.append(ev)
+        if until(events, result):
+            mirror.data.clear()
+            return events, result
+    sys.exit("no answer from the device")
+
+
+def record(mirror, path):
+    mirror.data.clear()
+    command(mirror, CMD_RECORD)
+    print("recording, Ctrl-C to stop")
+    try:
+        while True:
+            mirror.poll(100)
+    except KeyboardInterrupt:
+        pass
+    command(mirror, CMD_STOP)
+
+    events, _ = read_events(mirror, lambda evs, res: evs and evs[-1][1] == EV_END, 5)
+    with open(path, "wb") as f:
+        for ev in events:
+            f.write(EVENT.pack(*ev))
+    print("%d events in %.1f s" % (len(events) - 1, events[-1][3] / 1000))
+
+
+def play(mirror, path, baseline, save, tolerance):
+    with open(path, "rb") as f:
+        data = f.read()
+    events = [EVENT.unpack_from(data, pos) for pos in range(0, len(data) - EVENT.size + 1, EVENT.size)]
+
+    command(mirror, CMD_CLEAR)
+    for i in range(0, len(events), UPLOAD_BATCH):
+        batch = b"".join(EVENT.pack(ev[0], ev[1] | EV_SCRIPT, *ev[2:]) for ev in events[i:i + UPLOAD_BATCH])
+        mirror.write(batch)
+        mirror.poll(UPLOAD_PAUSE_MS)
+    mirror.data.clear()
+    command(mirror, CMD_PLAY)
+
+    length = max((ev[3] for ev in events), default=0)
+    _, result = read_events(mirror, lambda evs, res: res is not None, length / 1000 + 10)
+    print("%(events)d events, %(frames)d refreshes in %(time_ms)d ms: "
+          "avg %(avg_us)d us, median %(p50_us)d us, 95%% %(p95_us)d us, max %(max_us)d us" % result)
+
+    if save:
+        with open(save, "w") as f:
+            json.dump(result, f, indent=2)
+    if baseline:
+        with open(baseline) as f:
+            base = json.load(f)
+        regressed = False
+        for key in ("avg_us", "p95_us"):
+            if result[key] * 100 > base[key] * (100 + tolerance):
+                print("regression: %s %d, baseline %d" % (key, result[key], base[key]))
+                regressed = True
+        if result["frames"] != base["frames"]:
+            print("the replay refreshed %d times, the baseline %d" % (result["frames"], base["frames"]))
+        if regressed:
+            sys.exit(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("record")
+    p.add_argument("file")
+    p = sub.add_parser("play")
+    p.add_argument("file")
+    p.add_argument("--baseline", help="json of an earlier replay to compare with")
+    p.add_argument("--save-baseline", metavar="FILE", help="write the result as a baseline")
+    p.add_argument("--tolerance", type=int, default=10, help="percent slower which is accepted")
+    p = sub.add_parser("tap", help="press and release the virtual pointer")
+    p.add_argument("x", type=int)
+    p.add_argument("y", type=int)
+    p = sub.add_parser("key", help="press and release a key of the virtual keypad")
+    p.add_argument("key", type=int)
+    args = parser.parse_args()
+
+    mirror = Mirror()
+
+    if args.cmd == "record":
+        record(mirror, args.file)
+    elif args.cmd == "play":
+        play(mirror, args.file, args.baseline, args.save_baseline, args.tolerance)
+    elif args.cmd == "tap":
+        mirror.write(EVENT.pack(MAGIC, EV_POINTER, 1, 0, args.x, args.y, 0) +
+                     EVENT.pack(MAGIC, EV_POINTER, 0, 0, args.x, args.y, 0))
+    elif args.cmd == "key":
+        mirror.write(EVENT.pack(MAGIC, EV_KEY, 1, 0, 0, 0, args.key) +
+                     EVENT.pack(MAGIC, EV_KEY, 0, 0, 0, 0, args.key))
+
+
+if __name__ == "__main__":
+    main()
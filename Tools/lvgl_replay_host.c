@@ -0,0 +1,169 @@
+/* Replay a recording of lvgl_port_replay on the host, without a window.
+ *
+ * LVGL's tick is simulated, one millisecond per lv_timer_handler() call, so every run
+ * applies the events at the same refreshes. The refresh times are taken with the
+ * host's clock. Build it with LVGL and an lv_conf.h for the host (LV_USE_OS
+ * LV_OS_NONE, LV_USE_DEMO_BENCHMARK 1), e.g. from the directory above lvgl/:
+ *
+ *   cc -O2 -I. -Ipath/to/Core/Inc -DLV_CONF_INCLUDE_SIMPLE \
+ *      path/to/Tools/lvgl_replay_host.c path/to/Core/Src/lvgl_port_replay.c \
+ *      $(find lvgl/src lvgl/demos -name '*.c') -lm -o lvgl_replay_host
+ *
+ *   lvgl_replay_host session.lvrp                      print the refresh times
+ *   lvgl_replay_host session.lvrp base.txt             compare with a baseline, or write it
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "lvgl/lvgl.h"
+#include "lvgl/demos/lv_demos.h"
+#include "lvgl_port_replay.h"
+
+#define HOST_HOR_RES    800
+#define HOST_VER_RES    480
+#define HOST_TOLERANCE  10
+
+static uint32_t tick;
+static bool done;
+static lvgl_replay_result_t result;
+
+static uint32_t
+host_tick (void)
+{
+  return tick;
+}
+
+static uint32_t
+host_clock (void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+static void
+host_flush (lv_display_t  *disp,
+            const lv_area_t *area,
+            uint8_t       *px_map)
+{
+  LV_UNUSED(area);
+  LV_UNUSED(px_map);
+
+  lv_display_flush_ready(disp);
+}
+
+static void
+host_done (const lvgl_replay_result_t *res)
+{
+  result = *res;
+  done = true;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  static uint8_t buf[HOST_HOR_RES * HOST_VER_RES / 10 * 4];
+  lvgl_replay_result_t baseline;
+  lvgl_replay_event_t *events;
+  lv_display_t *disp;
+  long size;
+  FILE *f;
+
+  if (argc < 2)
+    {
+      fprintf(stderr, "usage: %s recording [baseline]\n", argv[0]);
+      return 2;
+    }
+
+  f = fopen(argv[1], "rb");
+  if (f == NULL)
+    {
+      perror(argv[1]);
+      return 2;
+    }
+  fseek(f, 0, SEEK_END);
+  size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  events = malloc(size);
+  if (events == NULL || fread(events, 1, size, f) != (size_t)size)
+    {
+      fprintf(stderr, "%s: can't be read\n", argv[1]);
+      return 2;
+    }
+  fclose(f);
+
+  lv_init();
+  lv_tick_set_cb(host_tick);
+
+  disp = lv_display_create(HOST_HOR_RES, HOST_VER_RES);
+  lv_display_set_flush_cb(disp, host_flush);
+  lv_display_set_buffers(disp, buf, NULL, sizeof(buf), LV_DISPLAY_RENDER_MODE_PARTIAL);
+
+  lvgl_replay_init(disp);
+  lvgl_replay_set_clock(host_clock, 1);
+
+#if LV_USE_DEMO_BENCHMARK
+  lv_demo_benchmark();
+#else
+  lv_demo_widgets();
+#endif
+
+  if (lvgl_replay_play(events, size / sizeof(lvgl_replay_event_t), host_done) != LV_RESULT_OK)
+    {
+      return 2;
+    }
+  while (!done)
+    {
+      lv_timer_handler();
+      tick++;
+    }
+
+  printf("events %u frames %u time_ms %u avg_us %u p50_us %u p95_us %u max_us %u\n",
+         (unsigned)result.events, (unsigned)result.frames, (unsigned)result.time_ms,
+         (unsigned)result.avg_us, (unsigned)result.p50_us, (unsigned)result.p95_us,
+         (unsigned)result.max_us);
+
+  if (argc < 3)
+    {
+      return 0;
+    }
+
+  f = fopen(argv[2], "r");
+  if (f == NULL)
+    {
+      /* the first run makes the baseline */
+      f = fopen(argv[2], "w");
+      if (f == NULL)
+        {
+          perror(argv[2]);
+          return 2;
+        }
+      fprintf(f, "%u %u %u %u %u %u %u\n", (unsigned)result.events, (unsigned)result.frames,
+              (unsigned)result.time_ms, (unsigned)result.avg_us, (unsigned)result.p50_us,
+              (unsigned)result.p95_us, (unsigned)result.max_us);
+      fclose(f);
+      return 0;
+    }
+
+  if (fscanf(f, "%u %u %u %u %u %u %u", &baseline.events, &baseline.frames, &baseline.time_ms,
+             &baseline.avg_us, &baseline.p50_us, &baseline.p95_us, &baseline.max_us) != 7)
+    {
+      fprintf(stderr, "%s: not a baseline\n", argv[2]);
+      return 2;
+    }
+  fclose(f);
+
+  if (lvgl_replay_compare(&result, &baseline, HOST_TOLERANCE) != LV_RESULT_OK)
+    {
+      printf("regression against %s\n", argv[2]);
+      return 1;
+    }
+
+  return 0;
+}
@@ -0,0 +1,224 @@
+/* Benchmark lvgl_port_stream on the host, without a window.
+ *
+ * A stream chart of the panel size is fed 1 M samples per second of simulated time,
+ * for histories from 64 K to 16 M samples, zoomed out so the screen shows the whole
+ * history. Each refresh is timed with the host's clock, the samples taken and the
+ * columns drawn included. An lv_chart with as many points is timed for comparison,
+ * up to 256 K points. Build it with LVGL and an lv_conf.h for the host (LV_USE_OS
+ * LV_OS_NONE, LV_USE_CHART 1), e.g. from the directory above lvgl/:
+ *
+ *   cc -O2 -I. -Ipath/to/Core/Inc -DLV_CONF_INCLUDE_SIMPLE \
+ *      path/to/Tools/lvgl_stream_host.c path/to/Core/Src/lvgl_port_stream.c \
+ *      $(find lvgl/src -name '*.c') -lm -o lvgl_stream_host
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+
+#include "lvgl/lvgl.h"
+#include "lvgl_port_stream.h"
+
+#define HOST_HOR_RES      800
+#define HOST_VER_RES      480
+#define HOST_RATE         1000000       /* samples per second */
+#define HOST_FRAMES       100
+#define HOST_CHART_MAX    (256 * 1024)
+#define HOST_BATCH        (HOST_RATE / 1000 * LV_DEF_REFR_PERIOD)
+
+static uint32_t tick;
+static int16_t batch[HOST_BATCH];
+static uint32_t phase;
+
+static uint32_t
+host_tick (void)
+{
+  return tick;
+}
+
+static double
+host_now_us (void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void
+host_flush (lv_display_t  *disp,
+            const lv_area_t *area,
+            uint8_t       *px_map)
+{
+  LV_UNUSED(area);
+  LV_UNUSED(px_map);
+
+  lv_display_flush_ready(disp);
+}
+
+/* a slow sine with noise and a spike now and then, which the min/max has to keep */
+static void
+host_fill (int16_t *buf,
+           uint32_t cnt)
+{
+  uint32_t i;
+
+  for (i = 0; i < cnt; i++, phase++)
+    {
+      buf[i] = (int16_t)(12000 * sin(phase * 2e-5) + rand() % 2000 - 1000);
+      if (phase % 100003 == 0)
+        {
+          buf[i] = 30000;
+        }
+    }
+}
+
+/* One refresh period: the samples of the period are written, then LVGL refreshes */
+static double
+host_frame (int32_t id)
+{
+  double start;
+
+  host_fill(batch, HOST_BATCH);
+  start = host_now_us();
+  lvgl_stream_write(id, batch, HOST_BATCH);
+  tick += LV_DEF_REFR_PERIOD;
+  lv_timer_handler();
+
+  return host_now_us() - start;
+}
+
+static void
+host_bench_stream (uint32_t           history,
+                   lvgl_stream_mode_t mode)
+{
+  uint32_t size = history * 3;
+  void *buf = malloc(size);
+  lvgl_stream_stats_t stats;
+  lv_obj_t *obj;
+  double us = 0;
+  double max_us = 0;
+  double t;
+  double rebuild;
+  uint32_t written;
+  uint32_t i;
+  int32_t id;
+
+  obj = lvgl_stream_create(lv_screen_active(), buf, size, mode);
+  id = lvgl_stream_get_id(obj);
+  lv_obj_set_size(obj, LV_PCT(100), LV_PCT(100));
+  lv_obj_set_style_pad_all(obj, 0, 0);
+  lv_obj_set_style_border_width(obj, 0, 0);
+  lv_obj_set_style_radius(obj, 0, 0);
+  lvgl_stream_set_range(obj, -16000, 32000);
+  lv_timer_handler();
+
+  lvgl_stream_get_stats(obj, &stats);
+
+  /* the history is filled first */
+  for (written = 0; written < stats.capacity; written += HOST_BATCH)
+    {
+      host_fill(batch, HOST_BATCH);
+      lvgl_stream_write(id, batch, HOST_BATCH);
+      lvgl_stream_update(obj);
+    }
+
+  /* the whole history on the screen, the worst case for the pyramid */
+  t = host_now_us();
+  lvgl_stream_set_view(obj, (stats.capacity - stats.capacity / 8) / HOST_HOR_RES, 0);
+  rebuild = host_now_us() - t;
+  lv_timer_handler();
+
+  for (i = 0; i < HOST_FRAMES; i++)
+    {
+      t = host_frame(id);
+      us += t;
+      max_us = LV_MAX(max_us, t);
+    }
+
+  lvgl_stream_get_stats(obj, &stats);
+  printf("stream %-6s %9u samples  %2u levels  refresh avg %7.1f us  max %7.1f us  zoom %7.1f us  "
+         "%5u px/frame invalidated\n",
+         mode == STREAM_MODE_SWEEP ? "sweep" : "scroll", (unsigned)stats.capacity,
+         (unsigned)stats.levels, us / HOST_FRAMES, max_us, rebuild,
+         (unsigned)(stats.invalidated_px / (HOST_FRAMES + 1)));
+
+  lv_obj_delete(obj);
+  free(buf);
+}
+
+static void
+host_bench_chart (uint32_t points)
+{
+  lv_chart_series_t *ser;
+  lv_obj_t *chart;
+  double us = 0;
+  double t;
+  uint32_t i;
+  uint32_t j;
+
+  chart = lv_chart_create(lv_screen_active());
+  lv_obj_set_size(chart, LV_PCT(100), LV_PCT(100));
+  lv_chart_set_point_count(chart, points);
+  lv_chart_set_axis_range(chart, LV_CHART_AXIS_PRIMARY_Y, -16000, 32000);
+  lv_chart_set_update_mode(chart, LV_CHART_UPDATE_MODE_SHIFT);
+  ser = lv_chart_add_series(chart, lv_color_black(), LV_CHART_AXIS_PRIMARY_Y);
+  lv_obj_set_style_size(chart, 0, 0, LV_PART_INDICATOR);
+
+  for (i = 0; i < points; i++)
+    {
+      host_fill(batch, 1);
+      lv_chart_set_next_value(chart, ser, batch[0]);
+    }
+  lv_timer_handler();
+
+  /* the same rate, lv_chart redraws every point of the series each refresh */
+  for (i = 0; i < HOST_FRAMES / 10; i++)
+    {
+      host_fill(batch, HOST_BATCH);
+      t = host_now_us();
+      for (j = 0; j < HOST_BATCH; j++)
+        {
+          lv_chart_set_next_value(chart, ser, batch[j]);
+        }
+      tick += LV_DEF_REFR_PERIOD;
+      lv_timer_handler();
+      us += host_now_us() - t;
+    }
+
+  printf("lv_chart      %9u points                refresh avg %7.1f us\n", (unsigned)points,
+         us / (HOST_FRAMES / 10));
+
+  lv_obj_delete(chart);
+}
+
+int
+main (void)
+{
+  static uint8_t buf[HOST_HOR_RES * HOST_VER_RES / 10 * 4];
+  lv_display_t *disp;
+  uint32_t history;
+
+  lv_init();
+  lv_tick_set_cb(host_tick);
+
+  disp = lv_display_create(HOST_HOR_RES, HOST_VER_RES);
+  lv_display_set_flush_cb(disp, host_flush);
+  lv_display_set_buffers(disp, buf, NULL, sizeof(buf), LV_DISPLAY_RENDER_MODE_PARTIAL);
+
+  for (history = 64 * 1024; history <= 16 * 1024 * 1024; history *= 4)
+    {
+      host_bench_stream(history, STREAM_MODE_SWEEP);
+      host_bench_stream(history, STREAM_MODE_SCROLL);
+    }
+
+  for (history = 4 * 1024; history <= HOST_CHART_MAX; history *= 4)
+    {
+      host_bench_chart(history);
+    }
+
+  return 0;
+}
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""Send an asset bundle to lvgl_port_update over the UART.
+
+The device writes it to the inactive OSPI slot, checks its SHA-256 and switches
+to it, the new bundle is used from the next boot. Needs pyserial.
+
+    lvgl_update.py -p /dev/ttyACM0 assets.lvpk
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+import time
+
+import serial
+
+MAGIC = 0x5055564C  # "LVUP"
+HEADER = struct.Struct("<II32s")
+
+CHUNK_SIZE = 4096
+SLOT_SIZE = 16 * 1024 * 1024
+MAX_SIZE = SLOT_SIZE - 4096
+
+ACK = b"K"
+NAK = b"E"
+
+# the first chunks wait for the erase of the slot, 16 MB take about a minute
+ACK_TIMEOUT = 120
+
+
+def wait_ack(port, what):
+    port.timeout = ACK_TIMEOUT
+    reply = port.read(1)
+    if reply == NAK:
+        sys.exit("%s: rejected by the device" % what)
+    if reply != ACK:
+        sys.exit("%s: no answer from the device" % what)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("-p", "--port", required=True, help="serial port of USART1")
+    parser.add_argument("-b", "--baudrate", type=int, default=921600)
+    parser.add_argument("bundle", help="bundle made by lvgl_bundle.py")
+    args = parser.parse_args()
+
+    with open(args.bundle, "rb") as f:
+        data = f.read()
+    if not 0 < len(data) <= MAX_SIZE:
+        sys.exit("%s: a bundle has to fit into a slot of %d bytes" % (args.bundle, MAX_SIZE))
+
+    digest = hashlib.sha256(data).digest()
+
+    with serial.Serial(args.port, args.baudrate) as port:
+        port.reset_input_buffer()
+        port.write(HEADER.pack(MAGIC, len(data), digest))
+        wait_ack(port, "header")
+
+        start = time.monotonic()
+        for pos in range(0, len(data), CHUNK_SIZE):
+            port.write(data[pos:pos + CHUNK_SIZE])
+            wait_ack(port, "chunk at %d" % pos)
+            print("\r%3d%%" % (min(pos + CHUNK_SIZE, len(data)) * 100 // len(data)), end="", flush=True)
+        secs = time.monotonic() - start
+
+    print("\r%s: %d bytes in %.1f s, %.1f KB/s, verified and switched" %
+          (args.bundle, len(data), secs, len(data) / 1024 / secs))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,547 @@
+/* Test lvgl_port_update on the host against a RAM model of the OSPI flash and a
+ * software model of the HASH.
+ *
+ * The flash model stands in for lvgl_port_ospi: the asynchronous jobs run at once,
+ * a program can only clear bits and an erase has to be sector aligned. The records
+ * and the bundle have to be read between lvgl_ospi_read_begin() and _end(), and the
+ * queued jobs mustn't be waited for in between, the OSPI task couldn't run them. The HASH model
+ * computes the SHA-256 in software and, like the peripheral, only finalizes the digest
+ * on a transfer started with MDMAT clear; a transfer with MDMAT set has to be a whole
+ * number of words. Images are written in pieces of random sizes, then the digest, the
+ * content of the slot and the switch of the active slot are checked, as well as the
+ * failures which have to keep the active slot, the refusal of a 2nd update until the
+ * reboot and a record cut before its commit word. Build it with LVGL, e.g. from the
+ * directory above lvgl/:
+ *
+ *   cc -O2 -I. -Ipath/to/Tools/host -Ipath/to/Core/Inc -DLV_CONF_INCLUDE_SIMPLE \
+ *      path/to/Tools/lvgl_update_host.c path/to/Core/Src/lvgl_port_update.c \
+ *      $(find lvgl/src -name '*.c') -lm -o lvgl_update_host
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lvgl/lvgl.h"
+#include "lvgl_port_update.h"
+#include "lvgl_port_bundle.h"
+#include "lvgl_port_trace.h"
+#include "hash.h"
+
+#define HOST_FLASH_SIZE   (UPDATE_SLOT_CNT * UPDATE_SLOT_SIZE)
+#define HOST_IMAGE_MAX    (5 * UPDATE_CHUNK_SIZE + 1000)
+#define HOST_PIECE_MAX    5000
+
+typedef struct
+{
+  uint32_t state[8];
+  uint64_t len;
+  uint8_t  block[64];
+  uint32_t fill;
+} host_sha_t;
+
+HASH_HandleTypeDef hhash;
+int host_hash_mdmat;
+
+static DMA_HandleTypeDef host_dma;
+static host_sha_t sha;
+static uint8_t sha_digest[UPDATE_DIGEST_SIZE];
+static bool sha_done;
+
+static uint8_t *flash;
+
+/* the program of the commit word fails, the power is cut before it */
+static bool cut_commit;
+static bool bundle_ok = true;
+
+/* lvgl_ospi_read_begin() without its _end() */
+static uint32_t read_depth;
+
+static uint8_t image[HOST_IMAGE_MAX];
+static uint32_t failed;
+
+/**********************
+ *   SHA-256
+ **********************/
+
+static const uint32_t sha_k[64] =
+{
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define SHA_ROR(x, n)  (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void
+sha_init (host_sha_t *s)
+{
+  static const uint32_t h0[8] =
+  {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+  };
+
+  memcpy(s->state, h0, sizeof(h0));
+  s->len = 0;
+  s->fill = 0;
+}
+
+static void
+sha_block (host_sha_t *s)
+{
+  uint32_t w[64];
+  uint32_t v[8];
+  uint32_t t1;
+  uint32_t t2;
+  uint32_t i;
+
+  for (i = 0; i < 16; i++)
+    {
+      w[i] = (uint32_t)s->block[i * 4] << 24 | (uint32_t)s->block[i * 4 + 1] << 16 |
+             (uint32_t)s->block[i * 4 + 2] << 8 | s->block[i * 4 + 3];
+    }
+  for (i = 16; i < 64; i++)
+    {
+      w[i] = w[i - 16] + (SHA_ROR(w[i - 15], 7) ^ SHA_ROR(w[i - 15], 18) ^ (w[i - 15] >> 3)) +
+             w[i - 7] + (SHA_ROR(w[i - 2], 17) ^ SHA_ROR(w[i - 2], 19) ^ (w[i - 2] >> 10));
+    }
+
+  memcpy(v, s->state, sizeof(v));
+  for (i = 0; i < 64; i++)
+    {
+      t1 = v[7] + (SHA_ROR(v[4], 6) ^ SHA_ROR(v[4], 11) ^ SHA_ROR(v[4], 25)) +
+           ((v[4] & v[5]) ^ (~v[4] & v[6])) + sha_k[i] + w[i];
+      t2 = (SHA_ROR(v[0], 2) ^ SHA_ROR(v[0], 13) ^ SHA_ROR(v[0], 22)) +
+           ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+      memmove(&v[1], &v[0], 7 * sizeof(v[0]));
+      v[4] += t1;
+      v[0] = t1 + t2;
+    }
+  for (i = 0; i < 8; i++)
+    {
+      s->state[i] += v[i];
+    }
+}
+
+static void
+sha_update (host_sha_t    *s,
+            const uint8_t *data,
+            uint32_t       size)
+{
+  while (size-- > 0)
+    {
+      s->block[s->fill++] = *data++;
+      s->len++;
+      if (s->fill == 64)
+        {
+          sha_block(s);
+          s->fill = 0;
+        }
+    }
+}
+
+static void
+sha_final (host_sha_t *s,
+           uint8_t     digest[UPDATE_DIGEST_SIZE])
+{
+  uint64_t bits = s->len * 8;
+  uint8_t pad = 0x80;
+  uint8_t len_be[8];
+  uint32_t i;
+
+  sha_update(s, &pad, 1);
+  pad = 0;
+  while (s->fill != 56)
+    {
+      sha_update(s, &pad, 1);
+    }
+  for (i = 0; i < 8; i++)
+    {
+      len_be[i] = (uint8_t)(bits >> (56 - i * 8));
+    }
+  sha_update(s, len_be, 8);
+
+  for (i = 0; i < UPDATE_DIGEST_SIZE; i++)
+    {
+      digest[i] = (uint8_t)(s->state[i / 4] >> (24 - (i % 4) * 8));
+    }
+}
+
+static void
+sha_of (const uint8_t *data,
+        uint32_t       size,
+        uint8_t        digest[UPDATE_DIGEST_SIZE])
+{
+  host_sha_t s;
+
+  sha_init(&s);
+  sha_update(&s, data, size);
+  sha_final(&s, digest);
+}
+
+/**********************
+ *   HASH MODEL
+ **********************/
+
+HAL_StatusTypeDef
+HAL_HASH_Init (HASH_HandleTypeDef *hhash_p)
+{
+  hhash_p->State = HAL_HASH_STATE_READY;
+  host_hash_mdmat = 0;
+  sha_init(&sha);
+  sha_done = false;
+
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_HASHEx_SHA256_Start_DMA (HASH_HandleTypeDef *hhash_p,
+                             uint8_t            *in,
+                             uint32_t            size)
+{
+  /* a digest was computed, or a partial word would be padded in the middle */
+  if (sha_done || (host_hash_mdmat && size % 4 != 0))
+    {
+      printf("FAIL HASH fed after the digest or with a partial word\n");
+      failed++;
+      return HAL_ERROR;
+    }
+
+  sha_update(&sha, in, size);
+  if (!host_hash_mdmat)
+    {
+      sha_final(&sha, sha_digest);
+      sha_done = true;
+    }
+
+  HAL_HASH_InCpltCallback(hhash_p);
+
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_HASHEx_SHA256_Finish (HASH_HandleTypeDef *hhash_p,
+                          uint8_t            *out,
+                          uint32_t            timeout)
+{
+  LV_UNUSED(hhash_p);
+  LV_UNUSED(timeout);
+
+  if (!sha_done)
+    {
+      return HAL_TIMEOUT;
+    }
+  memcpy(out, sha_digest, UPDATE_DIGEST_SIZE);
+
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef
+HAL_DMA_Abort (DMA_HandleTypeDef *hdma)
+{
+  LV_UNUSED(hdma);
+
+  return HAL_OK;
+}
+
+/**********************
+ *   FLASH MODEL
+ **********************/
+
+static void
+host_fail (const char *what,
+           uint32_t    offset)
+{
+  printf("FAIL %s at 0x%08x\n", what, (unsigned)offset);
+  failed++;
+}
+
+const void *
+lvgl_ospi_get_ptr (uint32_t offset)
+{
+  if (offset % UPDATE_SLOT_SIZE == UPDATE_RECORD_OFFSET && read_depth == 0)
+    {
+      host_fail("record read without the read bracket", offset);
+    }
+
+  return flash + offset;
+}
+
+void
+lvgl_ospi_read_begin (void)
+{
+  read_depth++;
+}
+
+void
+lvgl_ospi_read_end (void)
+{
+  if (read_depth == 0)
+    {
+      host_fail("read end without a begin", 0);
+      return;
+    }
+  read_depth--;
+}
+
+lv_result_t
+lvgl_ospi_program (uint32_t    offset,
+                   const void *buf,
+                   uint32_t    size)
+{
+  const uint8_t *src = buf;
+  uint32_t i;
+
+  if (offset + size > HOST_FLASH_SIZE)
+    {
+      host_fail("program outside the flash", offset);
+      return LV_RESULT_INVALID;
+    }
+  if (cut_commit && size == sizeof(uint32_t) && offset % OSPI_SECTOR_SIZE != 0 &&
+      offset % UPDATE_SLOT_SIZE >= UPDATE_RECORD_OFFSET)
+    {
+      return LV_RESULT_INVALID;
+    }
+
+  for (i = 0; i < size; i++)
+    {
+      if ((flash[offset + i] & src[i]) != src[i])
+        {
+          host_fail("program without erase", offset + i);
+          return LV_RESULT_INVALID;
+        }
+      flash[offset + i] = src[i];
+    }
+
+  return LV_RESULT_OK;
+}
+
+lv_result_t
+lvgl_ospi_erase (uint32_t offset,
+                 uint32_t size)
+{
+  if (offset % OSPI_SECTOR_SIZE != 0 || size % OSPI_SECTOR_SIZE != 0 ||
+      offset + size > HOST_FLASH_SIZE)
+    {
+      host_fail("unaligned erase", offset);
+      return LV_RESULT_INVALID;
+    }
+  memset(flash + offset, 0xFF, size);
+
+  return LV_RESULT_OK;
+}
+
+lv_result_t
+lvgl_ospi_program_async (uint32_t            offset,
+                         const void         *buf,
+                         uint32_t            size,
+                         lvgl_ospi_done_cb_t cb,
+                         void               *user_data)
+{
+  cb(lvgl_ospi_program(offset, buf, size), user_data);
+
+  return LV_RESULT_OK;
+}
+
+lv_result_t
+lvgl_ospi_erase_async (uint32_t            offset,
+                       uint32_t            size,
+                       lvgl_ospi_done_cb_t cb,
+                       void               *user_data)
+{
+  cb(lvgl_ospi_erase(offset, size), user_data);
+
+  return LV_RESULT_OK;
+}
+
+bool
+lvgl_ospi_is_busy (void)
+{
+  if (read_depth > 0)
+    {
+      host_fail("jobs waited for in the read bracket", 0);
+    }
+
+  return false;
+}
+
+bool
+lvgl_bundle_is_valid (const void *base)
+{
+  if (read_depth == 0)
+    {
+      host_fail("bundle read without the read bracket", (uint32_t)((const uint8_t *)base - flash));
+    }
+
+  return bundle_ok;
+}
+
+void
+lvgl_trace (const char *format,
+            ...)
+{
+  va_list args;
+
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+  printf("\n");
+}
+
+/**********************
+ *   TESTS
+ **********************/
+
+static void
+host_check (bool        ok,
+            const char *what)
+{
+  printf("%-40s %s\n", what, ok ? "ok" : "FAIL");
+  failed += !ok;
+}
+
+/* Send an image of `size` bytes in random pieces, with its digest or a wrong one */
+static lv_result_t
+host_update (uint32_t size,
+             bool     good_digest)
+{
+  uint8_t digest[UPDATE_DIGEST_SIZE];
+  uint32_t done = 0;
+  uint32_t n;
+  uint32_t i;
+
+  for (i = 0; i < size; i++)
+    {
+      image[i] = (uint8_t)rand();
+    }
+  sha_of(image, size, digest);
+  if (!good_digest)
+    {
+      digest[5] ^= 0x10;
+    }
+
+  if (lvgl_update_begin(size, digest) != LV_RESULT_OK)
+    {
+      return LV_RESULT_INVALID;
+    }
+  while (done < size)
+    {
+      n = LV_MIN(size - done, 1 + (uint32_t)rand() % HOST_PIECE_MAX);
+      if (lvgl_update_write(image + done, n) != LV_RESULT_OK)
+        {
+          return LV_RESULT_INVALID;
+        }
+      done += n;
+    }
+
+  return lvgl_update_finish();
+}
+
+static bool
+host_slot_holds (uint32_t slot_idx,
+                 uint32_t size)
+{
+  return memcmp(flash + slot_idx * UPDATE_SLOT_SIZE, image, size) == 0;
+}
+
+static void
+host_test_sha (void)
+{
+  static const uint8_t abc[UPDATE_DIGEST_SIZE] =
+  {
+    0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+    0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+  };
+  uint8_t digest[UPDATE_DIGEST_SIZE];
+
+  sha_of((const uint8_t *)"abc", 3, digest);
+  host_check(memcmp(digest, abc, sizeof(abc)) == 0, "SHA-256 model");
+}
+
+static void
+host_test_updates (void)
+{
+  lvgl_update_stats_t stats;
+  uint32_t size;
+  bool ok;
+
+  lvgl_update_init();
+  host_check(lvgl_update_get_active_slot() == 0 &&
+             lvgl_update_get_bundle() == flash, "no record, the 1st slot");
+
+  size = 3 * UPDATE_CHUNK_SIZE + 123;
+  ok = host_update(size, true) == LV_RESULT_OK;
+  host_check(ok && lvgl_update_get_active_slot() == 1 && host_slot_holds(1, size),
+             "pieces hashed, programmed and switched");
+
+  /* slot 0 is still mapped for the UI until the reboot */
+  ok = host_update(100, true) != LV_RESULT_OK;
+  host_check(ok && lvgl_update_get_active_slot() == 1, "2nd update refused");
+
+  lvgl_update_init();
+  host_check(lvgl_update_get_active_slot() == 1 &&
+             lvgl_update_get_bundle() == flash + UPDATE_SLOT_SIZE, "active after the reboot");
+
+  ok = host_update(2 * UPDATE_CHUNK_SIZE + 7, false) != LV_RESULT_OK;
+  lvgl_update_init();
+  host_check(ok && lvgl_update_get_active_slot() == 1, "wrong digest keeps the slot");
+
+  bundle_ok = false;
+  ok = host_update(UPDATE_CHUNK_SIZE + 7, true) != LV_RESULT_OK;
+  bundle_ok = true;
+  lvgl_update_init();
+  host_check(ok && lvgl_update_get_active_slot() == 1, "invalid bundle keeps the slot");
+
+  size = 100;
+  ok = host_update(size, true) == LV_RESULT_OK;
+  lvgl_update_init();
+  host_check(ok && lvgl_update_get_active_slot() == 0 && host_slot_holds(0, size),
+             "single chunk");
+
+  size = 4 * UPDATE_CHUNK_SIZE;
+  ok = host_update(size, true) == LV_RESULT_OK;
+  lvgl_update_init();
+  host_check(ok && lvgl_update_get_active_slot() == 1 && host_slot_holds(1, size),
+             "whole chunks");
+
+  ok = lvgl_update_begin(100, image) == LV_RESULT_OK;
+  ok &= lvgl_update_write(image, 101) != LV_RESULT_OK;
+  ok &= lvgl_update_write(image, 1) != LV_RESULT_OK;
+  host_check(ok && lvgl_update_get_active_slot() == 1, "write past the size fails");
+
+  cut_commit = true;
+  ok = host_update(UPDATE_CHUNK_SIZE * 2, true) != LV_RESULT_OK;
+  cut_commit = false;
+  lvgl_update_init();
+  host_check(ok && lvgl_update_get_active_slot() == 1, "record without commit ignored");
+
+  lvgl_update_get_stats(&stats);
+  host_check(stats.updates == 3 && stats.failures == 4, "stats");
+  host_check(read_depth == 0, "read brackets closed");
+}
+
+int
+main (void)
+{
+  flash = malloc(HOST_FLASH_SIZE);
+  memset(flash, 0xFF, HOST_FLASH_SIZE);
+  srand(1);
+
+  hhash.hdmain = &host_dma;
+  HAL_HASH_Init(&hhash);
+
+  host_test_sha();
+  host_test_updates();
+
+  printf("%u failed\n", (unsigned)failed);
+
+  free(flash);
+
+  return failed != 0;
+}
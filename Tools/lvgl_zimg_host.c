@@ -0,0 +1,287 @@
+/* Benchmark the RLE and LZ4 decoding of lvgl_port_zimg on the host.
+ *
+ * Three kinds of content, flat UI graphics, a gradient and a noisy photo-like image,
+ * are compressed in RGB565 and ARGB8888 with the methods of LVGLImage.py, then
+ * decoded by the port's decoder bypassing the image cache. The compression ratio,
+ * the decoding time and the output throughput are printed next to a memcpy of the
+ * uncompressed image, and every decoded image is compared with its source. On the
+ * target, lvgl_zimg_benchmark() measures an asset with the cycle counter. Build it
+ * with LVGL and an lv_conf.h for the host (LV_USE_OS LV_OS_NONE, LV_USE_RLE 1,
+ * LV_USE_LZ4_INTERNAL 1), e.g. from the directory above lvgl/:
+ *
+ *   cc -O2 -I. -Ipath/to/Tools/host -Ipath/to/Core/Inc -DLV_CONF_INCLUDE_SIMPLE \
+ *      path/to/Tools/lvgl_zimg_host.c path/to/Core/Src/lvgl_port_zimg.c \
+ *      $(find lvgl/src -name '*.c') -lm -o lvgl_zimg_host
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "lvgl/lvgl.h"
+#include "lvgl/src/libs/lz4/lz4.h"
+#include "lvgl_port_zimg.h"
+
+#define HOST_W          320
+#define HOST_H          240
+#define HOST_RUNS       50
+#define HOST_HEADER     12      /* method, compressed and decompressed size */
+#define HOST_RLE_MIN    3       /* blocks repeated at least this often are a run */
+
+typedef enum
+{
+  HOST_FLAT,
+  HOST_GRADIENT,
+  HOST_PHOTO,
+} host_content_t;
+
+static const char *content_names[] = { "flat", "gradient", "photo" };
+
+static uint8_t src[HOST_W * HOST_H * 4];
+static uint8_t packed[HOST_HEADER + HOST_W * HOST_H * 4 * 2];
+static uint8_t copy[HOST_W * HOST_H * 4];
+
+static double
+host_now_us (void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void
+host_put (uint8_t *px,
+          uint32_t bpp,
+          uint8_t  r,
+          uint8_t  g,
+          uint8_t  b)
+{
+  if (bpp == 2)
+    {
+      uint16_t c = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+
+      memcpy(px, &c, 2);
+    }
+  else
+    {
+      px[0] = b;
+      px[1] = g;
+      px[2] = r;
+      px[3] = 0xFF;
+    }
+}
+
+static void
+host_fill (host_content_t content,
+           uint32_t       bpp)
+{
+  uint32_t x;
+  uint32_t y;
+  int32_t dx;
+  int32_t dy;
+  uint8_t v;
+
+  srand(1);
+
+  for (y = 0; y < HOST_H; y++)
+    {
+      for (x = 0; x < HOST_W; x++)
+        {
+          uint8_t *px = &src[(y * HOST_W + x) * bpp];
+
+          switch (content)
+            {
+              case HOST_FLAT:
+                /* a panel with a few buttons and a round icon */
+                dx = (int32_t)x - 240;
+                dy = (int32_t)y - 80;
+                if (dx * dx + dy * dy < 40 * 40)
+                  {
+                    host_put(px, bpp, 0xF0, 0x80, 0x20);
+                  }
+                else if (y % 60 > 10 && y % 60 < 50 && x > 20 && x < 180)
+                  {
+                    host_put(px, bpp, 0x20, 0x60, 0xC0);
+                  }
+                else
+                  {
+                    host_put(px, bpp, 0xF4, 0xF4, 0xF4);
+                  }
+                break;
+
+              case HOST_GRADIENT:
+                v = (uint8_t)(x * 255 / (HOST_W - 1));
+                host_put(px, bpp, v, (uint8_t)(255 - v), (uint8_t)(y * 255 / (HOST_H - 1)));
+                break;
+
+              default:
+                v = (uint8_t)(128 + 60 * sin(x * 0.05) * cos(y * 0.07) + rand() % 24);
+                host_put(px, bpp, v, (uint8_t)(v * 3 / 4), (uint8_t)(255 - v));
+                break;
+            }
+        }
+    }
+}
+
+static uint32_t
+host_blocks_equal (const uint8_t *a,
+                   uint32_t       blk,
+                   uint32_t       left)
+{
+  uint32_t n = 1;
+
+  while (n < left && n < 127 && memcmp(a, a + n * blk, blk) == 0)
+    {
+      n++;
+    }
+
+  return n;
+}
+
+/* The RLE of LVGLImage.py: a control byte with the top bit set is followed by as
+ * many literal blocks, one without it by a block repeated as often */
+static uint32_t
+host_rle (const uint8_t *in,
+          uint32_t       size,
+          uint32_t       blk,
+          uint8_t       *out)
+{
+  uint32_t blocks = size / blk;
+  uint32_t i = 0;
+  uint32_t len = 0;
+  uint32_t lit;
+  uint32_t n;
+
+  while (i < blocks)
+    {
+      n = host_blocks_equal(in + i * blk, blk, blocks - i);
+      if (n >= HOST_RLE_MIN)
+        {
+          out[len++] = (uint8_t)n;
+          memcpy(out + len, in + i * blk, blk);
+          len += blk;
+          i += n;
+          continue;
+        }
+
+      for (lit = 0; i + lit < blocks && lit < 127; lit++)
+        {
+          if (host_blocks_equal(in + (i + lit) * blk, blk, blocks - i - lit) >= HOST_RLE_MIN)
+            {
+              break;
+            }
+        }
+      out[len++] = (uint8_t)(0x80 | lit);
+      memcpy(out + len, in + i * blk, lit * blk);
+      len += lit * blk;
+      i += lit;
+    }
+
+  return len;
+}
+
+static void
+host_bench (host_content_t        content,
+            lv_color_format_t     cf,
+            lv_image_compress_t   method)
+{
+  uint32_t bpp = lv_color_format_get_size(cf);
+  uint32_t size = HOST_W * HOST_H * bpp;
+  uint32_t words[3];
+  lv_image_dsc_t img = { 0 };
+  lv_image_decoder_args_t args = { 0 };
+  lv_image_decoder_dsc_t dsc;
+  const lv_draw_buf_t *decoded;
+  uint32_t len;
+  uint32_t y;
+  uint32_t i;
+  double best = 1e30;
+  double t;
+  double copy_us = 1e30;
+  bool ok = true;
+
+  host_fill(content, bpp);
+
+  if (method == LV_IMAGE_COMPRESS_RLE)
+    {
+      len = host_rle(src, size, bpp, packed + HOST_HEADER);
+    }
+  else
+    {
+      len = LZ4_compress_default((const char *)src, (char *)packed + HOST_HEADER, size,
+                                 sizeof(packed) - HOST_HEADER);
+    }
+
+  words[0] = method;
+  words[1] = len;
+  words[2] = size;
+  memcpy(packed, words, sizeof(words));
+
+  img.header.magic = LV_IMAGE_HEADER_MAGIC;
+  img.header.cf = cf;
+  img.header.flags = LV_IMAGE_FLAGS_COMPRESSED;
+  img.header.w = HOST_W;
+  img.header.h = HOST_H;
+  img.header.stride = HOST_W * bpp;
+  img.data = packed;
+  img.data_size = HOST_HEADER + len;
+
+  /* a cache hit would measure nothing */
+  args.no_cache = true;
+
+  for (i = 0; i < HOST_RUNS; i++)
+    {
+      t = host_now_us();
+      if (lv_image_decoder_open(&dsc, &img, &args) != LV_RESULT_OK)
+        {
+          printf("%-8s %-8s %s: not decoded\n", content_names[content],
+                 bpp == 2 ? "RGB565" : "ARGB8888", method == LV_IMAGE_COMPRESS_RLE ? "RLE" : "LZ4");
+          return;
+        }
+      best = LV_MIN(best, host_now_us() - t);
+
+      decoded = dsc.decoded;
+      for (y = 0; y < HOST_H; y++)
+        {
+          ok &= memcmp(decoded->data + y * decoded->header.stride, src + y * HOST_W * bpp,
+                       HOST_W * bpp) == 0;
+        }
+      lv_image_decoder_close(&dsc);
+
+      t = host_now_us();
+      memcpy(copy, src, size);
+      copy_us = LV_MIN(copy_us, host_now_us() - t);
+    }
+
+  printf("%-8s %-8s %s  ratio %5.2f  decode %7.1f us  %7.1f MB/s  (memcpy %6.1f us)  %s\n",
+         content_names[content], bpp == 2 ? "RGB565" : "ARGB8888",
+         method == LV_IMAGE_COMPRESS_RLE ? "RLE" : "LZ4", (double)size / len, best,
+         size / best, copy_us, ok ? "ok" : "MISMATCH");
+}
+
+int
+main (void)
+{
+  static const lv_color_format_t cfs[] = { LV_COLOR_FORMAT_RGB565, LV_COLOR_FORMAT_ARGB8888 };
+  uint32_t content;
+  uint32_t c;
+
+  lv_init();
+  lvgl_zimg_init();
+
+  for (content = HOST_FLAT; content <= HOST_PHOTO; content++)
+    {
+      for (c = 0; c < sizeof(cfs) / sizeof(cfs[0]); c++)
+        {
+          host_bench((host_content_t)content, cfs[c], LV_IMAGE_COMPRESS_RLE);
+          host_bench((host_content_t)content, cfs[c], LV_IMAGE_COMPRESS_LZ4);
+        }
+    }
+
+  return 0;
+}
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""Wrap a NemaGFX TSC texture into an LVGL image descriptor.
+
+The TSC4/TSC6/TSC12 payload is produced by Think Silicon's texture encoder
+shipped with the NemaGFX SDK, the TSC coding isn't published and this script
+doesn't encode pixels. It checks the payload against the image size and writes
+a C file with a `lv_image_dsc_t` which lvgl_port_tsc hands to GPU2D without
+decompression. tsc_to_lvgl_test.py tests it.
+
+    tsc_to_lvgl.py --format TSC4 --width 128 --height 64 icon.tsc -o icon.c
+"""
+
+import argparse
+import os
+import re
+import sys
+
+# bits per pixel of each format, a 4x4 block is coded in 16 * bpp bits
+FORMATS = {
+    "TSC4": 4,
+    "TSC6": 6,
+    "TSC6A": 6,
+    "TSC6AP": 6,
+    "TSC12": 12,
+    "TSC12A": 12,
+}
+
+BLOCK = 4
+
+
+def tsc_size(fmt, w, h):
+    blocks = ((w + BLOCK - 1) // BLOCK) * ((h + BLOCK - 1) // BLOCK)
+    return blocks * 16 * FORMATS[fmt] // 8
+
+
+def c_name(path):
+    name = os.path.splitext(os.path.basename(path))[0]
+    return re.sub(r"\W", "_", name)
+
+
+def write_c(out, name, fmt, w, h, data):
+    stride = w * FORMATS[fmt] // 8
+    out.write('#include "lvgl/lvgl.h"\n\n')
+    out.write("/* %s %dx%d, %d bytes */\n" % (fmt, w, h, len(data)))
+    out.write("static const __attribute__((aligned(8))) uint8_t %s_map[] = {\n" % name)
+    for i in range(0, len(data), 16):
+        out.write("  " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",\n")
+    out.write("};\n\n")
+    out.write("const lv_image_dsc_t %s = {\n" % name)
+    out.write("  .header.magic = LV_IMAGE_HEADER_MAGIC,\n")
+    out.write("  .header.cf = LV_COLOR_FORMAT_NEMA_%s,\n" % fmt)
+    out.write("  .header.w = %d,\n" % w)
+    out.write("  .header.h = %d,\n" % h)
+    out.write("  .header.stride = %d,\n" % stride)
+    out.write("  .data_size = sizeof(%s_map),\n" % name)
+    out.write("  .data = %s_map,\n" % name)
+    out.write("};\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="raw TSC payload from the NemaGFX texture encoder")
+    parser.add_argument("--format", required=True, choices=sorted(FORMATS))
+    parser.add_argument("--width", type=int, required=True)
+    parser.add_argument("--height", type=int, required=True)
+    parser.add_argument("--name", help="C symbol, defaults to the input file name")
+    parser.add_argument("-o", "--output", help="C file, defaults to stdout")
+    args = parser.parse_args()
+
+    if args.width % BLOCK or args.height % BLOCK:
+        sys.exit("%dx%d: TSC images have to be a multiple of %d pixels" % (args.width, args.height, BLOCK))
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+
+    expected = tsc_size(args.format, args.width, args.height)
+    if len(data) != expected:
+        sys.exit("%s: %d bytes, %s %dx%d needs %d" % (args.input, len(data), args.format,
+                                                      args.width, args.height, expected))
+
+    name = args.name or c_name(args.input)
+    if args.output:
+        with open(args.output, "w") as out:
+            write_c(out, name, args.format, args.width, args.height, data)
+    else:
+        write_c(sys.stdout, name, args.format, args.width, args.height, data)
+
+
+if __name__ == "__main__":
+    main()
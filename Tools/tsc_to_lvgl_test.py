@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Host tests of tsc_to_lvgl.py.
+
+The descriptor written for a TSC payload is compiled and its data compared with
+the payload byte by byte, for every format. Payloads of the wrong size and images
+which aren't a multiple of the block size have to be refused.
+
+    python3 Tools/tsc_to_lvgl_test.py
+"""
+
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+import tsc_to_lvgl  # noqa: E402
+
+SCRIPT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "tsc_to_lvgl.py")
+
+# just enough of LVGL for the generated file to compile on the host
+LVGL_H = """
+#include <stdint.h>
+#define LV_IMAGE_HEADER_MAGIC 0x19
+enum { LV_COLOR_FORMAT_NEMA_TSC4 = 1, LV_COLOR_FORMAT_NEMA_TSC6, LV_COLOR_FORMAT_NEMA_TSC6A,
+       LV_COLOR_FORMAT_NEMA_TSC6AP, LV_COLOR_FORMAT_NEMA_TSC12, LV_COLOR_FORMAT_NEMA_TSC12A };
+typedef struct { uint32_t magic, cf, w, h, stride; } lv_image_header_t;
+typedef struct { lv_image_header_t header; uint32_t data_size; const uint8_t *data; } lv_image_dsc_t;
+"""
+
+# prints the descriptor's header, then its data in hex
+MAIN_C = """
+#include <stdio.h>
+#include "lvgl/lvgl.h"
+extern const lv_image_dsc_t img;
+int main(void)
+{
+  unsigned i;
+  printf("%u %u %u %u %u\\n", (unsigned)img.header.cf, (unsigned)img.header.w,
+         (unsigned)img.header.h, (unsigned)img.header.stride, (unsigned)img.data_size);
+  if ((uintptr_t)img.data % 8 != 0) return 1;
+  for (i = 0; i < img.data_size; i++) printf("%02x", img.data[i]);
+  printf("\\n");
+  return 0;
+}
+"""
+
+CF = {fmt: i + 1 for i, fmt in enumerate(["TSC4", "TSC6", "TSC6A", "TSC6AP", "TSC12", "TSC12A"])}
+
+
+def convert(tmp, fmt, w, h, payload):
+    src = os.path.join(tmp, "img.tsc")
+    with open(src, "wb") as f:
+        f.write(payload)
+    return subprocess.run([sys.executable, SCRIPT, "--format", fmt, "--width", str(w),
+                           "--height", str(h), "--name", "img", src, "-o",
+                           os.path.join(tmp, "img.c")], capture_output=True, text=True)
+
+
+class TscToLvglTest(unittest.TestCase):
+
+    def setUp(self):
+        self.tmp = tempfile.mkdtemp()
+        self.rng = random.Random(1)
+
+    def tearDown(self):
+        shutil.rmtree(self.tmp)
+
+    def test_size_matches_the_decoder(self):
+        # lvgl_tsc_get_size(): 8, 12 or 24 bytes per 4x4 block
+        block_bytes = {"TSC4": 8, "TSC6": 12, "TSC6A": 12, "TSC6AP": 12, "TSC12": 24, "TSC12A": 24}
+        for fmt, size in block_bytes.items():
+            self.assertEqual(tsc_to_lvgl.tsc_size(fmt, 128, 64), 32 * 16 * size)
+            self.assertEqual(tsc_to_lvgl.tsc_size(fmt, 4, 4), size)
+
+    @unittest.skipUnless(shutil.which("cc"), "no host C compiler")
+    def test_descriptor_holds_the_payload(self):
+        os.makedirs(os.path.join(self.tmp, "lvgl"))
+        with open(os.path.join(self.tmp, "lvgl", "lvgl.h"), "w") as f:
+            f.write(LVGL_H)
+        with open(os.path.join(self.tmp, "main.c"), "w") as f:
+            f.write(MAIN_C)
+
+        for fmt in tsc_to_lvgl.FORMATS:
+            for w, h in ((4, 4), (128, 64), (36, 100)):
+                payload = bytes(self.rng.randrange(256) for _ in range(tsc_to_lvgl.tsc_size(fmt, w, h)))
+                res = convert(self.tmp, fmt, w, h, payload)
+                self.assertEqual(res.returncode, 0, res.stderr)
+
+                exe = os.path.join(self.tmp, "img")
+                subprocess.run(["cc", "-Wall", "-Werror", "-I", self.tmp, "-o", exe,
+                                os.path.join(self.tmp, "main.c"), os.path.join(self.tmp, "img.c")],
+                               check=True)
+                out = subprocess.run([exe], capture_output=True, text=True, check=True).stdout.split("\n")
+
+                self.assertEqual(out[0], "%d %d %d %d %d" % (CF[fmt], w, h, w * tsc_to_lvgl.FORMATS[fmt] // 8,
+                                                             len(payload)), fmt)
+                self.assertEqual(bytes.fromhex(out[1]), payload, fmt)
+
+    def test_wrong_size_is_refused(self):
+        size = tsc_to_lvgl.tsc_size("TSC6", 64, 64)
+        for n in (size - 1, size + 1, 0):
+            res = convert(self.tmp, "TSC6", 64, 64, bytes(n))
+            self.assertNotEqual(res.returncode, 0)
+            self.assertFalse(os.path.exists(os.path.join(self.tmp, "img.c")))
+
+    def test_partial_blocks_are_refused(self):
+        res = convert(self.tmp, "TSC4", 30, 64, bytes(tsc_to_lvgl.tsc_size("TSC4", 30, 64)))
+        self.assertNotEqual(res.returncode, 0)
+
+
+if __name__ == "__main__":
+    unittest.main()